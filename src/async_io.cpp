@@ -0,0 +1,176 @@
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <encmetric/async_io.hpp>
+
+using namespace adv;
+
+void io_loop::update(int fd){
+	auto it = watches.find(fd);
+	if(it == watches.end())
+		return;
+	watch &w = it->second;
+	bool rd = static_cast<bool>(w.on_read);
+	bool wr = static_cast<bool>(w.on_write);
+	if(rd != w.armed_read || wr != w.armed_write){
+		poller.arm(fd, rd, wr);
+		w.armed_read = rd;
+		w.armed_write = wr;
+	}
+	if(!rd && !wr)
+		watches.erase(it);
+}
+
+void io_loop::wait_readable(int fd, std::function<void()> h){
+	watch &w = watches[fd];
+	if(w.on_read)
+		throw encoding_error{"Handler already registered"};
+	w.on_read = std::move(h);
+	waiting++;
+	update(fd);
+}
+
+void io_loop::wait_writable(int fd, std::function<void()> h){
+	watch &w = watches[fd];
+	if(w.on_write)
+		throw encoding_error{"Handler already registered"};
+	w.on_write = std::move(h);
+	waiting++;
+	update(fd);
+}
+
+void io_loop::cancel(int fd){
+	auto it = watches.find(fd);
+	if(it == watches.end())
+		return;
+	watch &w = it->second;
+	if(w.on_read){
+		w.on_read = nullptr;
+		waiting--;
+	}
+	if(w.on_write){
+		w.on_write = nullptr;
+		waiting--;
+	}
+	update(fd);
+}
+
+std::uint64_t io_loop::add_op(std::function<void(std::ptrdiff_t)> h){
+	//tags are never 0 and lower than 2^62
+	next_tag = (next_tag + 1) & ((std::uint64_t{1} << 62) - 1);
+	if(next_tag == 0)
+		next_tag = 1;
+	ops.emplace(next_tag, std::move(h));
+	waiting++;
+	return next_tag;
+}
+
+void io_loop::read_some(int fd, byte *b, size_t siz, std::function<void(std::ptrdiff_t)> h){
+	std::uint64_t tag = add_op(std::move(h));
+	try{
+		poller.submit_read(fd, b, siz, tag);
+	}
+	catch(...){
+		ops.erase(tag);
+		waiting--;
+		throw;
+	}
+}
+
+void io_loop::write_some(int fd, const byte *b, size_t siz, std::function<void(std::ptrdiff_t)> h){
+	std::uint64_t tag = add_op(std::move(h));
+	try{
+		poller.submit_write(fd, b, siz, tag);
+	}
+	catch(...){
+		ops.erase(tag);
+		waiting--;
+		throw;
+	}
+}
+
+void io_loop::post(std::function<void()> h){
+	posted.push_back(std::move(h));
+}
+
+size_t io_loop::run_once(int timeout_ms){
+	size_t called = 0;
+	//Handlers posted meanwhile are run in the next iteration
+	for(size_t n = posted.size(); n > 0; n--){
+		std::function<void()> h = std::move(posted.front());
+		posted.pop_front();
+		called++;
+		h();
+	}
+	if(waiting == 0)
+		return called;
+
+	poll_event evs[64];
+	size_t n = poller.wait(evs, 64, (called > 0 || !posted.empty()) ? 0 : timeout_ms);
+	/*
+	    Notifications are one-shot, so all the ready handlers are removed (and the other ones armed
+	    again) before calling any of them. The same for completed reads and writes
+	*/
+	std::vector<std::function<void()>> ready;
+	for(size_t i=0; i<n; i++){
+		if(evs[i].tag != 0){
+			auto op = ops.find(evs[i].tag);
+			if(op == ops.end())
+				continue;
+			std::ptrdiff_t res = evs[i].res;
+			ready.push_back([h = std::move(op->second), res]() {h(res);});
+			ops.erase(op);
+			waiting--;
+			continue;
+		}
+		auto it = watches.find(evs[i].fd);
+		if(it == watches.end())
+			continue;
+		watch &w = it->second;
+		w.armed_read = false;
+		w.armed_write = false;
+		if(evs[i].readable && w.on_read){
+			ready.push_back(std::move(w.on_read));
+			w.on_read = nullptr;
+			waiting--;
+		}
+		if(evs[i].writable && w.on_write){
+			ready.push_back(std::move(w.on_write));
+			w.on_write = nullptr;
+			waiting--;
+		}
+		update(evs[i].fd);
+	}
+	for(size_t i=0; i<ready.size(); i++){
+		try{
+			ready[i]();
+		}
+		catch(...){
+			//Handlers not yet called are run in the next iteration
+			for(size_t j=i+1; j<ready.size(); j++)
+				posted.push_back(std::move(ready[j]));
+			throw;
+		}
+		called++;
+	}
+	return called;
+}
+
+void io_loop::run(){
+	while(!empty())
+		run_once(-1);
+}
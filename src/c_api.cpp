@@ -0,0 +1,325 @@
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <new>
+#include <cstring>
+#include <algorithm>
+#include <encmetric/enc_registry.hpp>
+#include <encmetric/byte_tools.hpp>
+#include <encmetric/stats.hpp>
+#include "encmetric_c.h"
+
+using namespace adv;
+
+/*
+    Bytes of a character kept by a converter, also the maximum length of a character checked
+    for incompleteness
+*/
+inline constexpr size_t max_char_bytes = 16;
+
+struct encmetric_converter{
+	const EncMetric<unicode> *from;
+	const EncMetric<unicode> *to;
+	byte pend[max_char_bytes];
+	size_t npend;
+};
+
+namespace{
+
+const EncMetric<unicode> *get(const encmetric_encoding *e) noexcept{
+	return reinterpret_cast<const EncMetric<unicode> *>(e);
+}
+
+const encmetric_encoding *handle(const EncMetric<unicode> *e) noexcept{
+	return reinterpret_cast<const encmetric_encoding *>(e);
+}
+
+size_t char_bound(const EncMetric<unicode> &e) noexcept{
+	return e.d_has_max() ? std::min<size_t>(e.d_max_bytes(), max_char_bytes) : max_char_bytes;
+}
+
+bool is_ascii(byte b) noexcept{
+	return std::to_integer<unsigned int>(b) < 0x80;
+}
+
+/*
+    Decodes the character at the beginning of src (n > 0), len is set to its length. A truncated
+    character is invalid if its bytes can't start any character (like 0xE2 0x62 in UTF-8)
+*/
+encmetric_status next_char(const EncMetric<unicode> &e, size_t bound, const byte *src, size_t n, unicode &c, uint &len) noexcept{
+	if(n < bound){
+		if(n < e.d_unity())
+			return ENCMETRIC_INCOMPLETE;
+		try{
+			if(EncMetric_info<WIDE<unicode>>{&e}.chLen(src, n) > n){
+				//incomplete only if the invalid subsequence reaches the end of the whole code units
+				if(!e.d_decode_checked(&c, src, n, len) && len < n - n % e.d_unity())
+					return ENCMETRIC_INVALID;
+				return ENCMETRIC_INCOMPLETE;
+			}
+		}
+		catch(...){
+			return ENCMETRIC_INVALID;
+		}
+	}
+	return e.d_decode_checked(&c, src, n, len) ? ENCMETRIC_OK : ENCMETRIC_INVALID;
+}
+
+/*
+    Validates src, r is set to the length of the valid prefix and nchr to its number of characters.
+    ASCII runs of ASCII compatible encodings are skipped 8 bytes at a time
+*/
+encmetric_status scan(const EncMetric<unicode> &e, const byte *src, size_t n, size_t &r, size_t &nchr) noexcept{
+	size_t bound = char_bound(e);
+	bool ascii = e.d_ascii_compatible();
+	r = 0;
+	nchr = 0;
+	while(r < n){
+		if(ascii && is_ascii(src[r])){
+			size_t k = ascii_prefix(src + r, n - r);
+			r += k;
+			nchr += k;
+			continue;
+		}
+		unicode c;
+		uint len;
+		encmetric_status st = next_char(e, bound, src + r, n - r, c, len);
+		if(st != ENCMETRIC_OK)
+			return st;
+		r += len;
+		nchr++;
+	}
+	return ENCMETRIC_OK;
+}
+
+encmetric_status convert_chars(const EncMetric<unicode> &from, const EncMetric<unicode> &to, const byte *src, size_t n, byte *dst, size_t cap, size_t &r, size_t &w, size_t &nchr) noexcept{
+	r = 0;
+	w = 0;
+	nchr = 0;
+	if(from.index() == to.index()){
+		//validated and copied at once
+		encmetric_status st = scan(from, src, std::min(n, cap), r, nchr);
+		if(r > 0)
+			std::memcpy(dst, src, r);
+		w = r;
+		if(n > cap && (st == ENCMETRIC_OK || st == ENCMETRIC_INCOMPLETE))
+			st = ENCMETRIC_OUTPUT_FULL;
+		return st;
+	}
+	size_t ibound = char_bound(from), obound = char_bound(to);
+	bool ascii = from.d_ascii_compatible() && to.d_ascii_compatible();
+	while(r < n){
+		if(ascii && is_ascii(src[r])){
+			size_t k = ascii_prefix(src + r, std::min(n - r, cap - w));
+			if(k == 0)
+				return ENCMETRIC_OUTPUT_FULL;
+			std::memcpy(dst + w, src + r, k);
+			r += k;
+			w += k;
+			nchr += k;
+			continue;
+		}
+		unicode c;
+		uint len, olen;
+		encmetric_status st = next_char(from, ibound, src + r, n - r, c, len);
+		if(st != ENCMETRIC_OK)
+			return st;
+		try{
+			if(cap - w >= obound){
+				if(!to.d_encode_checked(c, dst + w, cap - w, olen))
+					return ENCMETRIC_UNMAPPABLE;
+			}
+			else{
+				byte tmp[max_char_bytes];
+				if(!to.d_encode_checked(c, tmp, max_char_bytes, olen))
+					return ENCMETRIC_UNMAPPABLE;
+				if(olen > cap - w)
+					return ENCMETRIC_OUTPUT_FULL;
+				std::memcpy(dst + w, tmp, olen);
+			}
+		}
+		catch(const buffer_small &){
+			return ENCMETRIC_OUTPUT_FULL;
+		}
+		catch(...){
+			return ENCMETRIC_UNMAPPABLE;
+		}
+		r += len;
+		w += olen;
+		nchr++;
+	}
+	return ENCMETRIC_OK;
+}
+
+encmetric_status convert(const EncMetric<unicode> &from, const EncMetric<unicode> &to, const byte *src, size_t n, byte *dst, size_t cap, size_t &r, size_t &w) noexcept{
+	size_t nchr;
+	encmetric_status st = convert_chars(from, to, src, n, dst, cap, r, w, nchr);
+	count_decoded(from, r, nchr);
+	count_encoded(to, w, nchr);
+	if(st == ENCMETRIC_INVALID)
+		count_invalid(from);
+	return st;
+}
+
+void set(size_t *p, size_t v) noexcept{
+	if(p != nullptr)
+		*p = v;
+}
+
+}
+
+const encmetric_encoding *encmetric_find(const char *name){
+	if(name == nullptr)
+		return nullptr;
+	return handle(find_encoding(std::string_view{name}));
+}
+
+const encmetric_encoding *encmetric_find_n(const char *name, size_t len){
+	if(name == nullptr)
+		return nullptr;
+	return handle(find_encoding(std::string_view{name, len}));
+}
+
+const encmetric_encoding *encmetric_detect(const char *name, const void *data, size_t n, size_t *bomlen){
+	size_t bl = 0;
+	const EncMetric<unicode> *ret = nullptr;
+	if(data != nullptr)
+		ret = detect_bom(adv_string_view<RAW<unicode>>{const_tchar_pt<RAW<unicode>>{static_cast<const byte *>(data)}, n, n}, bl);
+	if(ret == nullptr && name != nullptr)
+		ret = find_encoding(std::string_view{name});
+	set(bomlen, bl);
+	return handle(ret);
+}
+
+size_t encmetric_max_bytes(const encmetric_encoding *enc){
+	if(enc == nullptr)
+		return 0;
+	return char_bound(*get(enc));
+}
+
+const char *encmetric_status_string(encmetric_status st){
+	switch(st){
+		case ENCMETRIC_OK:
+			return "Success";
+		case ENCMETRIC_OUTPUT_FULL:
+			return "Output buffer is full";
+		case ENCMETRIC_INCOMPLETE:
+			return "Incomplete character at the end of the input";
+		case ENCMETRIC_INVALID:
+			return "Invalid byte sequence";
+		case ENCMETRIC_UNMAPPABLE:
+			return "Character not representable in the destination encoding";
+		default:
+			return "Invalid arguments";
+	}
+}
+
+encmetric_status encmetric_validate(const encmetric_encoding *enc, const void *src, size_t n, size_t *read){
+	size_t nchr;
+	return encmetric_count(enc, src, n, read, &nchr);
+}
+
+encmetric_status encmetric_count(const encmetric_encoding *enc, const void *src, size_t n, size_t *read, size_t *nchr){
+	set(read, 0);
+	set(nchr, 0);
+	if(enc == nullptr || (src == nullptr && n > 0))
+		return ENCMETRIC_ERROR;
+	size_t r, c;
+	encmetric_status st = scan(*get(enc), static_cast<const byte *>(src), n, r, c);
+	if(st == ENCMETRIC_INVALID)
+		count_invalid(*get(enc));
+	set(read, r);
+	set(nchr, c);
+	return st;
+}
+
+encmetric_status encmetric_convert(const encmetric_encoding *src_enc, const void *src, size_t n,
+	const encmetric_encoding *dst_enc, void *dst, size_t cap, size_t *read, size_t *written){
+	set(read, 0);
+	set(written, 0);
+	if(src_enc == nullptr || dst_enc == nullptr || (src == nullptr && n > 0) || (dst == nullptr && cap > 0))
+		return ENCMETRIC_ERROR;
+	size_t r, w;
+	encmetric_status st = convert(*get(src_enc), *get(dst_enc), static_cast<const byte *>(src), n, static_cast<byte *>(dst), cap, r, w);
+	set(read, r);
+	set(written, w);
+	return st;
+}
+
+encmetric_converter *encmetric_converter_new(const encmetric_encoding *src_enc, const encmetric_encoding *dst_enc){
+	if(src_enc == nullptr || dst_enc == nullptr)
+		return nullptr;
+	encmetric_converter *ret = new(std::nothrow) encmetric_converter{};
+	if(ret != nullptr){
+		ret->from = get(src_enc);
+		ret->to = get(dst_enc);
+		ret->npend = 0;
+	}
+	return ret;
+}
+
+void encmetric_converter_free(encmetric_converter *conv){
+	delete conv;
+}
+
+void encmetric_converter_reset(encmetric_converter *conv){
+	if(conv != nullptr)
+		conv->npend = 0;
+}
+
+encmetric_status encmetric_converter_run(encmetric_converter *conv, const void *src, size_t n,
+	void *dst, size_t cap, size_t *read, size_t *written, int flush){
+	set(read, 0);
+	set(written, 0);
+	if(conv == nullptr || (src == nullptr && n > 0) || (dst == nullptr && cap > 0))
+		return ENCMETRIC_ERROR;
+	const byte *in = static_cast<const byte *>(src);
+	byte *out = static_cast<byte *>(dst);
+	size_t r = 0, w = 0, pr, pw;
+	encmetric_status st;
+	if(conv->npend > 0){
+		//completes the kept character with the first bytes of src
+		size_t k = std::min(n, max_char_bytes - conv->npend);
+		if(k > 0)
+			std::memcpy(conv->pend + conv->npend, in, k);
+		st = convert(*conv->from, *conv->to, conv->pend, conv->npend + k, out, cap, pr, pw);
+		if(pr <= conv->npend){
+			if(st == ENCMETRIC_INCOMPLETE && k == n){
+				conv->npend += k;
+				set(read, n);
+				return flush ? ENCMETRIC_INCOMPLETE : ENCMETRIC_OK;
+			}
+			return st == ENCMETRIC_INCOMPLETE ? ENCMETRIC_INVALID : st;
+		}
+		r = pr - conv->npend;
+		w = pw;
+		conv->npend = 0;
+	}
+	st = convert(*conv->from, *conv->to, in + r, n - r, out + w, cap - w, pr, pw);
+	r += pr;
+	w += pw;
+	if(st == ENCMETRIC_INCOMPLETE){
+		conv->npend = n - r;
+		std::memcpy(conv->pend, in + r, conv->npend);
+		r = n;
+		if(!flush)
+			st = ENCMETRIC_OK;
+	}
+	set(read, r);
+	set(written, w);
+	return st;
+}
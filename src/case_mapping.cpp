@@ -0,0 +1,138 @@
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <algorithm>
+#include <encmetric/case_mapping.hpp>
+
+namespace adv{
+
+struct case_map_entry{
+	std::uint32_t chr;
+	std::uint32_t lower;
+	std::uint32_t upper;
+	std::uint32_t fold;
+	std::uint32_t special;
+};
+
+struct case_special_entry{
+	std::uint8_t nlower;
+	std::uint32_t lower[max_case_mapping];
+	std::uint8_t nupper;
+	std::uint32_t upper[max_case_mapping];
+	std::uint8_t nfold;
+	std::uint32_t fold[max_case_mapping];
+};
+
+struct case_range{
+	std::uint32_t first;
+	std::uint32_t last;
+};
+
+}
+
+#include "case_data.hpp"
+
+using namespace adv;
+
+static_assert(case_max_mapping <= max_case_mapping, "Case mapping buffer too small");
+
+namespace{
+
+const case_map_entry *find_case(unicode c) noexcept{
+	const case_map_entry *end = case_map + sizeof(case_map) / sizeof(case_map_entry);
+	const case_map_entry *en = std::lower_bound(case_map, end, c, [](const case_map_entry &e, unicode u){
+		return e.chr < static_cast<std::uint32_t>(u);
+	});
+	if(en == end || en->chr != c)
+		return nullptr;
+	return en;
+}
+
+template<size_t N>
+bool in_ranges(const case_range (&r)[N], unicode c) noexcept{
+	const case_range *en = std::upper_bound(r, r + N, c, [](unicode u, const case_range &e){
+		return static_cast<std::uint32_t>(u) < e.first;
+	});
+	return en != r && c <= (en - 1)->last;
+}
+
+size_t copy_mapping(const std::uint32_t *from, size_t n, unicode *out) noexcept{
+	for(size_t i=0; i<n; i++)
+		out[i] = unicode{from[i]};
+	return n;
+}
+
+}
+
+unicode adv::simple_lower(unicode c) noexcept{
+	if(c < 0x80)
+		return (c >= 'A' && c <= 'Z') ? unicode{c + 0x20} : c;
+	const case_map_entry *en = find_case(c);
+	return en == nullptr ? c : unicode{en->lower};
+}
+
+unicode adv::simple_upper(unicode c) noexcept{
+	if(c < 0x80)
+		return (c >= 'a' && c <= 'z') ? unicode{c - 0x20} : c;
+	const case_map_entry *en = find_case(c);
+	return en == nullptr ? c : unicode{en->upper};
+}
+
+unicode adv::simple_fold(unicode c) noexcept{
+	if(c < 0x80)
+		return (c >= 'A' && c <= 'Z') ? unicode{c + 0x20} : c;
+	const case_map_entry *en = find_case(c);
+	return en == nullptr ? c : unicode{en->fold};
+}
+
+size_t adv::full_lower(unicode c, unicode *out) noexcept{
+	const case_map_entry *en = find_case(c);
+	if(en != nullptr && en->special != 0){
+		const case_special_entry &sp = case_special[en->special - 1];
+		return copy_mapping(sp.lower, sp.nlower, out);
+	}
+	out[0] = en == nullptr ? c : unicode{en->lower};
+	return 1;
+}
+
+size_t adv::full_upper(unicode c, unicode *out) noexcept{
+	const case_map_entry *en = find_case(c);
+	if(en != nullptr && en->special != 0){
+		const case_special_entry &sp = case_special[en->special - 1];
+		return copy_mapping(sp.upper, sp.nupper, out);
+	}
+	out[0] = en == nullptr ? c : unicode{en->upper};
+	return 1;
+}
+
+size_t adv::full_fold(unicode c, unicode *out) noexcept{
+	const case_map_entry *en = find_case(c);
+	if(en != nullptr && en->special != 0){
+		const case_special_entry &sp = case_special[en->special - 1];
+		return copy_mapping(sp.fold, sp.nfold, out);
+	}
+	out[0] = en == nullptr ? c : unicode{en->fold};
+	return 1;
+}
+
+bool adv::is_cased(unicode c) noexcept{
+	return in_ranges(cased_ranges, c);
+}
+
+bool adv::is_case_ignorable(unicode c) noexcept{
+	return in_ranges(case_ignorable_ranges, c);
+}
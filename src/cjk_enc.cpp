@@ -0,0 +1,558 @@
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+#include <encmetric/cjk_enc.hpp>
+#include <encmetric/utf8_enc.hpp>
+#include <encmetric/byte_tools.hpp>
+
+namespace adv{
+
+struct cjk_plane{
+	uint lead_first;
+	uint lead_last;
+	uint trail_first;
+	uint trail_last;
+	const std::uint16_t *rows;
+	const std::uint16_t *codes;
+};
+
+struct gb18030_range{
+	std::uint32_t linear;
+	std::uint32_t chr;
+};
+
+}
+
+#include "cjk_data.hpp"
+
+namespace adv{
+
+namespace{
+
+constexpr std::uint32_t gb18030_bmp = 39420;//four byte characters in the BMP
+constexpr std::uint32_t gb18030_supp = 189000;//linear index of U+10000
+
+inline uint to_uint(byte b) noexcept{
+	return std::to_integer<uint>(b);
+}
+
+/*
+    Character of a two byte sequence, 0 if undefined
+*/
+std::uint16_t plane_lookup(const cjk_plane &p, uint a, uint b) noexcept{
+	if(a < p.lead_first || a > p.lead_last || b < p.trail_first || b > p.trail_last)
+		return 0;
+	uint row = p.rows[a - p.lead_first];
+	if(row == 0)
+		return 0;
+	return p.codes[(row - 1) * (p.trail_last - p.trail_first + 1) + b - p.trail_first];
+}
+
+bool gbk_included(uint a, uint b) noexcept{
+	const cjk_plane &p = gb18030_plane;
+	size_t idx = (p.rows[a - p.lead_first] - 1) * (p.trail_last - p.trail_first + 1) + b - p.trail_first;
+	return (gbk_excluded[idx / 32] & (std::uint32_t{1} << (idx % 32))) == 0;
+}
+
+uint lead_length(cjk_charset cs, const byte *by) noexcept{
+	uint b = to_uint(by[0]);
+	if(b < 0x80)
+		return 1;
+	switch(cs){
+		case cjk_charset::shift_jis:
+			return (b >= 0x81 && b <= 0x9f) || (b >= 0xe0 && b <= 0xfc) ? 2 : 1;
+		case cjk_charset::euc_jp:
+			if(b == 0x8f)
+				return 3;
+			return b == 0x8e || (b >= 0xa1 && b <= 0xfe) ? 2 : 1;
+		case cjk_charset::euc_kr:
+			return b >= 0xa1 && b <= 0xfe ? 2 : 1;
+		case cjk_charset::gb18030:
+			if(b == 0x80 || b == 0xff)
+				return 1;
+			//four byte characters start only with these bytes
+			if((b >= 0x81 && b <= 0x84) || (b >= 0x90 && b <= 0xe3)){
+				uint c = to_uint(by[1]);
+				return c >= 0x30 && c <= 0x39 ? 4 : 2;
+			}
+			return 2;
+		default:
+			return b >= 0x81 && b <= 0xfe ? 2 : 1;
+	}
+}
+
+/*
+    Decodes a character: returns its length, 0 if it's invalid or minus the required length if
+    l is too small
+*/
+template<cjk_charset cs>
+int decode_char(const byte *by, size_t l, std::uint32_t &c) noexcept{
+	uint b = to_uint(by[0]);
+	if(b < 0x80){
+		c = b;
+		return 1;
+	}
+	if(cs == cjk_charset::shift_jis && b >= 0xa1 && b <= 0xdf){
+		c = 0xff61 + b - 0xa1;
+		return 1;
+	}
+	if(cs == cjk_charset::gb18030 && l < 2 && b >= 0x81 && b <= 0xfe)
+		return -2;
+	uint len = lead_length(cs, by);
+	if(len == 1)
+		return 0;
+	if(l < len)
+		return -static_cast<int>(len);
+	uint t = to_uint(by[1]);
+	switch(cs){
+		case cjk_charset::shift_jis:
+			c = plane_lookup(sjis_plane, b, t);
+			break;
+		case cjk_charset::euc_jp:
+			if(b == 0x8e)
+				c = t >= 0xa1 && t <= 0xdf ? 0xff61 + t - 0xa1 : 0;
+			else if(b == 0x8f)
+				c = plane_lookup(jisx0212_plane, t, to_uint(by[2]));
+			else
+				c = plane_lookup(jisx0208_plane, b, t);
+			break;
+		case cjk_charset::euc_kr:
+			c = plane_lookup(euckr_plane, b, t);
+			break;
+		case cjk_charset::big5:
+			c = plane_lookup(big5_plane, b, t);
+			break;
+		case cjk_charset::gbk:
+			c = plane_lookup(gb18030_plane, b, t);
+			if(c != 0 && !gbk_included(b, t))
+				c = 0;
+			break;
+		case cjk_charset::gb18030:
+			if(len == 2)
+				c = plane_lookup(gb18030_plane, b, t);
+			else{
+				uint b3 = to_uint(by[2]), b4 = to_uint(by[3]);
+				if(b3 < 0x81 || b3 > 0xfe || b4 < 0x30 || b4 > 0x39)
+					return 0;
+				std::uint32_t lin = (((b - 0x81) * 10 + (t - 0x30)) * 126 + (b3 - 0x81)) * 10 + (b4 - 0x30);
+				if(lin < gb18030_bmp){
+					const gb18030_range *r = std::upper_bound(gb18030_ranges, gb18030_ranges + sizeof(gb18030_ranges) / sizeof(gb18030_range), lin,
+						[](std::uint32_t x, const gb18030_range &rg){return x < rg.linear;}) - 1;
+					c = r->chr + (lin - r->linear);
+				}
+				else if(lin >= gb18030_supp && lin - gb18030_supp < 0x100000)
+					c = 0x10000 + (lin - gb18030_supp);
+				else
+					c = 0;
+			}
+			break;
+	}
+	return c == 0 ? 0 : static_cast<int>(len);
+}
+
+/*
+    Reverse map of the two byte characters: index[c >> 8] is the page (increased by one) of
+    character c, pages contain the encoded characters (0 if the character isn't included).
+    A code lower than 0x100 is a single byte, in EUC-JP the codes of JIS X 0212 have the most
+    significant bit of the lead byte reset
+*/
+struct reverse_map{
+	std::uint16_t index[0x100];
+	std::vector<std::uint16_t> pages;
+
+	reverse_map() : index{}, pages{} {}
+
+	void add(std::uint32_t c, std::uint16_t code){
+		if(index[c >> 8] == 0){
+			pages.resize(pages.size() + 0x100, 0);
+			index[c >> 8] = static_cast<std::uint16_t>(pages.size() / 0x100);
+		}
+		pages[(index[c >> 8] - 1) * 0x100 + (c & 0xff)] = code;
+	}
+	void add_plane(const cjk_plane &p, std::uint16_t mask, bool gbk = false){
+		for(uint a = p.lead_first; a <= p.lead_last; a++){
+			for(uint b = p.trail_first; b <= p.trail_last; b++){
+				std::uint16_t c = plane_lookup(p, a, b);
+				if(c >= 0x80 && (!gbk || gbk_included(a, b)))
+					add(c, static_cast<std::uint16_t>(((a << 8) | b) & mask));
+			}
+		}
+	}
+	std::uint16_t find(std::uint32_t c) const noexcept{
+		if(c > 0xffff || index[c >> 8] == 0)
+			return 0;
+		return pages[(index[c >> 8] - 1) * 0x100 + (c & 0xff)];
+	}
+};
+
+template<cjk_charset cs>
+const reverse_map &reverse(){
+	static const reverse_map map = [](){
+		reverse_map ret{};
+		switch(cs){
+			case cjk_charset::shift_jis:
+				for(uint b = 0xa1; b <= 0xdf; b++)
+					ret.add(0xff61 + b - 0xa1, static_cast<std::uint16_t>(b));
+				ret.add_plane(sjis_plane, 0xffff);
+				break;
+			case cjk_charset::euc_jp:
+				for(uint b = 0xa1; b <= 0xdf; b++)
+					ret.add(0xff61 + b - 0xa1, static_cast<std::uint16_t>(0x8e00 | b));
+				ret.add_plane(jisx0212_plane, 0x7fff);
+				ret.add_plane(jisx0208_plane, 0xffff);
+				break;
+			case cjk_charset::euc_kr:
+				ret.add_plane(euckr_plane, 0xffff);
+				break;
+			case cjk_charset::big5:
+				ret.add_plane(big5_plane, 0xffff);
+				break;
+			case cjk_charset::gbk:
+				ret.add_plane(gb18030_plane, 0xffff, true);
+				break;
+			case cjk_charset::gb18030:
+				ret.add_plane(gb18030_plane, 0xffff);
+				break;
+		}
+		return ret;
+	}();
+	return map;
+}
+
+/*
+    Encodes a character in out (that has space for max_bytes bytes), returns its length or 0 if
+    the character isn't included in the encoding
+*/
+template<cjk_charset cs>
+uint encode_char(std::uint32_t c, byte *out){
+	if(c < 0x80){
+		out[0] = byte{static_cast<std::uint8_t>(c)};
+		return 1;
+	}
+	std::uint16_t code = reverse<cs>().find(c);
+	if(code != 0){
+		uint a = code >> 8, b = code & 0xff;
+		if(a == 0){
+			out[0] = byte{static_cast<std::uint8_t>(b)};
+			return 1;
+		}
+		if(cs == cjk_charset::euc_jp && a < 0x80){
+			out[0] = byte{0x8f};
+			out[1] = byte{static_cast<std::uint8_t>(a | 0x80)};
+			out[2] = byte{static_cast<std::uint8_t>(b)};
+			return 3;
+		}
+		out[0] = byte{static_cast<std::uint8_t>(a)};
+		out[1] = byte{static_cast<std::uint8_t>(b)};
+		return 2;
+	}
+	if(cs != cjk_charset::gb18030 || c > 0x10ffff || (c >= 0xd800 && c < 0xe000))
+		return 0;
+	std::uint32_t lin;
+	if(c >= 0x10000)
+		lin = gb18030_supp + (c - 0x10000);
+	else{
+		const size_t n = sizeof(gb18030_ranges) / sizeof(gb18030_range);
+		const gb18030_range *r = std::upper_bound(gb18030_ranges, gb18030_ranges + n, c,
+			[](std::uint32_t x, const gb18030_range &rg){return x < rg.chr;});
+		if(r == gb18030_ranges)
+			return 0;
+		std::uint32_t end = r == gb18030_ranges + n ? gb18030_bmp : r->linear;
+		r--;
+		//c must be inside the range, otherwise it's a two byte character
+		if(c - r->chr >= end - r->linear)
+			return 0;
+		lin = r->linear + (c - r->chr);
+	}
+	out[3] = byte{static_cast<std::uint8_t>(0x30 + lin % 10)};
+	lin /= 10;
+	out[2] = byte{static_cast<std::uint8_t>(0x81 + lin % 126)};
+	lin /= 126;
+	out[1] = byte{static_cast<std::uint8_t>(0x30 + lin % 10)};
+	out[0] = byte{static_cast<std::uint8_t>(0x81 + lin / 10)};
+	return 4;
+}
+
+uint put_utf8(std::uint32_t c, byte *out) noexcept{
+	if(c < 0x80){
+		out[0] = byte{static_cast<std::uint8_t>(c)};
+		return 1;
+	}
+	if(c < 0x800){
+		out[0] = byte{static_cast<std::uint8_t>(0xc0 | (c >> 6))};
+		out[1] = byte{static_cast<std::uint8_t>(0x80 | (c & 0x3f))};
+		return 2;
+	}
+	if(c < 0x10000){
+		out[0] = byte{static_cast<std::uint8_t>(0xe0 | (c >> 12))};
+		out[1] = byte{static_cast<std::uint8_t>(0x80 | ((c >> 6) & 0x3f))};
+		out[2] = byte{static_cast<std::uint8_t>(0x80 | (c & 0x3f))};
+		return 3;
+	}
+	out[0] = byte{static_cast<std::uint8_t>(0xf0 | (c >> 18))};
+	out[1] = byte{static_cast<std::uint8_t>(0x80 | ((c >> 12) & 0x3f))};
+	out[2] = byte{static_cast<std::uint8_t>(0x80 | ((c >> 6) & 0x3f))};
+	out[3] = byte{static_cast<std::uint8_t>(0x80 | (c & 0x3f))};
+	return 4;
+}
+
+void put_unit(std::uint32_t u, byte *out, bool be) noexcept{
+	out[be ? 0 : 1] = byte{static_cast<std::uint8_t>(u >> 8)};
+	out[be ? 1 : 0] = byte{static_cast<std::uint8_t>(u & 0xff)};
+}
+
+uint get_unit(const byte *in, bool be) noexcept{
+	return (to_uint(in[be ? 0 : 1]) << 8) | to_uint(in[be ? 1 : 0]);
+}
+
+uint put_utf16(std::uint32_t c, byte *out, bool be) noexcept{
+	if(c < 0x10000){
+		put_unit(c, out, be);
+		return 2;
+	}
+	c -= 0x10000;
+	put_unit(0xd800 | (c >> 10), out, be);
+	put_unit(0xdc00 | (c & 0x3ff), out + 2, be);
+	return 4;
+}
+
+/*
+    Number of leading UTF16 code units that are ASCII characters, tested 4 at a time
+*/
+size_t ascii_units(const byte *in, size_t l, bool be) noexcept{
+	const std::uint8_t mbe[8] = {0xff, 0x80, 0xff, 0x80, 0xff, 0x80, 0xff, 0x80};
+	const std::uint8_t mle[8] = {0x80, 0xff, 0x80, 0xff, 0x80, 0xff, 0x80, 0xff};
+	const std::uint64_t mask = swar_load(reinterpret_cast<const byte *>(be ? mbe : mle));
+	size_t i = 0;
+	while(i + 8 <= l && (swar_load(in + i) & mask) == 0)
+		i += 8;
+	while(i + 2 <= l && get_unit(in + i, be) < 0x80)
+		i += 2;
+	return i / 2;
+}
+
+template<cjk_charset cs>
+size_t to_utf(const byte *in, size_t l, byte *out, uint unit, bool be, size_t &nchr){
+	size_t pos = 0, w = 0;
+	nchr = 0;
+	while(pos < l){
+		//a byte lower than 0x80 at the start of a character is always an ASCII character
+		size_t a = ascii_prefix(in + pos, l - pos);
+		if(unit == 1)
+			std::memcpy(out + w, in + pos, a);
+		else{
+			for(size_t i = 0; i < a; i++)
+				put_unit(to_uint(in[pos + i]), out + w + 2 * i, be);
+		}
+		pos += a;
+		w += a * unit;
+		nchr += a;
+		if(pos == l)
+			break;
+		std::uint32_t c;
+		int r = decode_char<cs>(in + pos, l - pos, c);
+		if(r <= 0)
+			throw encoding_error{"Invalid character"};
+		w += unit == 1 ? put_utf8(c, out + w) : put_utf16(c, out + w, be);
+		pos += r;
+		nchr++;
+	}
+	return w;
+}
+
+template<cjk_charset cs>
+size_t from_utf(const byte *in, size_t l, uint unit, bool be, byte *out, size_t &nchr){
+	size_t pos = 0, w = 0;
+	nchr = 0;
+	while(pos < l){
+		std::uint32_t c;
+		if(unit == 1){
+			size_t a = ascii_prefix(in + pos, l - pos);
+			std::memcpy(out + w, in + pos, a);
+			pos += a;
+			w += a;
+			nchr += a;
+			if(pos == l)
+				break;
+			unicode u;
+			uint rd;
+			if(!UTF8::decode_checked(&u, in + pos, l - pos, rd))
+				throw encoding_error{"Invalid utf8 character"};
+			c = u;
+			pos += rd;
+		}
+		else{
+			size_t a = ascii_units(in + pos, l - pos, be);
+			for(size_t i = 0; i < a; i++)
+				out[w + i] = in[pos + 2 * i + (be ? 1 : 0)];
+			pos += 2 * a;
+			w += a;
+			nchr += a;
+			if(pos == l)
+				break;
+			if(l - pos < 2)
+				throw encoding_error{"Invalid utf16 character"};
+			c = get_unit(in + pos, be);
+			pos += 2;
+			if(c >= 0xd800 && c < 0xdc00){
+				uint lo = l - pos >= 2 ? get_unit(in + pos, be) : 0;
+				if(lo < 0xdc00 || lo >= 0xe000)
+					throw encoding_error{"Invalid utf16 character"};
+				c = 0x10000 + ((c - 0xd800) << 10) + (lo - 0xdc00);
+				pos += 2;
+			}
+			else if(c >= 0xdc00 && c < 0xe000)
+				throw encoding_error{"Invalid utf16 character"};
+		}
+		uint n = encode_char<cs>(c, out + w);
+		if(n == 0)
+			throw encoding_error{"Character not included in this encoding"};
+		w += n;
+		nchr++;
+	}
+	return w;
+}
+
+}
+
+template<cjk_charset cs>
+uint CJK<cs>::chLen(const byte *by){
+	if(cs == cjk_charset::shift_jis && to_uint(by[0]) >= 0xa1 && to_uint(by[0]) <= 0xdf)
+		return 1;
+	return lead_length(cs, by);
+}
+
+template<cjk_charset cs>
+bool CJK<cs>::validChar(const byte *by, uint &chlen) noexcept{
+	chlen = chLen(by);
+	std::uint32_t c;
+	return decode_char<cs>(by, chlen, c) > 0;
+}
+
+template<cjk_charset cs>
+uint CJK<cs>::decode(unicode *uni, const byte *by, size_t l){
+	if(l == 0)
+		throw buffer_small{1};
+	std::uint32_t c;
+	int r = decode_char<cs>(by, l, c);
+	if(r < 0)
+		throw buffer_small{static_cast<uint>(-r)};
+	if(r == 0)
+		throw encoding_error{"Invalid character"};
+	*uni = unicode{c};
+	return static_cast<uint>(r);
+}
+
+/*
+    A lead byte followed by an ASCII byte is invalid alone, since the ASCII byte starts the next
+    character. Otherwise the whole sequence is invalid
+*/
+template<cjk_charset cs>
+bool CJK<cs>::decode_checked(unicode *uni, const byte *by, size_t l, uint &len) noexcept{
+	if(l == 0){
+		len = 0;
+		return false;
+	}
+	std::uint32_t c;
+	int r = decode_char<cs>(by, l, c);
+	if(r > 0){
+		*uni = unicode{c};
+		len = static_cast<uint>(r);
+		return true;
+	}
+	len = 1;
+	if(r == 0 && l >= 2 && to_uint(by[1]) >= 0x80 && lead_length(cs, by) == 2)
+		len = 2;
+	else if(r < 0){
+		//truncated character, the digit of a GB18030 four byte character isn't a new character
+		len = static_cast<uint>(l);
+		for(size_t i = 1; i < l; i++){
+			bool digit = cs == cjk_charset::gb18030 && i == 1 && lead_length(cs, by) == 4;
+			if(to_uint(by[i]) < 0x80 && !digit){
+				len = 1;
+				break;
+			}
+		}
+	}
+	return false;
+}
+
+template<cjk_charset cs>
+bool CJK<cs>::encode_checked(const unicode &uni, byte *by, size_t l, uint &len){
+	byte tmp[4];
+	len = encode_char<cs>(uni, tmp);
+	if(len == 0)
+		return false;
+	if(l < len)
+		throw buffer_small{len};
+	std::memcpy(by, tmp, len);
+	return true;
+}
+
+template<cjk_charset cs>
+uint CJK<cs>::encode(const unicode &uni, byte *by, size_t l){
+	uint len;
+	if(!encode_checked(uni, by, l, len))
+		throw encoding_error("Character not included in this encoding");
+	return len;
+}
+
+size_t cjk_to_utf(cjk_charset cs, const byte *in, size_t l, byte *out, uint unit, bool be, size_t &nchr){
+	switch(cs){
+		case cjk_charset::shift_jis:
+			return to_utf<cjk_charset::shift_jis>(in, l, out, unit, be, nchr);
+		case cjk_charset::euc_jp:
+			return to_utf<cjk_charset::euc_jp>(in, l, out, unit, be, nchr);
+		case cjk_charset::gbk:
+			return to_utf<cjk_charset::gbk>(in, l, out, unit, be, nchr);
+		case cjk_charset::gb18030:
+			return to_utf<cjk_charset::gb18030>(in, l, out, unit, be, nchr);
+		case cjk_charset::big5:
+			return to_utf<cjk_charset::big5>(in, l, out, unit, be, nchr);
+		default:
+			return to_utf<cjk_charset::euc_kr>(in, l, out, unit, be, nchr);
+	}
+}
+
+size_t utf_to_cjk(cjk_charset cs, const byte *in, size_t l, uint unit, bool be, byte *out, size_t &nchr){
+	switch(cs){
+		case cjk_charset::shift_jis:
+			return from_utf<cjk_charset::shift_jis>(in, l, unit, be, out, nchr);
+		case cjk_charset::euc_jp:
+			return from_utf<cjk_charset::euc_jp>(in, l, unit, be, out, nchr);
+		case cjk_charset::gbk:
+			return from_utf<cjk_charset::gbk>(in, l, unit, be, out, nchr);
+		case cjk_charset::gb18030:
+			return from_utf<cjk_charset::gb18030>(in, l, unit, be, out, nchr);
+		case cjk_charset::big5:
+			return from_utf<cjk_charset::big5>(in, l, unit, be, out, nchr);
+		default:
+			return from_utf<cjk_charset::euc_kr>(in, l, unit, be, out, nchr);
+	}
+}
+
+template class CJK<cjk_charset::shift_jis>;
+template class CJK<cjk_charset::euc_jp>;
+template class CJK<cjk_charset::gbk>;
+template class CJK<cjk_charset::gb18030>;
+template class CJK<cjk_charset::big5>;
+template class CJK<cjk_charset::euc_kr>;
+
+}
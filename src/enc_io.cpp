@@ -14,7 +14,7 @@ size_t adv::stdin_getChrs(iochar_pt ptr, size_t len){
 			throw encoding_error{"IO error"};
 		eof = siz < (len - chrRead);//less character than required
 		while(siz > 0){
-			size_t dwsiz = ptr.chLen();
+			size_t dwsiz = ptr.chLen(siz);
 			if(dwsiz > siz){
 				ptr += siz;
 				//read half-character
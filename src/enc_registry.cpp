@@ -0,0 +1,273 @@
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+#include <encmetric/enc_registry.hpp>
+
+using namespace adv;
+
+namespace{
+
+struct builtin_encoding{
+	const char *name;
+	const EncMetric<unicode> *(*instance)() noexcept;
+};
+
+template<typename T>
+constexpr builtin_encoding entry(const char *name) noexcept{
+	return builtin_encoding{name, &DynEncoding<T>::instance};
+}
+
+/*
+    UTF-16 and UTF-32 without BOM are big endian (RFC 2781)
+*/
+constexpr builtin_encoding builtins[] = {
+	entry<UTF8>("UTF-8"), entry<UTF8>("UTF8"), entry<UTF8>("csUTF8"),
+	entry<UTF16<true>>("UTF-16BE"), entry<UTF16<true>>("csUTF16BE"),
+	entry<UTF16<false>>("UTF-16LE"), entry<UTF16<false>>("csUTF16LE"),
+	entry<UTF16<true>>("UTF-16"), entry<UTF16<true>>("csUTF16"),
+	entry<UTF32<true>>("UTF-32BE"), entry<UTF32<true>>("csUTF32BE"),
+	entry<UTF32<false>>("UTF-32LE"), entry<UTF32<false>>("csUTF32LE"),
+	entry<UTF32<true>>("UTF-32"), entry<UTF32<true>>("csUTF32"),
+	entry<ASCII>("US-ASCII"), entry<ASCII>("ASCII"), entry<ASCII>("iso-ir-6"), entry<ASCII>("ANSI_X3.4-1968"),
+	entry<ASCII>("ANSI_X3.4-1986"), entry<ASCII>("ISO_646.irv:1991"), entry<ASCII>("ISO646-US"),
+	entry<ASCII>("us"), entry<ASCII>("IBM367"), entry<ASCII>("cp367"), entry<ASCII>("csASCII"),
+	entry<Latin1>("ISO-8859-1"), entry<Latin1>("ISO_8859-1"), entry<Latin1>("ISO_8859-1:1987"),
+	entry<Latin1>("iso-ir-100"), entry<Latin1>("latin1"), entry<Latin1>("l1"), entry<Latin1>("IBM819"),
+	entry<Latin1>("CP819"), entry<Latin1>("csISOLatin1"),
+	entry<ISO_8859_2>("ISO-8859-2"), entry<ISO_8859_2>("ISO_8859-2"), entry<ISO_8859_2>("ISO_8859-2:1987"),
+	entry<ISO_8859_2>("iso-ir-101"), entry<ISO_8859_2>("latin2"), entry<ISO_8859_2>("l2"),
+	entry<ISO_8859_2>("csISOLatin2"),
+	entry<ISO_8859_3>("ISO-8859-3"), entry<ISO_8859_3>("ISO_8859-3"), entry<ISO_8859_3>("ISO_8859-3:1988"),
+	entry<ISO_8859_3>("iso-ir-109"), entry<ISO_8859_3>("latin3"), entry<ISO_8859_3>("l3"),
+	entry<ISO_8859_3>("csISOLatin3"),
+	entry<ISO_8859_4>("ISO-8859-4"), entry<ISO_8859_4>("ISO_8859-4"), entry<ISO_8859_4>("ISO_8859-4:1988"),
+	entry<ISO_8859_4>("iso-ir-110"), entry<ISO_8859_4>("latin4"), entry<ISO_8859_4>("l4"),
+	entry<ISO_8859_4>("csISOLatin4"),
+	entry<ISO_8859_5>("ISO-8859-5"), entry<ISO_8859_5>("ISO_8859-5"), entry<ISO_8859_5>("ISO_8859-5:1988"),
+	entry<ISO_8859_5>("iso-ir-144"), entry<ISO_8859_5>("cyrillic"), entry<ISO_8859_5>("csISOLatinCyrillic"),
+	entry<ISO_8859_6>("ISO-8859-6"), entry<ISO_8859_6>("ISO_8859-6"), entry<ISO_8859_6>("ISO_8859-6:1987"),
+	entry<ISO_8859_6>("iso-ir-127"), entry<ISO_8859_6>("ECMA-114"), entry<ISO_8859_6>("ASMO-708"),
+	entry<ISO_8859_6>("arabic"), entry<ISO_8859_6>("csISOLatinArabic"),
+	entry<ISO_8859_7>("ISO-8859-7"), entry<ISO_8859_7>("ISO_8859-7"), entry<ISO_8859_7>("ISO_8859-7:1987"),
+	entry<ISO_8859_7>("iso-ir-126"), entry<ISO_8859_7>("ELOT_928"), entry<ISO_8859_7>("ECMA-118"),
+	entry<ISO_8859_7>("greek"), entry<ISO_8859_7>("greek8"), entry<ISO_8859_7>("csISOLatinGreek"),
+	entry<ISO_8859_8>("ISO-8859-8"), entry<ISO_8859_8>("ISO_8859-8"), entry<ISO_8859_8>("ISO_8859-8:1988"),
+	entry<ISO_8859_8>("iso-ir-138"), entry<ISO_8859_8>("hebrew"), entry<ISO_8859_8>("csISOLatinHebrew"),
+	entry<ISO_8859_9>("ISO-8859-9"), entry<ISO_8859_9>("ISO_8859-9"), entry<ISO_8859_9>("ISO_8859-9:1989"),
+	entry<ISO_8859_9>("iso-ir-148"), entry<ISO_8859_9>("latin5"), entry<ISO_8859_9>("l5"),
+	entry<ISO_8859_9>("csISOLatin5"),
+	entry<ISO_8859_10>("ISO-8859-10"), entry<ISO_8859_10>("ISO_8859-10:1992"), entry<ISO_8859_10>("iso-ir-157"),
+	entry<ISO_8859_10>("latin6"), entry<ISO_8859_10>("l6"), entry<ISO_8859_10>("csISOLatin6"),
+	entry<ISO_8859_11>("ISO-8859-11"), entry<ISO_8859_11>("csISO885911"),
+	entry<ISO_8859_13>("ISO-8859-13"), entry<ISO_8859_13>("csISO885913"),
+	entry<ISO_8859_14>("ISO-8859-14"), entry<ISO_8859_14>("ISO_8859-14"), entry<ISO_8859_14>("ISO_8859-14:1998"),
+	entry<ISO_8859_14>("iso-ir-199"), entry<ISO_8859_14>("iso-celtic"), entry<ISO_8859_14>("latin8"),
+	entry<ISO_8859_14>("l8"), entry<ISO_8859_14>("csISO885914"),
+	entry<ISO_8859_15>("ISO-8859-15"), entry<ISO_8859_15>("ISO_8859-15"), entry<ISO_8859_15>("Latin-9"),
+	entry<ISO_8859_15>("csISO885915"),
+	entry<ISO_8859_16>("ISO-8859-16"), entry<ISO_8859_16>("ISO_8859-16"), entry<ISO_8859_16>("ISO_8859-16:2001"),
+	entry<ISO_8859_16>("iso-ir-226"), entry<ISO_8859_16>("latin10"), entry<ISO_8859_16>("l10"),
+	entry<ISO_8859_16>("csISO885916"),
+	entry<Win_874>("windows-874"), entry<Win_874>("cp874"), entry<Win_874>("cswindows874"),
+	entry<Win_1250>("windows-1250"), entry<Win_1250>("cp1250"), entry<Win_1250>("cswindows1250"),
+	entry<Win_1251>("windows-1251"), entry<Win_1251>("cp1251"), entry<Win_1251>("cswindows1251"),
+	entry<Win_1252>("windows-1252"), entry<Win_1252>("cp1252"), entry<Win_1252>("cswindows1252"),
+	entry<Win_1253>("windows-1253"), entry<Win_1253>("cp1253"), entry<Win_1253>("cswindows1253"),
+	entry<Win_1254>("windows-1254"), entry<Win_1254>("cp1254"), entry<Win_1254>("cswindows1254"),
+	entry<Win_1255>("windows-1255"), entry<Win_1255>("cp1255"), entry<Win_1255>("cswindows1255"),
+	entry<Win_1256>("windows-1256"), entry<Win_1256>("cp1256"), entry<Win_1256>("cswindows1256"),
+	entry<Win_1257>("windows-1257"), entry<Win_1257>("cp1257"), entry<Win_1257>("cswindows1257"),
+	entry<Win_1258>("windows-1258"), entry<Win_1258>("cp1258"), entry<Win_1258>("cswindows1258"),
+	entry<KOI8_R>("KOI8-R"), entry<KOI8_R>("csKOI8R"), entry<KOI8_U>("KOI8-U"), entry<KOI8_U>("csKOI8U"),
+	entry<IBM_437>("IBM437"), entry<IBM_437>("cp437"), entry<IBM_437>("437"), entry<IBM_437>("csPC8CodePage437"),
+	entry<IBM_850>("IBM850"), entry<IBM_850>("cp850"), entry<IBM_850>("850"), entry<IBM_850>("csPC850Multilingual"),
+	entry<Shift_JIS>("Shift_JIS"), entry<Shift_JIS>("MS_Kanji"), entry<Shift_JIS>("csShiftJIS"),
+	entry<EUC_JP>("EUC-JP"), entry<EUC_JP>("Extended_UNIX_Code_Packed_Format_for_Japanese"), entry<EUC_JP>("csEUCPkdFmtJapanese"),
+	entry<GBK>("GBK"), entry<GBK>("CP936"), entry<GBK>("MS936"), entry<GBK>("windows-936"), entry<GBK>("csGBK"),
+	entry<GB18030>("GB18030"), entry<GB18030>("csGB18030"),
+	entry<Big5>("Big5"), entry<Big5>("csBig5"),
+	entry<EUC_KR>("EUC-KR"), entry<EUC_KR>("csEUCKR"),
+};
+
+constexpr size_t builtin_number = sizeof(builtins) / sizeof(builtin_encoding);
+
+constexpr char lower_ascii(char c) noexcept{
+	return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+constexpr size_t name_length(const char *c) noexcept{
+	size_t i = 0;
+	while(c[i] != '\0')
+		i++;
+	return i;
+}
+
+constexpr bool same_name(const char *a, size_t alen, const char *b, size_t blen) noexcept{
+	if(alen != blen)
+		return false;
+	for(size_t i = 0; i < alen; i++){
+		if(lower_ascii(a[i]) != lower_ascii(b[i]))
+			return false;
+	}
+	return true;
+}
+
+/*
+    FNV-1a of the lowercase name, followed by a final mixing step
+*/
+constexpr std::uint64_t name_hash(const char *c, size_t len, std::uint64_t seed) noexcept{
+	std::uint64_t h = 0xCBF29CE484222325ULL ^ seed;
+	for(size_t i = 0; i < len; i++){
+		h ^= static_cast<std::uint8_t>(lower_ascii(c[i]));
+		h *= 0x100000001B3ULL;
+	}
+	h ^= h >> 29;
+	h *= 0xBF58476D1CE4E5B9ULL;
+	return h ^ (h >> 32);
+}
+
+/*
+    Hash and displace: names are split in hash_buckets buckets by their hash with seed 0, then every
+    bucket gets its own seed such that all its names are stored in empty slots
+*/
+constexpr size_t hash_buckets = 64;
+constexpr size_t hash_slots = 512;
+constexpr std::uint8_t empty_slot = 0xFF;
+static_assert(builtin_number < hash_slots && builtin_number < empty_slot, "Too many built-in encodings");
+
+struct perfect_hash{
+	std::uint16_t seed[hash_buckets];
+	std::uint8_t slot[hash_slots];
+	bool valid;
+};
+
+constexpr size_t name_bucket(const char *name, size_t len) noexcept{
+	return name_hash(name, len, 0) % hash_buckets;
+}
+
+/*
+    Buckets with more names are placed first
+*/
+constexpr perfect_hash make_hash() noexcept{
+	perfect_hash ret{};
+	ret.valid = true;
+	for(size_t i = 0; i < hash_slots; i++)
+		ret.slot[i] = empty_slot;
+	size_t bsize[hash_buckets] = {};
+	for(size_t i = 0; i < builtin_number; i++)
+		bsize[name_bucket(builtins[i].name, name_length(builtins[i].name))]++;
+	for(size_t siz = builtin_number; siz > 0; siz--){
+		for(size_t b = 0; b < hash_buckets; b++){
+			if(bsize[b] != siz)
+				continue;
+			bool ok = false;
+			for(std::uint16_t seed = 1; seed < 0xFFFF && !ok; seed++){
+				size_t used[hash_slots] = {};
+				size_t n = 0;
+				ok = true;
+				for(size_t i = 0; i < builtin_number && ok; i++){
+					size_t len = name_length(builtins[i].name);
+					if(name_bucket(builtins[i].name, len) != b)
+						continue;
+					size_t s = name_hash(builtins[i].name, len, seed) % hash_slots;
+					for(size_t j = 0; j < n && ok; j++)
+						ok = used[j] != s;
+					ok = ok && ret.slot[s] == empty_slot;
+					used[n++] = s;
+				}
+				if(ok){
+					ret.seed[b] = seed;
+					for(size_t i = 0; i < builtin_number; i++){
+						size_t len = name_length(builtins[i].name);
+						if(name_bucket(builtins[i].name, len) == b)
+							ret.slot[name_hash(builtins[i].name, len, seed) % hash_slots] = static_cast<std::uint8_t>(i);
+					}
+				}
+			}
+			if(!ok)
+				ret.valid = false;
+		}
+	}
+	return ret;
+}
+
+constexpr perfect_hash builtin_hash = make_hash();
+static_assert(builtin_hash.valid, "Unable to build the perfect hash of the built-in encodings");
+
+struct user_encoding{
+	char name[max_encoding_name];
+	size_t len;
+	const EncMetric<unicode> *enc;
+};
+
+/*
+    Entries before user_number are never modified, registrations are serialized by user_mutex
+*/
+user_encoding user_table[max_user_encodings];
+std::atomic<size_t> user_number{0};
+std::mutex user_mutex;
+
+}
+
+const EncMetric<unicode> *adv::find_encoding(std::string_view name) noexcept{
+	std::uint16_t seed = builtin_hash.seed[name_bucket(name.data(), name.size())];
+	std::uint8_t s = empty_slot;
+	if(seed != 0)
+		s = builtin_hash.slot[name_hash(name.data(), name.size(), seed) % hash_slots];
+	if(s != empty_slot){
+		const builtin_encoding &b = builtins[s];
+		if(same_name(b.name, name_length(b.name), name.data(), name.size()))
+			return b.instance();
+	}
+	size_t n = user_number.load(std::memory_order_acquire);
+	for(size_t i = 0; i < n; i++){
+		if(same_name(user_table[i].name, user_table[i].len, name.data(), name.size()))
+			return user_table[i].enc;
+	}
+	return nullptr;
+}
+
+void adv::register_encoding(std::string_view name, const EncMetric<unicode> *enc){
+	if(name.size() == 0 || name.size() > max_encoding_name)
+		throw encoding_error{"Invalid encoding name"};
+	if(enc == nullptr)
+		throw encoding_error{"Null encoding"};
+	std::lock_guard<std::mutex> lock{user_mutex};
+	if(find_encoding(name) != nullptr)
+		throw encoding_error{"Encoding name already registered"};
+	size_t n = user_number.load(std::memory_order_relaxed);
+	if(n == max_user_encodings)
+		throw encoding_error{"Too many registered encodings"};
+	for(size_t i = 0; i < name.size(); i++)
+		user_table[n].name[i] = name[i];
+	user_table[n].len = name.size();
+	user_table[n].enc = enc;
+	user_number.store(n + 1, std::memory_order_release);
+}
+
+const EncMetric<unicode> *adv::detect_encoding(std::string_view name, adv_string_view<RAW<unicode>> data, size_t &bomlen){
+	const EncMetric<unicode> *ret = detect_bom(data, bomlen);
+	if(ret != nullptr)
+		return ret;
+	ret = find_encoding(name);
+	if(ret == nullptr)
+		throw encoding_error{"Unknown encoding"};
+	return ret;
+}
@@ -16,16 +16,59 @@
     You should have received a copy of the GNU Lesser General Public License
     along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
 */
+#include <cstdint>
 #include <encmetric/byte_tools.hpp>
 #include <encmetric/encoding.hpp>
 
 namespace adv{
 
+/*
+    Dense reverse map of a codepage: index[c >> 8] is the number (increased by one) of the page
+    containing the byte encoding character c, 0 if there isn't any. Pages contain 0 for
+    characters not included in the codepage
+*/
+template<std::size_t N>
+struct reverse_pages{
+	std::uint8_t index[0x100];
+	std::uint8_t value[N][0x100];
+};
+
+/*
+    Number of pages needed by the table of a codepage
+*/
+constexpr std::size_t count_reverse_pages(const unsigned int *table) noexcept{
+	bool used[0x100] = {};
+	std::size_t ret = 0;
+	for(int i=0; i<0x80; i++){
+		if(table[i] != 0 && table[i] < 0x10000 && !used[table[i] >> 8]){
+			used[table[i] >> 8] = true;
+			ret++;
+		}
+	}
+	return ret;
+}
+
+template<std::size_t N>
+constexpr reverse_pages<N> make_reverse_pages(const unsigned int *table) noexcept{
+	reverse_pages<N> ret{};
+	std::size_t n = 0;
+	for(int i=0; i<0x80; i++){
+		unsigned int c = table[i];
+		if(c == 0 || c >= 0x10000)
+			continue;
+		if(ret.index[c >> 8] == 0)
+			ret.index[c >> 8] = static_cast<std::uint8_t>(++n);
+		ret.value[ret.index[c >> 8] - 1][c & 0xFF] = static_cast<std::uint8_t>(i + 0x80);
+	}
+	return ret;
+}
+
 /*
     Base class for any single-byte ASCII extension
 
-    Enc is the class specialization, must have a public static array of unicode
-    member table for each character from 80 to FF
+    Enc is the class specialization, must have a public static constexpr array of unsigned int
+    member table for each character from 80 to FF, 0 for bytes not representing any character.
+    Codepages are usually generated by tools/gen_codepages.cmake
 */
 template<typename Enc>
 class ASCII_extension{
@@ -34,8 +77,12 @@ class ASCII_extension{
 		static constexpr uint unity() noexcept {return 1;}
 		static constexpr bool has_max() noexcept {return true;}
 		static constexpr uint max_bytes() noexcept {return 1;}
+		static constexpr bool ascii_compatible() noexcept {return true;}
 		static constexpr uint chLen(const byte *) {return 1;}
-		static bool validChar(const byte *, uint &chlen) noexcept {chlen=1; return true;}
+		static bool validChar(const byte *by, uint &chlen) noexcept{
+			chlen=1;
+			return bit_zero(*by, 7) || Enc::table[std::to_integer<int>(*by) - 0x80] != 0;
+		}
 		static uint decode(unicode *uni, const byte *by, size_t l){
 			if(l == 0)
 				throw buffer_small{};
@@ -44,32 +91,35 @@ class ASCII_extension{
 				return 1;
 			}
 			else{
-				int idx = std::to_integer<int>(by[0]);
-				idx -= 0x80;
-				*uni = unicode{Enc::table[idx]};
+				unsigned int c = Enc::table[std::to_integer<int>(by[0]) - 0x80];
+				if(c == 0)
+					throw incorrect_encoding{};
+				*uni = unicode{c};
 				return 1;
 			}
 		}
 		static uint encode(const unicode &uni, byte *by, size_t l){
+			uint len;
+			if(!encode_checked(uni, by, l, len))
+				throw encoding_error("Character not included in this encoding");
+			return len;
+		}
+		static bool encode_checked(const unicode &uni, byte *by, size_t l, uint &len){
 			if(l == 0)
 				throw buffer_small{};
+			len = 1;
 			if(uni < 0x80){
 				*by = byte{static_cast<uint8_t>(uni)};
-				return 1;
-			}
-			else{
-				int idx = -1;
-				for(int i=0; i < 0x80; i++){
-					if(Enc::table[i] == uni){
-						idx = i;
-						break;
-					}
-				}
-				if(idx == -1)
-					throw encoding_error("Character not included in this encoding");
-				*by = byte{static_cast<uint8_t>(idx + 0x80)};
-				return 1;
+				return true;
 			}
+			static constexpr auto rev = make_reverse_pages<count_reverse_pages(Enc::table)>(Enc::table);
+			if(uni >= 0x10000 || rev.index[uni >> 8] == 0)
+				return false;
+			std::uint8_t v = rev.value[rev.index[uni >> 8] - 1][uni & 0xFF];
+			if(v == 0)
+				return false;
+			*by = byte{v};
+			return true;
 		}
 };
 
@@ -0,0 +1,247 @@
+#pragma once
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+    Asynchronous IO on generic file descriptors.
+
+    An io_loop multiplexes many file descriptors on a single thread. With io_uring, readers and
+    writers submit their reads and writes to the ring, and the reader buffer is registered as a fixed
+    buffer when the kernel allows it (see io_poller). Otherwise the file descriptors are put in
+    non-blocking mode and epoll tells when to call read and write. Readers and writers never split
+    characters: a read completes only with whole characters, the bytes of a partial character stay in
+    the reader buffer until the rest arrives.
+
+    Not available on Windows: io_loop construction throws encoding_error.
+
+    Operations accept a completion handler. When coroutines are available they can also be awaited:
+        adv_string_view<UTF8> str = co_await reader.read_chars(100);
+*/
+#include <functional>
+#include <exception>
+#include <unordered_map>
+#include <vector>
+#include <deque>
+#include <optional>
+#include <encmetric/enc_string.hpp>
+#include <encmetric/enc_io_core.hpp>
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#define ENCMETRIC_COROUTINES
+#endif
+
+namespace adv{
+
+class io_loop{
+	private:
+		struct watch{
+			std::function<void()> on_read;
+			std::function<void()> on_write;
+			bool armed_read;
+			bool armed_write;
+		};
+		io_poller poller;
+		std::unordered_map<int, watch> watches;
+		std::unordered_map<std::uint64_t, std::function<void(std::ptrdiff_t)>> ops;
+		std::uint64_t next_tag;
+		std::deque<std::function<void()>> posted;
+		size_t waiting;
+
+		void update(int fd);
+		std::uint64_t add_op(std::function<void(std::ptrdiff_t)>);
+	public:
+		explicit io_loop(bool try_uring = true) : poller{try_uring}, watches{}, ops{}, next_tag{0}, posted{}, waiting{0} {}
+		io_loop(const io_loop &) = delete;
+		io_loop &operator=(const io_loop &) = delete;
+
+		/*
+		    Calls the handler once when fd becomes readable (writable). At most one handler for each
+		    direction can be registered on a file descriptor
+		*/
+		void wait_readable(int fd, std::function<void()>);
+		void wait_writable(int fd, std::function<void()>);
+		/*
+		    Removes the registered handlers without calling them, submitted reads and writes aren't cancelled
+		*/
+		void cancel(int fd);
+		/*
+		    Reads (writes) at most siz bytes with io_uring, only if direct_io() is true. The handler
+		    receives the number of transferred bytes (0 at end of file), io_would_block if fd is non-blocking
+		    and not ready, or -1 on error. Memory must stay valid until the handler is called
+		*/
+		void read_some(int fd, byte *, size_t siz, std::function<void(std::ptrdiff_t)>);
+		void write_some(int fd, const byte *, size_t siz, std::function<void(std::ptrdiff_t)>);
+		bool direct_io() const noexcept {return poller.uses_uring();}
+		/*
+		    Registers memory used by read_some and write_some as a fixed buffer, returns false if it
+		    can't be registered (operations on it work anyway)
+		*/
+		bool register_buffer(byte *b, size_t siz) {return poller.register_buffer(b, siz);}
+		void unregister_buffer(byte *b) {poller.unregister_buffer(b);}
+		/*
+		    Calls the handler from the loop
+		*/
+		void post(std::function<void()>);
+
+		/*
+		    Waits for events at most timeout_ms milliseconds (forever if negative), then runs the ready
+		    handlers. Returns the number of called handlers
+		*/
+		size_t run_once(int timeout_ms = -1);
+		/*
+		    Runs until there are no more pending handlers
+		*/
+		void run();
+		bool empty() const noexcept {return waiting == 0 && posted.empty();}
+		bool uses_uring() const noexcept {return poller.uses_uring();}
+};
+
+/*
+    Reads whole characters from a file descriptor, that is put in non-blocking mode if the loop
+    doesn't use io_uring. Returned views point into the reader buffer and are valid until the next read.
+
+    Only one read can be pending at a time, both reader and loop must outlive it.
+*/
+template<typename T, typename U = std::allocator<byte>>
+class async_reader{
+	public:
+		using handler = std::function<void(std::exception_ptr, const adv_string_view<T> &)>;
+	private:
+		io_loop &loop;
+		int fd;
+		EncMetric_info<T> ei;
+		basic_ptr<byte, U> buffer;
+		size_t beg, end;
+		size_t req;
+		bool eof;
+		bool busy;
+		bool fixed;
+		handler hnd;
+
+		size_t complete(size_t nchr, size_t &nbytes) const;
+		bool try_complete(size_t nchr, std::optional<adv_string_view<T>> &res);
+		void make_room();
+		bool fill();
+		void attempt();
+		void on_read(std::ptrdiff_t);
+		void finish(std::exception_ptr, const adv_string_view<T> &);
+	public:
+		explicit async_reader(io_loop &l, int f, size_t bufsiz = 4096, EncMetric_info<T> format = EncMetric_info<T>{}, const U &all = U{});
+		async_reader(const async_reader &) = delete;
+		async_reader &operator=(const async_reader &) = delete;
+		~async_reader();
+
+		/*
+		    Reads at least one and at most nchr characters (0 means all the available ones).
+		    At the end of the input the handler receives an empty view. The characters before an invalid
+		    one are returned normally, the error is reported by the read that starts from it
+		*/
+		void read_chars(size_t nchr, handler h);
+		bool pending() const noexcept {return busy;}
+		bool at_eof() const noexcept {return eof && beg == end;}
+		/*
+		    True if the buffer is registered as an io_uring fixed buffer
+		*/
+		bool fixed_buffer() const noexcept {return fixed;}
+		#ifdef ENCMETRIC_COROUTINES
+		class read_awaitable{
+			private:
+				async_reader &r;
+				size_t nchr;
+				std::exception_ptr err;
+				std::optional<adv_string_view<T>> res;
+			public:
+				read_awaitable(async_reader &rd, size_t n) : r{rd}, nchr{n}, err{}, res{} {}
+				bool await_ready(){
+					if(r.busy)
+						throw encoding_error{"Operation already pending"};
+					return r.try_complete(nchr, res);
+				}
+				void await_suspend(std::coroutine_handle<> h){
+					r.read_chars(nchr, [this, h](std::exception_ptr e, const adv_string_view<T> &str){
+						err = e;
+						if(!e)
+							res.emplace(str);
+						h.resume();
+					});
+				}
+				adv_string_view<T> await_resume(){
+					if(err)
+						std::rethrow_exception(err);
+					return *res;
+				}
+		};
+		read_awaitable read_chars(size_t nchr) {return read_awaitable{*this, nchr};}
+		#endif
+};
+
+/*
+    Writes whole strings to a file descriptor, that is put in non-blocking mode if the loop doesn't use
+    io_uring. String data is not copied, so it must stay valid until the handler is called. Strings
+    in memory registered with io_loop::register_buffer are written with WRITE_FIXED.
+
+    Only one write can be pending at a time, both writer and loop must outlive it.
+*/
+template<typename T>
+class async_writer{
+	public:
+		using handler = std::function<void(std::exception_ptr)>;
+	private:
+		io_loop &loop;
+		int fd;
+		const byte *data;
+		size_t left;
+		bool busy;
+		handler hnd;
+
+		void attempt();
+		void on_write(std::ptrdiff_t);
+		void finish(std::exception_ptr);
+	public:
+		explicit async_writer(io_loop &l, int f);
+		async_writer(const async_writer &) = delete;
+		async_writer &operator=(const async_writer &) = delete;
+
+		void write_view(const adv_string_view<T> &, handler h);
+		bool pending() const noexcept {return busy;}
+		#ifdef ENCMETRIC_COROUTINES
+		class write_awaitable{
+			private:
+				async_writer &w;
+				adv_string_view<T> str;
+				std::exception_ptr err;
+			public:
+				write_awaitable(async_writer &wr, const adv_string_view<T> &s) : w{wr}, str{s}, err{} {}
+				bool await_ready() const noexcept {return str.size() == 0;}
+				void await_suspend(std::coroutine_handle<> h){
+					w.write_view(str, [this, h](std::exception_ptr e){
+						err = e;
+						h.resume();
+					});
+				}
+				void await_resume(){
+					if(err)
+						std::rethrow_exception(err);
+				}
+		};
+		write_awaitable write_view(const adv_string_view<T> &str) {return write_awaitable{*this, str};}
+		#endif
+};
+
+#include <encmetric/async_io.tpp>
+}
@@ -0,0 +1,238 @@
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+template<typename T, typename U>
+async_reader<T, U>::async_reader(io_loop &l, int f, size_t bufsiz, EncMetric_info<T> format, const U &all) : loop{l}, fd{f}, ei{format}, buffer{bufsiz == 0 ? 1 : bufsiz, all}, beg{0}, end{0}, req{0}, eof{false}, busy{false}, fixed{false}, hnd{} {
+	if(loop.direct_io())
+		fixed = loop.register_buffer(buffer.memory, buffer.dimension);
+	else
+		raw_fd_set_nonblocking(fd);
+}
+
+template<typename T, typename U>
+async_reader<T, U>::~async_reader(){
+	if(fixed)
+		loop.unregister_buffer(buffer.memory);
+}
+
+template<typename T, typename U>
+size_t async_reader<T, U>::complete(size_t nchr, size_t &nbytes) const{
+	size_t p = beg;
+	size_t n = 0;
+	while((nchr == 0 || n < nchr) && end - p >= ei.unity()){
+		uint chl = 0;
+		bool valid = true;
+		try{
+			chl = ei.chLen(buffer.memory + p, end - p);
+		}
+		catch(const encoding_error &){
+			valid = false;
+		}
+		if(valid && chl > end - p)
+			break;
+		uint l;
+		if(!valid || !ei.validChar(buffer.memory + p, l)){
+			//the valid characters before are returned first, the error is reported by the next read
+			if(n == 0)
+				throw encoding_error{"Invalid character"};
+			break;
+		}
+		p += chl;
+		n++;
+	}
+	nbytes = p - beg;
+	return n;
+}
+
+/*
+    Moves the unread data at the beginning of the buffer, then grows it if it's full
+*/
+template<typename T, typename U>
+void async_reader<T, U>::make_room(){
+	if(beg > 0){
+		std::memmove(buffer.memory, buffer.memory + beg, end - beg);
+		end -= beg;
+		beg = 0;
+	}
+	if(end == buffer.dimension){
+		if(fixed){
+			loop.unregister_buffer(buffer.memory);
+			fixed = false;
+		}
+		buffer.exp_fit(end + 1);
+		fixed = loop.register_buffer(buffer.memory, buffer.dimension);
+	}
+}
+
+template<typename T, typename U>
+bool async_reader<T, U>::fill(){
+	make_room();
+	std::ptrdiff_t r = raw_fd_readbytes(fd, buffer.memory + end, buffer.dimension - end);
+	if(r > 0){
+		end += static_cast<size_t>(r);
+		return true;
+	}
+	if(r == 0){
+		eof = true;
+		return true;
+	}
+	if(raw_io_would_block())
+		return false;
+	throw encoding_error{"IO error"};
+}
+
+template<typename T, typename U>
+bool async_reader<T, U>::try_complete(size_t nchr, std::optional<adv_string_view<T>> &res){
+	while(true){
+		size_t nbytes;
+		size_t n = complete(nchr, nbytes);
+		if(n > 0 || eof){
+			if(n == 0 && beg != end)
+				throw encoding_error{"Incomplete character"};
+			res.emplace(adv_string_view<T>{n, nbytes, const_tchar_pt<T>{buffer.memory + beg, ei}});
+			beg += nbytes;
+			return true;
+		}
+		//with io_uring data is read only by attempt
+		if(loop.direct_io() || !fill())
+			return false;
+	}
+}
+
+template<typename T, typename U>
+void async_reader<T, U>::finish(std::exception_ptr err, const adv_string_view<T> &str){
+	handler h = std::move(hnd);
+	hnd = nullptr;
+	busy = false;
+	h(err, str);
+}
+
+template<typename T, typename U>
+void async_reader<T, U>::attempt(){
+	std::optional<adv_string_view<T>> res;
+	try{
+		if(!try_complete(req, res)){
+			if(loop.direct_io()){
+				make_room();
+				loop.read_some(fd, buffer.memory + end, buffer.dimension - end, [this](std::ptrdiff_t r) {on_read(r);});
+			}
+			else
+				loop.wait_readable(fd, [this]() {attempt();});
+			return;
+		}
+	}
+	catch(...){
+		finish(std::current_exception(), adv_string_view<T>{0, 0, const_tchar_pt<T>{buffer.memory + beg, ei}});
+		return;
+	}
+	finish(nullptr, *res);
+}
+
+template<typename T, typename U>
+void async_reader<T, U>::on_read(std::ptrdiff_t r){
+	if(r > 0)
+		end += static_cast<size_t>(r);
+	else if(r == 0)
+		eof = true;
+	else if(r == io_would_block){
+		//the file descriptor has been put in non-blocking mode by someone else
+		loop.wait_readable(fd, [this]() {attempt();});
+		return;
+	}
+	else{
+		finish(std::make_exception_ptr(encoding_error{"IO error"}), adv_string_view<T>{0, 0, const_tchar_pt<T>{buffer.memory + beg, ei}});
+		return;
+	}
+	attempt();
+}
+
+template<typename T, typename U>
+void async_reader<T, U>::read_chars(size_t nchr, handler h){
+	if(busy)
+		throw encoding_error{"Operation already pending"};
+	busy = true;
+	req = nchr;
+	hnd = std::move(h);
+	loop.post([this]() {attempt();});
+}
+
+template<typename T>
+async_writer<T>::async_writer(io_loop &l, int f) : loop{l}, fd{f}, data{nullptr}, left{0}, busy{false}, hnd{} {
+	if(!loop.direct_io())
+		raw_fd_set_nonblocking(fd);
+}
+
+template<typename T>
+void async_writer<T>::finish(std::exception_ptr err){
+	handler h = std::move(hnd);
+	hnd = nullptr;
+	busy = false;
+	h(err);
+}
+
+template<typename T>
+void async_writer<T>::on_write(std::ptrdiff_t r){
+	if(r > 0){
+		data += r;
+		left -= static_cast<size_t>(r);
+		attempt();
+	}
+	else if(r == io_would_block)
+		loop.wait_writable(fd, [this]() {attempt();});
+	else
+		finish(std::make_exception_ptr(encoding_error{"IO error"}));
+}
+
+template<typename T>
+void async_writer<T>::attempt(){
+	if(left > 0 && loop.direct_io()){
+		try{
+			loop.write_some(fd, data, left, [this](std::ptrdiff_t r) {on_write(r);});
+		}
+		catch(...){
+			finish(std::current_exception());
+		}
+		return;
+	}
+	std::exception_ptr err;
+	while(left > 0){
+		std::ptrdiff_t r = raw_fd_writebytes(fd, data, left);
+		if(r > 0){
+			data += r;
+			left -= static_cast<size_t>(r);
+			continue;
+		}
+		if(r < 0 && raw_io_would_block()){
+			loop.wait_writable(fd, [this]() {attempt();});
+			return;
+		}
+		err = std::make_exception_ptr(encoding_error{"IO error"});
+		break;
+	}
+	finish(err);
+}
+
+template<typename T>
+void async_writer<T>::write_view(const adv_string_view<T> &str, handler h){
+	if(busy)
+		throw encoding_error{"Operation already pending"};
+	busy = true;
+	data = str.data();
+	left = str.size();
+	hnd = std::move(h);
+	loop.post([this]() {attempt();});
+}
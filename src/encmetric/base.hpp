@@ -33,6 +33,15 @@ inline unicode read_unicode(byte b){
 }
 
 inline constexpr unicode BOM{0xFEFF};
+inline constexpr unicode REPLACEMENT_CHARACTER{0xFFFD};
+
+/*
+    Characters with the Unicode White_Space property
+*/
+inline constexpr bool is_whitespace(unicode c) noexcept{
+	return (c >= 0x9 && c <= 0xD) || c == 0x20 || c == 0x85 || c == 0xA0 || c == 0x1680 ||
+		(c >= 0x2000 && c <= 0x200A) || c == 0x2028 || c == 0x2029 || c == 0x202F || c == 0x205F || c == 0x3000;
+}
 
 }
 
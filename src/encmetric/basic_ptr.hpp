@@ -18,6 +18,7 @@
 */
 #include <new>
 #include <memory>
+#include <encmetric/stats.hpp>
 
 namespace adv{
 
@@ -82,6 +83,8 @@ class basic_ptr_0{
 
 		void reallocate(std::size_t dim){
 			byte *newm = std::allocator_traits<U>::allocate(alloc, dim);
+			count_event(stat_event::buffer_growths);
+			count_event(stat_event::buffer_growth_bytes, dim);
 			int mindim = dim > dimension ? dimension : dim;
 			if(memory != nullptr)
 				std::memcpy(newm, memory, mindim);
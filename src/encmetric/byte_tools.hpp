@@ -20,6 +20,7 @@
     Some usebul bitwise operations using bitmasks that can be built at compile-time
 */
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <type_traits>
 #include <stdexcept>
@@ -38,6 +39,194 @@ inline bool compare(const byte *a, const byte *b, int nsiz) noexcept{
 	return std::memcmp(a, b, nsiz) == 0;
 }
 
+/*
+    Word at a time operations: 8 bytes are loaded in a 64-bit integer and tested together
+*/
+inline std::uint64_t swar_load(const byte *b) noexcept{
+	std::uint64_t ret;
+	std::memcpy(&ret, b, 8);
+	return ret;
+}
+
+inline constexpr std::uint64_t swar_broadcast(std::uint8_t b) noexcept{
+	return 0x0101010101010101ULL * b;
+}
+
+inline void swar_store(byte *b, std::uint64_t w) noexcept{
+	std::memcpy(b, &w, 8);
+}
+
+/*
+    Swaps the two bytes of every 2 bytes item (or reverses the four bytes of every 4 bytes item)
+    of a word, the result doesn't depend on the endianess of the machine
+*/
+inline constexpr std::uint64_t swar_bswap16(std::uint64_t w) noexcept{
+	return ((w >> 8) & 0x00FF00FF00FF00FFULL) | ((w & 0x00FF00FF00FF00FFULL) << 8);
+}
+
+inline constexpr std::uint64_t swar_bswap32(std::uint64_t w) noexcept{
+	w = swar_bswap16(w);
+	return ((w >> 16) & 0x0000FFFF0000FFFFULL) | ((w & 0x0000FFFF0000FFFFULL) << 16);
+}
+
+/*
+    Not zero if and only if w contains a zero byte
+*/
+inline constexpr std::uint64_t swar_haszero(std::uint64_t w) noexcept{
+	return (w - 0x0101010101010101ULL) & ~w & 0x8080808080808080ULL;
+}
+
+/*
+    Not zero if and only if w contains a byte not lower than 0x80
+*/
+inline constexpr std::uint64_t swar_hashigh(std::uint64_t w) noexcept{
+	return w & 0x8080808080808080ULL;
+}
+
+/*
+    Word with the value v in every item of u bytes (u is 1, 2 or 4). Items of more bytes are
+    compared by value, so words must be loaded with the byte order of the machine
+*/
+inline constexpr std::uint64_t swar_lanes(std::uint64_t v, unsigned int u) noexcept{
+	return v * (u == 1 ? 0x0101010101010101ULL : (u == 2 ? 0x0001000100010001ULL : 0x0000000100000001ULL));
+}
+
+/*
+    Not zero if and only if an item of u bytes of w is lower than n, n must not be greater than
+    the highest bit of an item
+*/
+inline constexpr std::uint64_t swar_hasless(std::uint64_t w, std::uint64_t n, unsigned int u) noexcept{
+	return (w - swar_lanes(n, u)) & ~w & swar_lanes(std::uint64_t{0x80} << (8 * u - 8), u);
+}
+
+/*
+    Not zero if and only if an item of u bytes of w is equal to c
+*/
+inline constexpr std::uint64_t swar_haseq(std::uint64_t w, std::uint64_t c, unsigned int u) noexcept{
+	return swar_hasless(w ^ swar_lanes(c, u), 1, u);
+}
+
+inline bool host_little_endian() noexcept{
+	const byte b[8] = {byte{1}};
+	return swar_load(b) == 1;
+}
+
+inline constexpr std::uint64_t swar_bswap64(std::uint64_t w) noexcept{
+	w = swar_bswap32(w);
+	return (w >> 32) | (w << 32);
+}
+
+/*
+    Like swar_load and swar_store, but the first byte is always the least significant one
+*/
+inline std::uint64_t swar_load_le(const byte *b) noexcept{
+	std::uint64_t w = swar_load(b);
+	return host_little_endian() ? w : swar_bswap64(w);
+}
+
+inline void swar_store_le(byte *b, std::uint64_t w) noexcept{
+	swar_store(b, host_little_endian() ? w : swar_bswap64(w));
+}
+
+/*
+    Sets the highest bit of the bytes of w in [lo, hi) and clears the other bits, every byte of w
+    must be lower than 0x80 and lo <= hi <= 0x80
+*/
+inline constexpr std::uint64_t swar_inrange(std::uint64_t w, std::uint8_t lo, std::uint8_t hi) noexcept{
+	return (w + swar_broadcast(0x80 - lo)) & ~(w + swar_broadcast(0x80 - hi)) & 0x8080808080808080ULL;
+}
+
+/*
+    Sets the highest bit of the bytes of w equal to c and clears the other bits
+*/
+inline constexpr std::uint64_t swar_eqmask(std::uint64_t w, std::uint8_t c) noexcept{
+	std::uint64_t x = w ^ swar_broadcast(c);
+	return ~(((x & 0x7F7F7F7F7F7F7F7FULL) + 0x7F7F7F7F7F7F7F7FULL) | x) & 0x8080808080808080ULL;
+}
+
+/*
+    Number of bytes of m with the highest bit set, the other bits must be clear
+*/
+inline constexpr uint swar_count(std::uint64_t m) noexcept{
+	return static_cast<uint>(((m >> 7) * 0x0101010101010101ULL) >> 56);
+}
+
+/*
+    Converts the ASCII uppercase letters of w to lowercase, every byte of w must be lower than 0x80
+*/
+inline constexpr std::uint64_t swar_ascii_lower(std::uint64_t w) noexcept{
+	std::uint64_t ge_a = w + swar_broadcast(0x80 - 'A');
+	std::uint64_t gt_z = w + swar_broadcast(0x80 - 'Z' - 1);
+	return w | (((ge_a ^ gt_z) & 0x8080808080808080ULL) >> 2);
+}
+
+/*
+    Number of leading bytes lower than 0x80, tested 8 bytes at a time
+*/
+inline std::size_t ascii_prefix(const byte *b, std::size_t nsiz) noexcept{
+	std::size_t i = 0;
+	while(i + 8 <= nsiz && swar_hashigh(swar_load(b + i)) == 0)
+		i += 8;
+	while(i < nsiz && std::to_integer<std::uint8_t>(b[i]) < 0x80)
+		i++;
+	return i;
+}
+
+/*
+    Copies in out the leading ASCII digits of n units of u bytes (2 or 4), where every digit is
+    stored in the byte at position pos and the other bytes are zero (as in UTF16 and UTF32).
+    8 bytes are tested at a time, returns the number of copied digits
+*/
+inline std::size_t widened_digits(const byte *b, std::size_t n, unsigned int u, unsigned int pos, char *out) noexcept{
+	byte zb[8]{};
+	for(unsigned int i = 0; i < 8; i++){
+		if(i % u != pos)
+			zb[i] = byte{0xff};
+	}
+	const std::uint64_t zero_mask = swar_load(zb);
+	const std::uint64_t fill = zero_mask & swar_broadcast('0');
+	const std::size_t per = 8 / u;
+	std::size_t i = 0;
+	while(i + per <= n){
+		std::uint64_t w = swar_load(b + i * u);
+		if((w & zero_mask) != 0)
+			break;
+		//the zero bytes become '0', then every byte must be in '0'-'9'
+		w |= fill;
+		if(swar_hashigh(w | (w + swar_broadcast(0x80 - ':')) | (w - swar_broadcast('0'))) != 0)
+			break;
+		for(std::size_t j = 0; j < per; j++)
+			out[i + j] = static_cast<char>(b[(i + j) * u + pos]);
+		i += per;
+	}
+	while(i < n){
+		const byte *c = b + i * u;
+		for(unsigned int j = 0; j < u; j++){
+			if(j != pos && c[j] != byte{0})
+				return i;
+		}
+		if(c[pos] < byte{'0'} || c[pos] > byte{'9'})
+			return i;
+		out[i++] = static_cast<char>(c[pos]);
+	}
+	return i;
+}
+
+/*
+    Number of leading bytes shared by a and b, tested 8 bytes at a time
+*/
+inline std::size_t common_prefix(const byte *a, const byte *b, std::size_t nsiz) noexcept{
+	std::size_t i = 0;
+	while(i + 8 <= nsiz){
+		if(swar_load(a + i) != swar_load(b + i))
+			break;
+		i += 8;
+	}
+	while(i < nsiz && a[i] == b[i])
+		i++;
+	return i;
+}
+
 /*
     Create a bit mask of type RET with ones at positions oth.
 
@@ -0,0 +1,102 @@
+#pragma once
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+    Unicode case mapping and caseless matching of strings with Unicode characters.
+
+    The character data is generated by tools/gen_case.py and contains the language independent
+    mappings. Full mappings can map a character into more than one character (for example U+00DF
+    is folded to "ss"), simple mappings always map a character into a single character.
+*/
+#include <encmetric/enc_string.hpp>
+
+namespace adv{
+
+/*
+    Maximum number of characters of a full mapping
+*/
+inline constexpr size_t max_case_mapping = 3;
+
+unicode simple_lower(unicode) noexcept;
+unicode simple_upper(unicode) noexcept;
+unicode simple_fold(unicode) noexcept;
+/*
+    Full mappings, out must have space for max_case_mapping characters. Return the number of
+    characters written
+*/
+size_t full_lower(unicode, unicode *out) noexcept;
+size_t full_upper(unicode, unicode *out) noexcept;
+size_t full_fold(unicode, unicode *out) noexcept;
+/*
+    Cased and Case_Ignorable properties
+*/
+bool is_cased(unicode) noexcept;
+bool is_case_ignorable(unicode) noexcept;
+
+/*
+    Reads the full case folding of a string one character at a time
+*/
+template<typename T>
+class fold_reader{
+	private:
+		const_tchar_pt<T> ptr;
+		size_t rem;
+		unicode buf[max_case_mapping];
+		uint n, i;
+	public:
+		fold_reader(const_tchar_pt<T> p, size_t siz) noexcept : ptr{p}, rem{siz}, n{0}, i{0} {}
+		/*
+		    Sets the next folded character, returns false at the end of the string
+		*/
+		bool next(unicode &);
+		/*
+		    True if all the characters obtained from the last read character have been returned
+		*/
+		bool at_boundary() const noexcept {return i == n;}
+};
+
+/*
+    Full case mappings, the result has the same encoding of the argument.
+    to_lower handles the final form of the Greek capital letter sigma
+*/
+template<typename T, typename U = std::allocator<byte>>
+adv_string<T, U> to_lower(const adv_string_view<T> &, const U & = U{});
+template<typename T, typename U = std::allocator<byte>>
+adv_string<T, U> to_upper(const adv_string_view<T> &, const U & = U{});
+template<typename T, typename U = std::allocator<byte>>
+adv_string<T, U> fold(const adv_string_view<T> &, const U & = U{});
+
+/*
+    Caseless comparison of two strings (with the same ctype), compares their full case foldings
+    without allocating them. ASCII runs of strings with the same encoding are compared 8 bytes at a
+    time if ASCII characters are whole code units (UTF8, Latin1, UTF16, UTF32)
+*/
+template<typename T, typename S>
+int compare_icase(const adv_string_view<T> &, const adv_string_view<S> &);
+template<typename T, typename S>
+bool equals_icase(const adv_string_view<T> &a, const adv_string_view<S> &b) {return compare_icase(a, b) == 0;}
+/*
+    Index of the first character of str where a caseless match of sq starts. The match must end at
+    a character boundary of str.
+    Note: if found is false then can return anything
+*/
+template<typename T, typename S>
+size_t indexOf_icase(const adv_string_view<T> &str, const adv_string_view<S> &sq, bool &found);
+
+#include <encmetric/case_mapping.tpp>
+}
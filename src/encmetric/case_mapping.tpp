@@ -0,0 +1,199 @@
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+template<typename T>
+bool fold_reader<T>::next(unicode &c){
+	if(i == n){
+		if(rem == 0)
+			return false;
+		unicode dec;
+		uint l = ptr.decode(&dec, rem);
+		ptr += l;
+		rem -= l;
+		i = 0;
+		if(dec < 0x80){
+			buf[0] = (dec >= 'A' && dec <= 'Z') ? unicode{dec + 0x20} : dec;
+			n = 1;
+		}
+		else
+			n = static_cast<uint>(full_fold(dec, buf));
+	}
+	c = buf[i++];
+	return true;
+}
+
+/*
+    True if the characters after the iterator, ignoring the case ignorable ones, don't start
+    with a cased character
+*/
+template<typename T>
+bool final_sigma_follows(code_point_iterator<T> it, const code_point_iterator<T> &end){
+	for(++it; it != end; ++it){
+		unicode c = *it;
+		if(!is_case_ignorable(c))
+			return !is_cased(c);
+	}
+	return true;
+}
+
+/*
+    If every ASCII character of the encoding is a whole code unit (ASCII compatible encodings with unity 1,
+    UTF16 and UTF32) sets in high the bits that must be zero in 8 bytes of ASCII characters, in fill the
+    bytes that are always zero in them. Otherwise returns false
+*/
+template<typename F>
+bool ascii_word_masks(const F &f, std::uint64_t &high, std::uint64_t &fill) noexcept{
+	uint pos = 0;
+	if(!(f.unity() == 1 && f.ascii_compatible()) && !ascii_widened(f, pos))
+		return false;
+	uint u = f.unity();
+	byte h[8], z[8];
+	for(uint i=0; i<8; i++){
+		h[i] = i % u == pos ? byte{0x80} : byte{0xff};
+		z[i] = i % u == pos ? byte{0} : byte{0xff};
+	}
+	high = swar_load(h);
+	fill = swar_load(z);
+	return true;
+}
+
+/*
+    Appends the mapping of every character of str to buf, F is the full mapping function
+*/
+template<typename T, typename U, typename F>
+adv_string<T, U> case_map_string(const adv_string_view<T> &str, const U &alloc, F &&map, bool lower){
+	static_assert(std::is_same_v<typename T::ctype, unicode>, "Only Unicode strings");
+	adv_string_buf<T, U> buf{str.begin().raw_format(), alloc};
+	unicode out[max_case_mapping];
+	bool prev_cased = false;
+	code_point_range<T> cps = str.code_points();
+	for(auto it = cps.begin(); it != cps.end(); ++it){
+		unicode c = *it;
+		size_t n;
+		if(lower && c == 0x3A3 && prev_cased && final_sigma_follows(it, cps.end())){
+			out[0] = unicode{0x3C2};
+			n = 1;
+		}
+		else
+			n = map(c, out);
+		buf.append_ctypes(out, n);
+		if(!is_case_ignorable(c))
+			prev_cased = is_cased(c);
+	}
+	return buf.move();
+}
+
+template<typename T, typename U>
+adv_string<T, U> to_lower(const adv_string_view<T> &str, const U &alloc){
+	return case_map_string(str, alloc, full_lower, true);
+}
+
+template<typename T, typename U>
+adv_string<T, U> to_upper(const adv_string_view<T> &str, const U &alloc){
+	return case_map_string(str, alloc, full_upper, false);
+}
+
+template<typename T, typename U>
+adv_string<T, U> fold(const adv_string_view<T> &str, const U &alloc){
+	return case_map_string(str, alloc, full_fold, false);
+}
+
+template<typename T, typename S>
+int compare_icase(const adv_string_view<T> &a, const adv_string_view<S> &b){
+	static_assert(std::is_same_v<typename T::ctype, unicode> && std::is_same_v<typename S::ctype, unicode>, "Only Unicode strings");
+	size_t skip = 0;
+	const_tchar_pt<T> pa = a.begin();
+	std::uint64_t high, fill;
+	if(sameEnc(a, b) && ascii_word_masks(pa.raw_format(), high, fill)){
+		//compare 8 bytes of ASCII characters at a time, skip is always at a character boundary.
+		//The zero bytes of UTF16 and UTF32 units aren't changed by swar_ascii_lower
+		size_t m = a.size() < b.size() ? a.size() : b.size();
+		const byte *da = a.data();
+		const byte *db = b.data();
+		while(skip + 8 <= m){
+			std::uint64_t wa = swar_load(da + skip);
+			std::uint64_t wb = swar_load(db + skip);
+			if(((wa | wb) & high) != 0)
+				break;
+			if(swar_ascii_lower(wa) != swar_ascii_lower(wb))
+				break;
+			skip += 8;
+		}
+	}
+	fold_reader<T> ra{pa + skip, a.size() - skip};
+	fold_reader<S> rb{b.begin() + skip, b.size() - skip};
+	unicode ca, cb;
+	while(true){
+		bool ha = ra.next(ca);
+		bool hb = rb.next(cb);
+		if(!ha || !hb)
+			return ha ? 1 : (hb ? -1 : 0);
+		if(ca != cb)
+			return ca < cb ? -1 : 1;
+	}
+}
+
+template<typename T, typename S>
+size_t indexOf_icase(const adv_string_view<T> &str, const adv_string_view<S> &sq, bool &found){
+	static_assert(std::is_same_v<typename T::ctype, unicode> && std::is_same_v<typename S::ctype, unicode>, "Only Unicode strings");
+	found = false;
+	unicode first;
+	if(!fold_reader<S>{sq.begin(), sq.size()}.next(first)){
+		found = true;
+		return 0;
+	}
+	const_tchar_pt<T> ptr = str.begin();
+	std::uint64_t high = 0, fill = 0;
+	bool ascii_skip = first < 0x80 && ascii_word_masks(ptr.raw_format(), high, fill);
+	//the first character in every code unit, the other bytes of w ^ lo are set by fill
+	std::uint64_t lo = swar_broadcast(static_cast<std::uint8_t>(first)) & ~fill;
+	std::uint64_t up = (first >= 'a' && first <= 'z') ? swar_broadcast(static_cast<std::uint8_t>(first - 0x20)) & ~fill : lo;
+	size_t per = ascii_skip ? 8 / ptr.unity() : 0;
+	size_t byt = 0;
+	size_t chr = 0;
+	while(byt < str.size()){
+		if(ascii_skip){
+			//ASCII characters different from the first one can't start a match
+			while(byt + 8 <= str.size()){
+				std::uint64_t w = swar_load(str.data() + byt);
+				if((w & high) != 0 || swar_haszero((w ^ lo) | fill) != 0 || swar_haszero((w ^ up) | fill) != 0)
+					break;
+				byt += 8;
+				chr += per;
+			}
+			if(byt == str.size())
+				break;
+		}
+		fold_reader<T> rs{ptr + byt, str.size() - byt};
+		fold_reader<S> rq{sq.begin(), sq.size()};
+		unicode cs, cq;
+		while(true){
+			if(!rq.next(cq)){
+				if(rs.at_boundary()){
+					found = true;
+					return chr;
+				}
+				break;
+			}
+			if(!rs.next(cs) || cs != cq)
+				break;
+		}
+		byt += (ptr + byt).chLen();
+		chr++;
+	}
+	return 0;
+}
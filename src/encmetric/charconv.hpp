@@ -0,0 +1,74 @@
+#pragma once
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+    std::from_chars and std::to_chars on encoded strings with Unicode characters.
+
+    Numbers in ASCII compatible encodings are parsed in place by <charconv>. In the other encodings
+    the characters that can be part of a number are first copied as ASCII characters (8 bytes at
+    a time for the digits of UTF16 and UTF32) and then parsed.
+    to_chars appends the number to a buffer, widening it directly for UTF16 and UTF32.
+*/
+#include <string>
+#include <limits>
+#include <charconv>
+#include <algorithm>
+#include <type_traits>
+#include <encmetric/enc_string.hpp>
+
+namespace adv{
+
+/*
+    ptr points to the first character not parsed, it's the beginning of the string if no number
+    has been found (see std::from_chars)
+*/
+template<typename T>
+struct adv_from_chars_result{
+	const_tchar_pt<T> ptr;
+	std::errc ec;
+};
+
+template<typename T, typename I, std::enable_if_t<std::is_integral_v<I>, int> = 0>
+adv_from_chars_result<T> from_chars(const_tchar_pt<T> ptr, size_t siz, I &value, int base = 10);
+template<typename T, typename D, std::enable_if_t<std::is_floating_point_v<D>, int> = 0>
+adv_from_chars_result<T> from_chars(const_tchar_pt<T> ptr, size_t siz, D &value, std::chars_format fmt = std::chars_format::general);
+
+template<typename T, typename I, std::enable_if_t<std::is_integral_v<I>, int> = 0>
+adv_from_chars_result<T> from_chars(const adv_string_view<T> &str, I &value, int base = 10){
+	return from_chars(str.begin(), str.size(), value, base);
+}
+template<typename T, typename D, std::enable_if_t<std::is_floating_point_v<D>, int> = 0>
+adv_from_chars_result<T> from_chars(const adv_string_view<T> &str, D &value, std::chars_format fmt = std::chars_format::general){
+	return from_chars(str.begin(), str.size(), value, fmt);
+}
+
+/*
+    Append value to buf, return the number of bytes appended. Without a format floating point
+    numbers are written in the shortest form that parses back to the same value
+*/
+template<typename T, typename U, typename I, std::enable_if_t<std::is_integral_v<I>, int> = 0>
+size_t to_chars(adv_string_buf<T, U> &buf, I value, int base = 10);
+template<typename T, typename U, typename D, std::enable_if_t<std::is_floating_point_v<D>, int> = 0>
+size_t to_chars(adv_string_buf<T, U> &buf, D value);
+template<typename T, typename U, typename D, std::enable_if_t<std::is_floating_point_v<D>, int> = 0>
+size_t to_chars(adv_string_buf<T, U> &buf, D value, std::chars_format fmt);
+template<typename T, typename U, typename D, std::enable_if_t<std::is_floating_point_v<D>, int> = 0>
+size_t to_chars(adv_string_buf<T, U> &buf, D value, std::chars_format fmt, int precision);
+
+#include <encmetric/charconv.tpp>
+}
@@ -0,0 +1,152 @@
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+inline bool number_char(std::uint32_t c) noexcept{
+	return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '+' || c == '-' || c == '.' || c == '(' || c == ')' || c == '_';
+}
+
+/*
+    Calls parse(first, last) (a std::from_chars call) on the ASCII characters at the beginning of
+    the siz bytes pointed by ptr
+*/
+template<typename T, typename P>
+adv_from_chars_result<T> parse_number(const_tchar_pt<T> ptr, size_t siz, P &&parse){
+	static_assert(std::is_same_v<typename T::ctype, unicode>, "Encoding must have Unicode characters");
+	EncMetric_info<T> ei = ptr.raw_format();
+	const byte *b = ptr.data();
+	if(ei.ascii_compatible()){
+		const char *c = reinterpret_cast<const char *>(b);
+		std::from_chars_result res = parse(c, c + siz);
+		return adv_from_chars_result<T>{ptr.new_instance(b + (res.ptr - c)), res.ec};
+	}
+	char small[64];
+	std::string big;
+	char *out = small;
+	size_t cap = sizeof(small), n = 0;
+	uint pos = 0;
+	bool wide = ascii_widened(ei, pos);
+	uint u = wide ? ei.unity() : 1;
+	const byte *cur = b;
+	size_t rem = siz;
+	while(rem >= u){
+		if(n == cap){
+			if(out == small)
+				big.assign(small, n);
+			big.resize(cap * 2);
+			out = big.data();
+			cap = big.size();
+		}
+		if(wide){
+			size_t k = widened_digits(cur, std::min(rem / u, cap - n), u, pos, out + n);
+			n += k;
+			cur += k * u;
+			rem -= k * u;
+			if(n == cap || rem < u)
+				continue;
+			std::uint32_t c = std::to_integer<std::uint32_t>(cur[pos]);
+			bool ok = number_char(c);
+			for(uint j = 0; j < u && ok; j++)
+				ok = j == pos || cur[j] == byte{0};
+			if(!ok)
+				break;
+			out[n++] = static_cast<char>(c);
+			cur += u;
+			rem -= u;
+		}
+		else{
+			unicode c;
+			uint l;
+			if(!ei.decode_checked(&c, cur, rem, l) || !number_char(c))
+				break;
+			out[n++] = static_cast<char>(c);
+			cur += l;
+			rem -= l;
+		}
+	}
+	std::from_chars_result res = parse(out, out + n);
+	size_t k = static_cast<size_t>(res.ptr - out);
+	const byte *end = b;
+	if(wide)
+		end += k * u;
+	else{
+		for(size_t i = 0; i < k; i++)
+			end += ei.chLen(end);
+	}
+	return adv_from_chars_result<T>{ptr.new_instance(end), res.ec};
+}
+
+template<typename T, typename I, std::enable_if_t<std::is_integral_v<I>, int>>
+adv_from_chars_result<T> from_chars(const_tchar_pt<T> ptr, size_t siz, I &value, int base){
+	return parse_number(ptr, siz, [&](const char *first, const char *last){
+		return std::from_chars(first, last, value, base);
+	});
+}
+
+template<typename T, typename D, std::enable_if_t<std::is_floating_point_v<D>, int>>
+adv_from_chars_result<T> from_chars(const_tchar_pt<T> ptr, size_t siz, D &value, std::chars_format fmt){
+	return parse_number(ptr, siz, [&](const char *first, const char *last){
+		return std::from_chars(first, last, value, fmt);
+	});
+}
+
+/*
+    Calls write(first, last) (a std::to_chars call) and appends its result to buf. Only fixed
+    floating point numbers can be longer than the local buffer
+*/
+template<typename T, typename U, typename W>
+size_t write_number(adv_string_buf<T, U> &buf, size_t maxlen, W &&write){
+	size_t old = buf.size();
+	char small[128];
+	std::to_chars_result res = write(small, small + sizeof(small));
+	if(res.ec == std::errc{})
+		buf.append_ascii(small, static_cast<size_t>(res.ptr - small));
+	else{
+		std::string big(maxlen, '0');
+		res = write(big.data(), big.data() + big.size());
+		buf.append_ascii(big.data(), static_cast<size_t>(res.ptr - big.data()));
+	}
+	return buf.size() - old;
+}
+
+template<typename T, typename U, typename I, std::enable_if_t<std::is_integral_v<I>, int>>
+size_t to_chars(adv_string_buf<T, U> &buf, I value, int base){
+	return write_number(buf, 0, [&](char *first, char *last){
+		return std::to_chars(first, last, value, base);
+	});
+}
+
+template<typename T, typename U, typename D, std::enable_if_t<std::is_floating_point_v<D>, int>>
+size_t to_chars(adv_string_buf<T, U> &buf, D value){
+	return write_number(buf, 0, [&](char *first, char *last){
+		return std::to_chars(first, last, value);
+	});
+}
+
+template<typename T, typename U, typename D, std::enable_if_t<std::is_floating_point_v<D>, int>>
+size_t to_chars(adv_string_buf<T, U> &buf, D value, std::chars_format fmt){
+	return write_number(buf, std::numeric_limits<D>::max_exponent10 + std::numeric_limits<D>::max_digits10 + 8, [&](char *first, char *last){
+		return std::to_chars(first, last, value, fmt);
+	});
+}
+
+template<typename T, typename U, typename D, std::enable_if_t<std::is_floating_point_v<D>, int>>
+size_t to_chars(adv_string_buf<T, U> &buf, D value, std::chars_format fmt, int precision){
+	return write_number(buf, std::numeric_limits<D>::max_exponent10 + static_cast<size_t>(precision < 0 ? 0 : precision) + 8, [&](char *first, char *last){
+		return std::to_chars(first, last, value, fmt, precision);
+	});
+}
@@ -32,6 +32,7 @@
 #include <cstddef>
 #include <functional>
 #include <encmetric/encoding.hpp>
+#include <encmetric/translit.hpp>
 
 namespace adv{
 
@@ -72,7 +73,15 @@ class base_tchar_pt{
 		bool has_max() const noexcept {return ei.has_max();}
 		uint max_bytes() const noexcept {return ei.max_bytes();}
 		bool is_fixed() const noexcept {return ei.is_fixed();}
+		bool byte_ordered() const noexcept {return ei.byte_ordered();}
+		bool ascii_compatible() const noexcept {return ei.ascii_compatible();}
+		bool ascii_units() const noexcept {return ei.ascii_units();}
+		bool reversible() const noexcept {return ei.reversible();}
 		uint chLen() const {return ei.chLen(ptr);}
+		/*
+		    Length of the first character when only rem bytes can be read
+		*/
+		uint chLen(size_t rem) const {return ei.chLen(ptr, rem);}
 		bool validChar(uint &l) const noexcept {return ei.validChar(ptr, l);}
 		uint decode(ctype *uni, size_t l) const {return ei.decode(uni, ptr, l);}
 
@@ -91,6 +100,35 @@ class base_tchar_pt{
 				return add;
 			}
 		}
+		/*
+		    Like next, but reads at most rem bytes
+		*/
+		uint next(size_t rem){
+			if constexpr(fixed_size<T>){
+				ptr += T::unity();
+				return T::unity();
+			}
+			else{
+				uint add = chLen(rem);
+				ptr += add;
+				return add;
+			}
+		}
+		/*
+		    Step the pointer back by 1 character, returns the number of bytes skipped.
+		    lim is the beginning of the string, it must precede the pointer. The encoding must be reversible
+		*/
+		uint prev(const U &lim){
+			if constexpr(fixed_size<T>){
+				ptr -= T::unity();
+				return T::unity();
+			}
+			else{
+				uint sub = ei.prevLen(lim.data(), ptr);
+				ptr -= sub;
+				return sub;
+			}
+		}
 		/*
 		    Validate the first character, then skip it
 
@@ -99,6 +137,8 @@ class base_tchar_pt{
 		bool valid_next(size_t &rsiz) noexcept{
 			if(unity() > rsiz)
 				return false;
+			if(chLen(rsiz) > rsiz)
+				return false;
 			uint dec;
 			if(!validChar(dec))
 				return false;
@@ -321,6 +361,19 @@ template<typename S, typename T, enable_same_data_t<S, T, int> =0>
 void basic_encoding_conversion(const_tchar_pt<T> in, uint inlen, tchar_pt<S> out, uint oulen);
 template<typename S, typename T, enable_same_data_t<S, T, int> =0>
 void basic_encoding_conversion(const_tchar_pt<T> in, uint inlen, tchar_pt<S> out, uint oulen, uint &inread, uint &outwrite);
+/*
+    If the character is invalid and pol requires it, the maximal invalid subsequence is read and U+FFFD is written.
+    An unmappable character is substituted following pol, so more than one character can be written
+*/
+template<typename S, typename T, enable_same_data_t<S, T, int> =0>
+void basic_encoding_conversion(const_tchar_pt<T> in, uint inlen, tchar_pt<S> out, uint oulen, uint &inread, uint &outwrite, conv_policy &pol);
+
+/*
+    Writes a substitute of the unmappable character c following pol, then returns the number of written characters.
+    put(const unicode *, size_t n) must write all the n characters or nothing, returning false in the latter case
+*/
+template<typename F>
+size_t substitute_unmappable(unicode c, conv_policy &pol, F &&put);
 
 /*
     Estimate the size of a possible string with n characters
@@ -332,6 +385,8 @@ uint max_size_estimate(const_tchar_pt<T>, uint);
 
 template<typename T>
 bool dynamic_fixed_size(const_tchar_pt<T>) noexcept;
+template<typename T>
+bool dynamic_byte_ordered(const_tchar_pt<T>) noexcept;
 
 using c_wchar_pt = const_tchar_pt<WIDE<unicode>>;
 using wchar_pt = tchar_pt<WIDE<unicode>>;
@@ -104,20 +104,96 @@ const_tchar_pt<S> reassign(const_tchar_pt<T> p){
 	}
 }
 
-template<typename S, typename T, enable_same_data_t<S, T, int> =0>
+template<typename S, typename T, enable_same_data_t<S, T, int>>
 void basic_encoding_conversion(const_tchar_pt<T> in, uint inlen, tchar_pt<S> out, uint oulen){
 	typename S::ctype bias;
 	in.decode(&bias, inlen);
 	out.encode(bias, oulen);
 }
 
-template<typename S, typename T, enable_same_data_t<S, T, int> =0>
+template<typename S, typename T, enable_same_data_t<S, T, int>>
 void basic_encoding_conversion(const_tchar_pt<T> in, uint inlen, tchar_pt<S> out, uint oulen, uint &inread, uint &outread){
 	typename S::ctype bias;
 	inread = in.decode(&bias, inlen);
 	outread = out.encode(bias, oulen);
 }
 
+template<typename S, typename T, enable_same_data_t<S, T, int>>
+void basic_encoding_conversion(const_tchar_pt<T> in, uint inlen, tchar_pt<S> out, uint oulen, uint &inread, uint &outread, conv_policy &pol){
+	typename S::ctype bias;
+	if(pol.invalid == invalid_policy::raise)
+		inread = in.decode(&bias, inlen);
+	else if(!in.raw_format().decode_checked(&bias, in.data(), inlen, inread)){
+		if constexpr(std::is_same_v<typename S::ctype, unicode>)
+			bias = REPLACEMENT_CHARACTER;
+		else
+			throw encoding_error{"Invalid character"};
+		pol.replaced++;
+	}
+	if(pol.unmappable == unmappable_policy::raise){
+		outread = out.encode(bias, oulen);
+		return;
+	}
+	EncMetric_info<S> ei = out.raw_format();
+	size_t written = 0;
+	auto put = [&](const typename S::ctype *c, size_t n) -> bool{
+		size_t save = written;
+		for(size_t i=0; i<n; i++){
+			uint w;
+			if(!ei.encode_checked(c[i], out.data() + written, oulen - written, w)){
+				written = save;
+				return false;
+			}
+			written += w;
+		}
+		return true;
+	};
+	if(!put(&bias, 1)){
+		if constexpr(std::is_same_v<typename S::ctype, unicode>)
+			substitute_unmappable(bias, pol, put);
+		else
+			throw encoding_error{"Character not included in this encoding"};
+	}
+	outread = static_cast<uint>(written);
+}
+
+template<typename F>
+size_t substitute_unmappable(unicode c, conv_policy &pol, F &&put){
+	pol.unmapped++;
+	if(pol.unmappable == unmappable_policy::transliterate){
+		const translit_table &table = pol.translit != nullptr ? *pol.translit : translit_table::ascii();
+		const unicode *to;
+		size_t n;
+		if(table.find(c, to, n) && put(to, n)){
+			pol.transliterated++;
+			return n;
+		}
+	}
+	else if(pol.unmappable == unmappable_policy::ncr){
+		unicode ref[16];
+		size_t n = 0;
+		ref[n++] = unicode{'&'};
+		ref[n++] = unicode{'#'};
+		char digits[10];
+		int nd = 0;
+		std::uint_least32_t v = c;
+		do{
+			digits[nd++] = static_cast<char>('0' + v % 10);
+			v /= 10;
+		}
+		while(v > 0);
+		while(nd > 0)
+			ref[n++] = unicode{static_cast<std::uint_least32_t>(digits[--nd])};
+		ref[n++] = unicode{';'};
+		if(!put(ref, n))
+			throw encoding_error{"Character not included in this encoding"};
+		return n;
+	}
+	if(!put(&pol.replacement, 1))
+		throw encoding_error{"Replacement character not included in this encoding"};
+	return 1;
+}
+
 template<typename T>
 uint min_size_estimate(const_tchar_pt<T> ptr, uint nchr) noexcept{
 	if constexpr(!is_wide_v<T>)
@@ -143,3 +219,11 @@ bool dynamic_fixed_size(const_tchar_pt<T> ptr) noexcept{
 
 
 
+
+template<typename T>
+bool dynamic_byte_ordered(const_tchar_pt<T> ptr) noexcept{
+	if constexpr(is_wide_v<T>)
+		return ptr.format().d_byte_ordered();
+	else
+		return is_byte_ordered_v<T>;
+}
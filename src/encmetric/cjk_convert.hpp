@@ -0,0 +1,68 @@
+#pragma once
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+    Bulk conversion of strings between the CJK encodings and UTF8/UTF16, faster than the character
+    by character conversions of adv_string_view. The result is allocated only once with the maximum
+    size it can need.
+*/
+#include <encmetric/enc_string.hpp>
+#include <encmetric/utf8_enc.hpp>
+#include <encmetric/utf16_enc.hpp>
+#include <encmetric/cjk_enc.hpp>
+
+namespace adv{
+
+/*
+    Code unit dimension and byte order of UTF8 and UTF16
+*/
+template<typename S>
+struct utf_form;
+template<>
+struct utf_form<UTF8>{
+	static constexpr uint unit = 1;
+	static constexpr bool be = false;
+};
+template<bool b>
+struct utf_form<UTF16<b>>{
+	static constexpr uint unit = 2;
+	static constexpr bool be = b;
+};
+
+class cjk_conversion{
+	public:
+		template<typename S, cjk_charset cs, typename U>
+		static adv_string<S, U> decode(const adv_string_view<CJK<cs>> &, const U &);
+		template<cjk_charset cs, typename T, typename U>
+		static adv_string<CJK<cs>, U> encode(const adv_string_view<T> &, const U &);
+};
+
+/*
+    S (or T) must be UTF8 or UTF16, throw encoding_error on invalid or unmappable characters
+*/
+template<typename S, cjk_charset cs, typename U = std::allocator<byte>>
+adv_string<S, U> cjk_decode(const adv_string_view<CJK<cs>> &str, const U &alloc = U{}){
+	return cjk_conversion::decode<S>(str, alloc);
+}
+template<cjk_charset cs, typename T, typename U = std::allocator<byte>>
+adv_string<CJK<cs>, U> cjk_encode(const adv_string_view<T> &str, const U &alloc = U{}){
+	return cjk_conversion::encode<cs>(str, alloc);
+}
+
+#include <encmetric/cjk_convert.tpp>
+}
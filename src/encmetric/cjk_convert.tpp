@@ -0,0 +1,34 @@
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+template<typename S, cjk_charset cs, typename U>
+adv_string<S, U> cjk_conversion::decode(const adv_string_view<CJK<cs>> &str, const U &alloc){
+	constexpr uint unit = utf_form<S>::unit;
+	basic_ptr<byte, U> to{str.size() * (unit == 1 ? 3 : 2), alloc};
+	size_t nchr;
+	size_t siz = cjk_to_utf(cs, str.data(), str.size(), to.memory, unit, utf_form<S>::be, nchr);
+	return adv_string<S, U>{const_tchar_pt<S>{}, nchr, siz, std::move(to), 0};
+}
+
+template<cjk_charset cs, typename T, typename U>
+adv_string<CJK<cs>, U> cjk_conversion::encode(const adv_string_view<T> &str, const U &alloc){
+	basic_ptr<byte, U> to{str.size() * 2, alloc};
+	size_t nchr;
+	size_t siz = utf_to_cjk(cs, str.data(), str.size(), utf_form<T>::unit, utf_form<T>::be, to.memory, nchr);
+	return adv_string<CJK<cs>, U>{const_tchar_pt<CJK<cs>>{}, nchr, siz, std::move(to), 0};
+}
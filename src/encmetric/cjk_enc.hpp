@@ -0,0 +1,90 @@
+#pragma once
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+    Multibyte encodings of Chinese, Japanese and Korean: Shift_JIS, EUC-JP, GBK, GB18030, Big5 and
+    EUC-KR.
+
+    Two byte characters are stored in two level tables (one row for every used lead byte) generated
+    by tools/gen_cjk.py, the reverse tables needed for encoding are built the first time they're
+    used. EUC-JP and EUC-KR are ASCII compatible, the others contain ASCII bytes inside two (or four)
+    byte characters.
+*/
+#include <encmetric/encoding.hpp>
+
+namespace adv{
+
+enum class cjk_charset{
+	shift_jis,
+	euc_jp,
+	gbk,
+	gb18030,
+	big5,
+	euc_kr
+};
+
+template<cjk_charset cs>
+class CJK{
+	public:
+		using ctype=unicode;
+		static constexpr uint unity() noexcept {return 1;}
+		static constexpr bool has_max() noexcept {return true;}
+		static constexpr uint max_bytes() noexcept {return cs == cjk_charset::gb18030 ? 4 : (cs == cjk_charset::euc_jp ? 3 : 2);}
+		static constexpr bool ascii_compatible() noexcept {return cs == cjk_charset::euc_jp || cs == cjk_charset::euc_kr;}
+		/*
+		    Length deduced from the first byte, bytes that can't start any character have length 1.
+		    In GB18030 the lead bytes that can start both two and four byte characters (0x81-0x84 and
+		    0x90-0xE3) need also the second byte, which always belongs to the same character
+		*/
+		static uint chLen(const byte *);
+		static bool validChar(const byte *, uint &chlen) noexcept;
+		static uint decode(unicode *uni, const byte *by, size_t l);
+		/*
+		    Some characters have more than one encoding (for example U+5341 in Big5), so the
+		    default check that reencodes the character can't be used
+		*/
+		static bool decode_checked(unicode *uni, const byte *by, size_t l, uint &len) noexcept;
+		static uint encode(const unicode &uni, byte *by, size_t l);
+		static bool encode_checked(const unicode &uni, byte *by, size_t l, uint &len);
+};
+
+using Shift_JIS = CJK<cjk_charset::shift_jis>;
+using EUC_JP = CJK<cjk_charset::euc_jp>;
+using GBK = CJK<cjk_charset::gbk>;
+using GB18030 = CJK<cjk_charset::gb18030>;
+using Big5 = CJK<cjk_charset::big5>;
+using EUC_KR = CJK<cjk_charset::euc_kr>;
+
+extern template class CJK<cjk_charset::shift_jis>;
+extern template class CJK<cjk_charset::euc_jp>;
+extern template class CJK<cjk_charset::gbk>;
+extern template class CJK<cjk_charset::gb18030>;
+extern template class CJK<cjk_charset::big5>;
+extern template class CJK<cjk_charset::euc_kr>;
+
+/*
+    Bulk conversion of l bytes from the encoding cs to UTF8 (unit = 1) or UTF16 with byte order
+    be (unit = 2), and vice versa. ASCII runs are converted 8 bytes at a time.
+    out must have space for 3 * l bytes when converting to UTF8, 2 * l bytes otherwise.
+    Returns the number of written bytes and sets nchr to the number of characters, throws
+    encoding_error if the input is invalid or contains characters not included in the output encoding
+*/
+size_t cjk_to_utf(cjk_charset cs, const byte *in, size_t l, byte *out, uint unit, bool be, size_t &nchr);
+size_t utf_to_cjk(cjk_charset cs, const byte *in, size_t l, uint unit, bool be, byte *out, size_t &nchr);
+
+}
@@ -0,0 +1,126 @@
+#pragma once
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <iterator>
+#include <cstddef>
+#include <type_traits>
+#include <encmetric/chite.hpp>
+#if __has_include(<ranges>)
+#include <ranges>
+#endif
+
+namespace adv{
+
+/*
+    Iterator over the characters of an encoded string, dereferencing it gives the decoded character.
+
+    Characters are decoded in blocks of cp_block characters into an internal buffer, so the encoding
+    functions are called once per character only when needed (runs of ASCII characters in ASCII compatible
+    encodings are copied directly). The string must be correctly encoded.
+
+    It's a bidirectional iterator when the encoding is reversible (or WIDE, in this case decrementing a
+    non reversible encoding throws an encoding_error), otherwise a forward iterator.
+*/
+inline constexpr uint cp_block = 16;
+
+template<typename T>
+class code_point_iterator{
+	public:
+		using ctype = typename EncMetric_info<T>::ctype;
+		using value_type = ctype;
+		using reference = ctype;
+		using pointer = void;
+		using difference_type = std::ptrdiff_t;
+		using iterator_category = std::input_iterator_tag;
+		using iterator_concept = std::conditional_t<is_reversible_v<T> || is_wide_v<T>, std::bidirectional_iterator_tag, std::forward_iterator_tag>;
+	private:
+		EncMetric_info<T> ei;
+		const byte *first, *last;
+		/*
+		    The block starts at blk, the i-th buffered character starts at blk + off[i]
+		*/
+		const byte *blk;
+		ctype buf[cp_block];
+		uint off[cp_block + 1];
+		uint n, idx;
+
+		static EncMetric_info<T> null_info() noexcept{
+			if constexpr(is_wide_v<T>)
+				return EncMetric_info<T>{nullptr};
+			else
+				return EncMetric_info<T>{};
+		}
+		void load(const byte *);
+		void load_back(const byte *);
+		const byte *current() const noexcept {return blk + off[idx];}
+	public:
+		code_point_iterator() noexcept : ei{null_info()}, first{nullptr}, last{nullptr}, blk{nullptr}, off{0}, n{0}, idx{0} {}
+		/*
+		    Iterator to the character at pos in the string [fir, las)
+		*/
+		code_point_iterator(const byte *fir, const byte *las, const byte *pos, EncMetric_info<T> format);
+
+		reference operator*() const noexcept {return buf[idx];}
+		/*
+		    Position of the pointed character
+		*/
+		const_tchar_pt<T> base() const noexcept {return const_tchar_pt<T>{current(), ei};}
+		/*
+		    True if the iterator points to the end of the string
+		*/
+		bool at_end() const noexcept {return current() == last;}
+
+		code_point_iterator &operator++();
+		code_point_iterator operator++(int) {code_point_iterator ret = *this; ++(*this); return ret;}
+		template<typename Q = T, std::enable_if_t<is_reversible_v<Q> || is_wide_v<Q>, int> = 0>
+		code_point_iterator &operator--();
+		template<typename Q = T, std::enable_if_t<is_reversible_v<Q> || is_wide_v<Q>, int> = 0>
+		code_point_iterator operator--(int) {code_point_iterator ret = *this; --(*this); return ret;}
+
+		bool operator==(const code_point_iterator &oth) const noexcept {return current() == oth.current();}
+		bool operator!=(const code_point_iterator &oth) const noexcept {return current() != oth.current();}
+};
+
+/*
+    Range of the characters of an encoded string, returned by adv_string_view::code_points
+*/
+template<typename T>
+class code_point_range{
+	private:
+		const_tchar_pt<T> ptr;
+		size_t siz;
+	public:
+		using iterator = code_point_iterator<T>;
+		using const_iterator = code_point_iterator<T>;
+
+		code_point_range(const_tchar_pt<T> b, size_t s) noexcept : ptr{b}, siz{s} {}
+
+		iterator begin() const {return iterator{ptr.data(), ptr.data() + siz, ptr.data(), ptr.raw_format()};}
+		iterator end() const {return iterator{ptr.data(), ptr.data() + siz, ptr.data() + siz, ptr.raw_format()};}
+		bool empty() const noexcept {return siz == 0;}
+};
+
+#include <encmetric/code_points.tpp>
+}
+
+#if defined(__cpp_lib_ranges)
+namespace std::ranges{
+template<typename T>
+inline constexpr bool enable_borrowed_range<adv::code_point_range<T>> = true;
+}
+#endif
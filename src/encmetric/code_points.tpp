@@ -0,0 +1,92 @@
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+template<typename T>
+code_point_iterator<T>::code_point_iterator(const byte *fir, const byte *las, const byte *pos, EncMetric_info<T> format) : ei{format}, first{fir}, last{las}, blk{pos}, off{0}, n{0}, idx{0} {
+	if(pos != las)
+		load(pos);
+}
+
+/*
+    Decodes at most cp_block characters starting from p
+*/
+template<typename T>
+void code_point_iterator<T>::load(const byte *p){
+	blk = p;
+	n = 0;
+	idx = 0;
+	off[0] = 0;
+	size_t rem = static_cast<size_t>(last - p);
+	uint pos = 0;
+	if constexpr(std::is_same_v<ctype, unicode>){
+		if(ei.ascii_compatible() && ei.unity() == 1){
+			size_t asc = ascii_prefix(p, rem < cp_block ? rem : cp_block);
+			for(; n < asc; n++){
+				buf[n] = read_unicode(p[n]);
+				off[n+1] = n+1;
+			}
+			pos = n;
+		}
+	}
+	while(n < cp_block && pos < rem){
+		pos += ei.decode(buf + n, p + pos, rem - pos);
+		n++;
+		off[n] = pos;
+	}
+}
+
+/*
+    Loads a block ending with the character before p, p must be different from first
+*/
+template<typename T>
+void code_point_iterator<T>::load_back(const byte *p){
+	const byte *q = p;
+	uint k = 0;
+	while(k < cp_block && q != first){
+		q -= ei.prevLen(first, q);
+		k++;
+	}
+	load(q);
+	idx = k - 1;
+}
+
+template<typename T>
+code_point_iterator<T> &code_point_iterator<T>::operator++(){
+	idx++;
+	if(idx == n){
+		const byte *p = blk + off[n];
+		if(p == last){
+			blk = p;
+			n = 0;
+			idx = 0;
+			off[0] = 0;
+		}
+		else
+			load(p);
+	}
+	return *this;
+}
+
+template<typename T>
+template<typename Q, std::enable_if_t<is_reversible_v<Q> || is_wide_v<Q>, int>>
+code_point_iterator<T> &code_point_iterator<T>::operator--(){
+	if(idx > 0)
+		idx--;
+	else
+		load_back(blk);
+	return *this;
+}
@@ -64,22 +64,45 @@ inline adv_string_view<UTF16<bend>> getstring_16(const char16_t *c, size_t len){
 }
 
 /*
-    Detect utf8, utf16 encoding from BOM, if haven't BOM then throw exception
+    Detect utf8, utf16, utf32 encoding from BOM and sets bomlen to the length of the BOM.
+    If there isn't any BOM returns nullptr
 */
-inline const EncMetric<unicode> *detect_bom(adv_string_view<RAW<unicode>> t){
-	const_tchar_pt<RAW<unicode>> ptr = t.begin();
-	if(t.size() < 2)
-		throw encoding_error{"No BOM"};
-	if(ptr[0] == byte{0xfe} && ptr[1] == byte{0xff})
+inline const EncMetric<unicode> *detect_bom(adv_string_view<RAW<unicode>> t, size_t &bomlen) noexcept{
+	const byte *ptr = t.data();
+	size_t siz = t.size();
+	bomlen = 0;
+	if(siz >= 4 && ptr[0] == byte{0xff} && ptr[1] == byte{0xfe} && ptr[2] == byte{0} && ptr[3] == byte{0}){
+		bomlen = 4;
+		return DynEncoding<UTF32<false>>::instance();
+	}
+	if(siz >= 4 && ptr[0] == byte{0} && ptr[1] == byte{0} && ptr[2] == byte{0xfe} && ptr[3] == byte{0xff}){
+		bomlen = 4;
+		return DynEncoding<UTF32<true>>::instance();
+	}
+	if(siz >= 3 && ptr[0] == byte{0xef} && ptr[1] == byte{0xbb} && ptr[2] == byte{0xbf}){
+		bomlen = 3;
+		return DynEncoding<UTF8>::instance();
+	}
+	if(siz >= 2 && ptr[0] == byte{0xfe} && ptr[1] == byte{0xff}){
+		bomlen = 2;
 		return DynEncoding<UTF16<true>>::instance();
-	if(ptr[0] == byte{0xff} && ptr[1] == byte{0xfe})
+	}
+	if(siz >= 2 && ptr[0] == byte{0xff} && ptr[1] == byte{0xfe}){
+		bomlen = 2;
 		return DynEncoding<UTF16<false>>::instance();
-	if(t.size() < 3)
+	}
+	return nullptr;
+}
+
+/*
+    Detect utf8, utf16, utf32 encoding from BOM, if haven't BOM then throw exception
+*/
+inline const EncMetric<unicode> *detect_bom(adv_string_view<RAW<unicode>> t){
+	size_t bomlen;
+	const EncMetric<unicode> *ret = detect_bom(t, bomlen);
+	if(ret == nullptr)
 		throw encoding_error{"No BOM"};
-	if(ptr[0] == byte{0xef} && ptr[1] == byte{0xbb} && ptr[2] == byte{0xbf})
-		return DynEncoding<UTF8>::instance();
-	throw encoding_error{"No BOM"};
-	
+	return ret;
 }
 
 inline namespace literals{
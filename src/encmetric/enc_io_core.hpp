@@ -16,6 +16,8 @@
     You should have received a copy of the GNU Lesser General Public License
     along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
 */
+#include <utility>
+#include <cstdint>
 #include <encmetric/byte_tools.hpp>
 
 namespace adv{
@@ -24,8 +26,120 @@ size_t raw_stdin_readbytes(byte *, size_t);
 size_t raw_stdout_writebytes(const byte *, size_t);
 size_t raw_stderr_writebytes(const byte *, size_t);
 
-}
+/*
+    Reads from a generic file descriptor, returns a negative number on error and 0 at end of file
+*/
+std::ptrdiff_t raw_fd_readbytes(int, byte *, size_t);
 
+std::ptrdiff_t raw_fd_writebytes(int, const byte *, size_t);
+/*
+    Puts the file descriptor in non-blocking mode
+*/
+void raw_fd_set_nonblocking(int);
+/*
+    True if the last failed read or write didn't complete because it would block
+*/
+bool raw_io_would_block() noexcept;
 
+/*
+    Read-only memory mapping of an entire file
+*/
+class mapped_file{
+	private:
+		const byte *mem;
+		size_t siz;
+		void *handle;
+		void unmap() noexcept;
+	public:
+		mapped_file() noexcept : mem{nullptr}, siz{0}, handle{nullptr} {}
+		explicit mapped_file(int fd);
+		mapped_file(const mapped_file &) = delete;
+		mapped_file(mapped_file &&from) noexcept : mem{from.mem}, siz{from.siz}, handle{from.handle}{
+			from.mem = nullptr;
+			from.siz = 0;
+			from.handle = nullptr;
+		}
+		~mapped_file() {unmap();}
+		mapped_file &operator=(const mapped_file &) = delete;
+		mapped_file &operator=(mapped_file &&from) noexcept{
+			unmap();
+			std::swap(mem, from.mem);
+			std::swap(siz, from.siz);
+			std::swap(handle, from.handle);
+			return *this;
+		}
 
+		const byte *data() const noexcept {return mem;}
+		size_t size() const noexcept {return siz;}
+};
+
+/*
+    Readiness notification and direct IO for many file descriptors.
 
+    Notifications are one-shot: after an event is returned the file descriptor must be armed again.
+    Arming an already armed file descriptor replaces its previous interests.
+
+    With io_uring reads and writes can also be submitted directly, their completions are returned by
+    wait together with the notifications. Operations on memory registered with register_buffer use the
+    fixed buffer variants (READ_FIXED, WRITE_FIXED), so the kernel doesn't map the pages every time.
+    Fixed buffers need Linux 5.19, on older kernels (or if the locked memory limit is reached) the
+    memory isn't registered and the plain operations are used.
+
+    Not available on Windows, where the constructor throws encoding_error.
+*/
+struct poll_event{
+	int fd;
+	bool readable;
+	bool writable;
+	/*
+	    Not zero for the completion of a submitted read or write, res is then its result
+	*/
+	std::uint64_t tag;
+	std::ptrdiff_t res;
+};
+
+/*
+    Result of a direct read or write on a non-blocking file descriptor that isn't ready, other
+    errors are -1
+*/
+inline constexpr std::ptrdiff_t io_would_block = -2;
+
+class io_poller{
+	private:
+		struct impl;
+		impl *pimpl;
+	public:
+		/*
+		    If try_uring is false then io_uring isn't used even if available
+		*/
+		explicit io_poller(bool try_uring = true);
+		io_poller(const io_poller &) = delete;
+		io_poller &operator=(const io_poller &) = delete;
+		~io_poller();
+
+		void arm(int fd, bool read, bool write);
+		void disarm(int fd);
+		/*
+		    Waits for at most timeout_ms milliseconds (forever if negative) and stores at most max events,
+		    returns the number of stored events
+		*/
+		size_t wait(poll_event *, size_t max, int timeout_ms);
+		/*
+		    True if the kernel io_uring interface is used
+		*/
+		bool uses_uring() const noexcept;
+		/*
+		    Reads or writes at most siz bytes at the current file position, only if uses_uring() is true.
+		    tag must be lower than 2^62 and not 0. Memory must stay valid until the completion
+		*/
+		void submit_read(int fd, byte *, size_t siz, std::uint64_t tag);
+		void submit_write(int fd, const byte *, size_t siz, std::uint64_t tag);
+		/*
+		    Registers memory as a fixed buffer, returns false if it can't be registered.
+		    Registered memory must not be freed before unregister_buffer is called with the same pointer
+		*/
+		bool register_buffer(byte *, size_t);
+		void unregister_buffer(byte *);
+};
+
+}
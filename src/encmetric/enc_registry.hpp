@@ -0,0 +1,54 @@
+#pragma once
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+    Registry of the encodings by name, used to get the encoding of WIDE strings at runtime.
+
+    Names are the IANA character set names and aliases, compared ignoring the case of ASCII letters.
+    The built-in encodings are stored in a perfect hash table computed at compile time, the
+    encodings registered by the user in an append-only table. Lookups never allocate or lock and
+    can be performed concurrently with registrations.
+*/
+#include <string_view>
+#include <encmetric/enc_c.hpp>
+
+namespace adv{
+
+/*
+    Maximum number of user registered names and maximum length of every name
+*/
+inline constexpr size_t max_user_encodings = 64;
+inline constexpr size_t max_encoding_name = 40;
+
+/*
+    Returns nullptr if name is unknown
+*/
+const EncMetric<unicode> *find_encoding(std::string_view name) noexcept;
+/*
+    Registers a new name for enc, throws encoding_error if name is already registered, if it's
+    empty or too long, or if there are already max_user_encodings user names
+*/
+void register_encoding(std::string_view name, const EncMetric<unicode> *enc);
+/*
+    Encoding of data: if data starts with a BOM (see detect_bom) its encoding is returned and bomlen
+    is set to its length, otherwise bomlen is set to 0 and the encoding named name is returned.
+    Throws encoding_error if there isn't any BOM and name is unknown
+*/
+const EncMetric<unicode> *detect_encoding(std::string_view name, adv_string_view<RAW<unicode>> data, size_t &bomlen);
+
+}
@@ -22,7 +22,11 @@
 #include <stdexcept>
 #include <type_traits>
 #include <string>
+#if __has_include(<compare>)
+#include <compare>
+#endif
 #include <encmetric/chite.hpp>
+#include <encmetric/code_points.hpp>
 #include <encmetric/basic_ptr.hpp>
 
 namespace adv{
@@ -69,8 +73,28 @@ bool encoding_terminating(const byte *data, const EncMetric_info<T> &format){
 
 template<typename T, typename U>
 class adv_string; //forward declaration
+class endian_swap;
+class cjk_conversion;
+class format_writer;
+class json_conversion;
 template<typename T, typename V, typename U>
 class adv_string_buf_0;
+template<typename T, typename U>
+class adv_intern_table;
+template<typename T, typename U>
+class async_reader;
+
+/*
+    Decodes l bytes of encoding T and appends them with encoding S to buffer starting from offset siz, which is
+    updated. Invalid sequences and unmappable characters are handled following pol. Returns the number of
+    written characters. buffer is a basic_ptr or any type with the fields memory and dimension and the
+    function exp_fit.
+
+    The whole input is processed in a single pass: stretches of valid characters are copied unchanged
+    when the two encodings are the same, ASCII stretches are detected 8 bytes at a time
+*/
+template<typename S, typename T, typename B>
+size_t policy_convert(const EncMetric_info<T> &from, const byte *in, size_t l, const EncMetric_info<S> &to, B &buffer, size_t &siz, conv_policy &pol);
 
 
 template<typename T>
@@ -79,6 +103,9 @@ class adv_string_view{
 		const_tchar_pt<T> ptr;
 		size_t len;//character number
 		size_t siz;//bytes number
+
+		template<typename S>
+		size_t last_occurrence(const adv_string_view<S> &, bool &found, size_t &chr) const;
 	protected:
 		explicit adv_string_view(size_t length, size_t size, const_tchar_pt<T> bin) noexcept : ptr{bin}, len{length}, siz{size} {}
 	public:
@@ -141,6 +168,33 @@ class adv_string_view{
 		template<typename S>
 		bool operator!=(const_tchar_pt<S> bin) const {return !(*this == bin);}
 
+		/*
+		    Three-way comparison in character order: returns a negative number, zero or a positive number.
+		    The strings can have different encodings, but they must share the same ctype.
+		    No conversion is made, both strings are decoded together
+		*/
+		template<typename S>
+		int compare(const adv_string_view<S> &) const;
+		/*
+		    Different from operator==, returns true also if the strings have different encodings
+		    but they represent the same characters
+		*/
+		template<typename S>
+		bool equals(const adv_string_view<S> &) const;
+
+		template<typename S>
+		bool operator<(const adv_string_view<S> &bin) const {return compare(bin) < 0;}
+		template<typename S>
+		bool operator<=(const adv_string_view<S> &bin) const {return compare(bin) <= 0;}
+		template<typename S>
+		bool operator>(const adv_string_view<S> &bin) const {return compare(bin) > 0;}
+		template<typename S>
+		bool operator>=(const adv_string_view<S> &bin) const {return compare(bin) >= 0;}
+#ifdef __cpp_lib_three_way_comparison
+		template<typename S>
+		std::strong_ordering operator<=>(const adv_string_view<S> &bin) const {return compare(bin) <=> 0;}
+#endif
+
 		/*
 			Note: id found is false then can return anything
 		*/
@@ -150,15 +204,41 @@ class adv_string_view{
 		template<typename S>
 		size_t indexOf(const adv_string_view<S> &, bool &found) const;
 
+		/*
+			Search the last occurrence scanning backward from the end of the string, so only the characters
+			after it are read. If the encoding isn't reversible the whole string is scanned forward.
+			An empty string is found at the end.
+			Note: if found is false then can return anything
+		*/
+		template<typename S>
+		size_t lastBytesOf(const adv_string_view<S> &, bool &found) const;
+
+		template<typename S>
+		size_t lastIndexOf(const adv_string_view<S> &, bool &found) const;
+
 		template<typename S>
 		bool containsChar(const_tchar_pt<S>) const;
 
 		template<typename S>
 		bool startsWith(const adv_string_view<S> &) const;
 
+		/*
+			The suffix must start at a character boundary
+		*/
 		template<typename S>
 		bool endsWith(const adv_string_view<S> &) const;
 
+		/*
+			Removes trailing characters satisfying pred (a function accepting a ctype), the default one removes
+			Unicode whitespaces
+		*/
+		template<typename F>
+		adv_string_view<T> trim_right(F &&pred) const;
+		adv_string_view<T> trim_right() const{
+			static_assert(std::is_same_v<typename T::ctype, unicode>, "Only Unicode strings");
+			return trim_right(is_whitespace);
+		}
+
 		const byte *data() const noexcept {return ptr.data();}
 		const char *raw() const noexcept {return (const char *)(ptr.data());}
 		std::string toString() const noexcept {return std::string{(const char *)(ptr.data()), siz};}
@@ -168,6 +248,10 @@ class adv_string_view{
 		const_tchar_pt<T> at(size_t chr) const;
 		const_tchar_pt<T> begin() const noexcept {return at(0);}
 		const_tchar_pt<T> end() const noexcept {return at(len);}
+		/*
+			Range of the decoded characters
+		*/
+		code_point_range<T> code_points() const noexcept {return code_point_range<T>{ptr, siz};}
 
 		/*
 			These functions convert out string to another one with different encoding
@@ -183,6 +267,14 @@ class adv_string_view{
 
 		template<typename S, typename U = std::allocator<byte>>
 		adv_string<S, U> basic_encoding_conversion(const U & = U{}) const;
+		/*
+			Conversions with an error handling policy
+		*/
+		template<typename U = std::allocator<byte>>
+		adv_string<WIDE<typename T::ctype>, U> basic_encoding_conversion(const EncMetric<typename T::ctype> *, conv_policy &, const U & = U{}) const;
+
+		template<typename S, typename U = std::allocator<byte>>
+		adv_string<S, U> basic_encoding_conversion(conv_policy &, const U & = U{}) const;
 
 		template<typename S, typename U = std::allocator<byte>>
 		adv_string<T, U> concatenate(const adv_string_view<S> &, const U & = U{}) const;
@@ -191,6 +283,14 @@ class adv_string_view{
 	friend adv_string_view<W> reassign(const adv_string_view<S> &);
 	template<typename S, typename V, typename R>
 	friend class adv_string_buf_0;
+	template<typename S, typename R>
+	friend class adv_intern_table;
+	template<typename S, typename R>
+	friend class adv_shared_string;
+	template<typename S, size_t M>
+	friend class adv_static_string;
+	template<typename S, typename R>
+	friend class async_reader;
 };
 
 template<typename T, typename S>
@@ -248,12 +348,35 @@ class adv_string_buf_0{
 		*/
 		template<typename S>
 		size_t append_string_c(adv_string_view<S>);
+		template<typename S>
+		size_t append_string_c(adv_string_view<S>, conv_policy &);
+		/*
+		    Convert siz bytes with encoding S before adding them
+		*/
+		template<typename S>
+		size_t append_bytes_c(const byte *, size_t siz, EncMetric_info<S>, conv_policy &);
+		/*
+		    Encode n decoded characters and add them
+		*/
+		size_t append_ctypes(const typename T::ctype *, size_t n);
+		/*
+		    Encode n ASCII characters and add them, without decoding them one by one if the
+		    encoding is ASCII compatible or widens ASCII characters (see ascii_widened)
+		*/
+		void append_ascii(const char *, size_t n);
+		/*
+		    Makes space for at least n more bytes, so the next appends don't reallocate the buffer
+		*/
+		void reserve(size_t n);
 
 		void clear() noexcept;
 		adv_string_view<T> view() const noexcept;
 		adv_string<T, U> move();
 		template<typename Alloc>
 		adv_string<T, Alloc> allocate(const Alloc & = Alloc{}) const;
+
+	friend class format_writer;
+	friend class json_conversion;
 };
 
 template<typename T, typename U = std::allocator<byte>>
@@ -313,6 +436,8 @@ class adv_string : public adv_string_view<T>{
 	friend class adv_string_view;
 	template<typename S, typename V, typename R>
 	friend class adv_string_buf_0;
+	friend class endian_swap;
+	friend class cjk_conversion;
 };
 
 template<typename S, typename T, typename U = std::allocator<byte>>
@@ -320,6 +445,17 @@ adv_string<S, U> operator+(const adv_string<S, U> &a, const adv_string<T, U> &b)
 	return a.template concatenate<T, U>(b);
 }
 
+/*
+    Copies siz bytes with encoding T replacing every maximal invalid subsequence with U+FFFD (or '?'
+    if T can't encode it), replaced is set to the number of replacements
+*/
+template<typename T, typename U = std::allocator<byte>>
+adv_string<T, U> sanitize(const byte *, size_t siz, size_t &replaced, EncMetric_info<T> = EncMetric_info<T>{}, const U & = U{});
+template<typename T, typename U = std::allocator<byte>>
+adv_string<T, U> sanitize(const adv_string_view<T> &str, size_t &replaced, const U &alloc = U{}){
+	return sanitize<T, U>(str.data(), str.size(), replaced, str.begin().raw_format(), alloc);
+}
+
 using wstr_view = adv_string_view<WIDE<unicode>>;
 
 template<typename U = std::allocator<byte>>
@@ -16,6 +16,99 @@
     You should have received a copy of the GNU Lesser General Public License
     along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
 */
+template<typename S, typename T, typename B>
+size_t policy_convert(const EncMetric_info<T> &from, const byte *in, size_t l, const EncMetric_info<S> &to, B &buffer, size_t &siz, conv_policy &pol){
+	static_assert(same_data_v<S, T>, "Impossible to convert this string");
+	using ctype = typename T::ctype;
+	bool same = from.index() == to.index();
+	//ASCII bytes are the same in both encodings
+	bool ascii = from.unity() == 1 && to.unity() == 1 && from.ascii_compatible() && to.ascii_compatible();
+	bool replace = pol.invalid == invalid_policy::replace;
+	size_t start = siz;
+	size_t nchr = 0;
+	size_t pos = 0;
+	size_t run = 0;//bytes in [run, pos) are copied unchanged
+
+	auto flush = [&](){
+		size_t n = pos - run;
+		if(n > 0){
+			buffer.exp_fit(siz + n);
+			std::memcpy(buffer.memory + siz, in + run, n);
+			siz += n;
+		}
+	};
+	//Writes all the characters or nothing
+	auto put = [&](const ctype *c, size_t n) -> bool{
+		size_t save = siz;
+		for(size_t i=0; i<n; i++){
+			uint w;
+			while(true){
+				try{
+					if(pol.unmappable == unmappable_policy::raise)
+						w = to.encode(c[i], buffer.memory + siz, buffer.dimension - siz);
+					else if(!to.encode_checked(c[i], buffer.memory + siz, buffer.dimension - siz, w)){
+						siz = save;
+						return false;
+					}
+					break;
+				}
+				catch(const buffer_small &bs){
+					count_event(stat_event::buffer_small_retries);
+					size_t req = bs.get_required_size() > 0 ? bs.get_required_size() : buffer.dimension - siz + 1;
+					buffer.exp_fit(siz + req);
+				}
+			}
+			siz += w;
+		}
+		return true;
+	};
+
+	while(pos < l){
+		if(ascii){
+			size_t a = ascii_prefix(in + pos, l - pos);
+			pos += a;
+			nchr += a;
+			if(pos == l)
+				break;
+		}
+		ctype uni;
+		uint rd;
+		bool valid = true;
+		if(replace)
+			valid = from.decode_checked(&uni, in + pos, l - pos, rd);
+		else
+			rd = from.decode(&uni, in + pos, l - pos);
+		if(valid && same){
+			pos += rd;
+			nchr++;
+			continue;
+		}
+		flush();
+		if(!valid){
+			count_invalid(from);
+			if constexpr(std::is_same_v<ctype, unicode>)
+				uni = REPLACEMENT_CHARACTER;
+			else
+				throw encoding_error{"Invalid character"};
+			pol.replaced++;
+		}
+		if(put(&uni, 1))
+			nchr++;
+		else{
+			if constexpr(std::is_same_v<ctype, unicode>)
+				nchr += substitute_unmappable(uni, pol, put);
+			else
+				throw encoding_error{"Character not included in this encoding"};
+		}
+		pos += rd;
+		run = pos;
+	}
+	flush();
+	count_decoded(from, l, nchr);
+	count_encoded(to, siz - start, nchr);
+	return nchr;
+}
+
 template<typename T>
 void deduce_lens(const_tchar_pt<T> ptr, size_t &len, size_t &siz, const terminate_func<T> &terminate){
 	len=0;
@@ -47,9 +140,11 @@ void deduce_lens(const_tchar_pt<T> ptr, size_t dim, meas measure, size_t &len, s
 		int add;
 		size_t oldim;
 
+		if(dim == 0)
+			return;
 		if(issiz){
 			try{
-				add = ptr.next();
+				add = ptr.next(dim);
 				oldim = dim;
 				dim -= add;
 				while(dim < oldim){//Overflow test for unsigned integer
@@ -57,7 +152,7 @@ void deduce_lens(const_tchar_pt<T> ptr, size_t dim, meas measure, size_t &len, s
 					len++;
 					if(dim == 0)
 						break;
-					add = ptr.next();
+					add = ptr.next(dim);
 					oldim = dim;
 					dim -= add;
 				}
@@ -115,12 +210,16 @@ void adv_string_view<T>::verify() const{
 	size_t remlen = siz;
 	const_tchar_pt<T> mem{ptr};
 	for(size_t i=0; i<len; i++){
-		if(!mem.valid_next(remlen))
+		if(!mem.valid_next(remlen)){
+			count_invalid(ptr.raw_format());
 			throw encoding_error("Invalid string encoding");
+		}
 	}
 	//La lunghezza deve essere esatta
-	if(remlen != 0)
+	if(remlen != 0){
+		count_invalid(ptr.raw_format());
 		throw encoding_error("Invalid string encoding");
+	}
 }
 
 template<typename T>
@@ -206,7 +305,7 @@ bool adv_string_view<T>::compstr(const adv_string_view<S> &t, size_t ch) const{
 	size_t l2 = t.size(ch);
 	if(l1 != l2)
 		return false;
-	return compare(data(), t.data(), l1);
+	return adv::compare(data(), t.data(), l1);
 }
 
 template<typename T> template<typename S>
@@ -215,7 +314,7 @@ bool adv_string_view<T>::operator==(const adv_string_view<S> &t) const{
 		return false;
 	if(siz != t.size())
 		return false;
-	return compare(data(), t.data(), siz);
+	return adv::compare(data(), t.data(), siz);
 }
 
 template<typename T> template<typename S>
@@ -226,7 +325,65 @@ bool adv_string_view<T>::operator==(const_tchar_pt<S> t) const{
 	deduce_lens(t, tch, tsiz);
 	if(siz != tsiz)
 		return false;
-	return compare(data(), t.data(), siz);
+	return adv::compare(data(), t.data(), siz);
+}
+
+template<typename T> template<typename S>
+int adv_string_view<T>::compare(const adv_string_view<S> &t) const{
+	static_assert(same_data_v<T, S>, "Impossible to compare these strings");
+	const_tchar_pt<T> a = ptr;
+	const_tchar_pt<S> b = t.begin();
+	size_t ra = siz;
+	size_t rb = t.size();
+	if(sameEnc(a, b)){
+		size_t common = ra < rb ? ra : rb;
+		size_t pre = common_prefix(data(), t.data(), common);
+		if(dynamic_byte_ordered(a)){
+			if(pre < common)
+				return std::to_integer<int>(data()[pre]) - std::to_integer<int>(t.data()[pre]);
+			return ra < rb ? -1 : (ra > rb ? 1 : 0);
+		}
+		//Skip characters entirely contained in the common prefix
+		size_t skip = 0;
+		if(dynamic_fixed_size(a))
+			skip = pre - (pre % a.unity());
+		else{
+			while(skip < pre){
+				size_t chl = (a + skip).chLen();
+				if(skip + chl > pre)
+					break;
+				skip += chl;
+			}
+		}
+		a += skip;
+		b += skip;
+		ra -= skip;
+		rb -= skip;
+	}
+	typename T::ctype ca, cb;
+	while(ra > 0 && rb > 0){
+		uint la = a.decode(&ca, ra);
+		uint lb = b.decode(&cb, rb);
+		if(ca != cb)
+			return ca < cb ? -1 : 1;
+		a += la;
+		b += lb;
+		ra -= la;
+		rb -= lb;
+	}
+	if(ra == 0)
+		return rb == 0 ? 0 : -1;
+	else
+		return 1;
+}
+
+template<typename T> template<typename S>
+bool adv_string_view<T>::equals(const adv_string_view<S> &t) const{
+	if(sameEnc(ptr, t.begin()))
+		return *this == t;
+	if(len != t.length())
+		return false;
+	return compare(t) == 0;
 }
 
 template<typename T> template<typename S>
@@ -248,7 +405,7 @@ size_t adv_string_view<T>::bytesOf(const adv_string_view<S> &sq, bool &found) co
 	size_t byt = 0;
 	const_tchar_pt<T> newi = ptr;
 	while(byt <= rem){
-		if(compare(newi.data(), sq.begin().data(), sq.size())){
+		if(adv::compare(newi.data(), sq.begin().data(), sq.size())){
 			found = true;
 			return byt;
 		}
@@ -278,7 +435,7 @@ size_t adv_string_view<T>::indexOf(const adv_string_view<S> &sq, bool &found) co
 	size_t chr = 0;
 	const_tchar_pt<T> newi = ptr;
 	while(byt <= rem){
-		if(compare(newi.data(), sq.begin().data(), sq.size())){
+		if(adv::compare(newi.data(), sq.begin().data(), sq.size())){
 			found = true;
 			return chr;
 		}
@@ -301,7 +458,7 @@ bool adv_string_view<T>::containsChar(const_tchar_pt<S> cu) const{
 	size_t byt = 0;
 	const_tchar_pt<T> newi = ptr;
 	while(byt <= rem){
-		if(compare(newi.data(), cu.data(), chl)){
+		if(adv::compare(newi.data(), cu.data(), chl)){
 			return true;
 		}
 		byt += newi.next();
@@ -321,7 +478,7 @@ bool adv_string_view<T>::startsWith(const adv_string_view<S> &sq) const{
 	if(siz < sq.size()){
 		return false;
 	}
-	return compare(ptr.data(), sq.begin().data(), sq.size());
+	return adv::compare(ptr.data(), sq.begin().data(), sq.size());
 }
 
 template<typename T> template<typename S>
@@ -336,8 +493,117 @@ bool adv_string_view<T>::endsWith(const adv_string_view<S> &sq) const{
 	if(siz < sq.size()){
 		return false;
 	}
-	const_tchar_pt<T> poi = ptr + siz - sq.size();
-	return compare(poi.data(), sq.begin().data(), sq.size());
+	const_tchar_pt<T> poi = ptr + (siz - sq.size());
+	if(!adv::compare(poi.data(), sq.begin().data(), sq.size()))
+		return false;
+	if(ptr.is_fixed())
+		return (siz - sq.size()) % ptr.unity() == 0;
+	//the match must start at a character boundary
+	if(ptr.reversible()){
+		size_t byt = siz;
+		const_tchar_pt<T> newi = ptr + siz;
+		while(byt > siz - sq.size())
+			byt -= newi.prev(ptr);
+		return byt == siz - sq.size();
+	}
+	else{
+		size_t byt = 0;
+		const_tchar_pt<T> newi = ptr;
+		while(byt < siz - sq.size())
+			byt += newi.next();
+		return byt == siz - sq.size();
+	}
+}
+
+template<typename T> template<typename S>
+size_t adv_string_view<T>::lastBytesOf(const adv_string_view<S> &sq, bool &found) const{
+	size_t chr = 0;
+	return last_occurrence(sq, found, chr);
+}
+
+template<typename T> template<typename S>
+size_t adv_string_view<T>::lastIndexOf(const adv_string_view<S> &sq, bool &found) const{
+	size_t chr = 0;
+	last_occurrence(sq, found, chr);
+	return chr;
+}
+
+template<typename T> template<typename S>
+size_t adv_string_view<T>::last_occurrence(const adv_string_view<S> &sq, bool &found, size_t &chr) const{
+	found = false;
+	if(!sameEnc(ptr, sq.begin()))
+		return 0;
+	if(sq.size() == 0){
+		found = true;
+		chr = len;
+		return siz;
+	}
+	if(siz < sq.size())
+		return 0;
+	size_t rem = siz - sq.size();
+	if(ptr.reversible()){
+		size_t byt = siz;
+		chr = len;
+		const_tchar_pt<T> newi = ptr + siz;
+		while(byt > 0){
+			byt -= newi.prev(ptr);
+			chr--;
+			if(byt <= rem && adv::compare(newi.data(), sq.begin().data(), sq.size())){
+				found = true;
+				return byt;
+			}
+		}
+		return 0;
+	}
+	else{
+		size_t byt = 0;
+		size_t ret = 0;
+		const_tchar_pt<T> newi = ptr;
+		for(size_t i=0; byt <= rem; i++){
+			if(adv::compare(newi.data(), sq.begin().data(), sq.size())){
+				found = true;
+				ret = byt;
+				chr = i;
+			}
+			byt += newi.next();
+		}
+		return ret;
+	}
+}
+
+template<typename T> template<typename F>
+adv_string_view<T> adv_string_view<T>::trim_right(F &&pred) const{
+	size_t byt = siz;
+	size_t chr = len;
+	typename T::ctype uni;
+	if(ptr.reversible()){
+		const_tchar_pt<T> newi = ptr + siz;
+		while(byt > 0){
+			uint l = newi.prev(ptr);
+			newi.decode(&uni, l);
+			if(!pred(uni))
+				break;
+			byt -= l;
+			chr--;
+		}
+	}
+	else{
+		//the end of the last character not satisfying pred
+		size_t pos = 0;
+		byt = 0;
+		chr = 0;
+		const_tchar_pt<T> newi = ptr;
+		for(size_t i=0; i<len; i++){
+			uint l = newi.decode(&uni, siz - pos);
+			newi += l;
+			pos += l;
+			if(!pred(uni)){
+				byt = pos;
+				chr = i+1;
+			}
+		}
+	}
+	return adv_string_view<T>{chr, byt, ptr};
 }
 
 template<typename T>
@@ -506,6 +772,8 @@ adv_string<WIDE<typename T::ctype>, U> adv_string_view<T>::basic_encoding_conver
 			from.next();
 			to.next();
 		}
+		count_decoded(ptr.raw_format(), siz, len);
+		count_encoded(destination.raw_format(), newsiz, len);
 		return adv_string<WIDE<typename T::ctype>, U>{destination.cast(), len, newsiz, std::move(temp)};
 	}
 	else{
@@ -520,6 +788,7 @@ adv_string<WIDE<typename T::ctype>, U> adv_string_view<T>::basic_encoding_conver
                     completewrite = true;
                 }
                 catch(const buffer_small &bs){
+                    count_event(stat_event::buffer_small_retries);
                     size_t olddim = temp.dimension;
                     temp.exp_fit(olddim + bs.get_required_size() +1);
                     remsiz += temp.dimension - olddim;
@@ -536,6 +805,8 @@ adv_string<WIDE<typename T::ctype>, U> adv_string_view<T>::basic_encoding_conver
 			from.next();
 			to.next();
 		}
+		count_decoded(ptr.raw_format(), siz, len);
+		count_encoded(destination.raw_format(), newsiz, len);
 		return adv_string<WIDE<typename T::ctype>, U>{destination.cast(), len, newsiz, std::move(temp)};
 	}
 }
@@ -569,6 +840,8 @@ adv_string<S, U> adv_string_view<T>::basic_encoding_conversion(const U &alloc) c
 			from.next();
 			to.next();
 		}
+		count_decoded(ptr.raw_format(), siz, len);
+		count_encoded(destination.raw_format(), newsiz, len);
 		return adv_string<S, U>{destination.cast(), len, newsiz, std::move(temp)};
 	}
 	else{
@@ -583,6 +856,7 @@ adv_string<S, U> adv_string_view<T>::basic_encoding_conversion(const U &alloc) c
                     completewrite = true;
                 }
                 catch(const buffer_small &bs){
+                    count_event(stat_event::buffer_small_retries);
                     size_t olddim = temp.dimension;
                     temp.exp_fit(olddim + bs.get_required_size() +1);
                     remsiz += temp.dimension - olddim;
@@ -600,11 +874,33 @@ adv_string<S, U> adv_string_view<T>::basic_encoding_conversion(const U &alloc) c
 			from.next();
 			to.next();
 		}
+		count_decoded(ptr.raw_format(), siz, len);
+		count_encoded(destination.raw_format(), newsiz, len);
 		return adv_string<S, U>{destination.cast(), len, newsiz, std::move(temp)};
 	}
 }
 
 
+template<typename T>
+template<typename U>
+adv_string<WIDE<typename T::ctype>, U> adv_string_view<T>::basic_encoding_conversion(const EncMetric<typename T::ctype> *format, conv_policy &pol, const U &alloc) const{
+	EncMetric_info<WIDE<typename T::ctype>> to{format};
+	basic_ptr<byte, U> temp{siz, alloc};
+	size_t newsiz = 0;
+	size_t newlen = policy_convert(ptr.raw_format(), data(), siz, to, temp, newsiz, pol);
+	return adv_string<WIDE<typename T::ctype>, U>{const_tchar_pt<WIDE<typename T::ctype>>{temp.memory, to}, newlen, newsiz, std::move(temp)};
+}
+
+template<typename T>
+template<typename S, typename U>
+adv_string<S, U> adv_string_view<T>::basic_encoding_conversion(conv_policy &pol, const U &alloc) const{
+	EncMetric_info<S> to{};
+	basic_ptr<byte, U> temp{siz, alloc};
+	size_t newsiz = 0;
+	size_t newlen = policy_convert(ptr.raw_format(), data(), siz, to, temp, newsiz, pol);
+	return adv_string<S, U>{const_tchar_pt<S>{temp.memory, to}, newlen, newsiz, std::move(temp)};
+}
+
 template<typename T>
 template<typename S, typename U>
 adv_string<T, U> adv_string_view<T>::concatenate(const adv_string_view<S> &err, const U &alloc) const{
@@ -626,8 +922,8 @@ adv_string<T, U> adv_string_view<T>::concatenate(const adv_string_view<S> &err,
 template<typename T, typename V, typename U>
 uint adv_string_buf_0<T, V, U>::append_chr(const_tchar_pt<T> ptr){
 	uint chl = ptr.chLen();
-	const byte *dat = ptr.data();
-	append(buffer, siz, dat, chl);
+	buffer.exp_fit(siz + chl);
+	std::memcpy(buffer.memory + siz, ptr.data(), chl);
 	siz += chl;
 	len++;
 	return chl;
@@ -646,42 +942,50 @@ size_t adv_string_buf_0<T, V, U>::append_chrs(const_tchar_pt<T> ptr, size_t nchr
 template<typename T, typename V, typename U>
 size_t adv_string_buf_0<T, V, U>::append_string(adv_string_view<T> str){
 	size_t ret = str.size();
-	const byte *ptr = str.data();
-	append(buffer, siz, ptr, ret);
+	if(ret > 0){
+		buffer.exp_fit(siz + ret);
+		std::memcpy(buffer.memory + siz, str.data(), ret);
+	}
 	siz += ret;
 	len += str.length();
 	return ret;
 } 
 
 template<typename T, typename V, typename U>
-bool adv_string_buf_0<T, V, U>::append_chr_v(const_tchar_pt<T> ptr, size_t siz){
+bool adv_string_buf_0<T, V, U>::append_chr_v(const_tchar_pt<T> ptr, size_t psiz){
 	uint chlen;
-	if(!ptr.validChar(chlen))
+	if(!ptr.validChar(chlen)){
+		count_invalid(ei);
 		return false;
-	else if(siz < chlen)
+	}
+	else if(psiz < chlen)
 		return false;
-	const byte *dat = ptr.data();
-	append(buffer, siz, dat, chlen);
+	buffer.exp_fit(siz + chlen);
+	std::memcpy(buffer.memory + siz, ptr.data(), chlen);
 	siz += chlen;
 	len++;
 	return true;
 }
 
 template<typename T, typename V, typename U>
-bool adv_string_buf_0<T, V, U>::append_chrs_v(const_tchar_pt<T> ptr, size_t siz, size_t nchr){
+bool adv_string_buf_0<T, V, U>::append_chrs_v(const_tchar_pt<T> ptr, size_t psiz, size_t nchr){
 	uint lbuf;
 	size_t siztotal=0;
 	const_tchar_pt<T> verify = ptr;
 	for(size_t i=0; i<nchr; i++){
-		if(!verify.validChar(lbuf))
+		if(!verify.validChar(lbuf)){
+			count_invalid(ei);
 			return false;
+		}
 		siztotal += lbuf;
-		if(siztotal > siz)
+		if(siztotal > psiz)
 			return false;
 		verify.next();
 	}
-	const byte *lay=ptr.data();
-	append(buffer, siz, lay, siztotal);
+	if(siztotal > 0){
+		buffer.exp_fit(siz + siztotal);
+		std::memcpy(buffer.memory + siz, ptr.data(), siztotal);
+	}
 	siz += siztotal;
 	len += nchr;
 	return true;
@@ -714,6 +1018,7 @@ size_t adv_string_buf_0<T, V, U>::append_string_c(adv_string_view<S> str){
 				written=true;
 			}
 			catch(const buffer_small &err){
+				count_event(stat_event::buffer_small_retries);
 				size_t tip = err.get_required_size() >0 ? err.get_required_size() : to_r +1;
 				to = tchar_pt<T>{buffer.exp_fit_and_transfer(siz + tip, to.data()), ei};
 				to_r = tip;
@@ -726,9 +1031,85 @@ size_t adv_string_buf_0<T, V, U>::append_string_c(adv_string_view<S> str){
 		return_r += wrt;
 		len ++;
 	}
+	count_decoded(str.begin().raw_format(), str.size(), nchr);
+	count_encoded(ei, return_r, nchr);
 	return return_r;
 }
 
+template<typename T, typename V, typename U>
+template<typename S>
+size_t adv_string_buf_0<T, V, U>::append_string_c(adv_string_view<S> str, conv_policy &pol){
+	return append_bytes_c(str.data(), str.size(), str.begin().raw_format(), pol);
+}
+
+template<typename T, typename V, typename U>
+template<typename S>
+size_t adv_string_buf_0<T, V, U>::append_bytes_c(const byte *data, size_t dsiz, EncMetric_info<S> format, conv_policy &pol){
+	size_t oldsiz = siz;
+	len += policy_convert(format, data, dsiz, ei, buffer, siz, pol);
+	return siz - oldsiz;
+}
+
+template<typename T, typename V, typename U>
+size_t adv_string_buf_0<T, V, U>::append_ctypes(const typename T::ctype *chrs, size_t n){
+	size_t oldsiz = siz;
+	for(size_t i=0; i<n; i++){
+		bool written = false;
+		while(!written){
+			try{
+				siz += ei.encode(chrs[i], buffer.memory + siz, buffer.dimension - siz);
+				written = true;
+			}
+			catch(const buffer_small &err){
+				count_event(stat_event::buffer_small_retries);
+				size_t tip = err.get_required_size() > 0 ? err.get_required_size() : buffer.dimension - siz + 1;
+				buffer.exp_fit(siz + tip);
+			}
+		}
+	}
+	len += n;
+	count_encoded(ei, siz - oldsiz, n);
+	return siz - oldsiz;
+}
+
+template<typename T, typename V, typename U>
+void adv_string_buf_0<T, V, U>::append_ascii(const char *s, size_t n){
+	static_assert(std::is_same_v<typename T::ctype, unicode>, "Encoding must have Unicode characters");
+	if(n == 0)
+		return;
+	uint pos;
+	if(ei.ascii_compatible()){
+		buffer.exp_fit(siz + n);
+		std::memcpy(buffer.memory + siz, s, n);
+		siz += n;
+	}
+	else if(ascii_widened(ei, pos)){
+		uint u = ei.unity();
+		buffer.exp_fit(siz + n * u);
+		byte *out = buffer.memory + siz;
+		std::memset(out, 0, n * u);
+		for(size_t i = 0; i < n; i++)
+			out[i * u + pos] = static_cast<byte>(s[i]);
+		siz += n * u;
+	}
+	else{
+		unicode tmp[64];
+		for(size_t i = 0; i < n; i += 64){
+			size_t k = n - i < 64 ? n - i : 64;
+			for(size_t j = 0; j < k; j++)
+				tmp[j] = unicode{static_cast<std::uint32_t>(s[i + j])};
+			append_ctypes(tmp, k);
+		}
+		return;
+	}
+	len += n;
+}
+
+template<typename T, typename V, typename U>
+void adv_string_buf_0<T, V, U>::reserve(size_t n){
+	buffer.exp_fit(siz + n);
+}
+
 template<typename T, typename V, typename U>
 void adv_string_buf_0<T, V, U>::clear() noexcept{
 	siz=0;
@@ -779,5 +1160,11 @@ adv_string<T, U> adv_string<T, U>::newinstance_ter(const_tchar_pt<T> pt, const t
 	return adv_string<T, U>{pt, len, siz, basic_ptr<byte, U>{pt.data(), (std::size_t)siz, alloc}, 0};
 }
 
-
-
+template<typename T, typename U>
+adv_string<T, U> sanitize(const byte *data, size_t dsiz, size_t &replaced, EncMetric_info<T> format, const U &alloc){
+	adv_string_buf<T, U> buf{format, alloc};
+	conv_policy pol{invalid_policy::replace, unmappable_policy::replace};
+	buf.append_bytes_c(data, dsiz, format, pol);
+	replaced = pol.replaced;
+	return buf.move();
+}
@@ -37,6 +37,25 @@
         and returns the number of bytes read. If there aren't enough bytes it must throw buffer_small
      - unsigned int encode(const T &, byte *, size_t)  => encode the Unicode character and writes it in the memory pointed
         and returns the number of bytes written. If there isn't enough space it must throw buffer_small
+
+    Optionally it can also declare
+
+     - constexpr bool byte_ordered() noexcept => true if comparing two encoded strings byte by byte gives the
+        same result of comparing their characters one by one (for example UTF-8)
+     - constexpr bool ascii_compatible() noexcept => true if any byte lower than 0x80 is the encoding of the
+        corresponding ASCII character and it never appears inside other characters
+     - constexpr bool ascii_units() noexcept => true if any code unit (unity bytes) lower than 0x80 is the encoding
+        of the corresponding ASCII character and it never appears inside other characters (for example UTF-16)
+     - bool decode_checked(T *, const byte *, size_t, unsigned int &) noexcept => strict version of decode: if the
+        first character is valid and complete decodes it, sets its length and returns true. Otherwise returns
+        false and sets the length of the maximal invalid subsequence that should be replaced (at least 1 if
+        the input is not empty). If not declared every invalid code unit is replaced separately
+     - bool encode_checked(const T &, byte *, size_t, unsigned int &) => like encode, but returns false instead
+        of throwing when the character can't be represented in this encoding. It still throws buffer_small
+     - unsigned int prevLen(const byte *begin, const byte *end) => the length in bytes of the last character before
+        end, without reading before begin (end > begin). It can be declared only by self-synchronizing encodings
+        (for example UTF-8), fixed size encodings don't need it. Throws an encoding_error if the length can't be
+        recognized
 */
 #include <encmetric/base.hpp>
 #include <typeindex>
@@ -46,6 +65,8 @@
 
 namespace adv{
 
+class translit_table;
+
 inline void copyN(const byte *src, byte *des, size_t l) {std::memcpy(des, src, l);}
 
 template<typename T>
@@ -61,6 +82,13 @@ class EncMetric{
 		virtual uint d_decode(ctype *, const byte *, size_t) const =0;
 		virtual uint d_encode(const ctype &, byte *, size_t) const =0;
 		virtual bool d_fixed_size() const noexcept =0;
+		virtual bool d_byte_ordered() const noexcept {return false;}
+		virtual bool d_ascii_compatible() const noexcept {return false;}
+		virtual bool d_ascii_units() const noexcept {return false;}
+		virtual bool d_decode_checked(ctype *, const byte *, size_t, uint &len) const noexcept;
+		virtual bool d_encode_checked(const ctype &, byte *, size_t, uint &len) const;
+		virtual bool d_reversible() const noexcept {return d_fixed_size();}
+		virtual uint d_prevLen(const byte *, const byte *) const;
 		virtual std::type_index index() const noexcept=0;
 };
 
@@ -183,6 +211,81 @@ inline constexpr bool fixed_size = T::has_max() && (T::unity() == T::max_bytes()
 template<typename tt>
 inline constexpr bool fixed_size<WIDE<tt>> = false;
 
+/*
+    Test if the encoding declares byte_ordered
+*/
+template<typename T, typename = void>
+struct is_byte_ordered : public std::false_type {};
+template<typename T>
+struct is_byte_ordered<T, std::void_t<decltype(T::byte_ordered())>> : public std::bool_constant<T::byte_ordered()> {};
+
+template<typename T>
+inline constexpr bool is_byte_ordered_v = is_byte_ordered<T>::value;
+
+/*
+    Test if the encoding declares ascii_compatible
+*/
+template<typename T, typename = void>
+struct is_ascii_compatible : public std::false_type {};
+template<typename T>
+struct is_ascii_compatible<T, std::void_t<decltype(T::ascii_compatible())>> : public std::bool_constant<T::ascii_compatible()> {};
+
+template<typename T>
+inline constexpr bool is_ascii_compatible_v = is_ascii_compatible<T>::value;
+
+/*
+    Test if the encoding declares ascii_units
+*/
+template<typename T, typename = void>
+struct is_ascii_units : public std::false_type {};
+template<typename T>
+struct is_ascii_units<T, std::void_t<decltype(T::ascii_units())>> : public std::bool_constant<T::ascii_units()> {};
+
+template<typename T>
+inline constexpr bool is_ascii_units_v = is_ascii_units<T>::value;
+
+/*
+    Test if the encoding declares decode_checked
+*/
+template<typename T, typename = void>
+struct has_decode_checked : public std::false_type {};
+template<typename T>
+struct has_decode_checked<T, std::void_t<decltype(T::decode_checked(std::declval<typename T::ctype *>(), std::declval<const byte *>(), size_t{}, std::declval<uint &>()))>> : public std::true_type {};
+
+template<typename T>
+inline constexpr bool has_decode_checked_v = has_decode_checked<T>::value;
+
+/*
+    Test if the encoding declares encode_checked
+*/
+template<typename T, typename = void>
+struct has_encode_checked : public std::false_type {};
+template<typename T>
+struct has_encode_checked<T, std::void_t<decltype(T::encode_checked(std::declval<const typename T::ctype &>(), std::declval<byte *>(), size_t{}, std::declval<uint &>()))>> : public std::true_type {};
+
+template<typename T>
+inline constexpr bool has_encode_checked_v = has_encode_checked<T>::value;
+
+/*
+    Test if the encoding declares prevLen
+*/
+template<typename T, typename = void>
+struct has_prevLen : public std::false_type {};
+template<typename T>
+struct has_prevLen<T, std::void_t<decltype(T::prevLen(std::declval<const byte *>(), std::declval<const byte *>()))>> : public std::true_type {};
+
+template<typename T>
+inline constexpr bool has_prevLen_v = has_prevLen<T>::value;
+
+/*
+    Test if strings encoded with T can be read backward
+*/
+template<typename T>
+struct is_reversible : public std::bool_constant<fixed_size<T> || has_prevLen_v<T>> {};
+
+template<typename T>
+inline constexpr bool is_reversible_v = is_reversible<T>::value;
+
 template<typename T>
 constexpr int min_length(int nchr) noexcept{
 	return T::unity() * nchr;
@@ -237,6 +340,28 @@ class DynEncoding : public EncMetric<typename T::ctype>{
 		uint d_encode(const typename T::ctype &uni, byte *by, size_t l) const {return static_enc::encode(uni, by, l);}
 
 		bool d_fixed_size() const noexcept {return fixed_size<T>;}
+		bool d_byte_ordered() const noexcept {return is_byte_ordered_v<T>;}
+		bool d_ascii_compatible() const noexcept {return is_ascii_compatible_v<T>;}
+		bool d_ascii_units() const noexcept {return is_ascii_units_v<T>;}
+		bool d_decode_checked(typename T::ctype *uni, const byte *by, size_t l, uint &len) const noexcept{
+			if constexpr(has_decode_checked_v<T>)
+				return static_enc::decode_checked(uni, by, l, len);
+			else
+				return EncMetric<typename T::ctype>::d_decode_checked(uni, by, l, len);
+		}
+		bool d_encode_checked(const typename T::ctype &uni, byte *by, size_t l, uint &len) const{
+			if constexpr(has_encode_checked_v<T>)
+				return static_enc::encode_checked(uni, by, l, len);
+			else
+				return EncMetric<typename T::ctype>::d_encode_checked(uni, by, l, len);
+		}
+		bool d_reversible() const noexcept {return is_reversible_v<T>;}
+		uint d_prevLen(const byte *b, const byte *e) const{
+			if constexpr(has_prevLen_v<T>)
+				return static_enc::prevLen(b, e);
+			else
+				return EncMetric<typename T::ctype>::d_prevLen(b, e);
+		}
 
 		static const EncMetric<typename T::ctype> *instance() noexcept{
 			static DynEncoding<T> t{};
@@ -244,6 +369,20 @@ class DynEncoding : public EncMetric<typename T::ctype>{
 		}
 };
 
+/*
+    Length of the character at b when only rem bytes can be read. If rem is lower than max_bytes (or 16)
+    chLen works on a zero padded copy, so encodings that look at the following bytes never read past b + rem
+*/
+template<typename F>
+uint bounded_chLen(const F &f, const byte *b, size_t rem){
+	size_t bound = f.has_max() && f.max_bytes() < 16 ? f.max_bytes() : 16;
+	if(f.is_fixed() || rem >= bound)
+		return f.chLen(b);
+	byte tmp[16]{};
+	std::memcpy(tmp, b, rem);
+	return f.chLen(tmp);
+}
+
 /*
     Store information about used encoding
 */
@@ -260,10 +399,18 @@ class EncMetric_info{
 		constexpr bool has_max() const noexcept {return T::has_max();}
 		constexpr uint max_bytes() const noexcept {return T::max_bytes();}
 		constexpr bool is_fixed() const noexcept {return fixed_size<T>;}
+		constexpr bool byte_ordered() const noexcept {return is_byte_ordered_v<T>;}
+		constexpr bool ascii_compatible() const noexcept {return is_ascii_compatible_v<T>;}
+		constexpr bool ascii_units() const noexcept {return is_ascii_units_v<T>;}
+		constexpr bool reversible() const noexcept {return is_reversible_v<T>;}
 		uint chLen(const byte *b) const {return T::chLen(b);}
+		uint chLen(const byte *b, size_t rem) const {return bounded_chLen(*this, b, rem);}
 		bool validChar(const byte *b, uint &l) const noexcept {return T::validChar(b, l);}
 		uint decode(ctype *uni, const byte *by, size_t l) const {return T::decode(uni, by, l);}
 		uint encode(const ctype &uni, byte *by, size_t l) const {return T::encode(uni, by, l);}
+		bool decode_checked(ctype *uni, const byte *by, size_t l, uint &len) const noexcept;
+		bool encode_checked(const ctype &uni, byte *by, size_t l, uint &len) const;
+		uint prevLen(const byte *b, const byte *e) const;
 		std::type_index index() const noexcept {return index_traits<T>::index();}
 };
 
@@ -281,13 +428,195 @@ class EncMetric_info<WIDE<tt>>{
 		bool has_max() const noexcept {return f->d_has_max();}
 		uint max_bytes() const noexcept {return f->d_max_bytes();}
 		bool is_fixed() const noexcept {return f->d_fixed_size();}
+		bool byte_ordered() const noexcept {return f->d_byte_ordered();}
+		bool ascii_compatible() const noexcept {return f->d_ascii_compatible();}
+		bool ascii_units() const noexcept {return f->d_ascii_units();}
+		bool reversible() const noexcept {return f->d_reversible();}
 		uint chLen(const byte *b) const {return f->d_chLen(b);}
+		uint chLen(const byte *b, size_t rem) const {return bounded_chLen(*this, b, rem);}
 		bool validChar(const byte *b, uint &l) const noexcept {return f->d_validChar(b, l);}
 		uint decode(ctype *uni, const byte *by, size_t l) const {return f->d_decode(uni, by, l);}
 		uint encode(const ctype &uni, byte *by, size_t l) const {return f->d_encode(uni, by, l);}
+		bool decode_checked(ctype *uni, const byte *by, size_t l, uint &len) const noexcept {return f->d_decode_checked(uni, by, l, len);}
+		bool encode_checked(const ctype &uni, byte *by, size_t l, uint &len) const {return f->d_encode_checked(uni, by, l, len);}
+		uint prevLen(const byte *b, const byte *e) const {return f->d_prevLen(b, e);}
 		std::type_index index() const noexcept {return f->index();}
 };
 
+/*
+    Default implementation of decode_checked: a character is valid if validChar accepts it and decode doesn't
+    fail. For Unicode characters the result must also be a Unicode scalar value with a unique encoding
+    (so overlong forms are rejected). Otherwise the first code unit is marked as invalid
+*/
+template<typename F>
+bool basic_decode_checked(const F &f, typename F::ctype *uni, const byte *by, size_t l, uint &len) noexcept{
+	uint u = f.unity();
+	if(l < u){
+		len = static_cast<uint>(l);
+		return false;
+	}
+	len = u;
+	try{
+		uint chl = bounded_chLen(f, by, l);
+		if(chl > l || !f.validChar(by, chl))
+			return false;
+		f.decode(uni, by, chl);
+		if constexpr(std::is_same_v<typename F::ctype, unicode>){
+			if(*uni > 0x10FFFF || (*uni >= 0xD800 && *uni < 0xE000))
+				return false;
+			if(!f.is_fixed() && chl <= 16){
+				byte enc[16];
+				if(f.encode(*uni, enc, 16) != chl || std::memcmp(enc, by, chl) != 0)
+					return false;
+			}
+		}
+		len = chl;
+		return true;
+	}
+	catch(...){
+		return false;
+	}
+}
+
+/*
+    Default implementation of encode_checked, errors different from buffer_small mean that the character
+    can't be represented
+*/
+template<typename F>
+bool basic_encode_checked(const F &f, const typename F::ctype &uni, byte *by, size_t l, uint &len){
+	try{
+		len = f.encode(uni, by, l);
+		return true;
+	}
+	catch(const buffer_small &){
+		throw;
+	}
+	catch(const encoding_error &){
+		return false;
+	}
+}
+
+template<typename T>
+bool EncMetric<T>::d_encode_checked(const ctype &uni, byte *by, size_t l, uint &len) const{
+	return basic_encode_checked(EncMetric_info<WIDE<T>>{this}, uni, by, l, len);
+}
+
+template<typename T>
+bool EncMetric_info<T>::encode_checked(const ctype &uni, byte *by, size_t l, uint &len) const{
+	if constexpr(has_encode_checked_v<T>)
+		return T::encode_checked(uni, by, l, len);
+	else
+		return basic_encode_checked(*this, uni, by, l, len);
+}
+
+template<typename T>
+bool EncMetric<T>::d_decode_checked(ctype *uni, const byte *by, size_t l, uint &len) const noexcept{
+	return basic_decode_checked(EncMetric_info<WIDE<T>>{this}, uni, by, l, len);
+}
+
+template<typename T>
+bool EncMetric_info<T>::decode_checked(ctype *uni, const byte *by, size_t l, uint &len) const noexcept{
+	if constexpr(has_decode_checked_v<T>)
+		return T::decode_checked(uni, by, l, len);
+	else
+		return basic_decode_checked(*this, uni, by, l, len);
+}
+
+template<typename T>
+uint EncMetric<T>::d_prevLen(const byte *, const byte *) const{
+	if(d_fixed_size())
+		return d_unity();
+	else
+		throw encoding_error{"Encoding not reversible"};
+}
+
+template<typename T>
+uint EncMetric_info<T>::prevLen(const byte *b, const byte *e) const{
+	if constexpr(has_prevLen_v<T>)
+		return T::prevLen(b, e);
+	else if constexpr(fixed_size<T>)
+		return T::unity();
+	else
+		throw encoding_error{"Encoding not reversible"};
+}
+
+/*
+    True if every ASCII character is encoded in unity bytes, all zero except the one at position pos
+    that contains its ASCII code (like UTF16 and UTF32). The encoding must be fixed size or declare
+    ascii_units, so these units never appear inside other characters. ASCII compatible encodings have pos = 0
+*/
+template<typename F>
+bool ascii_widened(const F &f, uint &pos) noexcept{
+	if constexpr(!std::is_same_v<typename F::ctype, unicode>)
+		return false;
+	else{
+		uint u = f.unity();
+		if((!f.is_fixed() && !f.ascii_units()) || u > 8)
+			return false;
+		byte a[8], b[8];
+		try{
+			if(f.encode(unicode{'0'}, a, 8) != u || f.encode(unicode{'z'}, b, 8) != u)
+				return false;
+		}
+		catch(...){
+			return false;
+		}
+		for(pos = 0; pos < u && a[pos] == byte{0}; pos++);
+		if(pos == u || a[pos] != byte{'0'} || b[pos] != byte{'z'})
+			return false;
+		for(uint i = 0; i < u; i++){
+			if(i != pos && (a[i] != byte{0} || b[i] != byte{0}))
+				return false;
+		}
+		return true;
+	}
+}
+
+/*
+    Handling of invalid input sequences during conversions:
+     - raise: an encoding_error is thrown
+     - replace: every maximal invalid subsequence is replaced by U+FFFD
+*/
+enum class invalid_policy{
+	raise,
+	replace
+};
+
+/*
+    Handling of characters that can't be represented in the destination encoding:
+     - raise: an encoding_error is thrown
+     - replace: the replacement character is written instead
+     - transliterate: the character is approximated with the transliteration table (translit_table::ascii() if
+       not provided), if this isn't possible it's replaced
+     - ncr: the character is written as a decimal numeric character reference (&#8364;)
+*/
+enum class unmappable_policy{
+	raise,
+	replace,
+	transliterate,
+	ncr
+};
+
+/*
+    Error handling policy of a conversion, it also counts the applied replacements:
+     - replaced: invalid input sequences
+     - unmapped: characters that can't be represented (including transliterated ones)
+     - transliterated: characters approximated by the transliteration table
+*/
+struct conv_policy{
+	invalid_policy invalid;
+	unmappable_policy unmappable;
+	unicode replacement;
+	const translit_table *translit;
+	size_t replaced;
+	size_t unmapped;
+	size_t transliterated;
+
+	conv_policy(invalid_policy inv = invalid_policy::raise, unmappable_policy unm = unmappable_policy::raise, unicode rep = unicode{'?'}, const translit_table *tr = nullptr) noexcept
+		: invalid{inv}, unmappable{unm}, replacement{rep}, translit{tr}, replaced{0}, unmapped{0}, transliterated{0} {}
+	conv_policy(unmappable_policy unm, unicode rep = unicode{'?'}, const translit_table *tr = nullptr) noexcept : conv_policy{invalid_policy::raise, unm, rep, tr} {}
+};
+
 /*
     Some basic encodings
 */
@@ -297,10 +626,13 @@ class ASCII{
 		static constexpr uint unity() noexcept {return 1;}
 		static constexpr bool has_max() noexcept {return true;}
 		static constexpr uint max_bytes() noexcept {return 1;}
+		static constexpr bool byte_ordered() noexcept {return true;}
+		static constexpr bool ascii_compatible() noexcept {return true;}
 		static uint chLen(const byte *);
 		static bool validChar(const byte *, uint &) noexcept;
 		static uint decode(unicode *uni, const byte *by, size_t l);
 		static uint encode(const unicode &uni, byte *by, size_t l);
+		static bool encode_checked(const unicode &uni, byte *by, size_t l, uint &len);
 };
 
 class Latin1{
@@ -309,10 +641,13 @@ class Latin1{
 		static constexpr uint unity() noexcept {return 1;}
 		static constexpr bool has_max() noexcept {return true;}
 		static constexpr uint max_bytes() noexcept {return 1;}
+		static constexpr bool byte_ordered() noexcept {return true;}
+		static constexpr bool ascii_compatible() noexcept {return true;}
 		static uint chLen(const byte *);
 		static bool validChar(const byte *, uint &) noexcept;
 		static uint decode(unicode *uni, const byte *by, size_t l);
 		static uint encode(const unicode &uni, byte *by, size_t l);
+		static bool encode_checked(const unicode &uni, byte *by, size_t l, uint &len);
 };
 
 }
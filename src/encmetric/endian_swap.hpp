@@ -0,0 +1,95 @@
+#pragma once
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+    Conversion between the big endian and the little endian versions of UTF16 and UTF32.
+
+    Bytes are swapped 8 at a time and the input is validated in the same pass: surrogates must be
+    correctly paired in UTF16 and characters must be Unicode scalar values in UTF32.
+    The in-place versions reuse the memory of the string, nothing is allocated.
+*/
+#include <encmetric/enc_string.hpp>
+#include <encmetric/utf16_enc.hpp>
+#include <encmetric/utf32_enc.hpp>
+
+namespace adv{
+
+/*
+    Copies siz bytes from in to out (that can be equal to in) swapping the byte order of every
+    code unit, be is the byte order of in. Stops at the first invalid character and returns the
+    number of bytes converted (only them are written), so the input is valid if and only if siz
+    is returned
+*/
+size_t swap_utf16(const byte *in, byte *out, size_t siz, bool be) noexcept;
+size_t swap_utf32(const byte *in, byte *out, size_t siz, bool be) noexcept;
+
+class endian_swap{
+	private:
+		template<typename T>
+		static size_t swap_units(const byte *, byte *, size_t, bool be) noexcept;
+		template<typename S, typename T, typename U>
+		static adv_string<S, U> convert(const adv_string_view<T> &, bool be, const U &);
+		template<typename S, typename T, typename U>
+		static adv_string<S, U> convert(adv_string<T, U> &&, bool be);
+	public:
+		template<bool be, typename U>
+		static adv_string<UTF16<!be>, U> swap(const adv_string_view<UTF16<be>> &str, const U &alloc) {return convert<UTF16<!be>>(str, be, alloc);}
+		template<bool be, typename U>
+		static adv_string<UTF32<!be>, U> swap(const adv_string_view<UTF32<be>> &str, const U &alloc) {return convert<UTF32<!be>>(str, be, alloc);}
+		template<bool be, typename U>
+		static adv_string<UTF16<!be>, U> swap(adv_string<UTF16<be>, U> &&str) {return convert<UTF16<!be>>(std::move(str), be);}
+		template<bool be, typename U>
+		static adv_string<UTF32<!be>, U> swap(adv_string<UTF32<be>, U> &&str) {return convert<UTF32<!be>>(std::move(str), be);}
+};
+
+/*
+    All these functions throw encoding_error if the string is not valid
+*/
+template<bool be, typename U = std::allocator<byte>>
+adv_string<UTF16<!be>, U> swap_byte_order(const adv_string_view<UTF16<be>> &str, const U &alloc = U{}){
+	return endian_swap::swap(str, alloc);
+}
+template<bool be, typename U = std::allocator<byte>>
+adv_string<UTF32<!be>, U> swap_byte_order(const adv_string_view<UTF32<be>> &str, const U &alloc = U{}){
+	return endian_swap::swap(str, alloc);
+}
+/*
+    In-place versions, str is left empty (or untouched if an exception is thrown)
+*/
+template<bool be, typename U>
+adv_string<UTF16<!be>, U> swap_byte_order(adv_string<UTF16<be>, U> &&str){
+	return endian_swap::swap(std::move(str));
+}
+template<bool be, typename U>
+adv_string<UTF32<!be>, U> swap_byte_order(adv_string<UTF32<be>, U> &&str){
+	return endian_swap::swap(std::move(str));
+}
+/*
+    The content of buf is moved out (see adv_string_buf_0::move) and converted in place
+*/
+template<bool be, typename U>
+adv_string<UTF16<!be>, U> swap_byte_order(adv_string_buf<UTF16<be>, U> &buf){
+	return endian_swap::swap(buf.move());
+}
+template<bool be, typename U>
+adv_string<UTF32<!be>, U> swap_byte_order(adv_string_buf<UTF32<be>, U> &buf){
+	return endian_swap::swap(buf.move());
+}
+
+#include <encmetric/endian_swap.tpp>
+}
@@ -0,0 +1,53 @@
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+template<typename T>
+size_t endian_swap::swap_units(const byte *in, byte *out, size_t siz, bool be) noexcept{
+	if constexpr(T::unity() == 2)
+		return swap_utf16(in, out, siz, be);
+	else
+		return swap_utf32(in, out, siz, be);
+}
+
+template<typename S, typename T, typename U>
+adv_string<S, U> endian_swap::convert(const adv_string_view<T> &str, bool be, const U &alloc){
+	size_t siz = str.size();
+	basic_ptr<byte, U> to{siz, alloc};
+	size_t ok = swap_units<T>(str.data(), to.memory, siz, be);
+	if(ok != siz)
+		throw encoding_error{"Invalid character"};
+	return adv_string<S, U>{const_tchar_pt<S>{}, str.length(), siz, std::move(to), 0};
+}
+
+template<typename S, typename T, typename U>
+adv_string<S, U> endian_swap::convert(adv_string<T, U> &&str, bool be){
+	size_t siz = str.size(), len = str.length();
+	byte *b = const_cast<byte *>(str.data());
+	basic_ptr<byte, U> to = std::move(str.bind);
+	size_t ok = swap_units<T>(b, b, siz, be);
+	if(ok != siz){
+		/*
+		    Restores the converted part and gives the memory back to str
+		*/
+		swap_units<T>(b, b, ok, !be);
+		str.bind = std::move(to);
+		throw encoding_error{"Invalid character"};
+	}
+	static_cast<adv_string_view<T> &>(str) = adv_string_view<T>{const_tchar_pt<T>{}, size_t{0}, size_t{0}};
+	return adv_string<S, U>{const_tchar_pt<S>{b}, len, siz, std::move(to)};
+}
@@ -18,6 +18,7 @@
 */
 
 #include <encmetric/base.hpp>
+#include <encmetric/stats.hpp>
 #include <exception>
 
 namespace adv{
@@ -26,7 +27,7 @@ class encoding_error : public std::exception{
 	private:
 		const char *c;
 	public:
-		encoding_error(const char *ms) : c{ms} {}
+		encoding_error(const char *ms) : c{ms} {count_event(stat_event::exceptions);}
 		encoding_error() : encoding_error{"EncMetric error"} {}
 		const char *what() const noexcept override {return c;}
 };
@@ -0,0 +1,124 @@
+#pragma once
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+    Formatting of values directly into an adv_string_buf, with a subset of the std::format syntax:
+
+        {[index][:[[fill]align][sign][#][0][width][.precision][type]]}
+
+    align is one of < > ^, sign one of + - (space), type one of d x X b o (integers),
+    f e g (floating point numbers), c (characters) and s (strings and booleans). {{ and }} are
+    the braces themselves.
+
+    The format string must be built with ENCMETRIC_FORMAT, so it's parsed and checked against the
+    argument types at compile time. It must be encoded in UTF-8.
+    Arguments can be integers, floating point numbers, booleans, characters (unicode, char32_t and
+    ASCII char), UTF-8 strings (const char *, std::string, std::string_view) and adv_string_view
+    (or adv_string) with any encoding with Unicode characters, converted to the encoding of the buffer.
+    width and precision are measured in characters.
+*/
+#include <array>
+#include <tuple>
+#include <limits>
+#include <utility>
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <cstring>
+#include <cmath>
+#include <encmetric/enc_string.hpp>
+#include <encmetric/utf8_enc.hpp>
+
+namespace adv{
+
+struct format_string_tag{};
+
+template<typename F>
+inline constexpr bool is_format_string_v = std::is_base_of_v<format_string_tag, F>;
+
+/*
+    Format string checked at compile time
+*/
+#define ENCMETRIC_FORMAT(s) [](){ \
+		struct encmetric_format_string_ : adv::format_string_tag{ \
+			static constexpr std::string_view get() noexcept {return s;} \
+		}; \
+		return encmetric_format_string_{}; \
+	}()
+
+enum class fmt_kind : std::uint8_t{
+	none, integer, boolean, character, floating, string
+};
+
+enum class fmt_align : std::uint8_t{
+	none, left, right, center
+};
+
+struct fmt_spec{
+	std::uint32_t fill;
+	fmt_align align;
+	char sign;
+	bool alt;
+	bool zero;
+	size_t width;
+	int precision;
+	char type;
+};
+
+/*
+    Literal text followed by a replacement field (if arg is not negative)
+*/
+struct fmt_piece{
+	size_t lit_first;
+	size_t lit_size;
+	size_t lit_length;
+	bool lit_ascii;
+	int arg;
+	fmt_spec spec;
+};
+
+enum class fmt_error : std::uint8_t{
+	none, syntax, index, type
+};
+
+struct fmt_parse_result{
+	fmt_error error;
+	size_t npieces;
+};
+
+/*
+    Kind of an argument of type A, none if it can't be formatted
+*/
+template<typename A>
+constexpr fmt_kind fmt_kind_of() noexcept;
+
+/*
+    Parses s, where the i-th argument has kind kinds[i]. If out isn't null the pieces are written in it
+*/
+constexpr fmt_parse_result parse_format(std::string_view s, const fmt_kind *kinds, size_t nargs, fmt_piece *out) noexcept;
+
+/*
+    Appends the formatted arguments to buf and returns the number of bytes appended. The estimated
+    size of the result is reserved before writing.
+    Throws encoding_error if a string can't be converted into the encoding of buf
+*/
+template<typename T, typename U, typename F, typename... A>
+size_t format_to(adv_string_buf<T, U> &buf, F fmt, const A &... args);
+
+#include <encmetric/format.tpp>
+}
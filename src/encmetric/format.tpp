@@ -0,0 +1,499 @@
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+template<typename S>
+std::true_type fmt_is_view(const adv_string_view<S> *);
+std::false_type fmt_is_view(...);
+
+template<typename A>
+constexpr fmt_kind fmt_kind_of() noexcept{
+	using D = std::decay_t<A>;
+	if constexpr(std::is_same_v<D, bool>)
+		return fmt_kind::boolean;
+	else if constexpr(std::is_same_v<D, char> || std::is_same_v<D, char32_t> || std::is_same_v<D, unicode>)
+		return fmt_kind::character;
+	else if constexpr(std::is_same_v<D, wchar_t> || std::is_same_v<D, char16_t>)
+		return fmt_kind::none;
+	else if constexpr(std::is_integral_v<D>)
+		return fmt_kind::integer;
+	else if constexpr(std::is_floating_point_v<D>)
+		return fmt_kind::floating;
+	else if constexpr(std::is_same_v<D, const char *> || std::is_same_v<D, char *> || std::is_same_v<D, std::string> || std::is_same_v<D, std::string_view>)
+		return fmt_kind::string;
+	else if constexpr(decltype(fmt_is_view(std::declval<const D *>()))::value)
+		return fmt_kind::string;
+	else
+		return fmt_kind::none;
+}
+
+constexpr bool fmt_is_digit(char c) noexcept{
+	return c >= '0' && c <= '9';
+}
+
+constexpr fmt_align fmt_align_of(char c) noexcept{
+	switch(c){
+		case '<':
+			return fmt_align::left;
+		case '>':
+			return fmt_align::right;
+		case '^':
+			return fmt_align::center;
+		default:
+			return fmt_align::none;
+	}
+}
+
+/*
+    Decodes the UTF-8 character at s[i] and returns its length, 0 if it isn't valid
+*/
+constexpr size_t fmt_utf8_char(std::string_view s, size_t i, std::uint32_t &c) noexcept{
+	std::uint32_t b = static_cast<unsigned char>(s[i]);
+	size_t n = b < 0x80 ? 1 : (b >= 0xc2 && b < 0xe0) ? 2 : (b >= 0xe0 && b < 0xf0) ? 3 : (b >= 0xf0 && b < 0xf5) ? 4 : 0;
+	if(n == 0 || i + n > s.size())
+		return 0;
+	c = n == 1 ? b : (b & (0x7f >> n));
+	for(size_t j = 1; j < n; j++){
+		std::uint32_t t = static_cast<unsigned char>(s[i + j]);
+		if((t & 0xc0) != 0x80)
+			return 0;
+		c = (c << 6) | (t & 0x3f);
+	}
+	if((n == 3 && c < 0x800) || (c >= 0xd800 && c < 0xe000) || (n == 4 && (c < 0x10000 || c > 0x10ffff)))
+		return 0;
+	return n;
+}
+
+constexpr bool fmt_check_spec(const fmt_spec &sp, fmt_kind k) noexcept{
+	char t = sp.type;
+	switch(k){
+		case fmt_kind::integer:
+			return sp.precision < 0 && (t == 0 || t == 'd' || t == 'x' || t == 'X' || t == 'b' || t == 'o');
+		case fmt_kind::floating:
+			return !sp.alt && (t == 0 || t == 'f' || t == 'e' || t == 'g');
+		case fmt_kind::boolean:
+		case fmt_kind::string:
+		case fmt_kind::character:
+			if(sp.sign != 0 || sp.alt || sp.zero || sp.precision >= 0)
+				return false;
+			return t == 0 || t == (k == fmt_kind::character ? 'c' : 's');
+		default:
+			return false;
+	}
+}
+
+constexpr fmt_piece fmt_start_piece(size_t first) noexcept{
+	return fmt_piece{first, 0, 0, true, -1, fmt_spec{' ', fmt_align::none, 0, false, false, 0, -1, 0}};
+}
+
+/*
+    Reads a decimal number not greater than max
+*/
+constexpr bool fmt_number(std::string_view s, size_t &i, size_t max, size_t &val) noexcept{
+	val = 0;
+	while(i < s.size() && fmt_is_digit(s[i])){
+		val = val * 10 + (s[i] - '0');
+		if(val > max)
+			return false;
+		i++;
+	}
+	return true;
+}
+
+constexpr fmt_parse_result parse_format(std::string_view s, const fmt_kind *kinds, size_t nargs, fmt_piece *out) noexcept{
+	constexpr fmt_parse_result syntax_error{fmt_error::syntax, 0};
+	size_t np = 0, i = 0, next_arg = 0;
+	//0 not determined, 1 automatic indexing, 2 manual indexing
+	int indexing = 0;
+	fmt_piece cur = fmt_start_piece(0);
+	while(i < s.size()){
+		char c = s[i];
+		if(c != '{' && c != '}'){
+			std::uint32_t chr = 0;
+			size_t n = fmt_utf8_char(s, i, chr);
+			if(n == 0)
+				return syntax_error;
+			if(n > 1)
+				cur.lit_ascii = false;
+			cur.lit_length++;
+			i += n;
+			continue;
+		}
+		if(i + 1 < s.size() && s[i + 1] == c){
+			//escaped brace, the piece ends with the first one
+			cur.lit_size = i + 1 - cur.lit_first;
+			cur.lit_length++;
+			if(out != nullptr)
+				out[np] = cur;
+			np++;
+			i += 2;
+			cur = fmt_start_piece(i);
+			continue;
+		}
+		if(c == '}')
+			return syntax_error;
+		cur.lit_size = i - cur.lit_first;
+		i++;
+		size_t idx = 0;
+		if(i < s.size() && fmt_is_digit(s[i])){
+			if(indexing == 1 || !fmt_number(s, i, nargs, idx))
+				return indexing == 1 ? syntax_error : fmt_parse_result{fmt_error::index, 0};
+			indexing = 2;
+		}
+		else{
+			if(indexing == 2)
+				return syntax_error;
+			indexing = 1;
+			idx = next_arg++;
+		}
+		if(idx >= nargs)
+			return fmt_parse_result{fmt_error::index, 0};
+		cur.arg = static_cast<int>(idx);
+		fmt_spec &sp = cur.spec;
+		if(i < s.size() && s[i] == ':'){
+			i++;
+			std::uint32_t fill = 0;
+			size_t n = i < s.size() ? fmt_utf8_char(s, i, fill) : 0;
+			if(n > 0 && i + n < s.size() && fmt_align_of(s[i + n]) != fmt_align::none && s[i] != '{' && s[i] != '}'){
+				sp.fill = fill;
+				sp.align = fmt_align_of(s[i + n]);
+				i += n + 1;
+			}
+			else if(i < s.size() && fmt_align_of(s[i]) != fmt_align::none){
+				sp.align = fmt_align_of(s[i]);
+				i++;
+			}
+			if(i < s.size() && (s[i] == '+' || s[i] == '-' || s[i] == ' '))
+				sp.sign = s[i++];
+			if(i < s.size() && s[i] == '#'){
+				sp.alt = true;
+				i++;
+			}
+			if(i < s.size() && s[i] == '0'){
+				sp.zero = true;
+				i++;
+			}
+			if(!fmt_number(s, i, 0xffff, sp.width))
+				return syntax_error;
+			if(i < s.size() && s[i] == '.'){
+				i++;
+				size_t prec = 0;
+				if(i >= s.size() || !fmt_is_digit(s[i]) || !fmt_number(s, i, 1000, prec))
+					return syntax_error;
+				sp.precision = static_cast<int>(prec);
+			}
+			if(i < s.size() && s[i] != '}')
+				sp.type = s[i++];
+		}
+		if(i >= s.size() || s[i] != '}')
+			return syntax_error;
+		i++;
+		if(!fmt_check_spec(sp, kinds[idx]))
+			return fmt_parse_result{fmt_error::type, 0};
+		if(out != nullptr)
+			out[np] = cur;
+		np++;
+		cur = fmt_start_piece(i);
+	}
+	cur.lit_size = i - cur.lit_first;
+	if(cur.lit_size > 0 || np == 0){
+		if(out != nullptr)
+			out[np] = cur;
+		np++;
+	}
+	return fmt_parse_result{fmt_error::none, np};
+}
+
+/*
+    Format string F parsed for arguments A
+*/
+template<typename F, typename... A>
+struct fmt_parsed{
+	static constexpr fmt_kind kinds[] = {fmt_kind_of<A>()..., fmt_kind::none};
+	static constexpr fmt_parse_result result = parse_format(F::get(), kinds, sizeof...(A), nullptr);
+	static constexpr std::array<fmt_piece, result.npieces> pieces = [](){
+		std::array<fmt_piece, result.npieces> ret{};
+		if constexpr(result.error == fmt_error::none)
+			parse_format(F::get(), kinds, sizeof...(A), ret.data());
+		return ret;
+	}();
+};
+
+template<typename S>
+const adv_string_view<S> &fmt_as_view(const adv_string_view<S> &v) noexcept{
+	return v;
+}
+
+class format_writer{
+	private:
+		template<typename T, typename U>
+		static void put_ascii(adv_string_buf<T, U> &buf, const char *s, size_t n){
+			buf.append_ascii(s, n);
+		}
+		template<typename T, typename U>
+		static void put_fill(adv_string_buf<T, U> &buf, std::uint32_t c, size_t n){
+			if(c < 0x80){
+				char tmp[64];
+				std::memset(tmp, static_cast<int>(c), sizeof(tmp));
+				for(; n > 64; n -= 64)
+					put_ascii(buf, tmp, 64);
+				put_ascii(buf, tmp, n);
+			}
+			else{
+				unicode u{c};
+				for(size_t j = 0; j < n; j++)
+					buf.append_ctypes(&u, 1);
+			}
+		}
+		/*
+		    Writes len characters with body, padded according to sp
+		*/
+		template<typename T, typename U, typename B>
+		static void put_padded(adv_string_buf<T, U> &buf, const fmt_spec &sp, size_t len, fmt_align def, B &&body){
+			size_t pad = sp.width > len ? sp.width - len : 0;
+			fmt_align al = sp.align == fmt_align::none ? def : sp.align;
+			size_t left = al == fmt_align::right ? pad : (al == fmt_align::center ? pad / 2 : 0);
+			put_fill(buf, sp.fill, left);
+			body();
+			put_fill(buf, sp.fill, pad - left);
+		}
+		/*
+		    Numbers are right aligned, the 0 flag puts zeros between the prefix (sign and base) and the digits
+		*/
+		template<typename T, typename U>
+		static void put_number(adv_string_buf<T, U> &buf, const fmt_spec &sp, const char *prefix, size_t plen, const char *digits, size_t dlen, bool zero){
+			if(zero && sp.zero && sp.align == fmt_align::none){
+				put_ascii(buf, prefix, plen);
+				put_fill(buf, '0', sp.width > plen + dlen ? sp.width - plen - dlen : 0);
+				put_ascii(buf, digits, dlen);
+			}
+			else{
+				put_padded(buf, sp, plen + dlen, fmt_align::right, [&](){
+					put_ascii(buf, prefix, plen);
+					put_ascii(buf, digits, dlen);
+				});
+			}
+		}
+		static size_t put_sign(char *prefix, bool neg, char sign) noexcept{
+			if(neg)
+				prefix[0] = '-';
+			else if(sign == '+' || sign == ' ')
+				prefix[0] = sign;
+			else
+				return 0;
+			return 1;
+		}
+
+		template<typename T, typename U, typename I>
+		static void write_int(adv_string_buf<T, U> &buf, const fmt_spec &sp, I v){
+			using UI = std::make_unsigned_t<I>;
+			UI m = static_cast<UI>(v);
+			bool neg = false;
+			if constexpr(std::is_signed_v<I>){
+				neg = v < 0;
+				if(neg)
+					m = static_cast<UI>(UI{0} - m);
+			}
+			char prefix[3];
+			size_t plen = put_sign(prefix, neg, sp.sign);
+			int base = 10;
+			switch(sp.type){
+				case 'x':
+				case 'X':
+					base = 16;
+					break;
+				case 'b':
+					base = 2;
+					break;
+				case 'o':
+					base = 8;
+					break;
+			}
+			if(sp.alt && base != 10){
+				prefix[plen++] = '0';
+				if(base == 16)
+					prefix[plen++] = sp.type;
+				else if(base == 2)
+					prefix[plen++] = 'b';
+				else if(m == 0)
+					plen--;
+			}
+			char digits[std::numeric_limits<UI>::digits];
+			char *end = std::to_chars(digits, digits + sizeof(digits), m, base).ptr;
+			if(sp.type == 'X'){
+				for(char *d = digits; d != end; d++){
+					if(*d >= 'a' && *d <= 'f')
+						*d = static_cast<char>(*d - 'a' + 'A');
+				}
+			}
+			put_number(buf, sp, prefix, plen, digits, static_cast<size_t>(end - digits), true);
+		}
+
+		template<typename D>
+		static std::to_chars_result float_chars(char *first, char *last, D v, const fmt_spec &sp) noexcept{
+			//with an explicit type the default precision is 6, like printf
+			int prec = sp.precision >= 0 ? sp.precision : 6;
+			switch(sp.type){
+				case 'f':
+					return std::to_chars(first, last, v, std::chars_format::fixed, prec);
+				case 'e':
+					return std::to_chars(first, last, v, std::chars_format::scientific, prec);
+				case 'g':
+					return std::to_chars(first, last, v, std::chars_format::general, prec);
+				default:
+					if(sp.precision >= 0)
+						return std::to_chars(first, last, v, std::chars_format::general, prec);
+					return std::to_chars(first, last, v);
+			}
+		}
+		template<typename T, typename U, typename D>
+		static void write_float(adv_string_buf<T, U> &buf, const fmt_spec &sp, D v){
+			char prefix[1];
+			bool neg = std::signbit(v);
+			size_t plen = put_sign(prefix, neg, sp.sign);
+			if(neg)
+				v = -v;
+			char digits[128];
+			std::to_chars_result res = float_chars(digits, digits + sizeof(digits), v, sp);
+			if(res.ec == std::errc{}){
+				put_number(buf, sp, prefix, plen, digits, static_cast<size_t>(res.ptr - digits), std::isfinite(v));
+				return;
+			}
+			//large fixed numbers
+			std::string big(std::numeric_limits<D>::max_exponent10 + sp.precision + 8, '0');
+			res = float_chars(big.data(), big.data() + big.size(), v, sp);
+			put_number(buf, sp, prefix, plen, big.data(), static_cast<size_t>(res.ptr - big.data()), true);
+		}
+
+		template<typename T, typename U>
+		static void write_chr(adv_string_buf<T, U> &buf, const fmt_spec &sp, unicode c){
+			put_padded(buf, sp, 1, fmt_align::left, [&](){
+				buf.append_ctypes(&c, 1);
+			});
+		}
+		template<typename T, typename U, typename S>
+		static void write_view(adv_string_buf<T, U> &buf, const fmt_spec &sp, const adv_string_view<S> &v){
+			put_padded(buf, sp, v.length(), fmt_align::left, [&](){
+				if constexpr(std::is_same_v<S, T> && !is_wide_v<T>)
+					buf.append_string(v);
+				else
+					buf.append_string_c(v);
+			});
+		}
+		template<typename T, typename U>
+		static void write_utf8(adv_string_buf<T, U> &buf, const fmt_spec &sp, const char *s, size_t n){
+			if(n == 0)
+				put_padded(buf, sp, 0, fmt_align::left, [](){});
+			else
+				write_view(buf, sp, adv_string_view<UTF8>{const_tchar_pt<UTF8>{s}, n, meas::size});
+		}
+
+		template<typename T, typename U, typename A>
+		static void write_arg(adv_string_buf<T, U> &buf, const fmt_spec &sp, const A &a){
+			using D = std::decay_t<A>;
+			constexpr fmt_kind k = fmt_kind_of<A>();
+			if constexpr(k == fmt_kind::integer)
+				write_int(buf, sp, a);
+			else if constexpr(k == fmt_kind::floating)
+				write_float(buf, sp, a);
+			else if constexpr(k == fmt_kind::boolean){
+				if(a)
+					put_padded(buf, sp, 4, fmt_align::left, [&](){put_ascii(buf, "true", 4);});
+				else
+					put_padded(buf, sp, 5, fmt_align::left, [&](){put_ascii(buf, "false", 5);});
+			}
+			else if constexpr(k == fmt_kind::character){
+				if constexpr(std::is_same_v<D, char>){
+					if(static_cast<unsigned char>(a) >= 0x80)
+						throw incorrect_encoding{"char arguments must be ASCII characters"};
+				}
+				write_chr(buf, sp, unicode{static_cast<std::uint32_t>(a)});
+			}
+			else if constexpr(std::is_same_v<D, std::string> || std::is_same_v<D, std::string_view>)
+				write_utf8(buf, sp, a.data(), a.size());
+			else if constexpr(std::is_pointer_v<D>)
+				write_utf8(buf, sp, a, std::strlen(a));
+			else
+				write_view(buf, sp, fmt_as_view(a));
+		}
+
+		template<typename A>
+		static size_t estimate_arg(const fmt_spec &sp, const A &a, uint unit){
+			using D = std::decay_t<A>;
+			constexpr fmt_kind k = fmt_kind_of<A>();
+			if constexpr(k == fmt_kind::integer)
+				return (sp.type == 'b' ? std::numeric_limits<D>::digits : std::numeric_limits<D>::digits10 + 1) + 3;
+			else if constexpr(k == fmt_kind::floating)
+				return (sp.precision >= 0 ? static_cast<size_t>(sp.precision) : 0) + 24;
+			else if constexpr(k == fmt_kind::boolean)
+				return 5;
+			else if constexpr(k == fmt_kind::character)
+				return 1;
+			else if constexpr(std::is_same_v<D, std::string> || std::is_same_v<D, std::string_view>)
+				return a.size() * unit;
+			else if constexpr(std::is_pointer_v<D>)
+				return std::strlen(a) * unit;
+			else
+				return fmt_as_view(a).length() * unit;
+		}
+
+		template<typename P, size_t I, typename Tuple>
+		static size_t estimate(const Tuple &args, uint unit){
+			constexpr fmt_piece p = P::pieces[I];
+			size_t ret = p.lit_length * unit > p.lit_size ? p.lit_length * unit : p.lit_size;
+			if constexpr(p.arg >= 0){
+				size_t a = estimate_arg(p.spec, std::get<static_cast<size_t>(p.arg)>(args), 1);
+				ret += (a > p.spec.width ? a : p.spec.width) * unit;
+			}
+			return ret;
+		}
+
+		template<typename F, typename P, size_t I, typename T, typename U, typename Tuple>
+		static void write_piece(adv_string_buf<T, U> &buf, const Tuple &args){
+			constexpr fmt_piece p = P::pieces[I];
+			if constexpr(p.lit_size > 0){
+				const char *lit = F::get().data() + p.lit_first;
+				if constexpr(p.lit_ascii)
+					put_ascii(buf, lit, p.lit_size);
+				else
+					write_view(buf, fmt_start_piece(0).spec, adv_string_view<UTF8>{const_tchar_pt<UTF8>{lit}, p.lit_size, p.lit_length});
+			}
+			if constexpr(p.arg >= 0)
+				write_arg(buf, p.spec, std::get<static_cast<size_t>(p.arg)>(args));
+		}
+	public:
+		template<typename F, typename P, typename T, typename U, typename Tuple, size_t... I>
+		static size_t write(adv_string_buf<T, U> &buf, const Tuple &args, std::index_sequence<I...>){
+			size_t old = buf.size();
+			uint unit = buf.ei.unity();
+			buf.reserve((estimate<P, I>(args, unit) + ... + 0));
+			(write_piece<F, P, I>(buf, args), ...);
+			return buf.size() - old;
+		}
+};
+
+template<typename T, typename U, typename F, typename... A>
+size_t format_to(adv_string_buf<T, U> &buf, F, const A &... args){
+	static_assert(is_format_string_v<F>, "The format string must be built with ENCMETRIC_FORMAT");
+	static_assert(std::is_same_v<typename T::ctype, unicode>, "The encoding must have Unicode characters");
+	static_assert(((fmt_kind_of<A>() != fmt_kind::none) && ... && true), "Argument type not supported");
+	using P = fmt_parsed<F, A...>;
+	static_assert(P::result.error != fmt_error::syntax, "Invalid format string");
+	static_assert(P::result.error != fmt_error::index, "Format argument index out of range");
+	static_assert(P::result.error != fmt_error::type, "Format specification not valid for the argument type");
+	return format_writer::write<F, P>(buf, std::forward_as_tuple(args...), std::make_index_sequence<P::result.npieces>{});
+}
@@ -0,0 +1,77 @@
+#pragma once
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+    Hashing of encoded strings.
+
+    The hash is computed over the encoded bytes and it's seeded with the encoding index, without
+    any conversion or allocation. Strings equal with respect to operator== (same encoding and same
+    bytes) have equal hashes, different strings can collide.
+*/
+#include <cstdint>
+#include <functional>
+#include <encmetric/enc_string.hpp>
+
+namespace adv{
+
+/*
+    Hash of a byte array. Data is consumed 32 bytes at a time in four independent 64-bit lanes
+*/
+std::uint64_t hash_bytes(const byte *, size_t, std::uint64_t seed) noexcept;
+
+template<typename T>
+std::uint64_t hash_seed(const const_tchar_pt<T> &ptr) noexcept{
+	return static_cast<std::uint64_t>(ptr.index().hash_code());
+}
+
+template<typename T>
+std::uint64_t hash_string(const adv_string_view<T> &str) noexcept{
+	return hash_bytes(str.data(), str.size(), hash_seed(str.begin()));
+}
+
+/*
+    Transparent hash and equality functors: they accept any string view (or string) whatever its
+    encoding, so they can be used for heterogeneous lookup in containers that support it
+*/
+struct str_hash{
+	using is_transparent = void;
+	template<typename T>
+	size_t operator()(const adv_string_view<T> &str) const noexcept {return static_cast<size_t>(hash_string(str));}
+};
+
+struct str_equal{
+	using is_transparent = void;
+	template<typename S, typename T>
+	bool operator()(const adv_string_view<S> &a, const adv_string_view<T> &b) const {return a == b;}
+};
+
+}
+
+namespace std{
+
+template<typename T>
+struct hash<adv::adv_string_view<T>>{
+	size_t operator()(const adv::adv_string_view<T> &str) const noexcept {return static_cast<size_t>(adv::hash_string(str));}
+};
+
+template<typename T, typename U>
+struct hash<adv::adv_string<T, U>>{
+	size_t operator()(const adv::adv_string<T, U> &str) const noexcept {return static_cast<size_t>(adv::hash_string(str));}
+};
+
+}
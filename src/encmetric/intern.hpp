@@ -0,0 +1,112 @@
+#pragma once
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <vector>
+#include <shared_mutex>
+#include <mutex>
+#include <cstdint>
+#include <encmetric/enc_string.hpp>
+#include <encmetric/hash.hpp>
+
+namespace adv{
+
+/*
+    Interning pool for encoded strings.
+
+    Every distinct string is copied only once into an arena made of big memory blocks, then it's
+    identified by an integer id. Returned views point into the arena, so they're valid until the
+    table is destroyed.
+
+    Lookups can run concurrently, insertions are serialized.
+*/
+template<typename T, typename U = std::allocator<byte>>
+class adv_intern_table{
+	public:
+		using id_type = std::uint32_t;
+	private:
+		struct entry{
+			const byte *data;
+			size_t siz;
+			size_t len;
+			std::uint64_t hash;
+		};
+		/*
+		    id is the entry id increased by one, 0 means empty slot
+		*/
+		struct slot{
+			std::uint32_t tag;
+			id_type id;
+		};
+
+		EncMetric_info<T> ei;
+		U alloc;
+		size_t block_siz;
+		std::vector<basic_ptr<byte, U>> blocks;
+		size_t block_used;
+		std::vector<entry> entries;
+		std::vector<slot> slots;
+		mutable std::shared_mutex mtx;
+
+		static std::uint32_t get_tag(std::uint64_t h) noexcept {return static_cast<std::uint32_t>(h >> 32);}
+
+		adv_string_view<T> make_view(const entry &) const noexcept;
+		template<typename S>
+		bool lookup(const adv_string_view<S> &, std::uint64_t, id_type &) const;
+		const byte *store(const byte *, size_t);
+		void rehash(size_t);
+		id_type insert(const adv_string_view<T> &, std::uint64_t);
+	public:
+		explicit adv_intern_table(EncMetric_info<T> f = EncMetric_info<T>{}, size_t blocksiz = 64 * 1024, const U &all = U{});
+		adv_intern_table(const adv_intern_table &) = delete;
+		adv_intern_table &operator=(const adv_intern_table &) = delete;
+
+		/*
+		    Returns the id of the string, the string is copied into the table if not already present
+		*/
+		id_type intern(const adv_string_view<T> &);
+		/*
+		    Returns a view of the interned copy of the string
+		*/
+		adv_string_view<T> intern_view(const adv_string_view<T> &str) {return view(intern(str));}
+		/*
+		    Searches the string without inserting it. The argument can have any encoding
+		    Note: if found is false then can return anything
+		*/
+		template<typename S>
+		id_type find(const adv_string_view<S> &, bool &found) const;
+		template<typename S>
+		bool contains(const adv_string_view<S> &str) const {bool found; find(str, found); return found;}
+
+		adv_string_view<T> view(id_type) const;
+		adv_string_view<T> operator[](id_type id) const {return view(id);}
+		/*
+		    Number of distinct strings
+		*/
+		size_t size() const;
+		/*
+		    Bytes allocated by the arena
+		*/
+		size_t arena_size() const;
+		/*
+		    Prepares the table to hold at least n distinct strings
+		*/
+		void reserve(size_t n);
+};
+
+#include <encmetric/intern.tpp>
+}
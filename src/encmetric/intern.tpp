@@ -0,0 +1,164 @@
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+template<typename T, typename U>
+adv_intern_table<T, U>::adv_intern_table(EncMetric_info<T> f, size_t blocksiz, const U &all) : ei{f}, alloc{all}, block_siz{blocksiz == 0 ? 1 : blocksiz}, blocks{}, block_used{0}, entries{}, slots{}, mtx{} {}
+
+template<typename T, typename U>
+adv_string_view<T> adv_intern_table<T, U>::make_view(const entry &en) const noexcept{
+	return adv_string_view<T>{en.len, en.siz, const_tchar_pt<T>{en.data, ei}};
+}
+
+template<typename T, typename U>
+template<typename S>
+bool adv_intern_table<T, U>::lookup(const adv_string_view<S> &str, std::uint64_t h, id_type &id) const{
+	if(slots.size() == 0)
+		return false;
+	size_t mask = slots.size() - 1;
+	std::uint32_t tag = get_tag(h);
+	for(size_t i = static_cast<size_t>(h) & mask; slots[i].id != 0; i = (i+1) & mask){
+		if(slots[i].tag != tag)
+			continue;
+		const entry &en = entries[slots[i].id - 1];
+		if(en.hash == h && en.siz == str.size() && compare(en.data, str.data(), en.siz)){
+			id = slots[i].id - 1;
+			return true;
+		}
+	}
+	return false;
+}
+
+template<typename T, typename U>
+const byte *adv_intern_table<T, U>::store(const byte *data, size_t siz){
+	if(blocks.size() == 0){
+		blocks.push_back(basic_ptr<byte, U>{block_siz, alloc});
+		block_used = 0;
+	}
+	if(siz > block_siz / 2){
+		//Big strings get their own block, the current one (the last) is still used
+		basic_ptr<byte, U> big{data, siz, alloc};
+		const byte *ret = big.memory;
+		blocks.insert(blocks.end() - 1, std::move(big));
+		return ret;
+	}
+	if(blocks.back().dimension - block_used < siz){
+		blocks.push_back(basic_ptr<byte, U>{block_siz, alloc});
+		block_used = 0;
+	}
+	byte *ret = blocks.back().memory + block_used;
+	if(siz > 0)
+		std::memcpy(ret, data, siz);
+	block_used += siz;
+	return ret;
+}
+
+template<typename T, typename U>
+void adv_intern_table<T, U>::rehash(size_t nslots){
+	std::vector<slot> nw(nslots, slot{0, 0});
+	size_t mask = nslots - 1;
+	for(size_t j=0; j<entries.size(); j++){
+		std::uint64_t h = entries[j].hash;
+		size_t i = static_cast<size_t>(h) & mask;
+		while(nw[i].id != 0)
+			i = (i+1) & mask;
+		nw[i] = slot{get_tag(h), static_cast<id_type>(j+1)};
+	}
+	slots.swap(nw);
+}
+
+template<typename T, typename U>
+typename adv_intern_table<T, U>::id_type adv_intern_table<T, U>::insert(const adv_string_view<T> &str, std::uint64_t h){
+	if(entries.size() >= static_cast<size_t>(static_cast<id_type>(-1) - 1))
+		throw std::length_error{"Too many interned strings"};
+	//Load factor is kept under 1/2
+	if(2 * (entries.size() + 1) > slots.size())
+		rehash(slots.size() == 0 ? 16 : 2 * slots.size());
+	entries.push_back(entry{store(str.data(), str.size()), str.size(), str.length(), h});
+	id_type id = static_cast<id_type>(entries.size());
+	size_t mask = slots.size() - 1;
+	size_t i = static_cast<size_t>(h) & mask;
+	while(slots[i].id != 0)
+		i = (i+1) & mask;
+	slots[i] = slot{get_tag(h), id};
+	return id - 1;
+}
+
+template<typename T, typename U>
+typename adv_intern_table<T, U>::id_type adv_intern_table<T, U>::intern(const adv_string_view<T> &str){
+	if(!sameEnc(const_tchar_pt<T>{nullptr, ei}, str.begin()))
+		throw encoding_error("Not same encoding");
+	std::uint64_t h = hash_string(str);
+	id_type ret;
+	{
+		std::shared_lock<std::shared_mutex> lock{mtx};
+		if(lookup(str, h, ret))
+			return ret;
+	}
+	std::unique_lock<std::shared_mutex> lock{mtx};
+	//Someone else could have inserted it in the meanwhile
+	if(lookup(str, h, ret))
+		return ret;
+	return insert(str, h);
+}
+
+template<typename T, typename U>
+template<typename S>
+typename adv_intern_table<T, U>::id_type adv_intern_table<T, U>::find(const adv_string_view<S> &str, bool &found) const{
+	id_type ret = 0;
+	if(!sameEnc(const_tchar_pt<T>{nullptr, ei}, str.begin())){
+		found = false;
+		return ret;
+	}
+	std::uint64_t h = hash_string(str);
+	std::shared_lock<std::shared_mutex> lock{mtx};
+	found = lookup(str, h, ret);
+	return ret;
+}
+
+template<typename T, typename U>
+adv_string_view<T> adv_intern_table<T, U>::view(id_type id) const{
+	std::shared_lock<std::shared_mutex> lock{mtx};
+	if(static_cast<size_t>(id) >= entries.size())
+		throw std::out_of_range{"Out of range"};
+	return make_view(entries[id]);
+}
+
+template<typename T, typename U>
+size_t adv_intern_table<T, U>::size() const{
+	std::shared_lock<std::shared_mutex> lock{mtx};
+	return entries.size();
+}
+
+template<typename T, typename U>
+size_t adv_intern_table<T, U>::arena_size() const{
+	std::shared_lock<std::shared_mutex> lock{mtx};
+	size_t ret = 0;
+	for(const basic_ptr<byte, U> &b : blocks)
+		ret += b.dimension;
+	return ret;
+}
+
+template<typename T, typename U>
+void adv_intern_table<T, U>::reserve(size_t n){
+	std::unique_lock<std::shared_mutex> lock{mtx};
+	entries.reserve(n);
+	size_t nslots = slots.size() == 0 ? 16 : slots.size();
+	while(nslots < 2 * n)
+		nslots *= 2;
+	if(nslots > slots.size())
+		rehash(nslots);
+}
@@ -0,0 +1,124 @@
+#pragma once
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+    Escaping and unescaping of the content of JSON strings (RFC 8259), from any encoding with
+    Unicode characters into any other one.
+
+    Runs of characters that don't need to be changed are found 8 bytes at a time when the source
+    encoding is ASCII compatible or widens ASCII characters (UTF16, UTF32), and copied at once.
+*/
+#include <encmetric/enc_string.hpp>
+
+namespace adv{
+
+class json_conversion{
+	private:
+		/*
+		    How runs are searched: 8 bytes at a time with items of u bytes (in little endian order if
+		    le is true) if scan is true, otherwise decoding every character
+		*/
+		struct scan_mode{
+			bool scan;
+			uint u;
+			bool le;
+		};
+		template<typename T>
+		static scan_mode get_mode(const EncMetric_info<T> &) noexcept;
+		/*
+		    Number of leading items (of u bytes) of b that can be copied as they are
+		*/
+		static size_t clean_units(const byte *b, size_t n, uint u, bool le, bool unescape, bool ascii_only) noexcept;
+		/*
+		    Escape sequence of c in out (at least 12 characters), returns its length
+		*/
+		static size_t put_escape(unicode c, char *out) noexcept;
+		static unicode hex_value(unicode) noexcept;
+
+		template<typename T>
+		static size_t first_special(const adv_string_view<T> &, bool unescape, bool ascii_only);
+		template<typename T, typename S, typename U>
+		static void copy_run(const EncMetric_info<T> &, const byte *, size_t, adv_string_buf<S, U> &, bool same);
+		template<typename T>
+		static unicode read_ascii(const EncMetric_info<T> &, const byte *b, size_t siz, size_t &i);
+		template<typename T>
+		static unicode read_hex(const EncMetric_info<T> &, const byte *b, size_t siz, size_t &i);
+
+		template<typename T, typename S, typename U>
+		static size_t escape_from(const adv_string_view<T> &, size_t from, adv_string_buf<S, U> &, bool ascii_only);
+		template<typename T, typename S, typename U>
+		static size_t unescape_from(const adv_string_view<T> &, size_t from, adv_string_buf<S, U> &);
+	public:
+		template<typename T, typename S, typename U>
+		static size_t escape(const adv_string_view<T> &str, adv_string_buf<S, U> &buf, bool ascii_only){
+			return escape_from(str, first_special(str, false, ascii_only), buf, ascii_only);
+		}
+		template<typename T, typename S, typename U>
+		static size_t unescape(const adv_string_view<T> &str, adv_string_buf<S, U> &buf){
+			return unescape_from(str, first_special(str, true, false), buf);
+		}
+		template<typename T, typename U>
+		static adv_string_view<T> escape_view(const adv_string_view<T> &, adv_string_buf<T, U> &, bool ascii_only);
+		template<typename T, typename U>
+		static adv_string_view<T> unescape_view(const adv_string_view<T> &, adv_string_buf<T, U> &);
+		template<typename T>
+		static bool needs(const adv_string_view<T> &str, bool unescape, bool ascii_only){
+			return first_special(str, unescape, ascii_only) < str.size();
+		}
+};
+
+/*
+    Appends str to buf escaping quotation marks, reverse solidi and control characters (with the
+    short forms \b \f \n \r \t when available). If ascii_only is true also the non ASCII characters
+    are escaped with \uXXXX (or two of them for characters outside the BMP).
+    Returns the number of bytes appended
+*/
+template<typename S, typename T, typename U>
+size_t json_escape_append(const adv_string_view<T> &str, adv_string_buf<S, U> &buf, bool ascii_only = false){
+	return json_conversion::escape(str, buf, ascii_only);
+}
+/*
+    Appends str to buf replacing the escape sequences with their characters. Throws
+    incorrect_encoding if an escape sequence is invalid or is an unpaired surrogate.
+    Returns the number of bytes appended
+*/
+template<typename S, typename T, typename U>
+size_t json_unescape_append(const adv_string_view<T> &str, adv_string_buf<S, U> &buf){
+	return json_conversion::unescape(str, buf);
+}
+
+template<typename T>
+bool json_needs_escape(const adv_string_view<T> &str, bool ascii_only = false) {return json_conversion::needs(str, false, ascii_only);}
+template<typename T>
+bool json_needs_unescape(const adv_string_view<T> &str) {return json_conversion::needs(str, true, false);}
+
+/*
+    If nothing must be changed str is returned without copying it, otherwise buf is cleared,
+    the result is written in it and a view of buf is returned
+*/
+template<typename T, typename U>
+adv_string_view<T> json_escape(const adv_string_view<T> &str, adv_string_buf<T, U> &buf, bool ascii_only = false){
+	return json_conversion::escape_view(str, buf, ascii_only);
+}
+template<typename T, typename U>
+adv_string_view<T> json_unescape(const adv_string_view<T> &str, adv_string_buf<T, U> &buf){
+	return json_conversion::unescape_view(str, buf);
+}
+
+#include <encmetric/json.tpp>
+}
@@ -0,0 +1,222 @@
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+template<typename T>
+json_conversion::scan_mode json_conversion::get_mode(const EncMetric_info<T> &ei) noexcept{
+	if(ei.ascii_compatible())
+		return scan_mode{true, 1, true};
+	uint pos;
+	if(ascii_widened(ei, pos) && (ei.unity() == 2 || ei.unity() == 4) && (pos == 0 || pos + 1 == ei.unity()))
+		return scan_mode{true, ei.unity(), pos == 0};
+	return scan_mode{false, 1, true};
+}
+
+/*
+    Offset of the first character to escape (or of the first reverse solidus), size of str if
+    there isn't any
+*/
+template<typename T>
+size_t json_conversion::first_special(const adv_string_view<T> &str, bool unescape, bool ascii_only){
+	static_assert(std::is_same_v<typename T::ctype, unicode>, "Encoding must have Unicode characters");
+	EncMetric_info<T> ei = str.begin().raw_format();
+	scan_mode m = get_mode(ei);
+	const byte *b = str.data();
+	size_t siz = str.size(), i = 0;
+	while(i < siz){
+		if(m.scan){
+			i += clean_units(b + i, (siz - i) / m.u, m.u, m.le, unescape, ascii_only) * m.u;
+			if(i >= siz)
+				break;
+		}
+		unicode c;
+		uint l = ei.decode(&c, b + i, siz - i);
+		if(unescape ? c == '\\' : (c < 0x20 || c == '"' || c == '\\' || (ascii_only && c >= 0x80)))
+			return i;
+		i += l;
+	}
+	return siz;
+}
+
+/*
+    Characters with the same encoding are copied without converting them, the length of buf is
+    updated at the end
+*/
+template<typename T, typename S, typename U>
+void json_conversion::copy_run(const EncMetric_info<T> &ei, const byte *b, size_t n, adv_string_buf<S, U> &buf, bool same){
+	if(n == 0)
+		return;
+	if(same){
+		buf.buffer.exp_fit(buf.siz + n);
+		std::memcpy(buf.buffer.memory + buf.siz, b, n);
+		buf.siz += n;
+	}
+	else{
+		conv_policy pol{};
+		buf.append_bytes_c(b, n, ei, pol);
+	}
+}
+
+template<typename T, typename S, typename U>
+size_t json_conversion::escape_from(const adv_string_view<T> &str, size_t from, adv_string_buf<S, U> &buf, bool ascii_only){
+	static_assert(std::is_same_v<typename S::ctype, unicode>, "Encoding must have Unicode characters");
+	EncMetric_info<T> ei = str.begin().raw_format();
+	scan_mode m = get_mode(ei);
+	bool same = ei.index() == buf.ei.index();
+	const byte *b = str.data();
+	size_t siz = str.size(), old = buf.size(), i = from, run = 0, escaped = 0;
+	if(same)
+		buf.reserve(siz + (siz - from) / 8);
+	while(i < siz){
+		if(m.scan){
+			i += clean_units(b + i, (siz - i) / m.u, m.u, m.le, false, ascii_only) * m.u;
+			if(i >= siz)
+				break;
+		}
+		unicode c;
+		uint l = ei.decode(&c, b + i, siz - i);
+		if(c >= 0x20 && c != '"' && c != '\\' && (!ascii_only || c < 0x80)){
+			i += l;
+			continue;
+		}
+		copy_run(ei, b + run, i - run, buf, same);
+		char esc[12];
+		buf.append_ascii(esc, put_escape(c, esc));
+		escaped++;
+		i += l;
+		run = i;
+	}
+	copy_run(ei, b + run, siz - run, buf, same);
+	if(same)
+		buf.len += str.length() - escaped;
+	return buf.size() - old;
+}
+
+template<typename T>
+unicode json_conversion::read_ascii(const EncMetric_info<T> &ei, const byte *b, size_t siz, size_t &i){
+	if(i >= siz)
+		throw incorrect_encoding{"Truncated JSON escape sequence"};
+	unicode c;
+	i += ei.decode(&c, b + i, siz - i);
+	return c;
+}
+
+template<typename T>
+unicode json_conversion::read_hex(const EncMetric_info<T> &ei, const byte *b, size_t siz, size_t &i){
+	std::uint32_t ret = 0;
+	for(int j = 0; j < 4; j++){
+		unicode d = hex_value(read_ascii(ei, b, siz, i));
+		if(d > 0xf)
+			throw incorrect_encoding{"Invalid JSON escape sequence"};
+		ret = (ret << 4) | d;
+	}
+	return unicode{ret};
+}
+
+template<typename T, typename S, typename U>
+size_t json_conversion::unescape_from(const adv_string_view<T> &str, size_t from, adv_string_buf<S, U> &buf){
+	static_assert(std::is_same_v<typename S::ctype, unicode>, "Encoding must have Unicode characters");
+	EncMetric_info<T> ei = str.begin().raw_format();
+	scan_mode m = get_mode(ei);
+	bool same = ei.index() == buf.ei.index();
+	const byte *b = str.data();
+	size_t siz = str.size(), old = buf.size(), i = from, run = 0, consumed = 0;
+	if(same)
+		buf.reserve(siz);
+	while(i < siz){
+		if(m.scan){
+			i += clean_units(b + i, (siz - i) / m.u, m.u, m.le, true, false) * m.u;
+			if(i >= siz)
+				break;
+		}
+		unicode c;
+		uint l = ei.decode(&c, b + i, siz - i);
+		if(c != '\\'){
+			i += l;
+			continue;
+		}
+		copy_run(ei, b + run, i - run, buf, same);
+		i += l;
+		size_t nchr = 2;
+		c = read_ascii(ei, b, siz, i);
+		switch(c){
+			case '"':
+			case '\\':
+			case '/':
+				break;
+			case 'b':
+				c = unicode{'\b'};
+				break;
+			case 'f':
+				c = unicode{'\f'};
+				break;
+			case 'n':
+				c = unicode{'\n'};
+				break;
+			case 'r':
+				c = unicode{'\r'};
+				break;
+			case 't':
+				c = unicode{'\t'};
+				break;
+			case 'u':
+				nchr = 6;
+				c = read_hex(ei, b, siz, i);
+				if(c >= 0xdc00 && c < 0xe000)
+					throw incorrect_encoding{"Unpaired surrogate in JSON escape sequence"};
+				if(c >= 0xd800 && c < 0xdc00){
+					if(read_ascii(ei, b, siz, i) != '\\' || read_ascii(ei, b, siz, i) != 'u')
+						throw incorrect_encoding{"Unpaired surrogate in JSON escape sequence"};
+					unicode lo = read_hex(ei, b, siz, i);
+					if(lo < 0xdc00 || lo >= 0xe000)
+						throw incorrect_encoding{"Unpaired surrogate in JSON escape sequence"};
+					c = unicode{0x10000 + ((c - 0xd800) << 10) + (lo - 0xdc00)};
+					nchr = 12;
+				}
+				break;
+			default:
+				throw incorrect_encoding{"Invalid JSON escape sequence"};
+		}
+		buf.append_ctypes(&c, 1);
+		consumed += nchr;
+		run = i;
+	}
+	copy_run(ei, b + run, siz - run, buf, same);
+	if(same)
+		buf.len += str.length() - consumed;
+	return buf.size() - old;
+}
+
+template<typename T, typename U>
+adv_string_view<T> json_conversion::escape_view(const adv_string_view<T> &str, adv_string_buf<T, U> &buf, bool ascii_only){
+	size_t from = first_special(str, false, ascii_only);
+	if(from == str.size())
+		return str;
+	buf.clear();
+	escape_from(str, from, buf, ascii_only);
+	return buf.view();
+}
+
+template<typename T, typename U>
+adv_string_view<T> json_conversion::unescape_view(const adv_string_view<T> &str, adv_string_buf<T, U> &buf){
+	size_t from = first_special(str, true, false);
+	if(from == str.size())
+		return str;
+	buf.clear();
+	unescape_from(str, from, buf);
+	return buf.view();
+}
@@ -0,0 +1,127 @@
+#pragma once
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+    Unicode normalization forms (UAX #15) of strings with Unicode characters.
+
+    The character data is generated by tools/gen_normalization.py. Hangul syllables are
+    decomposed and composed algorithmically.
+*/
+#include <vector>
+#include <cstdint>
+#include <encmetric/enc_string.hpp>
+
+namespace adv{
+
+enum class norm_form{
+	nfc,
+	nfd,
+	nfkc,
+	nfkd
+};
+
+/*
+    Result of a quick check: no means that the string is surely not normalized, maybe that
+    it must be normalized in order to know it
+*/
+enum class qc_result{
+	yes,
+	maybe,
+	no
+};
+
+/*
+    Maximum number of characters of a full decomposition
+*/
+inline constexpr size_t max_decomposition = 18;
+
+/*
+    Canonical combining class
+*/
+std::uint8_t combining_class(unicode) noexcept;
+/*
+    Quick check property of a character
+*/
+qc_result quick_check(unicode, norm_form) noexcept;
+/*
+    Writes the full canonical (or compatibility if compat is true) decomposition of c in out,
+    that must have space for max_decomposition characters. Returns the number of characters written
+*/
+size_t decompose(unicode c, bool compat, unicode *out) noexcept;
+/*
+    Primary composite of a and b, returns false if it doesn't exist
+*/
+bool compose(unicode a, unicode b, unicode &res) noexcept;
+
+/*
+    Incremental normalizer: characters are pushed one by one and normalized characters are passed
+    to out (a function accepting a const unicode * and a size_t) as soon as they can't be affected
+    by following characters. flush must be called at the end of the input
+*/
+class normalizer{
+	private:
+		norm_form form;
+		std::vector<unicode> seg;
+
+		bool composing() const noexcept {return form == norm_form::nfc || form == norm_form::nfkc;}
+		bool compat() const noexcept {return form == norm_form::nfkc || form == norm_form::nfkd;}
+		/*
+		    True if nothing after c can interact with characters before it
+		*/
+		bool boundary(unicode c) const noexcept;
+		/*
+		    Canonical ordering and, if needed, composition of seg
+		*/
+		void finish();
+	public:
+		explicit normalizer(norm_form f) : form{f}, seg{} {}
+
+		norm_form get_form() const noexcept {return form;}
+
+		template<typename F>
+		void push(unicode c, F &&out);
+		template<typename F>
+		void flush(F &&out);
+};
+
+/*
+    Quick check of a string (UAX #15 algorithm), the string is read only once
+*/
+template<typename T>
+qc_result quick_check(const adv_string_view<T> &, norm_form);
+/*
+    Full check, the string is normalized only if the quick check answers maybe
+*/
+template<typename T>
+bool is_normalized(const adv_string_view<T> &, norm_form);
+
+/*
+    Appends the normalized string to buf, converting it into the encoding of buf.
+    Returns the number of characters appended
+*/
+template<typename S, typename T, typename U>
+size_t normalize_append(const adv_string_view<T> &, norm_form, adv_string_buf<S, U> &buf);
+/*
+    If the string is already normalized (quick check) it's returned without copying it, otherwise
+    buf is cleared, the normalized string is written in it and a view of buf is returned
+*/
+template<typename T, typename U>
+adv_string_view<T> normalize(const adv_string_view<T> &, norm_form, adv_string_buf<T, U> &buf);
+
+#include <encmetric/normalization.tpp>
+}
@@ -0,0 +1,111 @@
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+template<typename F>
+void normalizer::push(unicode c, F &&out){
+	unicode dec[max_decomposition];
+	size_t n = decompose(c, compat(), dec);
+	for(size_t i=0; i<n; i++){
+		if(seg.size() > 0 && boundary(dec[i])){
+			finish();
+			out(static_cast<const unicode *>(seg.data()), seg.size());
+			seg.clear();
+		}
+		seg.push_back(dec[i]);
+	}
+}
+
+template<typename F>
+void normalizer::flush(F &&out){
+	if(seg.size() > 0){
+		finish();
+		out(static_cast<const unicode *>(seg.data()), seg.size());
+		seg.clear();
+	}
+}
+
+template<typename T>
+qc_result quick_check(const adv_string_view<T> &str, norm_form form){
+	static_assert(std::is_same_v<typename T::ctype, unicode>, "Only Unicode strings can be normalized");
+	qc_result ret = qc_result::yes;
+	std::uint8_t last = 0;
+	for(unicode c : str.code_points()){
+		//characters before U+00A0 are starters and they're normalized in every form
+		if(c < 0xA0){
+			last = 0;
+			continue;
+		}
+		std::uint8_t cc = combining_class(c);
+		if(cc != 0 && last > cc)
+			return qc_result::no;
+		qc_result q = quick_check(c, form);
+		if(q == qc_result::no)
+			return qc_result::no;
+		else if(q == qc_result::maybe)
+			ret = qc_result::maybe;
+		last = cc;
+	}
+	return ret;
+}
+
+template<typename T>
+bool is_normalized(const adv_string_view<T> &str, norm_form form){
+	qc_result q = quick_check(str, form);
+	if(q != qc_result::maybe)
+		return q == qc_result::yes;
+	std::vector<unicode> res{};
+	normalizer nm{form};
+	auto out = [&res](const unicode *c, size_t n){
+		res.insert(res.end(), c, c + n);
+	};
+	for(unicode c : str.code_points())
+		nm.push(c, out);
+	nm.flush(out);
+	if(res.size() != str.length())
+		return false;
+	size_t i = 0;
+	for(unicode c : str.code_points()){
+		if(c != res[i])
+			return false;
+		i++;
+	}
+	return true;
+}
+
+template<typename S, typename T, typename U>
+size_t normalize_append(const adv_string_view<T> &str, norm_form form, adv_string_buf<S, U> &buf){
+	static_assert(std::is_same_v<typename T::ctype, unicode>, "Only Unicode strings can be normalized");
+	size_t ret = 0;
+	normalizer nm{form};
+	auto out = [&buf, &ret](const unicode *c, size_t n){
+		buf.append_ctypes(c, n);
+		ret += n;
+	};
+	for(unicode c : str.code_points())
+		nm.push(c, out);
+	nm.flush(out);
+	return ret;
+}
+
+template<typename T, typename U>
+adv_string_view<T> normalize(const adv_string_view<T> &str, norm_form form, adv_string_buf<T, U> &buf){
+	if(quick_check(str, form) == qc_result::yes)
+		return str;
+	buf.clear();
+	normalize_append(str, form, buf);
+	return buf.view();
+}
@@ -0,0 +1,82 @@
+#pragma once
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <cstring>
+#include <type_traits>
+#include <encmetric/enc_string.hpp>
+#include <encmetric/enc_io_core.hpp>
+
+namespace adv{
+
+/*
+    Splits an encoded input into records terminated by a delimiter character (by default a newline).
+
+    The input can be a file descriptor, a mapped file or a memory region. Records are returned as
+    views with the delimiter removed that point directly into the input (mapped file or memory) or
+    into an internal buffer (file descriptor): in the latter case a view is valid only until the next
+    call to next. The buffer is compacted on each refill and grows when a single record doesn't fit in it.
+
+    When the encoding allows it the delimiter is searched with memchr and then checked against the
+    code unit alignment, otherwise the input is scanned character by character.
+*/
+template<typename T, typename U = std::allocator<byte>>
+class record_reader{
+	private:
+		EncMetric_info<T> ei;
+		int fd;
+		mapped_file map;
+		basic_ptr<byte, U> buffer;
+		const byte *mem;
+		/*
+		    Unread data is [beg, end), the first scanned bytes after beg don't contain the delimiter
+		*/
+		size_t beg, end, scanned;
+		byte delim[8];
+		uint dlen;
+		bool bytesearch;
+		bool eof;
+
+		void init_delimiter();
+		bool search(size_t &pos);
+		bool refill();
+		adv_string_view<T> make_view(size_t from, size_t to) const;
+	public:
+		/*
+		    Reads from a file descriptor, which is not closed by the reader
+		*/
+		explicit record_reader(int fd, size_t bufsiz = 64 * 1024, EncMetric_info<T> f = EncMetric_info<T>{}, const U &all = U{});
+		explicit record_reader(mapped_file &&, EncMetric_info<T> f = EncMetric_info<T>{});
+		explicit record_reader(const adv_string_view<T> &);
+
+		/*
+		    Sets the delimiter character
+		*/
+		void set_delimiter(const typename T::ctype &);
+		/*
+		    Returns the next record. The last record can miss the delimiter, an empty input has no records.
+		    Note: if found is false then returns an empty view
+		*/
+		adv_string_view<T> next(bool &found);
+		/*
+		    Bytes of the input not yet returned
+		*/
+		size_t buffered() const noexcept {return end - beg;}
+};
+
+#include <encmetric/record_reader.tpp>
+}
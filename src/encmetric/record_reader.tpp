@@ -0,0 +1,136 @@
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+template<typename T, typename U>
+record_reader<T, U>::record_reader(int f, size_t bufsiz, EncMetric_info<T> format, const U &all) : ei{format}, fd{f}, map{}, buffer{bufsiz == 0 ? 1 : bufsiz, all}, mem{buffer.memory}, beg{0}, end{0}, scanned{0}, dlen{0}, bytesearch{false}, eof{false} {
+	init_delimiter();
+}
+
+template<typename T, typename U>
+record_reader<T, U>::record_reader(mapped_file &&m, EncMetric_info<T> format) : ei{format}, fd{-1}, map{std::move(m)}, buffer{}, mem{map.data()}, beg{0}, end{map.size()}, scanned{0}, dlen{0}, bytesearch{false}, eof{true} {
+	init_delimiter();
+}
+
+template<typename T, typename U>
+record_reader<T, U>::record_reader(const adv_string_view<T> &str) : ei{str.begin().raw_format()}, fd{-1}, map{}, buffer{}, mem{str.data()}, beg{0}, end{str.size()}, scanned{0}, dlen{0}, bytesearch{false}, eof{true} {
+	init_delimiter();
+}
+
+template<typename T, typename U>
+void record_reader<T, U>::init_delimiter(){
+	if constexpr(std::is_same_v<typename T::ctype, unicode>)
+		set_delimiter(unicode{'\n'});
+	else
+		set_delimiter(typename T::ctype{});
+}
+
+template<typename T, typename U>
+void record_reader<T, U>::set_delimiter(const typename T::ctype &c){
+	dlen = ei.encode(c, delim, 8);
+	/*
+	    A byte match aligned to code units is always a whole character for fixed size encodings and for
+	    encodings with units bigger than a byte (UTF-16 surrogates never match a BMP character),
+	    while in ASCII compatible encodings single bytes under 0x80 are always whole characters
+	*/
+	bytesearch = ei.is_fixed() || ei.unity() > 1 || (ei.ascii_compatible() && dlen == 1 && std::to_integer<uint>(delim[0]) < 0x80);
+	scanned = 0;
+}
+
+template<typename T, typename U>
+bool record_reader<T, U>::search(size_t &pos){
+	size_t from = beg + scanned;
+	if(bytesearch){
+		uint u = ei.unity();
+		while(end - from >= dlen){
+			const void *f = std::memchr(mem + from, std::to_integer<int>(delim[0]), end - from - dlen + 1);
+			if(f == nullptr){
+				from = end - dlen + 1;
+				break;
+			}
+			size_t c = static_cast<size_t>(static_cast<const byte *>(f) - mem);
+			if((c - beg) % u == 0 && std::memcmp(mem + c, delim, dlen) == 0){
+				pos = c;
+				scanned = c - beg;
+				return true;
+			}
+			from = c + 1;
+		}
+	}
+	else{
+		while(end - from >= ei.unity()){
+			uint chl = ei.chLen(mem + from, end - from);
+			if(chl > end - from)
+				break;
+			if(chl == dlen && std::memcmp(mem + from, delim, dlen) == 0){
+				pos = from;
+				scanned = from - beg;
+				return true;
+			}
+			from += chl;
+		}
+	}
+	scanned = from - beg;
+	return false;
+}
+
+template<typename T, typename U>
+bool record_reader<T, U>::refill(){
+	if(fd < 0)
+		return false;
+	if(beg > 0){
+		std::memmove(buffer.memory, buffer.memory + beg, end - beg);
+		end -= beg;
+		beg = 0;
+	}
+	if(end == buffer.dimension)
+		buffer.exp_fit(end + 1);
+	mem = buffer.memory;
+	std::ptrdiff_t r = raw_fd_readbytes(fd, buffer.memory + end, buffer.dimension - end);
+	if(r < 0)
+		throw encoding_error{"IO error"};
+	if(r == 0)
+		return false;
+	end += static_cast<size_t>(r);
+	return true;
+}
+
+template<typename T, typename U>
+adv_string_view<T> record_reader<T, U>::make_view(size_t from, size_t to) const{
+	return adv_string_view<T>{const_tchar_pt<T>{mem + from, ei}, to - from, meas::size};
+}
+
+template<typename T, typename U>
+adv_string_view<T> record_reader<T, U>::next(bool &found){
+	while(true){
+		size_t pos;
+		if(search(pos)){
+			size_t from = beg;
+			beg = pos + dlen;
+			scanned = 0;
+			found = true;
+			return make_view(from, pos);
+		}
+		if(eof || !refill()){
+			eof = true;
+			size_t from = beg;
+			beg = end;
+			scanned = 0;
+			found = from < end;
+			return make_view(from, end);
+		}
+	}
+}
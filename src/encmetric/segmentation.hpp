@@ -0,0 +1,129 @@
+#pragma once
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+    Text segmentation (UAX #29) of strings with Unicode characters: extended grapheme clusters
+    (user-perceived characters) and word boundaries.
+
+    The character data is generated by tools/gen_segmentation.py. Segments are views of the
+    original string, nothing is allocated.
+*/
+#include <iterator>
+#include <cstdint>
+#include <encmetric/enc_string.hpp>
+
+namespace adv{
+
+enum class grapheme_prop : std::uint8_t{
+	other, cr, lf, control, extend, zwj, regional_indicator, prepend, spacing_mark, l, v, t, lv, lvt
+};
+
+enum class word_prop : std::uint8_t{
+	other, cr, lf, newline, extend, zwj, regional_indicator, format, katakana, hebrew_letter, aletter,
+	single_quote, double_quote, midnumlet, midletter, midnum, numeric, extendnumlet, wsegspace
+};
+
+grapheme_prop grapheme_property(unicode) noexcept;
+word_prop word_property(unicode) noexcept;
+bool is_extended_pictographic(unicode) noexcept;
+
+/*
+    Moves it to the end of the grapheme cluster (or word segment) starting at it, that must not be
+    at the end of the string. n is increased by the number of characters of the segment
+*/
+template<typename T>
+void next_grapheme(code_point_iterator<T> &it, size_t &n);
+template<typename T>
+void next_word(code_point_iterator<T> &it, size_t &n);
+
+/*
+    Forward iterator over the grapheme clusters (or the word segments if words is true) of a string,
+    dereferencing it gives a view of the segment
+*/
+template<typename T, bool words>
+class segment_iterator{
+	public:
+		using value_type = adv_string_view<T>;
+		using reference = adv_string_view<T>;
+		using pointer = void;
+		using difference_type = std::ptrdiff_t;
+		using iterator_category = std::input_iterator_tag;
+		using iterator_concept = std::forward_iterator_tag;
+	private:
+		code_point_iterator<T> b, e;
+		size_t len;
+
+		void advance();
+	public:
+		segment_iterator() noexcept : b{}, e{}, len{0} {}
+		explicit segment_iterator(code_point_iterator<T> start) : b{start}, e{start}, len{0} {advance();}
+
+		reference operator*() const {return adv_string_view<T>{b.base(), static_cast<size_t>(e.base().data() - b.base().data()), len};}
+
+		segment_iterator &operator++() {b = e; advance(); return *this;}
+		segment_iterator operator++(int) {segment_iterator ret = *this; ++(*this); return ret;}
+
+		bool operator==(const segment_iterator &oth) const noexcept {return b == oth.b;}
+		bool operator!=(const segment_iterator &oth) const noexcept {return b != oth.b;}
+};
+
+template<typename T, bool words>
+class segment_range{
+	private:
+		code_point_range<T> cps;
+	public:
+		using iterator = segment_iterator<T, words>;
+		using const_iterator = segment_iterator<T, words>;
+
+		explicit segment_range(code_point_range<T> r) noexcept : cps{r} {}
+
+		iterator begin() const {return iterator{cps.begin()};}
+		iterator end() const {return iterator{cps.end()};}
+};
+
+template<typename T>
+using grapheme_range = segment_range<T, false>;
+template<typename T>
+using word_range = segment_range<T, true>;
+
+template<typename T>
+grapheme_range<T> graphemes(const adv_string_view<T> &str) {return grapheme_range<T>{str.code_points()};}
+/*
+    Every word segment is returned, also the ones made of spaces or punctuation
+*/
+template<typename T>
+word_range<T> words(const adv_string_view<T> &str) {return word_range<T>{str.code_points()};}
+
+/*
+    Number of grapheme clusters
+*/
+template<typename T>
+size_t grapheme_length(const adv_string_view<T> &);
+/*
+    First n grapheme clusters (or the whole string if it has less)
+*/
+template<typename T>
+adv_string_view<T> grapheme_prefix(const adv_string_view<T> &, size_t n);
+/*
+    Longest prefix made of whole grapheme clusters with at most maxsiz bytes
+*/
+template<typename T>
+adv_string_view<T> grapheme_truncate(const adv_string_view<T> &, size_t maxsiz);
+
+#include <encmetric/segmentation.tpp>
+}
@@ -0,0 +1,245 @@
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+    Rules GB3-GB13, emoji is 2 after Extended_Pictographic Extend* ZWJ and ri is the number of
+    consecutive regional indicators before the current position
+*/
+inline bool grapheme_continues(grapheme_prop prev, grapheme_prop p, unicode c, int emoji, size_t ri) noexcept{
+	using gp = grapheme_prop;
+	if(prev == gp::cr && p == gp::lf)
+		return true;
+	if(prev == gp::cr || prev == gp::lf || prev == gp::control)
+		return false;
+	if(p == gp::cr || p == gp::lf || p == gp::control)
+		return false;
+	if(prev == gp::l && (p == gp::l || p == gp::v || p == gp::lv || p == gp::lvt))
+		return true;
+	if((prev == gp::lv || prev == gp::v) && (p == gp::v || p == gp::t))
+		return true;
+	if((prev == gp::lvt || prev == gp::t) && p == gp::t)
+		return true;
+	if(p == gp::extend || p == gp::zwj || p == gp::spacing_mark || prev == gp::prepend)
+		return true;
+	if(prev == gp::zwj && emoji == 2 && is_extended_pictographic(c))
+		return true;
+	if(prev == gp::regional_indicator && p == gp::regional_indicator)
+		return ri % 2 == 1;
+	return false;
+}
+
+template<typename T>
+void next_grapheme(code_point_iterator<T> &it, size_t &n){
+	unicode c = *it;
+	++it;
+	n++;
+	//ASCII characters different from CR are never joined with an ASCII character
+	if(c < 0x80 && c != 0x0D && (it.at_end() || *it < 0x80))
+		return;
+	grapheme_prop prev = grapheme_property(c);
+	int emoji = is_extended_pictographic(c) ? 1 : 0;
+	size_t ri = prev == grapheme_prop::regional_indicator ? 1 : 0;
+	while(!it.at_end()){
+		c = *it;
+		grapheme_prop p = grapheme_property(c);
+		if(!grapheme_continues(prev, p, c, emoji, ri))
+			break;
+		if(is_extended_pictographic(c))
+			emoji = 1;
+		else if(emoji == 1 && p == grapheme_prop::zwj)
+			emoji = 2;
+		else if(emoji != 1 || p != grapheme_prop::extend)
+			emoji = 0;
+		ri = p == grapheme_prop::regional_indicator ? ri + 1 : 0;
+		prev = p;
+		++it;
+		n++;
+	}
+}
+
+inline bool word_ignorable(word_prop p) noexcept{
+	return p == word_prop::extend || p == word_prop::format || p == word_prop::zwj;
+}
+
+inline bool word_ahletter(word_prop p) noexcept{
+	return p == word_prop::aletter || p == word_prop::hebrew_letter;
+}
+
+inline bool word_midnumletq(word_prop p) noexcept{
+	return p == word_prop::midnumlet || p == word_prop::single_quote;
+}
+
+/*
+    Property of the first character after it that is not ignored by rule WB4
+*/
+template<typename T>
+word_prop word_lookahead(code_point_iterator<T> it){
+	for(++it; !it.at_end(); ++it){
+		word_prop p = word_property(*it);
+		if(!word_ignorable(p))
+			return p;
+	}
+	return word_prop::other;
+}
+
+/*
+    Rules WB5-WB16 between prev and p (both not ignorable), before is the property before prev
+*/
+template<typename T>
+bool word_continues(word_prop before, word_prop prev, word_prop p, const code_point_iterator<T> &it, size_t ri){
+	using wp = word_prop;
+	if(word_ahletter(prev) && word_ahletter(p))
+		return true;
+	if(word_ahletter(prev) && (p == wp::midletter || word_midnumletq(p)) && word_ahletter(word_lookahead(it)))
+		return true;
+	if(word_ahletter(before) && (prev == wp::midletter || word_midnumletq(prev)) && word_ahletter(p))
+		return true;
+	if(prev == wp::hebrew_letter && p == wp::single_quote)
+		return true;
+	if(prev == wp::hebrew_letter && p == wp::double_quote && word_lookahead(it) == wp::hebrew_letter)
+		return true;
+	if(before == wp::hebrew_letter && prev == wp::double_quote && p == wp::hebrew_letter)
+		return true;
+	if((prev == wp::numeric || word_ahletter(prev)) && p == wp::numeric)
+		return true;
+	if(prev == wp::numeric && word_ahletter(p))
+		return true;
+	if(before == wp::numeric && (prev == wp::midnum || word_midnumletq(prev)) && p == wp::numeric)
+		return true;
+	if(prev == wp::numeric && (p == wp::midnum || word_midnumletq(p)) && word_lookahead(it) == wp::numeric)
+		return true;
+	if(prev == wp::katakana && p == wp::katakana)
+		return true;
+	if((word_ahletter(prev) || prev == wp::numeric || prev == wp::katakana || prev == wp::extendnumlet) && p == wp::extendnumlet)
+		return true;
+	if(prev == wp::extendnumlet && (word_ahletter(p) || p == wp::numeric || p == wp::katakana))
+		return true;
+	if(prev == wp::regional_indicator && p == wp::regional_indicator)
+		return ri % 2 == 1;
+	return false;
+}
+
+template<typename T>
+void next_word(code_point_iterator<T> &it, size_t &n){
+	using wp = word_prop;
+	word_prop raw = word_property(*it);
+	word_prop prev = raw;
+	word_prop before = wp::other;
+	size_t ri = raw == wp::regional_indicator ? 1 : 0;
+	++it;
+	n++;
+	while(!it.at_end()){
+		unicode c = *it;
+		word_prop p = word_property(c);
+		bool cont;
+		if(raw == wp::cr && p == wp::lf)
+			cont = true;
+		else if(raw == wp::newline || raw == wp::cr || raw == wp::lf || p == wp::newline || p == wp::cr || p == wp::lf)
+			cont = false;
+		else if(raw == wp::zwj && is_extended_pictographic(c))
+			cont = true;
+		else if(raw == wp::wsegspace && p == wp::wsegspace)
+			cont = true;
+		else if(word_ignorable(p))
+			cont = true;
+		else
+			cont = word_continues(before, prev, p, it, ri);
+		if(!cont)
+			break;
+		if(!word_ignorable(p) || word_ignorable(prev)){
+			//an ignorable character is absorbed by the previous one
+			before = prev;
+			prev = p;
+			ri = p == wp::regional_indicator ? ri + 1 : 0;
+		}
+		raw = p;
+		++it;
+		n++;
+	}
+}
+
+template<typename T, bool words>
+void segment_iterator<T, words>::advance(){
+	len = 0;
+	if(b.at_end())
+		return;
+	if constexpr(words)
+		next_word(e, len);
+	else
+		next_grapheme(e, len);
+}
+
+template<typename T>
+size_t grapheme_length(const adv_string_view<T> &str){
+	static_assert(std::is_same_v<typename T::ctype, unicode>, "Only Unicode strings");
+	size_t ret = 0;
+	const_tchar_pt<T> ptr = str.begin();
+	code_point_range<T> cps = str.code_points();
+	if(ptr.unity() == 1 && ptr.ascii_compatible()){
+		//every byte of an ASCII run except the last one is a single cluster, but CR LF
+		const byte *data = str.data();
+		size_t pos = 0;
+		while(pos < str.size()){
+			size_t k = ascii_prefix(data + pos, str.size() - pos);
+			if(k >= 2){
+				for(size_t i=0; i+1<k; i++){
+					if(!(data[pos+i] == byte{0x0D} && data[pos+i+1] == byte{0x0A}))
+						ret++;
+				}
+				pos += k - 1;
+			}
+			code_point_iterator<T> it{str.data(), str.data() + str.size(), data + pos, ptr.raw_format()};
+			size_t n = 0;
+			next_grapheme(it, n);
+			ret++;
+			pos = static_cast<size_t>(it.base().data() - data);
+		}
+		return ret;
+	}
+	size_t n = 0;
+	for(code_point_iterator<T> it = cps.begin(); !it.at_end(); ret++)
+		next_grapheme(it, n);
+	return ret;
+}
+
+template<typename T>
+adv_string_view<T> grapheme_prefix(const adv_string_view<T> &str, size_t n){
+	code_point_iterator<T> it = str.code_points().begin();
+	size_t len = 0;
+	for(size_t i=0; i<n && !it.at_end(); i++)
+		next_grapheme(it, len);
+	return adv_string_view<T>{str.begin(), static_cast<size_t>(it.base().data() - str.data()), len};
+}
+
+template<typename T>
+adv_string_view<T> grapheme_truncate(const adv_string_view<T> &str, size_t maxsiz){
+	if(str.size() <= maxsiz)
+		return str;
+	code_point_iterator<T> it = str.code_points().begin();
+	size_t len = 0;
+	size_t siz = 0;
+	while(!it.at_end()){
+		size_t l = len;
+		next_grapheme(it, l);
+		size_t s = static_cast<size_t>(it.base().data() - str.data());
+		if(s > maxsiz)
+			break;
+		len = l;
+		siz = s;
+	}
+	return adv_string_view<T>{str.begin(), siz, len};
+}
@@ -0,0 +1,109 @@
+#pragma once
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <atomic>
+#include <encmetric/enc_string.hpp>
+
+namespace adv{
+
+/*
+    String sharing its memory with its copies and substrings.
+
+    The memory block has an atomic reference counter, so copies can be passed to other threads
+    without copying the data. Copying a string, taking a substring and moving it never copies the
+    encoded bytes, the functions changing the string copy them only when the block is shared
+    (copy on write). Every adv_shared_string object must be used by one thread at a time.
+*/
+template<typename T, typename U = std::allocator<byte>>
+class adv_shared_string : public adv_string_view<T>{
+	private:
+		struct header{
+			std::atomic<size_t> refs;
+			size_t capacity;
+		};
+		static constexpr size_t data_offset = (sizeof(header) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+
+		U alloc;
+		byte *block;
+
+		header *head() const noexcept {return reinterpret_cast<header *>(block);}
+		byte *block_data() const noexcept {return block + data_offset;}
+		byte *allocate_block(size_t capacity);
+		void acquire() noexcept;
+		void release() noexcept;
+		const adv_string_view<T> &as_view() const noexcept {return *this;}
+		void set_view(const_tchar_pt<T>, size_t len, size_t siz) noexcept;
+		/*
+		    Leaves an empty string without block, after its content has been moved
+		*/
+		void reset() noexcept;
+		/*
+		    Copies the string followed by the n bytes of extra in a new block with capacity bytes
+		*/
+		void reallocate(size_t capacity, const byte *extra = nullptr, size_t n = 0);
+		size_t grown_capacity(size_t n) const noexcept;
+
+		adv_shared_string(const adv_string_view<T> &view, byte *blk, const U &all) noexcept : adv_string_view<T>{view}, alloc{all}, block{blk} {acquire();}
+	public:
+		/*
+		    Copies the string in a new block
+		*/
+		explicit adv_shared_string(const adv_string_view<T> &, const U & = U{});
+		adv_shared_string(const adv_shared_string &oth) noexcept : adv_shared_string{oth.as_view(), oth.block, oth.alloc} {}
+		adv_shared_string(adv_shared_string &&oth) noexcept : adv_string_view<T>{oth.as_view()}, alloc{oth.alloc}, block{oth.block} {oth.reset();}
+		~adv_shared_string() {release();}
+
+		adv_shared_string &operator=(const adv_shared_string &);
+		adv_shared_string &operator=(adv_shared_string &&) noexcept;
+
+		U get_allocator() const noexcept {return alloc;}
+		/*
+		    Number of strings sharing the block (0 if the string has no block)
+		*/
+		size_t use_count() const noexcept;
+		bool unique() const noexcept {return use_count() <= 1;}
+		/*
+		    Bytes that can be appended without allocating a new block if it isn't shared
+		*/
+		size_t capacity() const noexcept;
+
+		/*
+		    Substrings share the block of the string
+		*/
+		adv_shared_string substring(size_t b, size_t e) const {return adv_shared_string{adv_string_view<T>::substring(b, e), block, alloc};}
+		adv_shared_string substring(size_t b) const {return adv_shared_string{adv_string_view<T>::substring(b), block, alloc};}
+
+		/*
+		    Copies the string in a new block if it's shared
+		*/
+		void unshare();
+		/*
+		    Pointer to the modifiable bytes of the string, calls unshare. The string must remain
+		    correctly encoded
+		*/
+		byte *mutable_data();
+		/*
+		    Appends str, the string is copied in a new block if it's shared or the block is full
+		*/
+		void append(const adv_string_view<T> &str);
+		void reserve(size_t n);
+		void clear() noexcept;
+};
+
+#include <encmetric/shared_string.tpp>
+}
@@ -0,0 +1,152 @@
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+template<typename T, typename U>
+byte *adv_shared_string<T, U>::allocate_block(size_t capacity){
+	byte *ret = std::allocator_traits<U>::allocate(alloc, data_offset + capacity);
+	header *h = new(ret) header{};
+	h->refs.store(1, std::memory_order_relaxed);
+	h->capacity = capacity;
+	return ret;
+}
+
+template<typename T, typename U>
+void adv_shared_string<T, U>::acquire() noexcept{
+	if(block != nullptr)
+		head()->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+template<typename T, typename U>
+void adv_shared_string<T, U>::release() noexcept{
+	if(block != nullptr && head()->refs.fetch_sub(1, std::memory_order_acq_rel) == 1){
+		size_t dim = data_offset + head()->capacity;
+		head()->~header();
+		std::allocator_traits<U>::deallocate(alloc, block, dim);
+	}
+	block = nullptr;
+}
+
+template<typename T, typename U>
+void adv_shared_string<T, U>::set_view(const_tchar_pt<T> p, size_t nlen, size_t nsiz) noexcept{
+	this->ptr = p;
+	this->len = nlen;
+	this->siz = nsiz;
+}
+
+template<typename T, typename U>
+void adv_shared_string<T, U>::reset() noexcept{
+	block = nullptr;
+	set_view(this->ptr.new_instance(static_cast<const byte *>(nullptr)), 0, 0);
+}
+
+template<typename T, typename U>
+void adv_shared_string<T, U>::reallocate(size_t capacity, const byte *extra, size_t n){
+	byte *nw = allocate_block(capacity);
+	if(this->size() > 0)
+		std::memcpy(nw + data_offset, this->data(), this->size());
+	if(n > 0)
+		std::memcpy(nw + data_offset + this->size(), extra, n);
+	//extra can point into the old block
+	release();
+	block = nw;
+	set_view(this->ptr.new_instance(block_data()), this->length(), this->size());
+}
+
+template<typename T, typename U>
+size_t adv_shared_string<T, U>::grown_capacity(size_t n) const noexcept{
+	size_t cap = this->size() == 0 ? 1 : this->size();
+	while(cap < this->size() + n)
+		cap *= 2;
+	return cap;
+}
+
+template<typename T, typename U>
+adv_shared_string<T, U>::adv_shared_string(const adv_string_view<T> &str, const U &all) : adv_string_view<T>{str}, alloc{all}, block{nullptr}{
+	block = allocate_block(str.size());
+	if(str.size() > 0)
+		std::memcpy(block_data(), str.data(), str.size());
+	set_view(this->ptr.new_instance(block_data()), str.length(), str.size());
+}
+
+template<typename T, typename U>
+adv_shared_string<T, U> &adv_shared_string<T, U>::operator=(const adv_shared_string &oth){
+	if(this != &oth){
+		adv_shared_string tmp{oth};
+		*this = std::move(tmp);
+	}
+	return *this;
+}
+
+template<typename T, typename U>
+adv_shared_string<T, U> &adv_shared_string<T, U>::operator=(adv_shared_string &&oth) noexcept{
+	if(this != &oth){
+		release();
+		adv_string_view<T>::operator=(oth.as_view());
+		alloc = oth.alloc;
+		block = oth.block;
+		oth.reset();
+	}
+	return *this;
+}
+
+template<typename T, typename U>
+size_t adv_shared_string<T, U>::use_count() const noexcept{
+	return block == nullptr ? 0 : head()->refs.load(std::memory_order_acquire);
+}
+
+template<typename T, typename U>
+size_t adv_shared_string<T, U>::capacity() const noexcept{
+	if(block == nullptr)
+		return 0;
+	return head()->capacity - static_cast<size_t>(this->data() - block_data()) - this->size();
+}
+
+template<typename T, typename U>
+void adv_shared_string<T, U>::unshare(){
+	if(!unique())
+		reallocate(this->size());
+}
+
+template<typename T, typename U>
+byte *adv_shared_string<T, U>::mutable_data(){
+	unshare();
+	return block == nullptr ? nullptr : block_data() + (this->data() - block_data());
+}
+
+template<typename T, typename U>
+void adv_shared_string<T, U>::reserve(size_t n){
+	if(block == nullptr || !unique() || capacity() < n)
+		reallocate(grown_capacity(n));
+}
+
+template<typename T, typename U>
+void adv_shared_string<T, U>::append(const adv_string_view<T> &str){
+	if(str.size() == 0)
+		return;
+	if(block == nullptr || !unique() || capacity() < str.size())
+		reallocate(grown_capacity(str.size()), str.data(), str.size());
+	else
+		std::memmove(mutable_data() + this->size(), str.data(), str.size());
+	set_view(this->ptr, this->length() + str.length(), this->size() + str.size());
+}
+
+template<typename T, typename U>
+void adv_shared_string<T, U>::clear() noexcept{
+	//the block isn't modified, so it can stay shared
+	set_view(this->ptr, 0, 0);
+}
@@ -0,0 +1,102 @@
+#pragma once
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <type_traits>
+#include <encmetric/enc_string.hpp>
+
+namespace adv{
+
+/*
+    String of at most N bytes stored inside the object, it never allocates memory.
+
+    The object is trivially copyable, so it can be copied with memcpy and placed in shared memory.
+    For this reason it doesn't contain pointers and only encodings known at compile time can be
+    used (not WIDE). The functions of adv_string_view are available through view() or the
+    implicit conversion, views are invalidated when the string is moved or modified.
+
+    The append functions work like the ones of adv_string_buf, but they return false and leave
+    the string unchanged if the result doesn't fit.
+*/
+template<typename T, size_t N>
+class adv_static_string{
+	static_assert(!is_wide_v<T>, "WIDE encodings can't be stored in static strings");
+	private:
+		byte buf[N];
+		size_t siz, len;
+
+		/*
+		    Buffer for policy_convert that can't grow
+		*/
+		struct fixed_buffer{
+			byte *memory;
+			size_t dimension;
+
+			void exp_fit(size_t fit) const{
+				if(fit > dimension)
+					throw buffer_big{};
+			}
+		};
+	public:
+		adv_static_string() noexcept : siz{0}, len{0}{
+			static_assert(std::is_trivially_copyable_v<adv_static_string<T, N>>, "Static strings must be trivially copyable");
+		}
+		/*
+		    Throws buffer_big if str has more than N bytes
+		*/
+		explicit adv_static_string(const adv_string_view<T> &str);
+
+		static constexpr size_t capacity() noexcept {return N;}
+		size_t size() const noexcept {return siz;}
+		size_t length() const noexcept {return len;}
+		bool empty() const noexcept {return siz == 0;}
+		const byte *data() const noexcept {return buf;}
+		const char *raw() const noexcept {return reinterpret_cast<const char *>(buf);}
+
+		adv_string_view<T> view() const noexcept {return adv_string_view<T>{len, siz, const_tchar_pt<T>{buf}};}
+		operator adv_string_view<T>() const noexcept {return view();}
+
+		bool append_chr(const_tchar_pt<T>);
+		bool append_chrs(const_tchar_pt<T>, size_t nchr);
+		bool append_string(const adv_string_view<T> &);
+		/*
+		    Convert the string before adding it
+		*/
+		template<typename S>
+		bool append_string_c(const adv_string_view<S> &str) {conv_policy pol{}; return append_string_c(str, pol);}
+		template<typename S>
+		bool append_string_c(const adv_string_view<S> &, conv_policy &);
+		/*
+		    Encode n decoded characters and add them
+		*/
+		bool append_ctypes(const typename T::ctype *, size_t n);
+		void clear() noexcept {siz = 0; len = 0;}
+
+		template<typename S>
+		bool operator==(const adv_string_view<S> &str) const {return view() == str;}
+		template<typename S>
+		bool operator!=(const adv_string_view<S> &str) const {return view() != str;}
+		template<size_t M>
+		bool operator==(const adv_static_string<T, M> &str) const {return view() == str.view();}
+		template<size_t M>
+		bool operator!=(const adv_static_string<T, M> &str) const {return view() != str.view();}
+		template<typename S>
+		int compare(const adv_string_view<S> &str) const {return view().compare(str);}
+};
+
+#include <encmetric/static_string.tpp>
+}
@@ -0,0 +1,93 @@
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+template<typename T, size_t N>
+adv_static_string<T, N>::adv_static_string(const adv_string_view<T> &str) : adv_static_string{}{
+	if(!append_string(str))
+		throw buffer_big{};
+}
+
+template<typename T, size_t N>
+bool adv_static_string<T, N>::append_chr(const_tchar_pt<T> ptr){
+	uint chl = ptr.chLen();
+	if(N - siz < chl)
+		return false;
+	std::memcpy(buf + siz, ptr.data(), chl);
+	siz += chl;
+	len++;
+	return true;
+}
+
+template<typename T, size_t N>
+bool adv_static_string<T, N>::append_chrs(const_tchar_pt<T> ptr, size_t nchr){
+	size_t n = 0;
+	const_tchar_pt<T> end = ptr;
+	for(size_t i=0; i<nchr; i++)
+		n += end.next();
+	if(N - siz < n)
+		return false;
+	if(n > 0)
+		std::memcpy(buf + siz, ptr.data(), n);
+	siz += n;
+	len += nchr;
+	return true;
+}
+
+template<typename T, size_t N>
+bool adv_static_string<T, N>::append_string(const adv_string_view<T> &str){
+	if(N - siz < str.size())
+		return false;
+	if(str.size() > 0)
+		std::memcpy(buf + siz, str.data(), str.size());
+	siz += str.size();
+	len += str.length();
+	return true;
+}
+
+template<typename T, size_t N>
+template<typename S>
+bool adv_static_string<T, N>::append_string_c(const adv_string_view<S> &str, conv_policy &pol){
+	fixed_buffer fb{buf, N};
+	size_t nsiz = siz;
+	size_t nlen;
+	try{
+		nlen = policy_convert(str.begin().raw_format(), str.data(), str.size(), EncMetric_info<T>{}, fb, nsiz, pol);
+	}
+	catch(const buffer_big &){
+		return false;
+	}
+	siz = nsiz;
+	len += nlen;
+	return true;
+}
+
+template<typename T, size_t N>
+bool adv_static_string<T, N>::append_ctypes(const typename T::ctype *chrs, size_t n){
+	size_t nsiz = siz;
+	for(size_t i=0; i<n; i++){
+		try{
+			nsiz += T::encode(chrs[i], buf + nsiz, N - nsiz);
+		}
+		catch(const buffer_small &){
+			return false;
+		}
+	}
+	siz = nsiz;
+	len += n;
+	return true;
+}
@@ -0,0 +1,106 @@
+#pragma once
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+    Instrumentation counters, collected only if the library is built with the cmake option
+    ENCMETRIC_STATS (see stats_enabled in config.hpp). Otherwise the recording functions are empty
+    and get_stats always returns zeros.
+
+    Every thread increments its own counters, they're summed only when get_stats is called. The
+    counters of terminated threads are kept.
+*/
+#include <cstdint>
+#include <typeindex>
+#include <vector>
+#include <encmetric/config.hpp>
+
+namespace adv{
+
+enum class stat_event : unsigned int{
+	exceptions,           //exceptions derived from encoding_error created
+	buffer_small_retries, //encodings retried after enlarging the buffer
+	buffer_growths,       //reallocations of basic_ptr
+	buffer_growth_bytes,  //bytes allocated by these reallocations
+	io_reads,             //read system calls of enc_io_core
+	io_read_bytes,
+	io_writes,            //write system calls of enc_io_core
+	io_written_bytes,
+	count
+};
+
+inline constexpr size_t stat_events = static_cast<size_t>(stat_event::count);
+
+/*
+    Counters of a single encoding, chars are the characters
+*/
+struct encoding_stats{
+	std::type_index encoding;
+	std::uint64_t decoded_bytes, decoded_chars;
+	std::uint64_t encoded_bytes, encoded_chars;
+	std::uint64_t invalid;            //validation failures and invalid sequences replaced
+};
+
+struct stats_snapshot{
+	std::uint64_t events[stat_events];
+	/*
+	    Encodings used at least once, in order of first use
+	*/
+	std::vector<encoding_stats> encodings;
+
+	std::uint64_t operator[](stat_event e) const noexcept {return events[static_cast<size_t>(e)];}
+};
+
+stats_snapshot get_stats();
+/*
+    Sets all the counters to zero, increments made concurrently by other threads can be lost
+*/
+void reset_stats() noexcept;
+
+void stats_add(stat_event, std::uint64_t) noexcept;
+void stats_decoded(std::type_index, std::uint64_t bytes, std::uint64_t chars) noexcept;
+void stats_encoded(std::type_index, std::uint64_t bytes, std::uint64_t chars) noexcept;
+void stats_invalid(std::type_index) noexcept;
+
+/*
+    Recording functions used by the library, they compile to nothing if stats aren't enabled.
+    Encodings are passed with any object having index(), so WIDE formats are queried only if needed
+*/
+inline void count_event(stat_event e, std::uint64_t n = 1) noexcept{
+	if constexpr(stats_enabled())
+		stats_add(e, n);
+}
+
+template<typename F>
+void count_decoded(const F &f, std::uint64_t bytes, std::uint64_t chars) noexcept{
+	if constexpr(stats_enabled())
+		stats_decoded(f.index(), bytes, chars);
+}
+
+template<typename F>
+void count_encoded(const F &f, std::uint64_t bytes, std::uint64_t chars) noexcept{
+	if constexpr(stats_enabled())
+		stats_encoded(f.index(), bytes, chars);
+}
+
+template<typename F>
+void count_invalid(const F &f) noexcept{
+	if constexpr(stats_enabled())
+		stats_invalid(f.index());
+}
+
+}
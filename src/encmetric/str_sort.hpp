@@ -0,0 +1,121 @@
+#pragma once
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+    Sorting of big arrays of string views in character order (the same of adv_string_view::compare).
+
+    When all the strings have the same byte ordered encoding (see is_byte_ordered) they're sorted with
+    an MSD radix sort directly on encoded bytes. Each string is represented by a small key that caches
+    the next 8 bytes to be examined, so the string memory is accessed only once every 8 radix passes.
+    Otherwise strings are sorted with compare.
+
+    nthreads is the number of threads to use, 0 means all the hardware threads
+*/
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+#include <encmetric/enc_string.hpp>
+
+namespace adv{
+
+struct radix_key{
+	std::uint64_t cache;//bytes [base, base+8) as a big endian integer, missing bytes are 0
+	const byte *data;
+	size_t siz;
+	size_t idx;
+};
+
+struct radix_task{
+	size_t start;
+	size_t n;
+	size_t base;
+	uint off;//next byte to examine is base+off
+};
+
+inline std::uint64_t radix_load(const byte *data, size_t siz, size_t base) noexcept{
+	std::uint64_t ret = 0;
+	if(base >= siz)
+		return 0;
+	size_t rem = siz - base;
+	if(rem >= 8){
+		for(int i=0; i<8; i++)
+			ret = (ret << 8) | std::to_integer<std::uint64_t>(data[base + i]);
+	}
+	else{
+		for(size_t i=0; i<rem; i++)
+			ret |= std::to_integer<std::uint64_t>(data[base + i]) << (56 - 8*i);
+	}
+	return ret;
+}
+
+/*
+    Byte order comparison of two keys sharing the same base
+*/
+inline bool radix_less(const radix_key &a, const radix_key &b, size_t base) noexcept{
+	if(a.cache != b.cache)
+		return a.cache < b.cache;
+	size_t from = base + 8;
+	size_t la = a.siz > from ? a.siz - from : 0;
+	size_t lb = b.siz > from ? b.siz - from : 0;
+	size_t m = la < lb ? la : lb;
+	if(m > 0){
+		int res = std::memcmp(a.data + from, b.data + from, m);
+		if(res != 0)
+			return res < 0;
+	}
+	return a.siz < b.siz;
+}
+
+/*
+    Distributes the keys of a task by their byte at position base+off, then pushes in pending a new task
+    for each bucket that still needs to be sorted. Small tasks are sorted immediately.
+
+    tmp is an auxiliary array with the same size of keys
+*/
+void radix_pass(radix_key *keys, radix_key *tmp, radix_task task, std::vector<radix_task> &pending);
+void radix_sort_keys(radix_key *keys, radix_key *tmp, radix_task task);
+void radix_sort_keys(radix_key *keys, size_t n, uint nthreads);
+
+template<typename T>
+void sort_strings(adv_string_view<T> *first, adv_string_view<T> *last, uint nthreads = 1);
+template<typename T, typename A>
+void sort_strings(std::vector<adv_string_view<T>, A> &vec, uint nthreads = 1){
+	sort_strings(vec.data(), vec.data() + vec.size(), nthreads);
+}
+
+/*
+    Removes consecutive equal strings (see equals), returns the new end of the range
+*/
+template<typename T>
+adv_string_view<T> *unique_strings(adv_string_view<T> *first, adv_string_view<T> *last);
+
+/*
+    Sorts strings and removes duplicates, returns the new end of the range
+*/
+template<typename T>
+adv_string_view<T> *sort_unique_strings(adv_string_view<T> *first, adv_string_view<T> *last, uint nthreads = 1);
+template<typename T, typename A>
+void sort_unique_strings(std::vector<adv_string_view<T>, A> &vec, uint nthreads = 1){
+	adv_string_view<T> *e = sort_unique_strings(vec.data(), vec.data() + vec.size(), nthreads);
+	vec.erase(vec.begin() + (e - vec.data()), vec.end());
+}
+
+#include <encmetric/str_sort.tpp>
+}
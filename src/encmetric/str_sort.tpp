@@ -0,0 +1,101 @@
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+    True if the strings can be sorted comparing their bytes
+*/
+template<typename T>
+bool radix_sortable(const adv_string_view<T> *first, const adv_string_view<T> *last) noexcept{
+	if constexpr(is_wide_v<T>){
+		if(!dynamic_byte_ordered(first->begin()))
+			return false;
+		for(const adv_string_view<T> *p = first + 1; p != last; ++p){
+			if(!sameEnc(*first, *p))
+				return false;
+		}
+		return true;
+	}
+	else
+		return is_byte_ordered_v<T>;
+}
+
+template<typename T>
+std::vector<radix_key> radix_sorted_keys(const adv_string_view<T> *first, const adv_string_view<T> *last, uint nthreads){
+	size_t n = last - first;
+	std::vector<radix_key> keys;
+	keys.reserve(n);
+	for(size_t i=0; i<n; i++){
+		const byte *d = first[i].data();
+		size_t s = first[i].size();
+		keys.push_back(radix_key{radix_load(d, s, 0), d, s, i});
+	}
+	radix_sort_keys(keys.data(), n, nthreads);
+	return keys;
+}
+
+template<typename T>
+void sort_strings(adv_string_view<T> *first, adv_string_view<T> *last, uint nthreads){
+	if(last - first < 2)
+		return;
+	if(!radix_sortable(first, last)){
+		std::stable_sort(first, last, [](const adv_string_view<T> &a, const adv_string_view<T> &b){return a.compare(b) < 0;});
+		return;
+	}
+	std::vector<radix_key> keys = radix_sorted_keys(first, last, nthreads);
+	std::vector<adv_string_view<T>> sorted;
+	sorted.reserve(keys.size());
+	for(const radix_key &k : keys)
+		sorted.push_back(first[k.idx]);
+	std::copy(sorted.begin(), sorted.end(), first);
+}
+
+template<typename T>
+adv_string_view<T> *unique_strings(adv_string_view<T> *first, adv_string_view<T> *last){
+	if(first == last)
+		return last;
+	adv_string_view<T> *out = first;
+	for(adv_string_view<T> *p = first + 1; p != last; ++p){
+		if(!out->equals(*p)){
+			++out;
+			if(out != p)
+				*out = *p;
+		}
+	}
+	return out + 1;
+}
+
+template<typename T>
+adv_string_view<T> *sort_unique_strings(adv_string_view<T> *first, adv_string_view<T> *last, uint nthreads){
+	if(last - first < 2)
+		return last;
+	if(!radix_sortable(first, last)){
+		sort_strings(first, last, nthreads);
+		return unique_strings(first, last);
+	}
+	std::vector<radix_key> keys = radix_sorted_keys(first, last, nthreads);
+	std::vector<adv_string_view<T>> sorted;
+	sorted.reserve(keys.size());
+	const radix_key *prev = nullptr;
+	for(const radix_key &k : keys){
+		if(prev != nullptr && prev->siz == k.siz && (k.siz == 0 || std::memcmp(prev->data, k.data, k.siz) == 0))
+			continue;
+		sorted.push_back(first[k.idx]);
+		prev = &k;
+	}
+	std::copy(sorted.begin(), sorted.end(), first);
+	return first + sorted.size();
+}
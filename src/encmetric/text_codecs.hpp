@@ -0,0 +1,268 @@
+#pragma once
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+    Binary to text codecs: Base16 and Base32 (RFC 4648) and percent-encoding (RFC 3986).
+
+    Every codec is an encoding class, where a character is a group of bytes, and has also bulk
+    functions working on whole buffers. Encoding is always uppercase, decoding accepts also
+    lowercase letters. Bulk functions process 8 bytes at a time and fall back to the lookup tables
+    when a word contains characters that need a special handling. They return the number of bytes
+    written and throw encoding_error on invalid input.
+*/
+#include <encmetric/encoding.hpp>
+
+namespace adv{
+
+/*
+    Base16 (hexadecimal), every byte is encoded with two digits
+*/
+class Base16{
+	public:
+		using ctype=byte;
+		static constexpr uint unity() noexcept {return 2;}
+		static constexpr bool has_max() noexcept {return true;}
+		static constexpr uint max_bytes() noexcept {return 2;}
+		static constexpr uint chLen(const byte *) noexcept {return 2;}
+		static bool validChar(const byte *, uint &) noexcept;
+		static uint decode(byte *uni, const byte *by, size_t l);
+		static uint encode(const byte &uni, byte *by, size_t l);
+};
+
+inline constexpr size_t base16_encoded_size(size_t siz) noexcept {return 2 * siz;}
+inline constexpr size_t base16_decoded_size(size_t siz) noexcept {return siz / 2;}
+
+size_t base16_encode(const byte *from, byte *to, size_t siz) noexcept;
+size_t base16_decode(const byte *from, byte *to, size_t siz);
+
+/*
+    Streaming Base16 decoder, input buffers can have an odd length
+*/
+class base16_decoder{
+	private:
+		byte pend;
+		bool has;
+	public:
+		base16_decoder() noexcept : pend{}, has{false} {}
+		/*
+		    to must have space for base16_decoded_size(siz + 1) bytes
+		*/
+		size_t update(const byte *from, size_t siz, byte *to);
+		/*
+		    Throws encoding_error if a digit is left
+		*/
+		void finish();
+		void reset() noexcept {has = false;}
+};
+
+/*
+    Group of up to 5 bytes encoded by Base32, nbyte is the number of bytes of the group
+*/
+struct five_byte{
+	byte *bytes;
+	uint nbyte;
+};
+
+/*
+    Base32 with padding, every character is a group of 8 digits. Groups with less than 5 bytes
+    are padded with '='
+*/
+class Base32{
+	public:
+		using ctype=five_byte;
+		static constexpr uint unity() noexcept {return 8;}
+		static constexpr bool has_max() noexcept {return true;}
+		static constexpr uint max_bytes() noexcept {return 8;}
+		static constexpr uint chLen(const byte *) noexcept {return 8;}
+		static bool validChar(const byte *, uint &) noexcept;
+		static uint decode(five_byte *uni, const byte *by, size_t l);
+		static uint encode(const five_byte &uni, byte *by, size_t l);
+};
+
+size_t base32_encoded_size(size_t siz, bool padding = true) noexcept;
+/*
+    Exact number of decoded bytes of the siz bytes of from, with or without padding
+*/
+size_t base32_decoded_size(const byte *from, size_t siz) noexcept;
+
+size_t base32_encode(const byte *from, byte *to, size_t siz, bool padding = true) noexcept;
+/*
+    The input can be padded or not
+*/
+size_t base32_decode(const byte *from, byte *to, size_t siz);
+
+/*
+    Streaming Base32 codecs, input buffers can be cut anywhere
+*/
+class base32_encoder{
+	private:
+		byte pend[4];
+		uint npend;
+		bool padding;
+	public:
+		explicit base32_encoder(bool pad = true) noexcept : pend{}, npend{0}, padding{pad} {}
+		/*
+		    to must have space for base32_encoded_size(siz + 4) bytes
+		*/
+		size_t update(const byte *from, size_t siz, byte *to) noexcept;
+		/*
+		    Encodes the last bytes, to must have space for 8 bytes
+		*/
+		size_t finish(byte *to) noexcept;
+		void reset() noexcept {npend = 0;}
+};
+
+class base32_decoder{
+	private:
+		byte pend[8];
+		uint npend;
+		bool ended;
+	public:
+		base32_decoder() noexcept : pend{}, npend{0}, ended{false} {}
+		/*
+		    to must have space for (siz + 7) / 8 * 5 bytes
+		*/
+		size_t update(const byte *from, size_t siz, byte *to);
+		/*
+		    Decodes the last group if the input isn't padded, to must have space for 5 bytes
+		*/
+		size_t finish(byte *to);
+		void reset() noexcept {npend = 0; ended = false;}
+};
+
+/*
+    Characters left as they are by percent-encoding, any other byte is encoded as %XX:
+     - component: only the unreserved characters, for query parameters and path segments
+     - path: also the sub-delimiters, ':', '@' and '/'
+     - query: also '?', for whole queries and fragments
+     - uri: all the reserved characters, for whole URIs
+*/
+enum class percent_set : std::uint8_t{
+	component, path, query, uri
+};
+
+/*
+    Any set of bytes left as they are by percent-encoding, bit i%64 of the i/64-th word is set if
+    the byte i is kept. Every percent_set is a predefined mask
+*/
+class percent_mask{
+	private:
+		std::uint64_t bits[4];
+	public:
+		constexpr percent_mask() noexcept : bits{0, 0, 0, 0} {}
+		constexpr percent_mask(std::uint64_t b0, std::uint64_t b1, std::uint64_t b2, std::uint64_t b3) noexcept : bits{b0, b1, b2, b3} {}
+		explicit percent_mask(percent_set) noexcept;
+
+		constexpr bool contains(byte b) const noexcept{
+			uint i = std::to_integer<uint>(b);
+			return (bits[i >> 6] >> (i & 63)) & 1;
+		}
+		constexpr percent_mask &add(byte b) noexcept{
+			uint i = std::to_integer<uint>(b);
+			bits[i >> 6] |= std::uint64_t{1} << (i & 63);
+			return *this;
+		}
+		/*
+		    chars is a zero terminated string
+		*/
+		constexpr percent_mask &add(const char *chars) noexcept{
+			for(; *chars != '\0'; chars++)
+				add(byte{static_cast<std::uint8_t>(*chars)});
+			return *this;
+		}
+		constexpr percent_mask &remove(byte b) noexcept{
+			uint i = std::to_integer<uint>(b);
+			bits[i >> 6] &= ~(std::uint64_t{1} << (i & 63));
+			return *this;
+		}
+		/*
+		    True if all the ASCII letters and digits are kept
+		*/
+		constexpr bool keeps_alnum() const noexcept{
+			return (bits[0] & 0x03FF000000000000ULL) == 0x03FF000000000000ULL && (bits[1] & 0x07FFFFFE07FFFFFEULL) == 0x07FFFFFE07FFFFFEULL;
+		}
+};
+
+bool percent_keep(byte, percent_set) noexcept;
+inline bool percent_keep(byte b, const percent_mask &mask) noexcept {return mask.contains(b);}
+
+/*
+    Exact number of encoded (or decoded) bytes
+*/
+size_t percent_encoded_size(const byte *from, size_t siz, const percent_mask &mask) noexcept;
+inline size_t percent_encoded_size(const byte *from, size_t siz, percent_set set = percent_set::component) noexcept{
+	return percent_encoded_size(from, siz, percent_mask{set});
+}
+size_t percent_decoded_size(const byte *from, size_t siz) noexcept;
+
+size_t percent_encode(const byte *from, byte *to, size_t siz, const percent_mask &mask) noexcept;
+inline size_t percent_encode(const byte *from, byte *to, size_t siz, percent_set set = percent_set::component) noexcept{
+	return percent_encode(from, to, siz, percent_mask{set});
+}
+/*
+    Decodes every %XX sequence, the other bytes must be unreserved or reserved characters
+*/
+size_t percent_decode(const byte *from, byte *to, size_t siz);
+
+/*
+    Every character is a single byte, encoded as it is or with a %XX sequence
+*/
+class percent_codec{
+	public:
+		using ctype=byte;
+		static constexpr uint unity() noexcept {return 1;}
+		static constexpr bool has_max() noexcept {return true;}
+		static constexpr uint max_bytes() noexcept {return 3;}
+		static constexpr uint chLen(const byte *b) noexcept {return b[0] == byte{'%'} ? 3 : 1;}
+		static bool validChar(const byte *, uint &) noexcept;
+		static uint decode(byte *uni, const byte *by, size_t l);
+		static uint encode(const byte &uni, byte *by, size_t l, percent_set set);
+};
+
+template<percent_set S>
+class Percent : public percent_codec{
+	public:
+		static uint encode(const byte &uni, byte *by, size_t l) {return percent_codec::encode(uni, by, l, S);}
+};
+
+using PercentComponent = Percent<percent_set::component>;
+using PercentPath = Percent<percent_set::path>;
+using PercentQuery = Percent<percent_set::query>;
+using PercentURI = Percent<percent_set::uri>;
+
+/*
+    Streaming percent decoder, an escape sequence can be split between two calls
+*/
+class percent_decoder{
+	private:
+		byte pend[2];
+		uint npend;
+	public:
+		percent_decoder() noexcept : pend{}, npend{0} {}
+		/*
+		    to must have space for siz bytes
+		*/
+		size_t update(const byte *from, size_t siz, byte *to);
+		/*
+		    Throws encoding_error if an escape sequence is incomplete
+		*/
+		void finish();
+		void reset() noexcept {npend = 0;}
+};
+
+}
@@ -16,10 +16,213 @@
     You should have received a copy of the GNU Lesser General Public License
     along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
 */
+#include <vector>
+#include <cstdint>
 #include <encmetric/enc_string.hpp>
+#include <encmetric/utf16_enc.hpp>
 
 namespace adv{
 
+/*
+ * Precompiled set of delimiter characters.
+ *
+ * Single byte characters are stored in a bitmap, longer characters in a small hash table.
+ * If the encoding is ASCII compatible and all the delimiters are ASCII characters then strings
+ * are scanned 8 bytes at a time without splitting them into characters. UTF16 strings with
+ * ASCII delimiters are scanned in the same way as four 16-bit units, since units lower than 0x80
+ * are always whole characters
+ */
+template<typename T>
+class delimiter_set{
+	private:
+		EncMetric_info<T> ei;
+		std::uint64_t single[4];//single byte delimiters
+		std::uint64_t lead[4];//first bytes of longer delimiters
+		std::vector<std::uint64_t> multi;//longer delimiters, 0 is an empty slot
+		std::uint64_t swar[4];
+		uint nsingle;//single byte delimiters, or ASCII delimiters when unit is 2
+		size_t nmulti;
+		uint unit;//bytes per unit in byte scanning, 2 only for UTF16
+		bool le;
+		bool bytescan;
+
+		static bool test(const std::uint64_t *map, byte b) noexcept{
+			uint i = std::to_integer<uint>(b);
+			return (map[i >> 6] >> (i & 63)) & 1;
+		}
+		static void mark(std::uint64_t *map, byte b) noexcept{
+			uint i = std::to_integer<uint>(b);
+			map[i >> 6] |= std::uint64_t{1} << (i & 63);
+		}
+		/*
+		 * Packs up to 7 bytes and the length in a single integer, never 0
+		 */
+		static std::uint64_t pack(const byte *b, uint chl) noexcept{
+			std::uint64_t ret = static_cast<std::uint64_t>(chl) << 56;
+			for(uint i=0; i<chl; i++)
+				ret |= std::to_integer<std::uint64_t>(b[i]) << (8*i);
+			return ret;
+		}
+		/*
+		 * Value of a 16-bit unit, only when unit is 2
+		 */
+		uint unit_value(const byte *b) const noexcept{
+			return le ? std::to_integer<uint>(b[0]) | (std::to_integer<uint>(b[1]) << 8) : (std::to_integer<uint>(b[0]) << 8) | std::to_integer<uint>(b[1]);
+		}
+		bool test_unit(const byte *b) const noexcept{
+			if(unit == 1)
+				return test(single, *b);
+			uint v = unit_value(b);
+			return v < 0x80 && test(single, byte{static_cast<std::uint8_t>(v)});
+		}
+		void add_scan(byte b){
+			if(!test(single, b)){
+				if(nsingle < 4)
+					swar[nsingle] = swar_lanes(std::to_integer<std::uint8_t>(b), unit);
+				nsingle++;
+			}
+			mark(single, b);
+		}
+		static size_t slot_of(std::uint64_t key, size_t mask) noexcept{
+			return static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+		}
+		void add_multi(std::uint64_t key){
+			if(2 * (nmulti + 1) > multi.size()){
+				std::vector<std::uint64_t> old{};
+				old.swap(multi);
+				multi.assign(old.size() == 0 ? 8 : 2 * old.size(), 0);
+				nmulti = 0;
+				for(std::uint64_t k : old){
+					if(k != 0)
+						add_multi(k);
+				}
+			}
+			size_t mask = multi.size() - 1;
+			size_t i = slot_of(key, mask);
+			while(multi[i] != 0){
+				if(multi[i] == key)
+					return;
+				i = (i+1) & mask;
+			}
+			multi[i] = key;
+			nmulti++;
+		}
+		bool has_multi(std::uint64_t key) const noexcept{
+			size_t mask = multi.size() - 1;
+			for(size_t i = slot_of(key, mask); multi[i] != 0; i = (i+1) & mask){
+				if(multi[i] == key)
+					return true;
+			}
+			return false;
+		}
+		/*
+		 * Byte scanning, only when bytescan is true
+		 */
+		const byte *find_bytes(const byte *b, const byte *e) const noexcept{
+			if(nsingle == 0 || b == e)
+				return e;
+			if(nsingle == 1 && unit == 1){
+				const void *f = std::memchr(b, static_cast<int>(swar[0] & 0xff), e - b);
+				return f == nullptr ? e : static_cast<const byte *>(f);
+			}
+			//units are compared by value, so they must have the byte order of the machine
+			bool swap = unit == 2 && le != host_little_endian();
+			if(nsingle <= 4){
+				while(e - b >= 8){
+					std::uint64_t w = swar_load(b);
+					if(swap)
+						w = swar_bswap16(w);
+					std::uint64_t hit = 0;
+					for(uint i=0; i<nsingle; i++)
+						hit |= swar_hasless(w ^ swar[i], 1, unit);
+					if(hit != 0)
+						break;
+					b += 8;
+				}
+			}
+			else if(unit == 2){
+				//skips the words without ASCII units
+				while(e - b >= 8){
+					std::uint64_t w = swar_load(b);
+					if(swap)
+						w = swar_bswap16(w);
+					if(swar_hasless(w, 0x80, 2) != 0)
+						break;
+					b += 8;
+				}
+			}
+			while(static_cast<size_t>(e - b) >= unit && !test_unit(b))
+				b += unit;
+			return static_cast<size_t>(e - b) >= unit ? b : e;
+		}
+	public:
+		explicit delimiter_set(const adv_string_view<T> &delim) : ei{delim.begin().raw_format()}, single{0, 0, 0, 0}, lead{0, 0, 0, 0}, multi{}, swar{0, 0, 0, 0}, nsingle{0}, nmulti{0}, unit{1}, le{true}, bytescan{true} {
+			if(ei.index() == index_traits<UTF16LE>::index())
+				unit = 2;
+			else if(ei.index() == index_traits<UTF16BE>::index()){
+				unit = 2;
+				le = false;
+			}
+			else if(ei.unity() != 1 || !ei.ascii_compatible())
+				bytescan = false;
+			const_tchar_pt<T> p = delim.begin();
+			for(size_t i=0; i<delim.length(); i++){
+				uint chl = p.chLen();
+				if(chl == 1){
+					add_scan(p[0]);
+					if(!bit_zero(p[0], 7))
+						bytescan = false;
+				}
+				else if(chl < 8){
+					mark(lead, p[0]);
+					add_multi(pack(p.data(), chl));
+					if(unit == 2 && chl == 2 && unit_value(p.data()) < 0x80)
+						add_scan(byte{static_cast<std::uint8_t>(unit_value(p.data()))});
+					else
+						bytescan = false;
+				}
+				else
+					throw encoding_error{"Delimiter too long"};
+				p.next();
+			}
+		}
+		/*
+		 * Test if the character pointed is a delimiter
+		 */
+		bool contains(const_tchar_pt<T> p) const{
+			uint chl = p.chLen();
+			if(chl == 1)
+				return test(single, p[0]);
+			if(nmulti == 0 || chl >= 8 || !test(lead, p[0]))
+				return false;
+			return has_multi(pack(p.data(), chl));
+		}
+		/*
+		 * First delimiter between b and e, e if there isn't any
+		 */
+		const_tchar_pt<T> find(const_tchar_pt<T> b, const_tchar_pt<T> e) const{
+			if(bytescan)
+				return b + (find_bytes(b.data(), e.data()) - b.data());
+			while(b != e && !contains(b))
+				b.next();
+			return b;
+		}
+		/*
+		 * First non delimiter character between b and e, e if there isn't any
+		 */
+		const_tchar_pt<T> skip(const_tchar_pt<T> b, const_tchar_pt<T> e) const{
+			if(bytescan){
+				const byte *d = b.data();
+				while(static_cast<size_t>(e.data() - d) >= unit && test_unit(d))
+					d += unit;
+				return static_cast<size_t>(e.data() - d) >= unit ? b + (d - b.data()) : e;
+			}
+			while(b != e && contains(b))
+				b.next();
+			return b;
+		}
+};
+
 /*
  * A simple class useful to divide a string into tokens
  */
@@ -47,9 +250,9 @@ class Token{
 			return true;
 		}
 		/*
-         * Share a view of current token
+         * Share a view of current token, it can't throw since the token is part of an already valid string
          */
-		adv_string_view<T> share() const noexcept {return adv_string_view<T>(s, e-s, true);}
+		adv_string_view<T> share() const noexcept {return adv_string_view<T>{s, static_cast<size_t>(e-s), meas::size};}
 		/*
          * Steps the token pointer until it encounter a character contained in the argumet
          */
@@ -86,6 +289,52 @@ class Token{
 			adv_string_view<T> ret = share();
 			return ret;
 		}
+		/*
+         * Same as above, with precompiled delimiters
+         */
+		bool goUp(const delimiter_set<T> &delim){
+			e = delim.find(e, end);
+			return e != end;
+		}
+		bool goUntil(const delimiter_set<T> &delim){
+			e = delim.skip(e, end);
+			return e != end;
+		}
+		adv_string_view<T> proceed(const delimiter_set<T> &delim){
+			goUntil(delim);
+			flush();
+			goUp(delim);
+			return share();
+		}
 };
 
+/*
+ * Splits the string in tokens separated by a delimiter and appends them to out in a single pass.
+ * If skip_empty is true then consecutive delimiters are treated as a single one (as Token::proceed),
+ * otherwise an empty token is added between them.
+ *
+ * Returns the number of tokens added
+ */
+template<typename T, typename A>
+size_t split(const adv_string_view<T> &str, const delimiter_set<T> &delim, std::vector<adv_string_view<T>, A> &out, bool skip_empty = false){
+	const_tchar_pt<T> b = str.begin();
+	const_tchar_pt<T> end = b + str.size();
+	size_t added = 0;
+	while(true){
+		if(skip_empty){
+			b = delim.skip(b, end);
+			if(b == end)
+				break;
+		}
+		const_tchar_pt<T> e = delim.find(b, end);
+		out.push_back(adv_string_view<T>{b, static_cast<size_t>(e - b), meas::size});
+		added++;
+		if(e == end)
+			break;
+		b = e;
+		b.next();
+	}
+	return added;
+}
+
 }
@@ -0,0 +1,60 @@
+#pragma once
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+    Transliteration tables: each character is mapped to a sequence of characters, used by conversions
+    in order to approximate characters not included in the destination encoding.
+*/
+#include <vector>
+#include <encmetric/base.hpp>
+
+namespace adv{
+
+class translit_table{
+	private:
+		struct entry{
+			unicode from;
+			size_t off;
+			size_t n;
+		};
+		std::vector<entry> entries;//sorted by from
+		std::vector<unicode> chars;
+	public:
+		translit_table() : entries{}, chars{} {}
+
+		/*
+		    Adds or replaces the transliteration of from
+		*/
+		void add(unicode from, const unicode *to, size_t n);
+		/*
+		    to is an ASCII zero terminated string
+		*/
+		void add(unicode from, const char *to);
+		/*
+		    Searches the transliteration of c, returns false if it's not present
+		*/
+		bool find(unicode c, const unicode *&to, size_t &n) const noexcept;
+		size_t size() const noexcept {return entries.size();}
+
+		/*
+		    Latin letters with diacritics, typographic punctuation and common symbols to ASCII
+		*/
+		static const translit_table &ascii();
+};
+
+}
@@ -31,7 +31,9 @@ class UTF16{
 		static constexpr uint unity() noexcept {return 2;}
 		static constexpr bool has_max() noexcept {return true;}
 		static constexpr uint max_bytes() noexcept {return 4;}
+		static constexpr bool ascii_units() noexcept {return true;}
 		static uint chLen(const byte *);
+		static uint prevLen(const byte *, const byte *);
 		static bool validChar(const byte *, uint &chlen) noexcept;
 		static uint decode(unicode *uni, const byte *by, size_t l);
 		static uint encode(const unicode &uni, byte *by, size_t l);
@@ -31,6 +31,7 @@ class UTF32{
 		static constexpr uint unity() noexcept {return 4;}
 		static constexpr bool has_max() noexcept {return true;}
 		static constexpr uint max_bytes() noexcept {return 4;}
+		static constexpr bool byte_ordered() noexcept {return be;}
 		static uint chLen(const byte *){ return 4;}
 		static bool validChar(const byte *, uint &chlen) noexcept;
 		static uint decode(unicode *uni, const byte *by, size_t l);
@@ -25,10 +25,14 @@ class UTF8{
 		static constexpr uint unity() noexcept {return 1;}
 		static constexpr bool has_max() noexcept {return true;}
 		static constexpr uint max_bytes() noexcept {return 4;}
+		static constexpr bool byte_ordered() noexcept {return true;}
+		static constexpr bool ascii_compatible() noexcept {return true;}
 		static uint chLen(const byte *);
+		static uint prevLen(const byte *, const byte *);
 		static bool validChar(const byte *, uint &chlen) noexcept;
 		static uint decode(unicode *uni, const byte *by, size_t l);
 		static uint encode(const unicode &uni, byte *by, size_t l);
+		static bool decode_checked(unicode *uni, const byte *by, size_t l, uint &len) noexcept;
 };
 
 }
@@ -16,15 +16,4 @@
     You should have received a copy of the GNU Lesser General Public License
     along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
 */
-#include <encmetric/ascii_extensions.hpp>
-
-namespace adv{
-	class Win_1252 : ASCII_extension<Win_1252>{
-		public:
-			static const unsigned int table[];
-	};
-	class Win_1250 : ASCII_extension<Win_1250>{
-		public:
-			static const unsigned int table[];
-	};
-}
+#include <encmetric/codepages.hpp>
@@ -0,0 +1,118 @@
+#ifndef ENCMETRIC_C_H
+#define ENCMETRIC_C_H
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+/*
+    C interface of Encmetric, provided by the shared library encmetric_c.
+
+    Encodings are opaque handles obtained from the encoding registry by name, they're never freed.
+    All the functions work on whole buffers and never throw: errors are reported with an
+    encmetric_status. When a function stops before the end of the input read is set to the number of
+    bytes processed, so the call can be resumed from there.
+*/
+#include <stddef.h>
+
+#if defined(_WIN32)
+#	ifdef ENCMETRIC_C_BUILD
+#		define ENCMETRIC_API __declspec(dllexport)
+#	else
+#		define ENCMETRIC_API __declspec(dllimport)
+#	endif
+#else
+#	define ENCMETRIC_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+typedef struct encmetric_encoding encmetric_encoding;
+typedef struct encmetric_converter encmetric_converter;
+
+typedef enum encmetric_status{
+	/* the whole input has been processed */
+	ENCMETRIC_OK = 0,
+	/* the output buffer is full, call again with more space */
+	ENCMETRIC_OUTPUT_FULL = 1,
+	/* the input ends in the middle of a character, call again with more input */
+	ENCMETRIC_INCOMPLETE = 2,
+	/* invalid byte sequence at the end of the processed input */
+	ENCMETRIC_INVALID = 3,
+	/* the character at the end of the processed input can't be represented in the destination encoding */
+	ENCMETRIC_UNMAPPABLE = 4,
+	/* null arguments or other errors */
+	ENCMETRIC_ERROR = 5
+} encmetric_status;
+
+/*
+    Encoding with the given name (see enc_registry.hpp), NULL if unknown
+*/
+ENCMETRIC_API const encmetric_encoding *encmetric_find(const char *name);
+ENCMETRIC_API const encmetric_encoding *encmetric_find_n(const char *name, size_t len);
+/*
+    If data starts with a BOM returns its encoding and sets bomlen to its length, otherwise returns
+    the encoding named name (NULL if unknown) and sets bomlen to 0
+*/
+ENCMETRIC_API const encmetric_encoding *encmetric_detect(const char *name, const void *data, size_t n, size_t *bomlen);
+/*
+    Maximum number of bytes of a character, useful to allocate output buffers
+*/
+ENCMETRIC_API size_t encmetric_max_bytes(const encmetric_encoding *enc);
+ENCMETRIC_API const char *encmetric_status_string(encmetric_status st);
+
+/*
+    Validates the n bytes of src, read (if not NULL) is set to the length of the longest valid prefix
+*/
+ENCMETRIC_API encmetric_status encmetric_validate(const encmetric_encoding *enc, const void *src, size_t n, size_t *read);
+/*
+    Like encmetric_validate, nchr is set to the number of characters of the valid prefix
+*/
+ENCMETRIC_API encmetric_status encmetric_count(const encmetric_encoding *enc, const void *src, size_t n, size_t *read, size_t *nchr);
+/*
+    Converts src into dst (with capacity cap bytes), only whole characters are written. read and
+    written are set to the number of bytes read and written. If the status isn't ENCMETRIC_OK
+    the conversion can be resumed from src + read and dst + written
+*/
+ENCMETRIC_API encmetric_status encmetric_convert(const encmetric_encoding *src_enc, const void *src, size_t n,
+	const encmetric_encoding *dst_enc, void *dst, size_t cap, size_t *read, size_t *written);
+
+/*
+    Streaming conversion: the bytes of a character split between two calls are kept by the converter,
+    so input buffers can be cut anywhere. Returns NULL if an argument is NULL or out of memory
+*/
+ENCMETRIC_API encmetric_converter *encmetric_converter_new(const encmetric_encoding *src_enc, const encmetric_encoding *dst_enc);
+ENCMETRIC_API void encmetric_converter_free(encmetric_converter *conv);
+/*
+    Discards the kept bytes
+*/
+ENCMETRIC_API void encmetric_converter_reset(encmetric_converter *conv);
+/*
+    Same as encmetric_convert, but a trailing incomplete character is kept by the converter (and
+    counted in read) instead of returning ENCMETRIC_INCOMPLETE. Set flush to a nonzero value on
+    the last buffer: it returns ENCMETRIC_INCOMPLETE if the input ends in the middle of a character.
+    If an error is caused by a character started in a previous call read is 0, reset the converter
+    to skip it
+*/
+ENCMETRIC_API encmetric_status encmetric_converter_run(encmetric_converter *conv, const void *src, size_t n,
+	void *dst, size_t cap, size_t *read, size_t *written, int flush);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
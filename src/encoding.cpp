@@ -50,6 +50,16 @@ uint ASCII::encode(const unicode &uni, byte *by, size_t l){
 	return 1;
 }
 
+bool ASCII::encode_checked(const unicode &uni, byte *by, size_t l, uint &len){
+	if(l == 0)
+		throw buffer_small{};
+	if(uni >= 128)
+		return false;
+	by[0] = byte{static_cast<uint8_t>(uni & 0xff)};
+	len = 1;
+	return true;
+}
+
 //------------------------------
 
 uint Latin1::chLen(const byte *){
@@ -77,6 +87,16 @@ uint Latin1::encode(const unicode &uni, byte *by, size_t l){
 	return 1;
 }
 
+bool Latin1::encode_checked(const unicode &uni, byte *by, size_t l, uint &len){
+	if(l == 0)
+		throw buffer_small{};
+	if(uni >= 256)
+		return false;
+	by[0] = byte{static_cast<std::uint8_t>(uni & 0xff)};
+	len = 1;
+	return true;
+}
+
 //------------------------------
 /*
 void copyN(const byte *src, byte *dest, int len) noexcept{
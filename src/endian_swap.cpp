@@ -0,0 +1,116 @@
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <encmetric/endian_swap.hpp>
+
+namespace adv{
+
+/*
+    Masks of the bytes containing the most significant byte of every UTF16 code unit
+*/
+static std::uint64_t high_bytes(bool be) noexcept{
+	const std::uint8_t mbe[8] = {0xFF, 0, 0xFF, 0, 0xFF, 0, 0xFF, 0};
+	const std::uint8_t mle[8] = {0, 0xFF, 0, 0xFF, 0, 0xFF, 0, 0xFF};
+	return swar_load(reinterpret_cast<const byte *>(be ? mbe : mle));
+}
+
+size_t swap_utf16(const byte *in, byte *out, size_t siz, bool be) noexcept{
+	siz -= siz % 2;
+	const std::uint64_t hmask = high_bytes(be);
+	const int h = be ? 0 : 1;
+	size_t i = 0;
+	size_t pending = siz;//position of a high surrogate waiting for its low surrogate
+	while(i < siz){
+		if(pending == siz && i + 8 <= siz){
+			std::uint64_t w = swar_load(in + i);
+			/*
+			    Only the most significant bytes are tested, the other ones are set to a non zero value
+			*/
+			std::uint64_t sur = ((w & swar_broadcast(0xF8)) ^ swar_broadcast(0xD8)) | ~hmask;
+			if(swar_haszero(sur) == 0){
+				swar_store(out + i, swar_bswap16(w));
+				i += 8;
+				continue;
+			}
+		}
+		std::uint8_t hb = std::to_integer<std::uint8_t>(in[i + h]);
+		if((hb & 0xFC) == 0xD8){
+			if(pending != siz)
+				return pending;
+			//written together with its low surrogate
+			pending = i;
+			i += 2;
+			continue;
+		}
+		else if((hb & 0xFC) == 0xDC){
+			if(pending == siz)
+				return i;
+			byte p0 = in[pending], p1 = in[pending + 1];
+			out[pending] = p1;
+			out[pending + 1] = p0;
+			pending = siz;
+		}
+		else if(pending != siz)
+			return pending;
+		byte b0 = in[i], b1 = in[i + 1];
+		out[i] = b1;
+		out[i + 1] = b0;
+		i += 2;
+	}
+	return pending != siz ? pending : siz;
+}
+
+/*
+    True if the UTF32 code unit c is a Unicode scalar value
+*/
+static bool valid_utf32(const byte *c, bool be) noexcept{
+	std::uint8_t hb = std::to_integer<std::uint8_t>(c[be ? 0 : 3]);
+	std::uint8_t mb = std::to_integer<std::uint8_t>(c[be ? 1 : 2]);
+	std::uint8_t lb = std::to_integer<std::uint8_t>(c[be ? 2 : 1]);
+	return hb == 0 && mb <= 0x10 && (mb != 0 || (lb & 0xF8) != 0xD8);
+}
+
+static void swap_unit32(const byte *in, byte *out) noexcept{
+	byte b0 = in[0], b1 = in[1], b2 = in[2], b3 = in[3];
+	out[0] = b3;
+	out[1] = b2;
+	out[2] = b1;
+	out[3] = b0;
+}
+
+size_t swap_utf32(const byte *in, byte *out, size_t siz, bool be) noexcept{
+	siz -= siz % 4;
+	size_t i = 0;
+	for(; i + 8 <= siz; i += 8){
+		if(!valid_utf32(in + i, be))
+			return i;
+		if(!valid_utf32(in + i + 4, be)){
+			//the first unit is valid, so it must be written
+			swap_unit32(in + i, out + i);
+			return i + 4;
+		}
+		swar_store(out + i, swar_bswap32(swar_load(in + i)));
+	}
+	if(i < siz){
+		if(!valid_utf32(in + i, be))
+			return i;
+		swap_unit32(in + i, out + i);
+	}
+	return siz;
+}
+
+}
@@ -0,0 +1,108 @@
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <encmetric/hash.hpp>
+
+using namespace adv;
+
+/*
+    Same mixing steps of xxHash64
+*/
+namespace{
+constexpr std::uint64_t prime1 = 0x9E3779B185EBCA87ULL;
+constexpr std::uint64_t prime2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr std::uint64_t prime3 = 0x165667B19E3779F9ULL;
+constexpr std::uint64_t prime4 = 0x85EBCA77C2B2AE63ULL;
+constexpr std::uint64_t prime5 = 0x27D4EB2F165667C5ULL;
+
+inline std::uint64_t rotl(std::uint64_t x, int r) noexcept{
+	return (x << r) | (x >> (64 - r));
+}
+
+inline std::uint64_t read64(const byte *b) noexcept{
+	std::uint64_t ret;
+	std::memcpy(&ret, b, 8);
+	return ret;
+}
+
+inline std::uint64_t read32(const byte *b) noexcept{
+	std::uint32_t ret;
+	std::memcpy(&ret, b, 4);
+	return ret;
+}
+
+inline std::uint64_t lane_round(std::uint64_t acc, std::uint64_t input) noexcept{
+	acc += input * prime2;
+	acc = rotl(acc, 31);
+	return acc * prime1;
+}
+
+inline std::uint64_t lane_merge(std::uint64_t acc, std::uint64_t lane) noexcept{
+	acc ^= lane_round(0, lane);
+	return acc * prime1 + prime4;
+}
+}
+
+std::uint64_t adv::hash_bytes(const byte *data, size_t siz, std::uint64_t seed) noexcept{
+	const byte *end = data + siz;
+	std::uint64_t h;
+	if(siz >= 32){
+		std::uint64_t v1 = seed + prime1 + prime2;
+		std::uint64_t v2 = seed + prime2;
+		std::uint64_t v3 = seed;
+		std::uint64_t v4 = seed - prime1;
+		const byte *limit = end - 32;
+		do{
+			v1 = lane_round(v1, read64(data));
+			v2 = lane_round(v2, read64(data + 8));
+			v3 = lane_round(v3, read64(data + 16));
+			v4 = lane_round(v4, read64(data + 24));
+			data += 32;
+		}
+		while(data <= limit);
+		h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+		h = lane_merge(h, v1);
+		h = lane_merge(h, v2);
+		h = lane_merge(h, v3);
+		h = lane_merge(h, v4);
+	}
+	else
+		h = seed + prime5;
+	h += static_cast<std::uint64_t>(siz);
+
+	while(end - data >= 8){
+		h ^= lane_round(0, read64(data));
+		h = rotl(h, 27) * prime1 + prime4;
+		data += 8;
+	}
+	if(end - data >= 4){
+		h ^= read32(data) * prime1;
+		h = rotl(h, 23) * prime2 + prime3;
+		data += 4;
+	}
+	while(data < end){
+		h ^= std::to_integer<std::uint64_t>(*data) * prime5;
+		h = rotl(h, 11) * prime1;
+		data++;
+	}
+	h ^= h >> 33;
+	h *= prime2;
+	h ^= h >> 29;
+	h *= prime3;
+	h ^= h >> 32;
+	return h;
+}
@@ -0,0 +1,125 @@
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <encmetric/json.hpp>
+
+using namespace adv;
+
+namespace{
+
+std::uint32_t unit_value(const byte *b, uint u, bool le) noexcept{
+	std::uint32_t ret = 0;
+	for(uint i = 0; i < u; i++)
+		ret = (ret << 8) | std::to_integer<std::uint32_t>(b[le ? u - 1 - i : i]);
+	return ret;
+}
+
+bool special(std::uint32_t c, bool unescape, bool ascii_only) noexcept{
+	if(unescape)
+		return c == '\\';
+	return c < 0x20 || c == '"' || c == '\\' || (ascii_only && c >= 0x80);
+}
+
+}
+
+size_t json_conversion::clean_units(const byte *b, size_t n, uint u, bool le, bool unescape, bool ascii_only) noexcept{
+	const size_t per = 8 / u;
+	//items of more bytes are compared by value
+	const bool swap = u > 1 && le != host_little_endian();
+	const std::uint64_t high = swar_lanes(((std::uint64_t{1} << (8 * u)) - 1) & ~std::uint64_t{0x7f}, u);
+	size_t i = 0;
+	while(i + per <= n){
+		std::uint64_t w = swar_load(b + i * u);
+		if(swap)
+			w = u == 2 ? swar_bswap16(w) : swar_bswap32(w);
+		std::uint64_t bad = swar_haseq(w, '\\', u);
+		if(!unescape){
+			bad |= swar_hasless(w, 0x20, u) | swar_haseq(w, '"', u);
+			if(ascii_only)
+				bad |= w & high;
+		}
+		if(bad != 0){
+			//the special item is in this word
+			for(size_t j = 0; j < per; j++, i++){
+				if(special(unit_value(b + i * u, u, le), unescape, ascii_only))
+					return i;
+			}
+			continue;
+		}
+		i += per;
+	}
+	while(i < n && !special(unit_value(b + i * u, u, le), unescape, ascii_only))
+		i++;
+	return i;
+}
+
+size_t json_conversion::put_escape(unicode c, char *out) noexcept{
+	static const char hex[] = "0123456789abcdef";
+	size_t n = 0;
+	auto hex4 = [&](std::uint32_t v){
+		out[n++] = '\\';
+		out[n++] = 'u';
+		for(int s = 12; s >= 0; s -= 4)
+			out[n++] = hex[(v >> s) & 0xf];
+	};
+	char sh = 0;
+	switch(static_cast<std::uint32_t>(c)){
+		case '"':
+			sh = '"';
+			break;
+		case '\\':
+			sh = '\\';
+			break;
+		case '\b':
+			sh = 'b';
+			break;
+		case '\f':
+			sh = 'f';
+			break;
+		case '\n':
+			sh = 'n';
+			break;
+		case '\r':
+			sh = 'r';
+			break;
+		case '\t':
+			sh = 't';
+			break;
+	}
+	if(sh != 0){
+		out[n++] = '\\';
+		out[n++] = sh;
+	}
+	else if(c >= 0x10000){
+		std::uint32_t v = c - 0x10000;
+		hex4(0xd800 + (v >> 10));
+		hex4(0xdc00 + (v & 0x3ff));
+	}
+	else
+		hex4(c);
+	return n;
+}
+
+unicode json_conversion::hex_value(unicode c) noexcept{
+	if(c >= '0' && c <= '9')
+		return unicode{c - '0'};
+	if(c >= 'a' && c <= 'f')
+		return unicode{c - 'a' + 10};
+	if(c >= 'A' && c <= 'F')
+		return unicode{c - 'A' + 10};
+	return unicode{0x10};
+}
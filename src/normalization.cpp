@@ -0,0 +1,182 @@
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <algorithm>
+#include <encmetric/normalization.hpp>
+
+namespace adv{
+
+struct norm_decomp_entry{
+	std::uint32_t chr;
+	std::uint16_t canon_off;
+	std::uint8_t canon_len;//0 if there is only a compatibility decomposition
+	std::uint16_t compat_off;
+	std::uint8_t compat_len;
+};
+
+struct norm_comp_entry{
+	std::uint32_t first;
+	std::uint32_t second;
+	std::uint32_t comp;
+};
+
+}
+
+#include "normalization_data.hpp"
+
+using namespace adv;
+
+static_assert(norm_max_decomposition <= max_decomposition, "Decomposition buffer too small");
+
+namespace{
+
+constexpr std::uint16_t NFD_NO = 1 << 8;
+constexpr std::uint16_t NFKD_NO = 1 << 9;
+constexpr std::uint16_t NFC_NO = 1 << 10;
+constexpr std::uint16_t NFC_MAYBE = 1 << 11;
+constexpr std::uint16_t NFKC_NO = 1 << 12;
+constexpr std::uint16_t NFKC_MAYBE = 1 << 13;
+
+constexpr std::uint32_t SBase = 0xAC00, LBase = 0x1100, VBase = 0x1161, TBase = 0x11A7;
+constexpr std::uint32_t LCount = 19, VCount = 21, TCount = 28;
+constexpr std::uint32_t NCount = VCount * TCount, SCount = LCount * NCount;
+
+std::uint16_t props(unicode c) noexcept{
+	if(c >= 0x110000)
+		return 0;
+	std::uint32_t blk = norm_stage1[c / norm_block];
+	return norm_props[norm_stage2[blk * norm_block + c % norm_block]];
+}
+
+}
+
+std::uint8_t adv::combining_class(unicode c) noexcept{
+	return static_cast<std::uint8_t>(props(c) & 0xFF);
+}
+
+qc_result adv::quick_check(unicode c, norm_form f) noexcept{
+	std::uint16_t p = props(c);
+	switch(f){
+	case norm_form::nfd:
+		return (p & NFD_NO) ? qc_result::no : qc_result::yes;
+	case norm_form::nfkd:
+		return (p & NFKD_NO) ? qc_result::no : qc_result::yes;
+	case norm_form::nfc:
+		return (p & NFC_NO) ? qc_result::no : ((p & NFC_MAYBE) ? qc_result::maybe : qc_result::yes);
+	default:
+		return (p & NFKC_NO) ? qc_result::no : ((p & NFKC_MAYBE) ? qc_result::maybe : qc_result::yes);
+	}
+}
+
+size_t adv::decompose(unicode c, bool compat, unicode *out) noexcept{
+	if(c >= SBase && c < SBase + SCount){
+		std::uint32_t s = c - SBase;
+		out[0] = unicode{LBase + s / NCount};
+		out[1] = unicode{VBase + (s % NCount) / TCount};
+		if(s % TCount == 0)
+			return 2;
+		out[2] = unicode{TBase + s % TCount};
+		return 3;
+	}
+	if((props(c) & (compat ? NFKD_NO : NFD_NO)) == 0){
+		out[0] = c;
+		return 1;
+	}
+	const norm_decomp_entry *end = norm_decomp + sizeof(norm_decomp) / sizeof(norm_decomp_entry);
+	const norm_decomp_entry *en = std::lower_bound(norm_decomp, end, c, [](const norm_decomp_entry &e, unicode u){
+		return e.chr < static_cast<std::uint32_t>(u);
+	});
+	size_t off = compat ? en->compat_off : en->canon_off;
+	size_t n = compat ? en->compat_len : en->canon_len;
+	for(size_t i=0; i<n; i++)
+		out[i] = unicode{norm_pool[off + i]};
+	return n;
+}
+
+bool adv::compose(unicode a, unicode b, unicode &res) noexcept{
+	if(a >= LBase && a < LBase + LCount && b >= VBase && b < VBase + VCount){
+		res = unicode{SBase + ((a - LBase) * VCount + (b - VBase)) * TCount};
+		return true;
+	}
+	if(a >= SBase && a < SBase + SCount && (a - SBase) % TCount == 0 && b > TBase && b < TBase + TCount){
+		res = unicode{a + (b - TBase)};
+		return true;
+	}
+	const norm_comp_entry *end = norm_comp + sizeof(norm_comp) / sizeof(norm_comp_entry);
+	const norm_comp_entry *en = std::lower_bound(norm_comp, end, std::make_pair(a, b), [](const norm_comp_entry &e, const std::pair<unicode, unicode> &p){
+		return e.first < p.first || (e.first == p.first && e.second < p.second);
+	});
+	if(en == end || en->first != a || en->second != b)
+		return false;
+	res = unicode{en->comp};
+	return true;
+}
+
+bool normalizer::boundary(unicode c) const noexcept{
+	std::uint16_t p = props(c);
+	if((p & 0xFF) != 0)
+		return false;
+	if(form == norm_form::nfc)
+		return (p & (NFC_NO | NFC_MAYBE)) == 0;
+	else if(form == norm_form::nfkc)
+		return (p & (NFKC_NO | NFKC_MAYBE)) == 0;
+	else
+		return true;
+}
+
+void normalizer::finish(){
+	//Canonical ordering: stable sort of every run of non starters
+	size_t n = seg.size();
+	for(size_t i=1; i<n; i++){
+		unicode c = seg[i];
+		std::uint8_t cc = combining_class(c);
+		if(cc == 0)
+			continue;
+		size_t j = i;
+		while(j > 0){
+			std::uint8_t pc = combining_class(seg[j-1]);
+			if(pc <= cc)
+				break;
+			seg[j] = seg[j-1];
+			j--;
+		}
+		seg[j] = c;
+	}
+	if(!composing() || n < 2)
+		return;
+	//Canonical composition
+	size_t starter = 0;
+	bool has_starter = combining_class(seg[0]) == 0;
+	int last = has_starter ? 0 : 256;
+	size_t w = 1;
+	for(size_t i=1; i<n; i++){
+		unicode c = seg[i];
+		int cc = combining_class(c);
+		unicode comp;
+		if(has_starter && (last < cc || last == 0) && compose(seg[starter], c, comp)){
+			seg[starter] = comp;
+			continue;
+		}
+		if(cc == 0){
+			starter = w;
+			has_starter = true;
+		}
+		last = cc;
+		seg[w++] = c;
+	}
+	seg.resize(w);
+}
@@ -0,0 +1,44 @@
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <encmetric/segmentation.hpp>
+#include "segmentation_data.hpp"
+
+using namespace adv;
+
+namespace{
+
+std::uint16_t props(unicode c) noexcept{
+	if(c >= 0x110000)
+		return 0;
+	std::uint32_t blk = seg_stage1[c / seg_block];
+	return seg_props[seg_stage2[blk * seg_block + c % seg_block]];
+}
+
+}
+
+grapheme_prop adv::grapheme_property(unicode c) noexcept{
+	return static_cast<grapheme_prop>(props(c) & 0x0F);
+}
+
+word_prop adv::word_property(unicode c) noexcept{
+	return static_cast<word_prop>((props(c) >> 8) & 0x1F);
+}
+
+bool adv::is_extended_pictographic(unicode c) noexcept{
+	return (props(c) & 0x10) != 0;
+}
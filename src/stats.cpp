@@ -0,0 +1,195 @@
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <encmetric/stats.hpp>
+
+using namespace adv;
+
+namespace{
+
+/*
+    Encodings counted by every thread, the other ones are ignored
+*/
+constexpr size_t max_stat_encodings = 64;
+constexpr size_t enc_values = 5;
+
+struct enc_counters{
+	std::type_index enc{typeid(void)};
+	std::atomic<std::uint64_t> values[enc_values];
+};
+
+/*
+    Counters of a thread, modified only by their thread. New encodings are published by
+    incrementing nencs, so other threads can read them without locks
+*/
+struct thread_counters{
+	std::atomic<std::uint64_t> events[stat_events];
+	enc_counters encs[max_stat_encodings];
+	std::atomic<size_t> nencs;
+	size_t last;
+
+	thread_counters() noexcept : events{}, encs{}, nencs{0}, last{0} {}
+
+	enc_counters *find(std::type_index idx) noexcept{
+		size_t n = nencs.load(std::memory_order_relaxed);
+		if(last < n && encs[last].enc == idx)
+			return encs + last;
+		for(size_t i=0; i<n; i++){
+			if(encs[i].enc == idx){
+				last = i;
+				return encs + i;
+			}
+		}
+		if(n == max_stat_encodings)
+			return nullptr;
+		encs[n].enc = idx;
+		nencs.store(n + 1, std::memory_order_release);
+		last = n;
+		return encs + n;
+	}
+
+	void add(std::type_index idx, size_t i, std::uint64_t n) noexcept{
+		enc_counters *c = find(idx);
+		if(c != nullptr)
+			c->values[i].fetch_add(n, std::memory_order_relaxed);
+	}
+
+	void clear() noexcept{
+		for(auto &e : events)
+			e.store(0, std::memory_order_relaxed);
+		size_t n = nencs.load(std::memory_order_acquire);
+		for(size_t i=0; i<n; i++){
+			for(auto &v : encs[i].values)
+				v.store(0, std::memory_order_relaxed);
+		}
+	}
+};
+
+/*
+    retired contains the counters of the terminated threads
+*/
+struct stats_registry{
+	std::mutex mtx;
+	std::vector<thread_counters *> live;
+	thread_counters retired;
+};
+
+stats_registry &registry(){
+	static stats_registry reg;
+	return reg;
+}
+
+void merge(thread_counters &to, const thread_counters &from) noexcept{
+	for(size_t i=0; i<stat_events; i++)
+		to.events[i].fetch_add(from.events[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+	size_t n = from.nencs.load(std::memory_order_acquire);
+	for(size_t i=0; i<n; i++){
+		for(size_t j=0; j<enc_values; j++)
+			to.add(from.encs[i].enc, j, from.encs[i].values[j].load(std::memory_order_relaxed));
+	}
+}
+
+/*
+    If the counters can't be added to live (no memory) they're still merged when the thread ends
+*/
+class thread_slot{
+	private:
+		stats_registry &reg;
+		bool listed;
+	public:
+		thread_counters counters;
+
+		thread_slot() noexcept : reg{registry()}, listed{false}, counters{}{
+			try{
+				std::lock_guard<std::mutex> lock{reg.mtx};
+				reg.live.push_back(&counters);
+				listed = true;
+			}
+			catch(...){}
+		}
+		~thread_slot(){
+			std::lock_guard<std::mutex> lock{reg.mtx};
+			merge(reg.retired, counters);
+			if(listed)
+				reg.live.erase(std::find(reg.live.begin(), reg.live.end(), &counters));
+		}
+};
+
+thread_counters &local() noexcept{
+	thread_local thread_slot slot;
+	return slot.counters;
+}
+
+void collect(stats_snapshot &snap, const thread_counters &from){
+	for(size_t i=0; i<stat_events; i++)
+		snap.events[i] += from.events[i].load(std::memory_order_relaxed);
+	size_t n = from.nencs.load(std::memory_order_acquire);
+	for(size_t i=0; i<n; i++){
+		const enc_counters &c = from.encs[i];
+		auto it = std::find_if(snap.encodings.begin(), snap.encodings.end(), [&](const encoding_stats &s){return s.encoding == c.enc;});
+		if(it == snap.encodings.end())
+			it = snap.encodings.insert(it, encoding_stats{c.enc, 0, 0, 0, 0, 0});
+		it->decoded_bytes += c.values[0].load(std::memory_order_relaxed);
+		it->decoded_chars += c.values[1].load(std::memory_order_relaxed);
+		it->encoded_bytes += c.values[2].load(std::memory_order_relaxed);
+		it->encoded_chars += c.values[3].load(std::memory_order_relaxed);
+		it->invalid += c.values[4].load(std::memory_order_relaxed);
+	}
+}
+
+}
+
+stats_snapshot adv::get_stats(){
+	stats_snapshot ret{};
+	stats_registry &reg = registry();
+	std::lock_guard<std::mutex> lock{reg.mtx};
+	collect(ret, reg.retired);
+	for(const thread_counters *c : reg.live)
+		collect(ret, *c);
+	return ret;
+}
+
+void adv::reset_stats() noexcept{
+	stats_registry &reg = registry();
+	std::lock_guard<std::mutex> lock{reg.mtx};
+	reg.retired.clear();
+	for(thread_counters *c : reg.live)
+		c->clear();
+}
+
+void adv::stats_add(stat_event e, std::uint64_t n) noexcept{
+	local().events[static_cast<size_t>(e)].fetch_add(n, std::memory_order_relaxed);
+}
+
+void adv::stats_decoded(std::type_index idx, std::uint64_t bytes, std::uint64_t chars) noexcept{
+	thread_counters &c = local();
+	c.add(idx, 0, bytes);
+	c.add(idx, 1, chars);
+}
+
+void adv::stats_encoded(std::type_index idx, std::uint64_t bytes, std::uint64_t chars) noexcept{
+	thread_counters &c = local();
+	c.add(idx, 2, bytes);
+	c.add(idx, 3, chars);
+}
+
+void adv::stats_invalid(std::type_index idx) noexcept{
+	local().add(idx, 4, 1);
+}
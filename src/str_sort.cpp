@@ -0,0 +1,148 @@
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <encmetric/str_sort.hpp>
+
+using namespace adv;
+
+namespace{
+constexpr size_t insertion_limit = 32;
+constexpr size_t parallel_limit = 1 << 16;
+
+void insertion_sort(radix_key *keys, size_t n, size_t base) noexcept{
+	for(size_t i=1; i<n; i++){
+		radix_key k = keys[i];
+		size_t j = i;
+		while(j > 0 && radix_less(k, keys[j-1], base)){
+			keys[j] = keys[j-1];
+			j--;
+		}
+		keys[j] = k;
+	}
+}
+
+/*
+    Bucket 0 contains strings shorter than depth+1 bytes
+*/
+inline uint bucket_of(const radix_key &k, size_t depth, uint off) noexcept{
+	if(k.siz <= depth)
+		return 0;
+	return static_cast<uint>((k.cache >> (56 - 8*off)) & 0xff) + 1;
+}
+}
+
+void adv::radix_pass(radix_key *keys, radix_key *tmp, radix_task task, std::vector<radix_task> &pending){
+	radix_key *k = keys + task.start;
+	radix_key *t = tmp + task.start;
+	size_t n = task.n;
+	size_t base = task.base;
+	uint off = task.off;
+	while(true){
+		if(n < insertion_limit){
+			insertion_sort(k, n, base);
+			return;
+		}
+		if(off == 8){
+			base += 8;
+			off = 0;
+			for(size_t i=0; i<n; i++)
+				k[i].cache = radix_load(k[i].data, k[i].siz, base);
+		}
+		size_t depth = base + off;
+		size_t count[257] = {};
+		for(size_t i=0; i<n; i++)
+			count[bucket_of(k[i], depth, off)]++;
+		if(count[0] == n)
+			return;//all strings are equal
+		bool single = false;
+		for(uint b=1; b<257; b++){
+			if(count[b] == n){
+				single = true;
+				break;
+			}
+		}
+		if(single){
+			//Common byte, no need to move keys
+			off++;
+			continue;
+		}
+		size_t pos[257];
+		size_t acc = 0;
+		for(uint b=0; b<257; b++){
+			pos[b] = acc;
+			acc += count[b];
+		}
+		for(size_t i=0; i<n; i++)
+			t[pos[bucket_of(k[i], depth, off)]++] = k[i];
+		std::memcpy(k, t, n * sizeof(radix_key));
+
+		size_t st = count[0];
+		for(uint b=1; b<257; b++){
+			if(count[b] > 1)
+				pending.push_back(radix_task{task.start + st, count[b], base, off+1});
+			st += count[b];
+		}
+		return;
+	}
+}
+
+void adv::radix_sort_keys(radix_key *keys, radix_key *tmp, radix_task task){
+	std::vector<radix_task> stack{task};
+	while(!stack.empty()){
+		radix_task t = stack.back();
+		stack.pop_back();
+		radix_pass(keys, tmp, t, stack);
+	}
+}
+
+void adv::radix_sort_keys(radix_key *keys, size_t n, uint nthreads){
+	if(n < 2)
+		return;
+	std::vector<radix_key> tmp(n);
+	if(nthreads == 0)
+		nthreads = std::thread::hardware_concurrency();
+	if(nthreads <= 1 || n < parallel_limit){
+		radix_sort_keys(keys, tmp.data(), radix_task{0, n, 0, 0});
+		return;
+	}
+	//Splits big tasks until there is enough work for all threads
+	size_t limit = n / (4 * nthreads);
+	std::vector<radix_task> pending{radix_task{0, n, 0, 0}};
+	std::vector<radix_task> ready;
+	while(!pending.empty()){
+		radix_task t = pending.back();
+		pending.pop_back();
+		if(t.n > limit)
+			radix_pass(keys, tmp.data(), t, pending);
+		else
+			ready.push_back(t);
+	}
+	std::sort(ready.begin(), ready.end(), [](const radix_task &a, const radix_task &b){return a.n > b.n;});
+
+	std::atomic<size_t> next{0};
+	auto worker = [&](){
+		size_t i;
+		while((i = next.fetch_add(1)) < ready.size())
+			radix_sort_keys(keys, tmp.data(), ready[i]);
+	};
+	std::vector<std::thread> pool;
+	for(uint i=1; i<nthreads; i++)
+		pool.emplace_back(worker);
+	worker();
+	for(std::thread &th : pool)
+		th.join();
+}
@@ -0,0 +1,589 @@
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <encmetric/text_codecs.hpp>
+#include <encmetric/byte_tools.hpp>
+
+using namespace adv;
+
+namespace{
+
+constexpr char upper_hex[] = "0123456789ABCDEF";
+constexpr char base32_digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
+constexpr std::uint8_t no_digit = 0xFF;
+
+/*
+    Values of the digits of Base16 and Base32, no_digit if the byte isn't a digit
+*/
+struct digit_tables{
+	std::uint8_t hex[256];
+	std::uint8_t b32[256];
+	/*
+	    Bit i is set if the character is kept by the percent_set with value i, bit 7 if it's
+	    allowed in an URI
+	*/
+	std::uint8_t pct[256];
+
+	constexpr digit_tables() : hex{}, b32{}, pct{}{
+		for(int i = 0; i < 256; i++){
+			hex[i] = no_digit;
+			b32[i] = no_digit;
+			pct[i] = 0;
+		}
+		for(int i = 0; i < 16; i++){
+			hex[static_cast<unsigned char>(upper_hex[i])] = i;
+			if(i >= 10)
+				hex[static_cast<unsigned char>(upper_hex[i]) + 0x20] = i;
+		}
+		for(int i = 0; i < 32; i++){
+			b32[static_cast<unsigned char>(base32_digits[i])] = i;
+			if(i < 26)
+				b32[static_cast<unsigned char>(base32_digits[i]) + 0x20] = i;
+		}
+		constexpr std::uint8_t all = 0x8F, path = 0x8E, query = 0x8C, uri = 0x88;
+		for(int i = 0; i < 256; i++){
+			if((i >= '0' && i <= '9') || (i >= 'A' && i <= 'Z') || (i >= 'a' && i <= 'z'))
+				pct[i] = all;
+		}
+		for(char c : {'-', '.', '_', '~'})
+			pct[static_cast<unsigned char>(c)] = all;
+		for(char c : {'!', '$', '&', '\'', '(', ')', '*', '+', ',', ';', '=', ':', '@', '/'})
+			pct[static_cast<unsigned char>(c)] = path;
+		pct[static_cast<unsigned char>('?')] = query;
+		for(char c : {'#', '[', ']'})
+			pct[static_cast<unsigned char>(c)] = uri;
+	}
+};
+
+constexpr digit_tables tables{};
+
+constexpr std::uint64_t high_bits = 0x8080808080808080ULL;
+
+inline std::uint8_t value(byte b) noexcept {return std::to_integer<std::uint8_t>(b);}
+
+/*
+    Mask of the characters kept by the percent_set with value bit
+*/
+constexpr percent_mask predefined_mask(uint bit) noexcept{
+	std::uint64_t b[4] = {0, 0, 0, 0};
+	for(uint i = 0; i < 256; i++){
+		if((tables.pct[i] >> bit) & 1)
+			b[i >> 6] |= std::uint64_t{1} << (i & 63);
+	}
+	return percent_mask{b[0], b[1], b[2], b[3]};
+}
+
+constexpr percent_mask predefined_masks[4] = {predefined_mask(0), predefined_mask(1), predefined_mask(2), predefined_mask(3)};
+
+/*
+    True if the 8 bytes of w are ASCII letters or digits
+*/
+inline bool all_alnum(std::uint64_t w) noexcept{
+	return (w & high_bits) == 0 && (swar_inrange(w, '0', '9' + 1) | swar_inrange(w, 'A', 'Z' + 1) | swar_inrange(w, 'a', 'z' + 1)) == high_bits;
+}
+
+/*
+    Puts the 4 bytes of x in the even bytes of the result
+*/
+inline std::uint64_t spread(std::uint64_t x) noexcept{
+	x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+	return (x | (x << 8)) & 0x00FF00FF00FF00FFULL;
+}
+
+/*
+    Inverse of spread
+*/
+inline std::uint64_t compact(std::uint64_t x) noexcept{
+	x = (x | (x >> 8)) & 0x0000FFFF0000FFFFULL;
+	return (x | (x >> 16)) & 0xFFFFFFFFULL;
+}
+
+/*
+    Base16 digits of 4 bytes
+*/
+inline std::uint64_t hex_word(std::uint64_t x) noexcept{
+	x = spread(x);
+	std::uint64_t n = ((x >> 4) & 0x000F000F000F000FULL) | ((x & 0x000F000F000F000FULL) << 8);
+	//digits greater than 9 are letters
+	return n + swar_broadcast('0') + (((n + swar_broadcast(6)) & swar_broadcast(0x10)) >> 4) * 7;
+}
+
+/*
+    Decodes 8 Base16 digits into 4 bytes, returns false if w contains something else
+*/
+inline bool unhex_word(std::uint64_t w, std::uint64_t &ret) noexcept{
+	if((w & high_bits) != 0 || (swar_inrange(w, '0', '9' + 1) | swar_inrange(w, 'A', 'G') | swar_inrange(w, 'a', 'g')) != high_bits)
+		return false;
+	std::uint64_t v = (w & swar_broadcast(0x0F)) + ((w >> 6) & swar_broadcast(1)) * 9;
+	ret = compact(((v & 0x00FF00FF00FF00FFULL) << 4) | ((v >> 8) & 0x00FF00FF00FF00FFULL));
+	return true;
+}
+
+/*
+    Decodes two Base16 digits, returns a value greater than 0xFF if they aren't valid
+*/
+inline uint unhex(byte a, byte b) noexcept{
+	uint h = tables.hex[value(a)], l = tables.hex[value(b)];
+	return (h == no_digit || l == no_digit) ? 0x100 : ((h << 4) | l);
+}
+
+/*
+    Base32 digits of the 5 bytes group g (shorter groups are filled with zeros)
+*/
+std::uint64_t b32_word(const byte *g, uint n) noexcept{
+	std::uint64_t v = 0;
+	for(uint i = 0; i < 5; i++)
+		v = (v << 8) | (i < n ? value(g[i]) : 0);
+	std::uint64_t d = 0;
+	for(uint i = 0; i < 8; i++)
+		d |= ((v >> (35 - 5 * i)) & 0x1F) << (8 * i);
+	//values from 26 are digits from '2'
+	return d + swar_broadcast('A') - (((d + swar_broadcast(0x80 - 26)) & high_bits) >> 7) * ('A' - '2' + 26);
+}
+
+/*
+    Digits of a Base32 group with n bytes
+*/
+constexpr uint b32_digits[6] = {0, 2, 4, 5, 7, 8};
+
+/*
+    Bytes of a Base32 group with n digits, 0 if invalid
+*/
+constexpr uint b32_bytes[9] = {0, 0, 1, 0, 2, 3, 0, 4, 5};
+
+/*
+    Decodes a Base32 group of n digits (at most 8) followed by padding characters up to 8, returns
+    the number of bytes written or throws if it isn't valid
+*/
+uint b32_group(const byte *g, uint n, uint pad, byte *to){
+	uint nd = 0;
+	std::uint64_t v = 0;
+	while(nd < n && g[nd] != byte{'='}){
+		std::uint8_t d = tables.b32[value(g[nd])];
+		if(d == no_digit)
+			throw encoding_error{"Invalid Base32 digit"};
+		v = (v << 5) | d;
+		nd++;
+	}
+	uint np = n - nd;
+	for(uint i = nd; i < n; i++){
+		if(g[i] != byte{'='})
+			throw encoding_error{"Invalid Base32 padding"};
+	}
+	uint nb = b32_bytes[nd];
+	if(nb == 0 || (np != 0 && nd + np != pad))
+		throw encoding_error{"Invalid Base32 group"};
+	v <<= 40 - 5 * nd;
+	for(uint i = 0; i < nb; i++)
+		to[i] = byte{static_cast<std::uint8_t>(v >> (32 - 8 * i))};
+	return nb;
+}
+
+/*
+    Decodes ngroups groups of 8 digits, the last one can be padded. ended is set if it's padded
+*/
+size_t b32_groups(const byte *from, size_t ngroups, byte *to, bool &ended){
+	size_t j = 0;
+	for(size_t k = 0; k < ngroups; k++, from += 8){
+		if(ended)
+			throw encoding_error{"Base32 data after padding"};
+		std::uint64_t w = swar_load_le(from);
+		if((w & high_bits) == 0){
+			std::uint64_t dig = swar_inrange(w, '2', '8');
+			if((swar_inrange(w, 'A', 'Z' + 1) | swar_inrange(w, 'a', 'z' + 1) | dig) == high_bits){
+				std::uint64_t m = (dig >> 7) * 0xFF;
+				std::uint64_t d = ((w - swar_broadcast('2' - 26)) & m) | (((w & swar_broadcast(0x1F)) - swar_broadcast(1)) & ~m);
+				std::uint64_t v = 0;
+				for(uint i = 0; i < 8; i++)
+					v = (v << 5) | ((d >> (8 * i)) & 0x1F);
+				for(uint i = 0; i < 5; i++)
+					to[j + i] = byte{static_cast<std::uint8_t>(v >> (32 - 8 * i))};
+				j += 5;
+				continue;
+			}
+		}
+		uint nb = b32_group(from, 8, 8, to + j);
+		j += nb;
+		ended = nb < 5;
+	}
+	return j;
+}
+
+/*
+    Decodes the %XX sequence or the single byte at from[i], increases i
+*/
+inline byte pct_char(const byte *from, size_t siz, size_t &i){
+	byte c = from[i];
+	if(c == byte{'%'}){
+		if(siz - i < 3)
+			throw encoding_error{"Incomplete percent-encoding sequence"};
+		uint v = unhex(from[i + 1], from[i + 2]);
+		if(v > 0xFF)
+			throw encoding_error{"Invalid percent-encoding sequence"};
+		i += 3;
+		return byte{static_cast<std::uint8_t>(v)};
+	}
+	if(tables.pct[value(c)] == 0)
+		throw encoding_error{"Invalid character in percent-encoded data"};
+	i++;
+	return c;
+}
+
+inline size_t pct_put(byte c, byte *to, const percent_mask &mask) noexcept{
+	if(mask.contains(c)){
+		to[0] = c;
+		return 1;
+	}
+	to[0] = byte{'%'};
+	to[1] = byte{static_cast<std::uint8_t>(upper_hex[value(c) >> 4])};
+	to[2] = byte{static_cast<std::uint8_t>(upper_hex[value(c) & 0xF])};
+	return 3;
+}
+
+}
+
+bool Base16::validChar(const byte *b, uint &l) noexcept{
+	l = 2;
+	return unhex(b[0], b[1]) <= 0xFF;
+}
+
+uint Base16::decode(byte *uni, const byte *by, size_t l){
+	if(l < 2)
+		throw buffer_small{2};
+	uint v = unhex(by[0], by[1]);
+	if(v > 0xFF)
+		throw encoding_error{"Invalid Base16 digit"};
+	*uni = byte{static_cast<std::uint8_t>(v)};
+	return 2;
+}
+
+uint Base16::encode(const byte &uni, byte *by, size_t l){
+	if(l < 2)
+		throw buffer_small{2};
+	by[0] = byte{static_cast<std::uint8_t>(upper_hex[value(uni) >> 4])};
+	by[1] = byte{static_cast<std::uint8_t>(upper_hex[value(uni) & 0xF])};
+	return 2;
+}
+
+size_t adv::base16_encode(const byte *from, byte *to, size_t siz) noexcept{
+	size_t i = 0;
+	for(; i + 8 <= siz; i += 8){
+		std::uint64_t w = swar_load_le(from + i);
+		swar_store_le(to + 2 * i, hex_word(w & 0xFFFFFFFFULL));
+		swar_store_le(to + 2 * i + 8, hex_word(w >> 32));
+	}
+	for(; i < siz; i++)
+		Base16::encode(from[i], to + 2 * i, 2);
+	return 2 * siz;
+}
+
+size_t adv::base16_decode(const byte *from, byte *to, size_t siz){
+	if(siz % 2 != 0)
+		throw encoding_error{"Odd number of Base16 digits"};
+	size_t i = 0;
+	for(; i + 16 <= siz; i += 16){
+		std::uint64_t lo, hi;
+		if(!unhex_word(swar_load_le(from + i), lo) || !unhex_word(swar_load_le(from + i + 8), hi))
+			break;
+		swar_store_le(to + i / 2, lo | (hi << 32));
+	}
+	for(; i < siz; i += 2)
+		Base16::decode(to + i / 2, from + i, 2);
+	return siz / 2;
+}
+
+size_t base16_decoder::update(const byte *from, size_t siz, byte *to){
+	if(siz == 0)
+		return 0;
+	size_t j = 0;
+	if(has){
+		byte g[2] = {pend, from[0]};
+		Base16::decode(to, g, 2);
+		from++;
+		siz--;
+		j++;
+		has = false;
+	}
+	if(siz % 2 != 0){
+		pend = from[siz - 1];
+		if(tables.hex[value(pend)] == no_digit)
+			throw encoding_error{"Invalid Base16 digit"};
+		has = true;
+		siz--;
+	}
+	return j + base16_decode(from, to + j, siz);
+}
+
+void base16_decoder::finish(){
+	if(has)
+		throw encoding_error{"Odd number of Base16 digits"};
+}
+
+bool Base32::validChar(const byte *b, uint &l) noexcept{
+	l = 8;
+	byte tmp[5];
+	try{
+		b32_group(b, 8, 8, tmp);
+		return true;
+	}
+	catch(encoding_error &){
+		return false;
+	}
+}
+
+uint Base32::decode(five_byte *uni, const byte *by, size_t l){
+	if(l < 8)
+		throw buffer_small{8};
+	uni->nbyte = b32_group(by, 8, 8, uni->bytes);
+	return 8;
+}
+
+uint Base32::encode(const five_byte &uni, byte *by, size_t l){
+	if(l < 8)
+		throw buffer_small{8};
+	if(uni.nbyte == 0 || uni.nbyte > 5)
+		throw encoding_error{"Invalid Base32 group"};
+	swar_store_le(by, b32_word(uni.bytes, uni.nbyte));
+	for(uint i = b32_digits[uni.nbyte]; i < 8; i++)
+		by[i] = byte{'='};
+	return 8;
+}
+
+size_t adv::base32_encoded_size(size_t siz, bool padding) noexcept{
+	return siz / 5 * 8 + (siz % 5 == 0 ? 0 : (padding ? 8 : b32_digits[siz % 5]));
+}
+
+size_t adv::base32_decoded_size(const byte *from, size_t siz) noexcept{
+	while(siz > 0 && from[siz - 1] == byte{'='})
+		siz--;
+	return siz / 8 * 5 + b32_bytes[siz % 8];
+}
+
+size_t adv::base32_encode(const byte *from, byte *to, size_t siz, bool padding) noexcept{
+	size_t j = 0;
+	for(; siz >= 5; siz -= 5, from += 5, j += 8)
+		swar_store_le(to + j, b32_word(from, 5));
+	if(siz > 0){
+		byte g[8];
+		swar_store_le(g, b32_word(from, static_cast<uint>(siz)));
+		uint nd = padding ? 8 : b32_digits[siz];
+		for(uint i = 0; i < nd; i++)
+			to[j + i] = i < b32_digits[siz] ? g[i] : byte{'='};
+		j += nd;
+	}
+	return j;
+}
+
+size_t adv::base32_decode(const byte *from, byte *to, size_t siz){
+	bool ended = false;
+	size_t j = b32_groups(from, siz / 8, to, ended);
+	if(siz % 8 != 0){
+		if(ended)
+			throw encoding_error{"Base32 data after padding"};
+		j += b32_group(from + siz / 8 * 8, static_cast<uint>(siz % 8), 0, to + j);
+	}
+	return j;
+}
+
+size_t base32_encoder::update(const byte *from, size_t siz, byte *to) noexcept{
+	size_t j = 0;
+	if(npend > 0){
+		while(npend < 5 && siz > 0){
+			if(npend == 4){
+				byte g[5] = {pend[0], pend[1], pend[2], pend[3], from[0]};
+				swar_store_le(to, b32_word(g, 5));
+				j = 8;
+				npend = 0;
+				from++;
+				siz--;
+				break;
+			}
+			pend[npend++] = *from++;
+			siz--;
+		}
+	}
+	size_t full = siz / 5 * 5;
+	j += base32_encode(from, to + j, full, padding);
+	for(size_t i = full; i < siz; i++)
+		pend[npend++] = from[i];
+	return j;
+}
+
+size_t base32_encoder::finish(byte *to) noexcept{
+	size_t ret = base32_encode(pend, to, npend, padding);
+	npend = 0;
+	return ret;
+}
+
+size_t base32_decoder::update(const byte *from, size_t siz, byte *to){
+	size_t j = 0;
+	if(npend > 0){
+		while(npend < 8 && siz > 0){
+			pend[npend++] = *from++;
+			siz--;
+		}
+		if(npend < 8)
+			return 0;
+		j = b32_groups(pend, 1, to, ended);
+		npend = 0;
+	}
+	j += b32_groups(from, siz / 8, to + j, ended);
+	for(size_t i = siz / 8 * 8; i < siz; i++)
+		pend[npend++] = from[i];
+	return j;
+}
+
+size_t base32_decoder::finish(byte *to){
+	size_t ret = 0;
+	if(npend > 0){
+		if(ended)
+			throw encoding_error{"Base32 data after padding"};
+		ret = b32_group(pend, npend, 0, to);
+	}
+	npend = 0;
+	ended = false;
+	return ret;
+}
+
+percent_mask::percent_mask(percent_set set) noexcept : percent_mask{predefined_masks[static_cast<uint>(set)]} {}
+
+bool adv::percent_keep(byte b, percent_set set) noexcept{
+	return predefined_masks[static_cast<uint>(set)].contains(b);
+}
+
+size_t adv::percent_encoded_size(const byte *from, size_t siz, const percent_mask &mask) noexcept{
+	size_t ret = siz;
+	for(size_t i = 0; i < siz; i++){
+		if(!mask.contains(from[i]))
+			ret += 2;
+	}
+	return ret;
+}
+
+size_t adv::percent_decoded_size(const byte *from, size_t siz) noexcept{
+	size_t n = 0, i = 0;
+	for(; i + 8 <= siz; i += 8)
+		n += swar_count(swar_eqmask(swar_load(from + i), '%'));
+	for(; i < siz; i++){
+		if(from[i] == byte{'%'})
+			n++;
+	}
+	return siz - 2 * n;
+}
+
+size_t adv::percent_encode(const byte *from, byte *to, size_t siz, const percent_mask &mask) noexcept{
+	//words of letters and digits are copied only if the mask keeps all of them
+	bool alnum = mask.keeps_alnum();
+	size_t i = 0, j = 0;
+	while(i < siz){
+		if(alnum && siz - i >= 8){
+			std::uint64_t w = swar_load(from + i);
+			if(all_alnum(w)){
+				swar_store(to + j, w);
+				i += 8;
+				j += 8;
+				continue;
+			}
+			for(size_t e = i + 8; i < e; i++)
+				j += pct_put(from[i], to + j, mask);
+		}
+		else
+			j += pct_put(from[i++], to + j, mask);
+	}
+	return j;
+}
+
+size_t adv::percent_decode(const byte *from, byte *to, size_t siz){
+	size_t i = 0, j = 0;
+	while(i < siz){
+		if(siz - i >= 8){
+			std::uint64_t w = swar_load(from + i);
+			if(all_alnum(w)){
+				swar_store(to + j, w);
+				i += 8;
+				j += 8;
+				continue;
+			}
+			for(size_t e = i + 8; i < e && i < siz;)
+				to[j++] = pct_char(from, siz, i);
+		}
+		else
+			to[j++] = pct_char(from, siz, i);
+	}
+	return j;
+}
+
+bool percent_codec::validChar(const byte *b, uint &l) noexcept{
+	if(b[0] == byte{'%'}){
+		l = 3;
+		return unhex(b[1], b[2]) <= 0xFF;
+	}
+	l = 1;
+	return tables.pct[value(b[0])] != 0;
+}
+
+uint percent_codec::decode(byte *uni, const byte *by, size_t l){
+	if(l < 1)
+		throw buffer_small{1};
+	if(by[0] == byte{'%'} && l < 3)
+		throw buffer_small{3};
+	size_t i = 0;
+	*uni = pct_char(by, l, i);
+	return static_cast<uint>(i);
+}
+
+uint percent_codec::encode(const byte &uni, byte *by, size_t l, percent_set set){
+	const percent_mask &mask = predefined_masks[static_cast<uint>(set)];
+	uint n = mask.contains(uni) ? 1 : 3;
+	if(l < n)
+		throw buffer_small{n};
+	pct_put(uni, by, mask);
+	return n;
+}
+
+size_t percent_decoder::update(const byte *from, size_t siz, byte *to){
+	size_t j = 0;
+	if(npend > 0){
+		byte g[3] = {pend[0], pend[1]};
+		while(npend < 3 && siz > 0){
+			g[npend++] = *from++;
+			siz--;
+		}
+		if(npend < 3){
+			pend[1] = g[1];
+			return 0;
+		}
+		size_t i = 0;
+		to[j++] = pct_char(g, 3, i);
+		npend = 0;
+	}
+	//a trailing incomplete sequence is kept
+	size_t keep = 0;
+	if(siz >= 1 && from[siz - 1] == byte{'%'})
+		keep = 1;
+	else if(siz >= 2 && from[siz - 2] == byte{'%'})
+		keep = 2;
+	j += percent_decode(from, to + j, siz - keep);
+	for(size_t i = siz - keep; i < siz; i++)
+		pend[npend++] = from[i];
+	return j;
+}
+
+void percent_decoder::finish(){
+	if(npend > 0)
+		throw encoding_error{"Incomplete percent-encoding sequence"};
+}
@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+#
+#    This file is part of Encmetric.
+#    Copyright (C) 2021 Paolo De Donato.
+#
+#    Encmetric is free software: you can redistribute it and/or modify
+#    it under the terms of the GNU Lesser General Public License as published by
+#    the Free Software Foundation, either version 3 of the License, or
+#    (at your option) any later version.
+#
+#    Encmetric is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU Lesser General Public License for more details.
+#
+#    You should have received a copy of the GNU Lesser General Public License
+#    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+#
+# Generates the case mapping tables used by case_mapping.cpp from the
+# Unicode database shipped with Python:
+#
+#     python3 tools/gen_case.py > case_data.hpp
+#
+# Tables:
+#  - case_map: simple lowercase, uppercase and case folding of every character with a
+#    mapping, sorted by character. special is the index of the full mappings increased by one
+#    (0 if the full mappings are the simple ones)
+#  - case_special: full mappings longer than one character
+#  - cased_ranges, case_ignorable_ranges: Cased and Case_Ignorable properties, used by the
+#    Final_Sigma condition
+# The language sensitive mappings (Turkish, Lithuanian) are not included.
+
+import sys
+import unicodedata as ud
+
+# Word_Break MidLetter, MidNumLet and Single_Quote
+WB_IGNORABLE = [0x27, 0x2E, 0x3A, 0xB7, 0x387, 0x55F, 0x5F4, 0x2018, 0x2019, 0x2024, 0x2027,
+    0xFE13, 0xFE52, 0xFE55, 0xFF07, 0xFF0E, 0xFF1A]
+
+def is_ignorable(c):
+    return ud.category(chr(c)) in ('Mn', 'Me', 'Cf', 'Lm', 'Sk') or c in WB_IGNORABLE
+
+def is_cased(c):
+    ch = chr(c)
+    return ch.islower() or ch.isupper() or ud.category(ch) == 'Lt'
+
+def ranges(f):
+    ret = []
+    start = None
+    for c in range(0x110001):
+        v = c < 0x110000 and not (0xD800 <= c < 0xE000) and f(c)
+        if v and start is None:
+            start = c
+        elif not v and start is not None:
+            ret.append((start, c - 1))
+            start = None
+    return ret
+
+def single(s, default):
+    return ord(s) if len(s) == 1 else default
+
+def main():
+    w = sys.stdout.write
+    entries = []
+    special = []
+    maxlen = 0
+    for c in range(0x110000):
+        ch = chr(c)
+        if ud.category(ch) == 'Cs':
+            continue
+        lo, up, fo = ch.lower(), ch.upper(), ch.casefold()
+        if lo == ch and up == ch and fo == ch:
+            continue
+        maxlen = max(maxlen, len(lo), len(up), len(fo))
+        # simple mappings are the full ones when they're a single character, otherwise they're
+        # derived as in CaseFolding.txt (status S) and UnicodeData.txt
+        slo = single(lo, c)
+        sup = single(up, single(ch.title(), c))
+        sfo = single(fo, slo)
+        sp = 0
+        if len(lo) > 1 or len(up) > 1 or len(fo) > 1:
+            special.append((lo, up, fo))
+            sp = len(special)
+        entries.append((c, slo, sup, sfo, sp))
+
+    w('#pragma once\n')
+    w('/*\n    Generated by tools/gen_case.py from the Unicode Character Database %s, do not edit\n*/\n' % ud.unidata_version)
+    w('namespace adv{\n\n')
+    w('inline constexpr size_t case_max_mapping = %d;\n\n' % maxlen)
+    w('static const case_map_entry case_map[%d] = {\n' % len(entries))
+    for e in entries:
+        w('\t{0x%04X, 0x%04X, 0x%04X, 0x%04X, %d},\n' % e)
+    w('};\n\n')
+
+    def seq(s):
+        vals = ['0x%04X' % ord(x) for x in s] + ['0'] * (maxlen - len(s))
+        return '%d, {%s}' % (len(s), ', '.join(vals))
+
+    w('static const case_special_entry case_special[%d] = {\n' % len(special))
+    for (lo, up, fo) in special:
+        w('\t{%s, %s, %s},\n' % (seq(lo), seq(up), seq(fo)))
+    w('};\n\n')
+
+    for (name, f) in (('cased_ranges', is_cased), ('case_ignorable_ranges', is_ignorable)):
+        r = ranges(f)
+        w('static const case_range %s[%d] = {\n' % (name, len(r)))
+        for i in range(0, len(r), 6):
+            w('\t' + ', '.join('{0x%04X, 0x%04X}' % x for x in r[i:i + 6]) + ',\n')
+        w('};\n\n')
+    w('}\n')
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+#
+#    This file is part of Encmetric.
+#    Copyright (C) 2021 Paolo De Donato.
+#
+#    Encmetric is free software: you can redistribute it and/or modify
+#    it under the terms of the GNU Lesser General Public License as published by
+#    the Free Software Foundation, either version 3 of the License, or
+#    (at your option) any later version.
+#
+#    Encmetric is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU Lesser General Public License for more details.
+#
+#    You should have received a copy of the GNU Lesser General Public License
+#    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+#
+# Generates the mapping tables of the multibyte CJK encodings used by cjk_enc.cpp from the
+# codecs shipped with Python:
+#
+#     python3 tools/gen_cjk.py > cjk_data.hpp
+#
+# Tables:
+#  - <name>_rows/<name>_codes: two byte characters of a plane. rows contains, for every lead byte
+#    of the plane, the number of its row in codes increased by one (0 if the lead byte isn't used),
+#    every row of codes contains the characters of all the trail bytes of the plane (0 if undefined)
+#  - gbk_excluded: bitset of the GB18030 two byte characters not included in GBK, indexed like
+#    gb18030_codes
+#  - gb18030_ranges: four byte characters of the BMP, as pairs (first linear index, first character)
+#    of runs where both the linear index of the four byte sequence and the character are consecutive
+# The make-up sequences of EUC-KR are not included, their first byte pair (the Hangul filler
+# A4D4) is decoded as U+3164 like the other characters of KS X 1001.
+
+import sys
+
+# name, codec, prefix, first lead, last lead, first trail, last trail
+PLANES = [
+    ('sjis', 'shift_jis', b'', 0x81, 0xFC, 0x40, 0xFC),
+    ('jisx0208', 'euc_jp', b'', 0xA1, 0xFE, 0xA1, 0xFE),
+    ('jisx0212', 'euc_jp', b'\x8f', 0xA1, 0xFE, 0xA1, 0xFE),
+    ('euckr', 'euc_kr', b'', 0xA1, 0xFE, 0xA1, 0xFE),
+    ('big5', 'big5', b'', 0xA1, 0xFE, 0x40, 0xFE),
+    ('gb18030', 'gb18030', b'', 0x81, 0xFE, 0x40, 0xFE),
+]
+
+# characters that the Python codecs don't decode as a single character
+EXTRA = {('euc_kr', b'\xa4\xd4'): 0x3164}
+
+def decode(codec, seq):
+    if (codec, seq) in EXTRA:
+        return EXTRA[(codec, seq)]
+    try:
+        s = seq.decode(codec)
+    except UnicodeDecodeError:
+        return 0
+    if len(s) != 1 or ord(s) > 0xFFFF:
+        return 0
+    return ord(s)
+
+def plane(codec, prefix, lf, ll, tf, tl):
+    rows = []
+    codes = []
+    for a in range(lf, ll + 1):
+        row = [decode(codec, prefix + bytes([a, b])) for b in range(tf, tl + 1)]
+        if any(row):
+            codes.append(row)
+            rows.append(len(codes))
+        else:
+            rows.append(0)
+    return rows, codes
+
+def gb_linear(i):
+    b4 = i % 10
+    i //= 10
+    b3 = i % 126
+    i //= 126
+    b2 = i % 10
+    b1 = i // 10
+    return bytes([0x81 + b1, 0x30 + b2, 0x81 + b3, 0x30 + b4])
+
+def main():
+    w = sys.stdout.write
+    w('#pragma once\n')
+    w('/*\n    Generated by tools/gen_cjk.py, do not edit\n*/\n')
+    w('namespace adv{\n\n')
+
+    def array(typ, name, data, per_line=16):
+        w('static const %s %s[%d] = {\n' % (typ, name, len(data)))
+        for i in range(0, len(data), per_line):
+            w('\t' + ', '.join(data[i:i + per_line]) + ',\n')
+        w('};\n\n')
+
+    gb = None
+    for (name, codec, prefix, lf, ll, tf, tl) in PLANES:
+        rows, codes = plane(codec, prefix, lf, ll, tf, tl)
+        if name == 'gb18030':
+            gb = codes
+            gbrows = rows
+        array('std::uint16_t', name + '_rows', [str(x) for x in rows], 24)
+        array('std::uint16_t', name + '_codes', ['0x%04X' % x for row in codes for x in row], 16)
+        w('static const cjk_plane %s_plane = {0x%02X, 0x%02X, 0x%02X, 0x%02X, %s_rows, %s_codes};\n\n' % (name, lf, ll, tf, tl, name, name))
+
+    # GBK is a subset of the two byte characters of GB18030
+    bits = [0] * ((len(gb) * len(gb[0]) + 31) // 32)
+    k = 0
+    for ri, a in enumerate(range(0x81, 0xFF)):
+        if gbrows[ri] == 0:
+            continue
+        for j, b in enumerate(range(0x40, 0xFF)):
+            c = gb[gbrows[ri] - 1][j]
+            if c != 0 and decode('gbk', bytes([a, b])) != c:
+                idx = (gbrows[ri] - 1) * len(gb[0]) + j
+                bits[idx // 32] |= 1 << (idx % 32)
+    array('std::uint32_t', 'gbk_excluded', ['0x%08X' % x for x in bits], 8)
+
+    ranges = []
+    prev = None
+    for i in range(39420):
+        c = decode('gb18030', gb_linear(i))
+        if c == 0:
+            raise SystemExit('Missing four byte character %d' % i)
+        if prev is None or c != prev + 1:
+            ranges.append((i, c))
+        prev = c
+    w('static const gb18030_range gb18030_ranges[%d] = {\n' % len(ranges))
+    for i in range(0, len(ranges), 6):
+        w('\t' + ', '.join('{%d, 0x%04X}' % r for r in ranges[i:i + 6]) + ',\n')
+    w('};\n\n')
+    w('}\n')
+
+if __name__ == '__main__':
+    main()
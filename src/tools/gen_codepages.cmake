@@ -0,0 +1,88 @@
+#
+#    This file is part of Encmetric.
+#    Copyright (C) 2021 Paolo De Donato.
+#
+#    Encmetric is free software: you can redistribute it and/or modify
+#    it under the terms of the GNU Lesser General Public License as published by
+#    the Free Software Foundation, either version 3 of the License, or
+#    (at your option) any later version.
+#
+#    Encmetric is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU Lesser General Public License for more details.
+#
+#    You should have received a copy of the GNU Lesser General Public License
+#    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+#
+# Generates the single byte codepages from the mapping files in MAPPINGS (same format of the
+# mapping tables of the Unicode Consortium), it's executed during the build:
+#
+#     cmake -DMAPPINGS=<mappings directory> -DOUTPUT=<header> -P tools/gen_codepages.cmake
+#
+# Every codepage is an ASCII_extension with a constexpr table of the characters from 80 to FF.
+# Bytes from 00 to 7F must be mapped to ASCII. Undefined bytes are stored as 0 (invalid byte).
+
+# class name and mapping file of every codepage
+set(codepages
+	ISO_8859_2 8859-2 ISO_8859_3 8859-3 ISO_8859_4 8859-4 ISO_8859_5 8859-5 ISO_8859_6 8859-6
+	ISO_8859_7 8859-7 ISO_8859_8 8859-8 ISO_8859_9 8859-9 ISO_8859_10 8859-10 ISO_8859_11 8859-11
+	ISO_8859_13 8859-13 ISO_8859_14 8859-14 ISO_8859_15 8859-15 ISO_8859_16 8859-16
+	Win_874 CP874 Win_1250 CP1250 Win_1251 CP1251 Win_1252 CP1252 Win_1253 CP1253 Win_1254 CP1254
+	Win_1255 CP1255 Win_1256 CP1256 Win_1257 CP1257 Win_1258 CP1258
+	KOI8_R KOI8-R KOI8_U KOI8-U IBM_437 CP437 IBM_850 CP850)
+
+set(out "#pragma once\n/*\n    Generated by tools/gen_codepages.cmake, do not edit\n*/\n")
+string(APPEND out "#include <encmetric/ascii_extensions.hpp>\n\nnamespace adv{\n")
+
+list(LENGTH codepages n)
+math(EXPR last "${n} - 1")
+foreach(i RANGE 0 ${last} 2)
+	math(EXPR j "${i} + 1")
+	list(GET codepages ${i} name)
+	list(GET codepages ${j} file)
+	set(path "${MAPPINGS}/${file}.TXT")
+	if(NOT EXISTS "${path}")
+		message(FATAL_ERROR "Missing mapping file ${path}")
+	endif()
+
+	# table[k] is the character of byte k + 0x80
+	set(table "")
+	foreach(k RANGE 0 127)
+		list(APPEND table 0)
+	endforeach()
+
+	file(STRINGS "${path}" lines REGEX "^0x[0-9A-Fa-f][0-9A-Fa-f]\t0x[0-9A-Fa-f]+")
+	foreach(line IN LISTS lines)
+		string(REGEX MATCH "^(0x[0-9A-Fa-f]+)\t(0x[0-9A-Fa-f]+)" unused "${line}")
+		math(EXPR b "${CMAKE_MATCH_1}")
+		math(EXPR v "${CMAKE_MATCH_2}")
+		if(b LESS 128)
+			if(NOT v EQUAL b)
+				message(FATAL_ERROR "${path}: byte ${CMAKE_MATCH_1} is not ASCII")
+			endif()
+		else()
+			math(EXPR k "${b} - 128")
+			list(REMOVE_AT table ${k})
+			list(INSERT table ${k} ${CMAKE_MATCH_2})
+		endif()
+	endforeach()
+
+	string(APPEND out "\n/*\n    Generated from ${file}.TXT\n*/\n")
+	string(APPEND out "class ${name} : public ASCII_extension<${name}>{\n\tpublic:\n")
+	string(APPEND out "\t\tstatic constexpr unsigned int table[0x80] = {")
+	foreach(k RANGE 0 127 16)
+		math(EXPR e "${k} + 15")
+		set(row "")
+		foreach(h RANGE ${k} ${e})
+			list(GET table ${h} v)
+			list(APPEND row ${v})
+		endforeach()
+		list(JOIN row ", " row)
+		string(APPEND out "\n\t\t\t${row},")
+	endforeach()
+	string(APPEND out "\n\t\t};\n};\n")
+endforeach()
+
+string(APPEND out "\n}\n")
+file(WRITE "${OUTPUT}" "${out}")
@@ -0,0 +1,153 @@
+#!/usr/bin/env python3
+#
+#    This file is part of Encmetric.
+#    Copyright (C) 2021 Paolo De Donato.
+#
+#    Encmetric is free software: you can redistribute it and/or modify
+#    it under the terms of the GNU Lesser General Public License as published by
+#    the Free Software Foundation, either version 3 of the License, or
+#    (at your option) any later version.
+#
+#    Encmetric is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU Lesser General Public License for more details.
+#
+#    You should have received a copy of the GNU Lesser General Public License
+#    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+#
+# Generates the Unicode normalization tables used by normalization.cpp from the
+# Unicode database shipped with Python:
+#
+#     python3 tools/gen_normalization.py > normalization_data.hpp
+#
+# Tables:
+#  - norm_stage1/norm_stage2/norm_props: two stage table of character properties,
+#    every property is the combining class (bits 0-7) with the quick check flags
+#  - norm_decomp/norm_pool: full canonical and compatibility decompositions, sorted by character
+#  - norm_comp: primary composites, sorted by (first, second)
+# Hangul syllables are handled algorithmically and don't appear in the tables.
+
+import sys
+import unicodedata as ud
+
+BLOCK = 128
+SBASE, SCOUNT = 0xAC00, 11172
+
+NFD_NO = 1 << 8
+NFKD_NO = 1 << 9
+NFC_NO = 1 << 10
+NFC_MAYBE = 1 << 11
+NFKC_NO = 1 << 12
+NFKC_MAYBE = 1 << 13
+
+def is_hangul(c):
+    return SBASE <= c < SBASE + SCOUNT
+
+def main():
+    out = sys.stdout
+    chars = [chr(c) for c in range(0x110000)]
+
+    # primary composites: canonical decomposition mapping of length 2 that recompose
+    comps = []
+    for c in range(0x110000):
+        if is_hangul(c):
+            continue
+        m = ud.decomposition(chars[c])
+        if not m or m.startswith('<'):
+            continue
+        parts = [int(x, 16) for x in m.split()]
+        if len(parts) == 2 and ud.normalize('NFC', chr(parts[0]) + chr(parts[1])) == chars[c]:
+            comps.append((parts[0], parts[1], c))
+    comps.sort()
+    second = {b for (_, b, _) in comps}
+    # Hangul vowels and trailing consonants compose with the previous jamo
+    second.update(range(0x1161, 0x1176))
+    second.update(range(0x11A8, 0x11C3))
+
+    props = []
+    for c in range(0x110000):
+        ch = chars[c]
+        p = ud.combining(ch)
+        if ud.normalize('NFD', ch) != ch:
+            p |= NFD_NO
+        if ud.normalize('NFKD', ch) != ch:
+            p |= NFKD_NO
+        if ud.normalize('NFC', ch) != ch:
+            p |= NFC_NO
+        elif c in second:
+            p |= NFC_MAYBE
+        if ud.normalize('NFKC', ch) != ch:
+            p |= NFKC_NO
+        elif c in second:
+            p |= NFKC_MAYBE
+        props.append(p)
+
+    values = sorted(set(props))
+    if len(values) > 256:
+        raise SystemExit('Too many distinct properties')
+    vindex = {v: i for i, v in enumerate(values)}
+
+    blocks = []
+    bindex = {}
+    stage1 = []
+    for b in range(0, 0x110000, BLOCK):
+        blk = tuple(vindex[p] for p in props[b:b + BLOCK])
+        if blk not in bindex:
+            bindex[blk] = len(blocks)
+            blocks.append(blk)
+        stage1.append(bindex[blk])
+
+    pool = []
+    poolindex = {}
+    def store(seq):
+        key = tuple(seq)
+        if key not in poolindex:
+            poolindex[key] = len(pool)
+            pool.extend(seq)
+        return poolindex[key]
+
+    decomp = []
+    maxlen = 0
+    for c in range(0x110000):
+        if is_hangul(c):
+            continue
+        ch = chars[c]
+        canon = ud.normalize('NFD', ch)
+        compat = ud.normalize('NFKD', ch)
+        if compat == ch:
+            continue
+        maxlen = max(maxlen, len(compat))
+        co, cl = (0, 0) if canon == ch else (store([ord(x) for x in canon]), len(canon))
+        ko = store([ord(x) for x in compat])
+        decomp.append((c, co, cl, ko, len(compat)))
+
+    w = out.write
+    w('#pragma once\n')
+    w('/*\n    Generated by tools/gen_normalization.py from the Unicode Character Database %s, do not edit\n*/\n' % ud.unidata_version)
+    w('namespace adv{\n\n')
+    w('inline constexpr unsigned int norm_block = %d;\n' % BLOCK)
+    w('inline constexpr size_t norm_max_decomposition = %d;\n\n' % maxlen)
+
+    def array(typ, name, data, per_line=16):
+        w('static const %s %s[%d] = {\n' % (typ, name, len(data)))
+        for i in range(0, len(data), per_line):
+            w('\t' + ', '.join(data[i:i + per_line]) + ',\n')
+        w('};\n\n')
+
+    array('std::uint16_t', 'norm_props', ['0x%04X' % v for v in values])
+    array('std::uint8_t' if len(blocks) <= 256 else 'std::uint16_t', 'norm_stage1', [str(x) for x in stage1], 24)
+    array('std::uint8_t', 'norm_stage2', [str(x) for blk in blocks for x in blk], 32)
+    array('std::uint32_t', 'norm_pool', ['0x%04X' % x for x in pool], 12)
+    w('static const norm_decomp_entry norm_decomp[%d] = {\n' % len(decomp))
+    for (c, co, cl, ko, kl) in decomp:
+        w('\t{0x%04X, %d, %d, %d, %d},\n' % (c, co, cl, ko, kl))
+    w('};\n\n')
+    w('static const norm_comp_entry norm_comp[%d] = {\n' % len(comps))
+    for (a, b, c) in comps:
+        w('\t{0x%04X, 0x%04X, 0x%04X},\n' % (a, b, c))
+    w('};\n\n')
+    w('}\n')
+
+if __name__ == '__main__':
+    main()
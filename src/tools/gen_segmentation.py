@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+#
+#    This file is part of Encmetric.
+#    Copyright (C) 2021 Paolo De Donato.
+#
+#    Encmetric is free software: you can redistribute it and/or modify
+#    it under the terms of the GNU Lesser General Public License as published by
+#    the Free Software Foundation, either version 3 of the License, or
+#    (at your option) any later version.
+#
+#    Encmetric is distributed in the hope that it will be useful,
+#    but WITHOUT ANY WARRANTY; without even the implied warranty of
+#    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#    GNU Lesser General Public License for more details.
+#
+#    You should have received a copy of the GNU Lesser General Public License
+#    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+#
+# Generates the text segmentation tables used by segmentation.cpp from the files
+# GraphemeBreakProperty.txt, WordBreakProperty.txt (auxiliary directory of the UCD) and
+# emoji-data.txt, all contained in the directory passed as argument:
+#
+#     python3 tools/gen_segmentation.py <UCD directory> > segmentation_data.hpp
+#
+# Tables:
+#  - seg_stage1/seg_stage2/seg_props: two stage table of character properties, every property is
+#    the Grapheme_Cluster_Break value (bits 0-3), Extended_Pictographic (bit 4) and the Word_Break
+#    value (bits 8-12). Values are the ones of grapheme_prop and word_prop in segmentation.hpp
+
+import os
+import re
+import sys
+
+BLOCK = 128
+
+GCB = ['Other', 'CR', 'LF', 'Control', 'Extend', 'ZWJ', 'Regional_Indicator', 'Prepend',
+    'SpacingMark', 'L', 'V', 'T', 'LV', 'LVT']
+WB = ['Other', 'CR', 'LF', 'Newline', 'Extend', 'ZWJ', 'Regional_Indicator', 'Format', 'Katakana',
+    'Hebrew_Letter', 'ALetter', 'Single_Quote', 'Double_Quote', 'MidNumLet', 'MidLetter', 'MidNum',
+    'Numeric', 'ExtendNumLet', 'WSegSpace']
+
+LINE = re.compile(r'^([0-9A-Fa-f]+)(?:\.\.([0-9A-Fa-f]+))?\s*;\s*([A-Za-z_]+)')
+
+def load(path, values, target, shift, name=None):
+    with open(path, encoding='utf-8') as f:
+        for line in f:
+            m = LINE.match(line)
+            if not m:
+                continue
+            first = int(m.group(1), 16)
+            last = int(m.group(2), 16) if m.group(2) else first
+            prop = m.group(3)
+            if name is not None:
+                if prop != name:
+                    continue
+                val = 1
+            else:
+                val = values.index(prop)
+            for c in range(first, last + 1):
+                target[c] |= val << shift
+
+def main():
+    ucd = sys.argv[1]
+    props = [0] * 0x110000
+    load(os.path.join(ucd, 'GraphemeBreakProperty.txt'), GCB, props, 0)
+    load(os.path.join(ucd, 'emoji-data.txt'), None, props, 4, 'Extended_Pictographic')
+    load(os.path.join(ucd, 'WordBreakProperty.txt'), WB, props, 8)
+
+    values = sorted(set(props))
+    if len(values) > 256:
+        raise SystemExit('Too many distinct properties')
+    vindex = {v: i for i, v in enumerate(values)}
+
+    blocks = []
+    bindex = {}
+    stage1 = []
+    for b in range(0, 0x110000, BLOCK):
+        blk = tuple(vindex[p] for p in props[b:b + BLOCK])
+        if blk not in bindex:
+            bindex[blk] = len(blocks)
+            blocks.append(blk)
+        stage1.append(bindex[blk])
+
+    w = sys.stdout.write
+    w('#pragma once\n')
+    w('/*\n    Generated by tools/gen_segmentation.py, do not edit\n*/\n')
+    w('namespace adv{\n\n')
+    w('inline constexpr unsigned int seg_block = %d;\n\n' % BLOCK)
+
+    def array(typ, name, data, per_line=16):
+        w('static const %s %s[%d] = {\n' % (typ, name, len(data)))
+        for i in range(0, len(data), per_line):
+            w('\t' + ', '.join(data[i:i + per_line]) + ',\n')
+        w('};\n\n')
+
+    array('std::uint16_t', 'seg_props', ['0x%04X' % v for v in values])
+    array('std::uint8_t' if len(blocks) <= 256 else 'std::uint16_t', 'seg_stage1', [str(x) for x in stage1], 24)
+    array('std::uint8_t', 'seg_stage2', [str(x) for blk in blocks for x in blk], 32)
+    w('}\n')
+
+if __name__ == '__main__':
+    main()
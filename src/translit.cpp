@@ -0,0 +1,394 @@
+/*
+    This file is part of Encmetric.
+    Copyright (C) 2021 Paolo De Donato.
+
+    Encmetric is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Encmetric is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with Encmetric. If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <encmetric/translit.hpp>
+#include <algorithm>
+
+using namespace adv;
+
+namespace{
+struct builtin_entry{
+	std::uint_least32_t from;
+	const char *to;
+};
+
+/*
+    Letters are taken from their canonical decomposition without combining marks
+*/
+const builtin_entry builtin_ascii[] = {
+	{0xa0, " "},
+	{0xa1, "!"},
+	{0xa2, "c"},
+	{0xa3, "GBP"},
+	{0xa5, "JPY"},
+	{0xa6, "|"},
+	{0xa9, "(C)"},
+	{0xab, "<<"},
+	{0xad, "-"},
+	{0xae, "(R)"},
+	{0xb1, "+/-"},
+	{0xb7, "."},
+	{0xbb, ">>"},
+	{0xbc, " 1/4"},
+	{0xbd, " 1/2"},
+	{0xbe, " 3/4"},
+	{0xbf, "?"},
+	{0xc0, "A"},
+	{0xc1, "A"},
+	{0xc2, "A"},
+	{0xc3, "A"},
+	{0xc4, "A"},
+	{0xc5, "A"},
+	{0xc6, "AE"},
+	{0xc7, "C"},
+	{0xc8, "E"},
+	{0xc9, "E"},
+	{0xca, "E"},
+	{0xcb, "E"},
+	{0xcc, "I"},
+	{0xcd, "I"},
+	{0xce, "I"},
+	{0xcf, "I"},
+	{0xd0, "D"},
+	{0xd1, "N"},
+	{0xd2, "O"},
+	{0xd3, "O"},
+	{0xd4, "O"},
+	{0xd5, "O"},
+	{0xd6, "O"},
+	{0xd7, "x"},
+	{0xd8, "O"},
+	{0xd9, "U"},
+	{0xda, "U"},
+	{0xdb, "U"},
+	{0xdc, "U"},
+	{0xdd, "Y"},
+	{0xde, "TH"},
+	{0xdf, "ss"},
+	{0xe0, "a"},
+	{0xe1, "a"},
+	{0xe2, "a"},
+	{0xe3, "a"},
+	{0xe4, "a"},
+	{0xe5, "a"},
+	{0xe6, "ae"},
+	{0xe7, "c"},
+	{0xe8, "e"},
+	{0xe9, "e"},
+	{0xea, "e"},
+	{0xeb, "e"},
+	{0xec, "i"},
+	{0xed, "i"},
+	{0xee, "i"},
+	{0xef, "i"},
+	{0xf0, "d"},
+	{0xf1, "n"},
+	{0xf2, "o"},
+	{0xf3, "o"},
+	{0xf4, "o"},
+	{0xf5, "o"},
+	{0xf6, "o"},
+	{0xf7, "/"},
+	{0xf8, "o"},
+	{0xf9, "u"},
+	{0xfa, "u"},
+	{0xfb, "u"},
+	{0xfc, "u"},
+	{0xfd, "y"},
+	{0xfe, "th"},
+	{0xff, "y"},
+	{0x100, "A"},
+	{0x101, "a"},
+	{0x102, "A"},
+	{0x103, "a"},
+	{0x104, "A"},
+	{0x105, "a"},
+	{0x106, "C"},
+	{0x107, "c"},
+	{0x108, "C"},
+	{0x109, "c"},
+	{0x10a, "C"},
+	{0x10b, "c"},
+	{0x10c, "C"},
+	{0x10d, "c"},
+	{0x10e, "D"},
+	{0x10f, "d"},
+	{0x110, "D"},
+	{0x111, "d"},
+	{0x112, "E"},
+	{0x113, "e"},
+	{0x114, "E"},
+	{0x115, "e"},
+	{0x116, "E"},
+	{0x117, "e"},
+	{0x118, "E"},
+	{0x119, "e"},
+	{0x11a, "E"},
+	{0x11b, "e"},
+	{0x11c, "G"},
+	{0x11d, "g"},
+	{0x11e, "G"},
+	{0x11f, "g"},
+	{0x120, "G"},
+	{0x121, "g"},
+	{0x122, "G"},
+	{0x123, "g"},
+	{0x124, "H"},
+	{0x125, "h"},
+	{0x126, "H"},
+	{0x127, "h"},
+	{0x128, "I"},
+	{0x129, "i"},
+	{0x12a, "I"},
+	{0x12b, "i"},
+	{0x12c, "I"},
+	{0x12d, "i"},
+	{0x12e, "I"},
+	{0x12f, "i"},
+	{0x130, "I"},
+	{0x131, "i"},
+	{0x132, "IJ"},
+	{0x133, "ij"},
+	{0x134, "J"},
+	{0x135, "j"},
+	{0x136, "K"},
+	{0x137, "k"},
+	{0x139, "L"},
+	{0x13a, "l"},
+	{0x13b, "L"},
+	{0x13c, "l"},
+	{0x13d, "L"},
+	{0x13e, "l"},
+	{0x141, "L"},
+	{0x142, "l"},
+	{0x143, "N"},
+	{0x144, "n"},
+	{0x145, "N"},
+	{0x146, "n"},
+	{0x147, "N"},
+	{0x148, "n"},
+	{0x14c, "O"},
+	{0x14d, "o"},
+	{0x14e, "O"},
+	{0x14f, "o"},
+	{0x150, "O"},
+	{0x151, "o"},
+	{0x152, "OE"},
+	{0x153, "oe"},
+	{0x154, "R"},
+	{0x155, "r"},
+	{0x156, "R"},
+	{0x157, "r"},
+	{0x158, "R"},
+	{0x159, "r"},
+	{0x15a, "S"},
+	{0x15b, "s"},
+	{0x15c, "S"},
+	{0x15d, "s"},
+	{0x15e, "S"},
+	{0x15f, "s"},
+	{0x160, "S"},
+	{0x161, "s"},
+	{0x162, "T"},
+	{0x163, "t"},
+	{0x164, "T"},
+	{0x165, "t"},
+	{0x166, "T"},
+	{0x167, "t"},
+	{0x168, "U"},
+	{0x169, "u"},
+	{0x16a, "U"},
+	{0x16b, "u"},
+	{0x16c, "U"},
+	{0x16d, "u"},
+	{0x16e, "U"},
+	{0x16f, "u"},
+	{0x170, "U"},
+	{0x171, "u"},
+	{0x172, "U"},
+	{0x173, "u"},
+	{0x174, "W"},
+	{0x175, "w"},
+	{0x176, "Y"},
+	{0x177, "y"},
+	{0x178, "Y"},
+	{0x179, "Z"},
+	{0x17a, "z"},
+	{0x17b, "Z"},
+	{0x17c, "z"},
+	{0x17d, "Z"},
+	{0x17e, "z"},
+	{0x192, "f"},
+	{0x1a0, "O"},
+	{0x1a1, "o"},
+	{0x1af, "U"},
+	{0x1b0, "u"},
+	{0x1cd, "A"},
+	{0x1ce, "a"},
+	{0x1cf, "I"},
+	{0x1d0, "i"},
+	{0x1d1, "O"},
+	{0x1d2, "o"},
+	{0x1d3, "U"},
+	{0x1d4, "u"},
+	{0x1d5, "U"},
+	{0x1d6, "u"},
+	{0x1d7, "U"},
+	{0x1d8, "u"},
+	{0x1d9, "U"},
+	{0x1da, "u"},
+	{0x1db, "U"},
+	{0x1dc, "u"},
+	{0x1de, "A"},
+	{0x1df, "a"},
+	{0x1e0, "A"},
+	{0x1e1, "a"},
+	{0x1e6, "G"},
+	{0x1e7, "g"},
+	{0x1e8, "K"},
+	{0x1e9, "k"},
+	{0x1ea, "O"},
+	{0x1eb, "o"},
+	{0x1ec, "O"},
+	{0x1ed, "o"},
+	{0x1f0, "j"},
+	{0x1f4, "G"},
+	{0x1f5, "g"},
+	{0x1f8, "N"},
+	{0x1f9, "n"},
+	{0x1fa, "A"},
+	{0x1fb, "a"},
+	{0x200, "A"},
+	{0x201, "a"},
+	{0x202, "A"},
+	{0x203, "a"},
+	{0x204, "E"},
+	{0x205, "e"},
+	{0x206, "E"},
+	{0x207, "e"},
+	{0x208, "I"},
+	{0x209, "i"},
+	{0x20a, "I"},
+	{0x20b, "i"},
+	{0x20c, "O"},
+	{0x20d, "o"},
+	{0x20e, "O"},
+	{0x20f, "o"},
+	{0x210, "R"},
+	{0x211, "r"},
+	{0x212, "R"},
+	{0x213, "r"},
+	{0x214, "U"},
+	{0x215, "u"},
+	{0x216, "U"},
+	{0x217, "u"},
+	{0x218, "S"},
+	{0x219, "s"},
+	{0x21a, "T"},
+	{0x21b, "t"},
+	{0x21e, "H"},
+	{0x21f, "h"},
+	{0x226, "A"},
+	{0x227, "a"},
+	{0x228, "E"},
+	{0x229, "e"},
+	{0x22a, "O"},
+	{0x22b, "o"},
+	{0x22c, "O"},
+	{0x22d, "o"},
+	{0x22e, "O"},
+	{0x22f, "o"},
+	{0x230, "O"},
+	{0x231, "o"},
+	{0x232, "Y"},
+	{0x233, "y"},
+	{0x2c6, "^"},
+	{0x2dc, "~"},
+	{0x2002, " "},
+	{0x2003, " "},
+	{0x2009, " "},
+	{0x2010, "-"},
+	{0x2011, "-"},
+	{0x2012, "-"},
+	{0x2013, "-"},
+	{0x2014, "--"},
+	{0x2015, "--"},
+	{0x2018, "'"},
+	{0x2019, "'"},
+	{0x201a, "'"},
+	{0x201b, "'"},
+	{0x201c, "\""},
+	{0x201d, "\""},
+	{0x201e, "\""},
+	{0x201f, "\""},
+	{0x2020, "+"},
+	{0x2022, "*"},
+	{0x2026, "..."},
+	{0x2030, "%o"},
+	{0x2032, "'"},
+	{0x2033, "\""},
+	{0x2039, "<"},
+	{0x203a, ">"},
+	{0x2044, "/"},
+	{0x20ac, "EUR"},
+	{0x2122, "(TM)"},
+	{0x2190, "<-"},
+	{0x2192, "->"},
+	{0x2212, "-"},
+	{0x2260, "!="},
+	{0x2264, "<="},
+	{0x2265, ">="}
+};
+}
+
+void translit_table::add(unicode from, const unicode *to, size_t n){
+	size_t off = chars.size();
+	chars.insert(chars.end(), to, to + n);
+	auto it = std::lower_bound(entries.begin(), entries.end(), from, [](const entry &e, unicode c) {return e.from < c;});
+	if(it != entries.end() && it->from == from){
+		it->off = off;
+		it->n = n;
+	}
+	else
+		entries.insert(it, entry{from, off, n});
+}
+
+void translit_table::add(unicode from, const char *to){
+	std::vector<unicode> tmp;
+	for(; *to != '\0'; to++)
+		tmp.push_back(unicode{static_cast<std::uint_least32_t>(static_cast<unsigned char>(*to))});
+	add(from, tmp.data(), tmp.size());
+}
+
+bool translit_table::find(unicode c, const unicode *&to, size_t &n) const noexcept{
+	auto it = std::lower_bound(entries.begin(), entries.end(), c, [](const entry &e, unicode u) {return e.from < u;});
+	if(it == entries.end() || it->from != c)
+		return false;
+	to = chars.data() + it->off;
+	n = it->n;
+	return true;
+}
+
+const translit_table &translit_table::ascii(){
+	static const translit_table table = [](){
+		translit_table ret{};
+		for(const builtin_entry &e : builtin_ascii)
+			ret.add(unicode{e.from}, e.to);
+		return ret;
+	}();
+	return table;
+}
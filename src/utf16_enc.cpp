@@ -29,6 +29,17 @@ uint UTF16<be>::chLen(const byte *data){
 		return 2;
 }
 
+template<bool be>
+uint UTF16<be>::prevLen(const byte *begin, const byte *end){
+	if(end - begin < 2)
+		throw encoding_error("Invalid utf16 character");
+	//a low surrogate preceded by an high surrogate
+	if(end - begin >= 4 && utf16_L_range(end - 2, be) && utf16_H_range(end - 4, be))
+		return 4;
+	else
+		return 2;
+}
+
 template<bool be>
 bool UTF16<be>::validChar(const byte *data, uint &add) noexcept{
 	if(utf16_H_range(data, be)){
@@ -47,10 +47,9 @@ template<bool be>
 uint UTF32<be>::encode(const unicode &unin, byte *by, size_t l){
 	if(l < 4)
 		throw buffer_small{4};
-	byte temp[4];
 	unicode uni=unin;
 	for(int i=0; i<4; i++){
-		access(temp, be, 4, 3-i) = byte{static_cast<uint8_t>(uni & 0xff)};
+		access(by, be, 4, 3-i) = byte{static_cast<uint8_t>(uni & 0xff)};
 		uni=unicode{uni >> 8};
 	}
 	return 4;
@@ -39,6 +39,17 @@ uint UTF8::chLen(const byte *data){
 	}
 }
 
+uint UTF8::prevLen(const byte *begin, const byte *end){
+	//step back over continuation bytes, then check the lead byte
+	const byte *p = end - 1;
+	while(p > begin && end - p < 4 && bit_one(*p, 7) && bit_zero(*p, 6))
+		p--;
+	uint ret = static_cast<uint>(end - p);
+	if(chLen(p) != ret)
+		throw encoding_error("Invalid utf8 character");
+	return ret;
+}
+
 bool UTF8::validChar(const byte *data, uint &add) noexcept{
 	byte b = *data;
 
@@ -135,4 +146,64 @@ uint UTF8::encode(const unicode &unin, byte *by, size_t l){
 	return y_byte;
 }
 
-
+/*
+    Well-formed sequences follow table 3-7 of the Unicode standard, an invalid sequence is replaced
+    up to (but excluding) the first byte that can't continue it
+*/
+bool UTF8::decode_checked(unicode *uni, const byte *by, size_t l, uint &len) noexcept{
+	if(l == 0){
+		len = 0;
+		return false;
+	}
+	uint b = std::to_integer<uint>(by[0]);
+	if(b < 0x80){
+		*uni = unicode{b};
+		len = 1;
+		return true;
+	}
+	uint need;
+	uint lower = 0x80;
+	uint upper = 0xbf;
+	std::uint_least32_t cp;
+	if(b >= 0xc2 && b <= 0xdf){
+		need = 1;
+		cp = b & 0x1f;
+	}
+	else if(b >= 0xe0 && b <= 0xef){
+		need = 2;
+		cp = b & 0x0f;
+		if(b == 0xe0)
+			lower = 0xa0;
+		else if(b == 0xed)
+			upper = 0x9f;
+	}
+	else if(b >= 0xf0 && b <= 0xf4){
+		need = 3;
+		cp = b & 0x07;
+		if(b == 0xf0)
+			lower = 0x90;
+		else if(b == 0xf4)
+			upper = 0x8f;
+	}
+	else{
+		len = 1;
+		return false;
+	}
+	for(uint i=1; i<=need; i++){
+		if(i >= l){
+			len = i;
+			return false;
+		}
+		uint c = std::to_integer<uint>(by[i]);
+		if(c < lower || c > upper){
+			len = i;
+			return false;
+		}
+		lower = 0x80;
+		upper = 0xbf;
+		cp = (cp << 6) | (c & 0x3f);
+	}
+	*uni = unicode{cp};
+	len = need + 1;
+	return true;
+}
@@ -0,0 +1,136 @@
+#include <encmetric.hpp>
+#include <encmetric/async_io.hpp>
+#include <iostream>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#ifndef ENCMETRIC_COROUTINES
+#error "Coroutines are not available"
+#endif
+
+using namespace adv;
+
+static int failures = 0;
+
+#define CHECK(...) check((__VA_ARGS__), #__VA_ARGS__, __LINE__)
+
+static void check(bool ok, const char *expr, int line){
+	if(!ok){
+		std::cerr << "coroutines.cpp:" << line << ": check failed: " << expr << std::endl;
+		failures++;
+	}
+}
+
+/*
+    Starts immediately, the frame is destroyed with the task
+*/
+struct task{
+	struct promise_type{
+		task get_return_object() {return task{std::coroutine_handle<promise_type>::from_promise(*this)};}
+		std::suspend_never initial_suspend() noexcept {return {};}
+		std::suspend_always final_suspend() noexcept {return {};}
+		void return_void() noexcept {}
+		void unhandled_exception() noexcept {failures++;}
+	};
+	std::coroutine_handle<promise_type> h;
+
+	explicit task(std::coroutine_handle<promise_type> c) : h{c} {}
+	task(const task &) = delete;
+	~task() {h.destroy();}
+	bool done() const noexcept {return h.done();}
+};
+
+static task write_all(async_writer<UTF8> &wr, adv_string_view<UTF8> str, int fd, bool &written){
+	co_await wr.write_view(str);
+	//an empty string is ready without suspending
+	co_await wr.write_view(adv_string_view<UTF8>{str.data(), size_t{0}, meas::size});
+	close(fd);
+	written = true;
+}
+
+static task read_all(async_reader<UTF8> &rd, std::string &out, size_t &nreads){
+	for(;;){
+		adv_string_view<UTF8> s = co_await rd.read_chars(3);
+		if(s.size() == 0)
+			break;
+		if(s.length() > 3)
+			failures++;
+		out.append(reinterpret_cast<const char *>(s.data()), s.size());
+		nreads++;
+	}
+}
+
+static task read_invalid(async_reader<UTF8> &rd, std::string &out, bool &thrown){
+	try{
+		for(;;){
+			adv_string_view<UTF8> s = co_await rd.read_chars(0);
+			if(s.size() == 0)
+				break;
+			out.append(reinterpret_cast<const char *>(s.data()), s.size());
+		}
+	}
+	catch(const encoding_error &){
+		thrown = true;
+	}
+}
+
+/*
+    Writes str in a pipe and reads it back, both sides are coroutines on the same loop
+*/
+static std::string coroutine_pipe(bool try_uring, const std::string &str, size_t &nreads){
+	std::string ret;
+	int fds[2];
+	if(pipe(fds) != 0)
+		return ret;
+	io_loop loop{try_uring};
+	async_reader<UTF8> rd{loop, fds[0], 64};
+	async_writer<UTF8> wr{loop, fds[1]};
+	bool written = false;
+	nreads = 0;
+	task w = write_all(wr, adv_string_view<UTF8>{reinterpret_cast<const byte *>(str.data()), str.size(), meas::size}, fds[1], written);
+	task r = read_all(rd, ret, nreads);
+	loop.run();
+	CHECK(written && w.done() && r.done() && rd.at_eof());
+	close(fds[0]);
+	return ret;
+}
+
+static void test_pipe(bool try_uring){
+	std::string big;
+	for(int i = 0; i < 30000; i++)
+		big += "a\xC3\xA8\xE2\x82\xAC\xF0\x9F\x98\x80";
+	size_t nreads;
+	CHECK(coroutine_pipe(try_uring, big, nreads) == big);
+	//at most three characters at a time
+	CHECK(nreads >= 40000);
+	CHECK(coroutine_pipe(try_uring, "", nreads) == "" && nreads == 0);
+
+	//the characters before the invalid byte are returned, then the read throws
+	int fds[2];
+	if(pipe(fds) != 0)
+		return;
+	const char bad[] = "ab\xFF" "cd";
+	CHECK(write(fds[1], bad, 5) == 5);
+	close(fds[1]);
+	io_loop loop{try_uring};
+	async_reader<UTF8> rd{loop, fds[0]};
+	std::string got;
+	bool thrown = false;
+	task r = read_invalid(rd, got, thrown);
+	loop.run();
+	CHECK(r.done() && thrown && got == "ab");
+	close(fds[0]);
+}
+
+int main(){
+	test_pipe(true);
+	test_pipe(false);
+	if(failures != 0){
+		std::cerr << failures << " checks failed" << std::endl;
+		return 1;
+	}
+	std::cout << "All checks passed" << std::endl;
+	return 0;
+}
@@ -1,5 +1,36 @@
 #include <encmetric.hpp>
+#include <encmetric/hash.hpp>
+#include <encmetric/intern.hpp>
+#include <encmetric/str_sort.hpp>
+#include <encmetric/tokens.hpp>
+#include <encmetric/record_reader.hpp>
+#include <encmetric/translit.hpp>
+#include <encmetric/async_io.hpp>
+#include <encmetric/normalization.hpp>
+#include <encmetric/case_mapping.hpp>
+#include <encmetric/segmentation.hpp>
+#include <encmetric/endian_swap.hpp>
+#include <encmetric/enc_registry.hpp>
+#include <encmetric/cjk_enc.hpp>
+#include <encmetric/format.hpp>
+#include <encmetric/charconv.hpp>
+#include <encmetric/json.hpp>
+#include <encmetric/text_codecs.hpp>
+#include <encmetric/shared_string.hpp>
+#include <encmetric/static_string.hpp>
+#include <encmetric_c.h>
 #include <iostream>
+#include <cstring>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <memory>
+#include <random>
+#include <algorithm>
+#include <cstdio>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 
 using namespace adv;
 
@@ -8,6 +39,1720 @@ template class const_tchar_pt<WIDEchr>;
 template class tchar_pt<ISO_8859_1>;
 template class tchar_pt<WIDE<byte>>;
 
+template class adv_intern_table<UTF8>;
+template class record_reader<UTF8>;
+template class record_reader<UTF16LE>;
+template class async_reader<UTF8>;
+template class async_writer<UTF16LE>;
+template class adv_shared_string<UTF8>;
+template class adv_shared_string<UTF16LE>;
+template class adv_static_string<UTF8, 8>;
+template class adv_static_string<UTF16LE, 16>;
+
+static int failures = 0;
+
+#define CHECK(...) check((__VA_ARGS__), #__VA_ARGS__, __LINE__)
+
+static void check(bool ok, const char *expr, int line){
+	if(!ok){
+		std::cerr << "main.cpp:" << line << ": check failed: " << expr << std::endl;
+		failures++;
+	}
+}
+
+/*
+    View of a zero terminated byte string (or of its first n bytes)
+*/
+template<typename T = UTF8>
+adv_string_view<T> sv(const char *s, size_t n){
+	return adv_string_view<T>{s, n, meas::size};
+}
+template<typename T = UTF8>
+adv_string_view<T> sv(const char *s){
+	return sv<T>(s, std::strlen(s));
+}
+
+template<typename S, typename T>
+adv_string<S> convert_to(const adv_string_view<T> &str){
+	adv_string_buf<S> buf{};
+	buf.append_string_c(str);
+	return buf.template allocate<std::allocator<byte>>();
+}
+
+static void test_hash(){
+	adv_string_view<UTF8> a = sv("hello world");
+	adv_string<UTF8> b{a};
+	CHECK(hash_string(a) == hash_string<UTF8>(b));
+	CHECK(std::hash<adv_string_view<UTF8>>{}(a) == std::hash<adv_string<UTF8>>{}(b));
+	//same bytes, different encoding
+	adv_string_view<Latin1> l = sv<Latin1>("hello world");
+	CHECK(hash_string(a) != hash_string(l));
+	CHECK(hash_string(a) != hash_string("hello worle"_asv));
+	//every tail length of the four lane loop
+	const char *txt = "the quick brown fox jumps over the lazy dog, the quick brown fox jumps over the lazy dog";
+	std::unordered_set<std::uint64_t> seen;
+	for(size_t i = 0; i <= 80; i++)
+		seen.insert(hash_string(sv(txt, i)));
+	CHECK(seen.size() == 81);
+
+	std::unordered_set<adv_string_view<UTF8>, str_hash, str_equal> set;
+	set.insert(a);
+	CHECK(set.count(adv_string_view<UTF8>{b}) == 1);
+	CHECK(set.count("hello"_asv) == 0);
+}
+
+static void test_intern(){
+	adv_intern_table<UTF8> tab{EncMetric_info<UTF8>{}, 64};
+	auto h = tab.intern("hello"_asv);
+	auto w = tab.intern("world"_asv);
+	CHECK(h != w);
+	CHECK(tab.intern("hello"_asv) == h);
+	CHECK(tab.size() == 2);
+	CHECK(tab[h] == "hello"_asv);
+	CHECK(tab[w].length() == 5);
+	CHECK(tab.intern_view("hello"_asv).data() == tab[h].data());
+
+	bool found;
+	CHECK(tab.find("world"_asv, found) == w && found);
+	tab.find("other"_asv, found);
+	CHECK(!found);
+	CHECK(!tab.contains(adv_string_view<UTF16LE>{u"hello"}));
+
+	//bigger than half a block and many strings to force rehashing
+	std::string big(100, 'x');
+	auto bid = tab.intern(sv(big.c_str(), big.size()));
+	for(int i = 0; i < 1000; i++){
+		std::string s = "key" + std::to_string(i);
+		tab.intern(sv(s.c_str(), s.size()));
+	}
+	CHECK(tab.size() == 1003);
+	CHECK(tab[h] == "hello"_asv);
+	CHECK(tab[bid].size() == 100);
+	CHECK(tab.contains("key999"_asv));
+	CHECK(!tab.contains("key1000"_asv));
+}
+
+/*
+    Sign of the comparison of a in the encoding T with b in the encoding S
+*/
+template<typename T, typename S>
+static int compare_sign(const char *a, const char *b){
+	int c = convert_to<T>(sv(a)).compare(convert_to<S>(sv(b)));
+	return c < 0 ? -1 : (c > 0 ? 1 : 0);
+}
+
+template<typename T, typename S>
+static void test_compare_enc(){
+	const char *emoji = "\xF0\x9F\x98\x80";
+	//equal strings, also after a shared prefix longer than a character
+	CHECK(compare_sign<T, S>("", "") == 0 && compare_sign<T, S>("ab\xC3\xA8\xE2\x82\xAC", "ab\xC3\xA8\xE2\x82\xAC") == 0);
+	//shared prefixes, the difference is in the last byte of a multibyte character
+	CHECK(compare_sign<T, S>("x\xC3\xA8" "a", "x\xC3\xA9" "a") < 0);
+	CHECK(compare_sign<T, S>("x\xE2\x82\xAD", "x\xE2\x82\xAC") > 0);
+	CHECK(compare_sign<T, S>("ab\xF0\x9F\x98\x81", "ab\xF0\x9F\x98\x80z") > 0);
+	//code point order, also where UTF16 code units are in a different order
+	CHECK(compare_sign<T, S>("\xEF\xBD\xA1", emoji) < 0 && compare_sign<T, S>(emoji, "\xEF\xBD\xA1") > 0);
+	CHECK(compare_sign<T, S>("a\xEF\xBF\xBD", (std::string{"a"} + emoji).c_str()) < 0);
+	//different lengths, a prefix is less than the whole string
+	CHECK(compare_sign<T, S>("abc", "abcd") < 0 && compare_sign<T, S>("abcd", "abc") > 0);
+	CHECK(compare_sign<T, S>("", "a") < 0 && compare_sign<T, S>(emoji, "") > 0);
+	CHECK(compare_sign<T, S>((std::string{"ab"} + emoji).c_str(), "ab") > 0);
+	CHECK(compare_sign<T, S>("abd", "abcd") > 0 && compare_sign<T, S>("ab", "b") < 0);
+
+	//equals compares the characters, operator== also the encoding
+	adv_string<T> a = convert_to<T>(sv("h\xC3\xA8llo \xE2\x82\xAC"));
+	adv_string<S> b = convert_to<S>(sv("h\xC3\xA8llo \xE2\x82\xAC"));
+	CHECK(a.equals(b) && b.equals(a) && (a == b) == std::is_same_v<T, S>);
+	CHECK(!a.equals(convert_to<S>(sv("h\xC3\xA8llo \xE2\x82\xAD"))) && !a.equals(convert_to<S>(sv("h\xC3\xA8llo"))));
+	CHECK(!a.equals(convert_to<S>(sv("h\xC3\xA8llo \xE2\x82\xAC "))));
+	CHECK(a <= b && a >= b && !(a < b) && !(a > b));
+	CHECK(a < convert_to<S>(sv("h\xC3\xA8llo \xE2\x82\xAC!")) && a > convert_to<S>(sv("h\xC3\xA8llo")));
+}
+
+static void test_compare(){
+	test_compare_enc<UTF8, UTF8>();
+	test_compare_enc<UTF16LE, UTF16LE>();
+	test_compare_enc<UTF16BE, UTF16BE>();
+	test_compare_enc<UTF32BE, UTF32BE>();
+	test_compare_enc<UTF8, UTF16LE>();
+	test_compare_enc<UTF16BE, UTF8>();
+	test_compare_enc<UTF16LE, UTF32LE>();
+	test_compare_enc<GB18030, UTF8>();
+
+	//the ctype is the same, the strings are compared through their characters
+	CHECK(sv<Latin1>("h\xE8llo").equals(sv("h\xC3\xA8llo")) && sv<Latin1>("h\xE8").compare(sv("h\xC3\xA9")) < 0);
+	CHECK(sv<Latin1>("\xFF").compare(sv("\xC4\x80")) < 0 && sv<Latin1>("ab").compare(sv("a")) > 0);
+	//runtime encodings
+	adv_string<UTF8> u8 = convert_to<UTF8>(sv("ab\xF0\x9F\x98\x80"));
+	adv_string<WIDE<unicode>> w16 = u8.basic_encoding_conversion(DynEncoding<UTF16LE>::instance());
+	adv_string<WIDE<unicode>> w32 = u8.basic_encoding_conversion(DynEncoding<UTF32BE>::instance());
+	CHECK(w16.equals(w32) && w16.equals(u8) && w16 != w32 && w16.compare(w32) == 0);
+	CHECK(w16.compare(sv("ab\xEF\xBD\xA1")) > 0 && w16.compare(sv("ab")) > 0);
+}
+
+/*
+    Sorts with sort_strings and with std::sort, then checks that the results agree
+*/
+template<typename T>
+bool sorted_as_std(std::vector<adv_string_view<T>> vec, uint nthreads){
+	std::vector<adv_string_view<T>> ref = vec;
+	std::stable_sort(ref.begin(), ref.end(), [](const adv_string_view<T> &a, const adv_string_view<T> &b){return a.compare(b) < 0;});
+	sort_strings(vec, nthreads);
+	if(vec.size() != ref.size())
+		return false;
+	for(size_t i = 0; i < vec.size(); i++){
+		if(vec[i].compare(ref[i]) != 0)
+			return false;
+	}
+	return true;
+}
+
+static void test_sort(){
+	std::mt19937 gen{42};
+	//few distinct characters so that strings share long prefixes
+	const char alpha[] = {'a', 'b', 'c', '\0', '\xC3', '\xA8'};
+	std::vector<std::string> data;
+	for(int i = 0; i < 5000; i++){
+		std::string s;
+		size_t n = gen() % 24;
+		for(size_t j = 0; j < n; j++){
+			uint k = gen() % 4;
+			if(k == 3)
+				s += "\xC3\xA8";
+			else
+				s += alpha[k];
+		}
+		data.push_back(s);
+	}
+	std::vector<adv_string_view<UTF8>> vec;
+	for(const std::string &s : data)
+		vec.push_back(sv(s.data(), s.size()));
+	CHECK(sorted_as_std(vec, 1));
+	CHECK(sorted_as_std(vec, 4));
+	//small arrays
+	CHECK(sorted_as_std(std::vector<adv_string_view<UTF8>>{}, 1));
+	CHECK(sorted_as_std(std::vector<adv_string_view<UTF8>>{sv("b"), sv(""), sv("ab"), sv("a")}, 1));
+
+	//not byte ordered, sorted with compare
+	std::vector<adv_string<UTF16LE>> wide;
+	for(size_t i = 0; i < 300; i++)
+		wide.push_back(convert_to<UTF16LE>(vec[i]));
+	std::vector<adv_string_view<UTF16LE>> wvec{wide.begin(), wide.end()};
+	CHECK(sorted_as_std(wvec, 2));
+
+	std::vector<adv_string_view<UTF8>> dup{sv("b"), sv("a"), sv("b"), sv("c"), sv("a"), sv("b")};
+	sort_unique_strings(dup, 1);
+	CHECK(dup.size() == 3);
+	CHECK(dup[0] == sv("a") && dup[1] == sv("b") && dup[2] == sv("c"));
+}
+
+static std::string to_std(const adv_string_view<UTF8> &str){
+	return std::string{reinterpret_cast<const char *>(str.data()), str.size()};
+}
+
+/*
+    Splits a UTF8 string on the bytes, the reference for split
+*/
+static std::vector<std::string> ref_split(const std::string &str, const std::vector<std::string> &delims, bool skip_empty){
+	std::vector<std::string> ret;
+	std::string cur;
+	bool any = false;
+	size_t i = 0;
+	while(i < str.size()){
+		size_t dl = 0;
+		for(const std::string &d : delims){
+			if(str.compare(i, d.size(), d) == 0)
+				dl = d.size();
+		}
+		if(dl == 0){
+			cur += str[i++];
+			continue;
+		}
+		if(!skip_empty || !cur.empty())
+			ret.push_back(cur);
+		cur.clear();
+		any = true;
+		i += dl;
+	}
+	if(!skip_empty || !cur.empty() || (!any && str.empty() && !skip_empty))
+		ret.push_back(cur);
+	return ret;
+}
+
+template<typename T>
+bool split_as_ref(const std::string &str, const std::vector<std::string> &delims, bool skip_empty){
+	std::string all;
+	for(const std::string &d : delims)
+		all += d;
+	adv_string<T> tstr = convert_to<T>(sv(str.data(), str.size()));
+	delimiter_set<T> ds{convert_to<T>(sv(all.data(), all.size()))};
+	std::vector<adv_string_view<T>> out;
+	size_t n = split<T>(tstr, ds, out, skip_empty);
+	std::vector<std::string> ref = ref_split(str, delims, skip_empty);
+	if(n != out.size() || n != ref.size())
+		return false;
+	for(size_t i = 0; i < n; i++){
+		if(to_std(convert_to<UTF8>(out[i])) != ref[i])
+			return false;
+	}
+	return true;
+}
+
+template<typename T>
+void test_split_enc(){
+	std::string text = "alpha,beta;;gamma delta\tepsilon-a-very-long-field-without-delimiters,,x\xC3\xA8y|z,";
+	std::vector<std::vector<std::string>> sets{
+		{","},
+		{",", ";"},
+		{",", ";", " ", "\t"},
+		{",", ";", " ", "\t", "|", "-"},
+		{",", "\xC3\xA8"},
+		{"\xC3\xA8"}
+	};
+	for(const std::vector<std::string> &d : sets){
+		//every prefix, to cover all the tails of the word loop
+		for(size_t l = 0; l <= text.size(); l++){
+			if(l < text.size() && (static_cast<unsigned char>(text[l]) & 0xC0) == 0x80)
+				continue;
+			CHECK(split_as_ref<T>(text.substr(0, l), d, false));
+			CHECK(split_as_ref<T>(text.substr(0, l), d, true));
+		}
+	}
+}
+
+static void test_tokens(){
+	test_split_enc<UTF8>();
+	test_split_enc<Latin1>();
+	test_split_enc<UTF16LE>();
+	test_split_enc<UTF16BE>();
+	test_split_enc<UTF32LE>();
+
+	adv_string<UTF16BE> str = convert_to<UTF16BE>(sv("  one  two\xF0\x9F\x98\x80 three "));
+	delimiter_set<UTF16BE> ds{convert_to<UTF16BE>(sv(" "))};
+	Token<UTF16BE> tok{str};
+	CHECK(tok.proceed(ds) == convert_to<UTF16BE>(sv("one")));
+	CHECK(tok.proceed(ds) == convert_to<UTF16BE>(sv("two\xF0\x9F\x98\x80")));
+	CHECK(tok.proceed(ds).length() == 5);
+	CHECK(tok.proceed(ds).size() == 0);
+	CHECK(ds.contains(convert_to<UTF16BE>(sv(" ")).begin()));
+	CHECK(!ds.contains(str.begin() + 4));
+}
+
+/*
+    Reads all the records and converts them to UTF8
+*/
+template<typename T, typename U>
+std::vector<std::string> all_records(record_reader<T, U> &rd){
+	std::vector<std::string> ret;
+	bool found;
+	while(true){
+		adv_string_view<T> r = rd.next(found);
+		if(!found)
+			break;
+		ret.push_back(to_std(convert_to<UTF8>(r)));
+	}
+	return ret;
+}
+
+static void test_records(){
+	std::vector<std::string> expect{"a", "bb", "", "a longer record \xC4\x8A\xE0\xA8\x8A", "last"};
+	std::string text = "a\nbb\n\na longer record \xC4\x8A\xE0\xA8\x8A\nlast";
+	record_reader<UTF8> mr{sv(text.c_str())};
+	CHECK(all_records(mr) == expect);
+	CHECK(mr.buffered() == 0);
+
+	//U+010A and U+0A0A contain the byte 0x0A
+	adv_string<UTF16LE> wtext = convert_to<UTF16LE>(sv(text.c_str()));
+	record_reader<UTF16LE> wr{wtext};
+	CHECK(all_records(wr) == expect);
+
+	record_reader<UTF8> cr{sv("x;y;")};
+	cr.set_delimiter(unicode{';'});
+	CHECK(all_records(cr) == std::vector<std::string>{"x", "y"});
+	record_reader<UTF8> er{sv("")};
+	CHECK(all_records(er).empty());
+
+#ifndef _WIN32
+	//a buffer smaller than the records must grow
+	int fds[2];
+	if(pipe(fds) == 0){
+		CHECK(write(fds[1], wtext.data(), wtext.size()) == static_cast<ssize_t>(wtext.size()));
+		close(fds[1]);
+		record_reader<UTF16LE> fr{fds[0], 3};
+		CHECK(all_records(fr) == expect);
+		close(fds[0]);
+	}
+	std::FILE *tmp = std::tmpfile();
+	if(tmp != nullptr){
+		std::fwrite(text.data(), 1, text.size(), tmp);
+		std::fflush(tmp);
+		record_reader<UTF8> pr{mapped_file{fileno(tmp)}};
+		CHECK(all_records(pr) == expect);
+		std::fclose(tmp);
+	}
+#endif
+}
+
+/*
+    Sanitizes the first n bytes of s with encoding T, the result is converted to UTF8
+*/
+template<typename T>
+static std::string sanitized(const char *s, size_t n, size_t &replaced, EncMetric_info<T> format = EncMetric_info<T>{}){
+	adv_string<T> str = sanitize(reinterpret_cast<const byte *>(s), n, replaced, format);
+	CHECK(str.verify_safe() && str.length() == convert_to<UTF32LE>(str).length());
+	return to_std(convert_to<UTF8>(str));
+}
+
+static void test_sanitize(){
+	const std::string rep = "\xEF\xBF\xBD";
+	size_t replaced = 10;
+	//valid strings are copied
+	CHECK(sanitized<UTF8>("", 0, replaced) == "" && replaced == 0);
+	CHECK(sanitized<UTF8>("a\xC3\xA8\xF0\x9F\x98\x80", 7, replaced) == "a\xC3\xA8\xF0\x9F\x98\x80" && replaced == 0);
+	//every maximal subpart of an ill-formed sequence is replaced once
+	CHECK(sanitized<UTF8>("a\xFF" "b", 3, replaced) == "a" + rep + "b" && replaced == 1);
+	CHECK(sanitized<UTF8>("a\xE2\x82" "b", 4, replaced) == "a" + rep + "b" && replaced == 1);
+	CHECK(sanitized<UTF8>("\xE2\x82\xE2\x82\xAC", 5, replaced) == rep + "\xE2\x82\xAC" && replaced == 1);
+	CHECK(sanitized<UTF8>("\xC0\xAF", 2, replaced) == rep + rep && replaced == 2);
+	CHECK(sanitized<UTF8>("\xED\xA0\x80" "a", 4, replaced) == rep + rep + rep + "a" && replaced == 3);
+	CHECK(sanitized<UTF8>("\xF4\x90\x80\x80", 4, replaced) == rep + rep + rep + rep && replaced == 4);
+	CHECK(sanitized<UTF8>("\x80\x80", 2, replaced) == rep + rep && replaced == 2);
+	//a truncated character at the end
+	CHECK(sanitized<UTF8>("ab\xF0\x9F\x98", 5, replaced) == "ab" + rep && replaced == 1);
+
+	//lone surrogates and an odd number of bytes
+	CHECK(sanitized<UTF16LE>("a\0\x3D\xD8" "b\0", 6, replaced) == "a" + rep + "b" && replaced == 1);
+	CHECK(sanitized<UTF16LE>("\x00\xDE\x3D\xD8\x00\xDE", 6, replaced) == rep + "\xF0\x9F\x98\x80" && replaced == 1);
+	CHECK(sanitized<UTF16BE>("\0a\xD8\x3D", 4, replaced) == "a" + rep && replaced == 1);
+	CHECK(sanitized<UTF16LE>("a\0b", 3, replaced) == "a" + rep && replaced == 1);
+	CHECK(sanitized<UTF32LE>("a\0\0\0\0\0\x11\0\0\xD8\0\0", 12, replaced) == "a" + rep + rep && replaced == 2);
+	//runtime encodings
+	CHECK(sanitized<WIDE<unicode>>("a\0\x3D\xD8", 4, replaced, EncMetric_info<WIDE<unicode>>{DynEncoding<UTF16LE>::instance()}) == "a" + rep && replaced == 1);
+
+	//U+FFFD can't be represented, '?' is written instead
+	CHECK(sanitized<ASCII>("a\x80" "b\xFF", 4, replaced) == "a?b?" && replaced == 2);
+	CHECK(sanitized<Shift_JIS>("a\x82\xA0\x82", 4, replaced) == "a\xE3\x81\x82?" && replaced == 1);
+	CHECK(sanitized<GB18030>("a\x81", 2, replaced) == "a" + rep && replaced == 1);
+	//the view overload
+	CHECK(to_std(convert_to<UTF8>(sanitize(sv("ok\xC3\xA8"), replaced))) == "ok\xC3\xA8" && replaced == 0);
+}
+
+/*
+    Converts the UTF8 string s to T, then from T to S with the policy pol
+*/
+template<typename S, typename T = UTF8>
+static std::string convert_pol(const char *s, conv_policy &pol){
+	adv_string<T> src = convert_to<T>(sv(s));
+	adv_string_buf<S> buf{};
+	buf.append_string_c(adv_string_view<T>{src}, pol);
+	return to_std(convert_to<UTF8>(buf.template allocate<std::allocator<byte>>()));
+}
+
+template<typename T>
+static bool convert_raises(const char *s, conv_policy &pol){
+	try{
+		convert_pol<T>(s, pol);
+		return false;
+	}
+	catch(const encoding_error &){
+		return true;
+	}
+}
+
+template<typename T>
+static void test_unmappable_enc(){
+	//the ASCII table: diacritics, ligatures, punctuation and symbols
+	conv_policy tr{unmappable_policy::transliterate};
+	CHECK(convert_pol<ASCII, T>("\xC5\x81\xC3\xB3" "d\xC5\xBA \xC3\x86on \xC5\x92uvre \xE2\x80\x9Cok\xE2\x80\x9D \xE2\x80\x94 5\xE2\x82\xAC\xE2\x80\xA6", tr)
+		== "Lodz AEon OEuvre \"ok\" -- 5EUR...");
+	CHECK(tr.unmapped == 10 && tr.transliterated == 10);
+	//Latin1 keeps the characters it can represent
+	tr = conv_policy{unmappable_policy::transliterate};
+	CHECK(convert_pol<Latin1, T>("stra\xC3\x9F" "e \xC3\xA8 \xC5\x81 \xE2\x82\xAC", tr) == "stra\xC3\x9F" "e \xC3\xA8 L EUR");
+	CHECK(tr.unmapped == 2 && tr.transliterated == 2);
+	//without a transliteration the replacement character is used
+	tr = conv_policy{unmappable_policy::transliterate, unicode{'_'}};
+	CHECK(convert_pol<ASCII, T>("a\xE4\xB8\xAD\xF0\x9F\x98\x80" "b", tr) == "a__b" && tr.unmapped == 2 && tr.transliterated == 0);
+
+	//numeric character references, also outside the BMP
+	conv_policy ncr{unmappable_policy::ncr};
+	CHECK(convert_pol<ASCII, T>("5\xE2\x82\xAC \xC3\xA8 \xF0\x9F\x98\x80", ncr) == "5&#8364; &#232; &#128512;");
+	CHECK(ncr.unmapped == 3 && ncr.transliterated == 0);
+	ncr = conv_policy{unmappable_policy::ncr};
+	CHECK(convert_pol<Latin1, T>("5\xE2\x82\xAC \xC3\xA8\xC4\x80", ncr) == "5&#8364; \xC3\xA8&#256;" && ncr.unmapped == 2);
+	CHECK(convert_pol<Win_1252, T>("\xE2\x82\xAC\xC4\x80", ncr) == "\xE2\x82\xAC&#256;");
+
+	conv_policy rep{unmappable_policy::replace};
+	CHECK(convert_pol<ASCII, T>("\xC3\xA8x\xE2\x82\xAC", rep) == "?x?" && rep.unmapped == 2);
+	conv_policy raise{};
+	CHECK(convert_raises<ASCII>("ab\xC3\xA8", raise));
+}
+
+static void test_unmappable(){
+	test_unmappable_enc<UTF8>();
+	test_unmappable_enc<UTF16LE>();
+
+	//a custom table, a transliteration that isn't representable is replaced as a whole
+	translit_table table{};
+	table.add(unicode{0x3B1}, "alpha");
+	const unicode euro[2]{unicode{0x20AC}, unicode{'!'}};
+	table.add(unicode{0x3B2}, euro, 2);
+	CHECK(table.size() == 2);
+	conv_policy tr{unmappable_policy::transliterate, unicode{'?'}, &table};
+	CHECK(convert_pol<Latin1>("\xCE\xB1\xCE\xB2\xC3\xA8\xC5\x81", tr) == "alpha?\xC3\xA8?");
+	CHECK(tr.unmapped == 3 && tr.transliterated == 1);
+	CHECK(convert_pol<Win_1252>("\xCE\xB2", tr) == "\xE2\x82\xAC!");
+
+	//the replacement must be representable
+	conv_policy bad{unmappable_policy::replace, unicode{0x20AC}};
+	CHECK(convert_raises<ASCII>("\xC3\xA8", bad));
+	CHECK(convert_pol<Win_1252>("\xC4\x80", bad) == "\xE2\x82\xAC");
+
+	//conversions of views and of bytes
+	conv_policy ncr{unmappable_policy::ncr};
+	adv_string<ASCII> a = sv("x\xCF\x80y").basic_encoding_conversion<ASCII>(ncr);
+	CHECK(a.size() == 8 && a.length() == 8 && a == sv<ASCII>("x&#960;y"));
+	adv_string_buf<Latin1> lb{};
+	const char *u16 = "a\0\xAC\x20";
+	CHECK(lb.append_bytes_c(reinterpret_cast<const byte *>(u16), 4, EncMetric_info<UTF16LE>{}, ncr) == 8);
+	CHECK(lb.allocate<std::allocator<byte>>() == sv<Latin1>("a&#8364;"));
+}
+
+/*
+    lastIndexOf and lastBytesOf of sq in str, both converted to T. Returns false if sq is not found
+*/
+template<typename T>
+static bool last_index(const char *str, const char *sq, size_t &idx, size_t &byt){
+	adv_string<T> tstr = convert_to<T>(sv(str));
+	adv_string<T> tsq = convert_to<T>(sv(sq));
+	bool found = false, found2 = false;
+	idx = tstr.lastIndexOf(tsq, found);
+	byt = tstr.lastBytesOf(tsq, found2);
+	if(found != found2)
+		return false;
+	return found;
+}
+
+template<typename T>
+static bool ends_with(const char *str, const char *sq){
+	return convert_to<T>(sv(str)).endsWith(convert_to<T>(sv(sq)));
+}
+
+template<typename T>
+static std::string trim_right_std(const char *str){
+	adv_string<T> tstr = convert_to<T>(sv(str));
+	adv_string_view<T> t = tstr.trim_right();
+	CHECK(t.data() == tstr.data() && t.length() == convert_to<T>(t).length());
+	return to_std(convert_to<UTF8>(t));
+}
+
+template<typename T>
+static void test_reverse_enc(){
+	const char *emoji = "\xF0\x9F\x98\x80";
+	std::string str = std::string{"a"} + emoji + "b\xC3\xA8" + emoji + "\xC3\xA8" + emoji;
+	size_t idx, byt;
+	//multibyte characters and surrogate pairs at the end
+	CHECK(last_index<T>(str.c_str(), emoji, idx, byt) && idx == 6 && byt == convert_to<T>(sv(str.c_str(), str.size() - 4)).size());
+	CHECK(last_index<T>(str.c_str(), "\xC3\xA8", idx, byt) && idx == 5);
+	CHECK(last_index<T>(str.c_str(), (std::string{"b\xC3\xA8"} + emoji).c_str(), idx, byt) && idx == 2);
+	CHECK(last_index<T>(str.c_str(), "a", idx, byt) && idx == 0 && byt == 0);
+	CHECK(!last_index<T>(str.c_str(), "\xC3\xA8\xC3\xA8", idx, byt));
+	CHECK(!last_index<T>("ab", "abc", idx, byt));
+	CHECK(last_index<T>(str.c_str(), "", idx, byt) && idx == 7 && byt == convert_to<T>(sv(str.c_str())).size());
+	CHECK(last_index<T>(emoji, emoji, idx, byt) && idx == 0 && byt == 0);
+
+	CHECK(ends_with<T>(str.c_str(), emoji) && ends_with<T>(str.c_str(), (std::string{"\xC3\xA8"} + emoji).c_str()));
+	CHECK(ends_with<T>(str.c_str(), "") && ends_with<T>(str.c_str(), str.c_str()));
+	CHECK(!ends_with<T>(str.c_str(), "\xC3\xA8") && !ends_with<T>(emoji, (std::string{"a"} + emoji).c_str()));
+
+	CHECK(trim_right_std<T>((std::string{"x "} + emoji + " \t\xE3\x80\x80\xC2\xA0\r\n").c_str()) == std::string{"x "} + emoji);
+	CHECK(trim_right_std<T>((std::string{"\xC3\xA8"} + emoji).c_str()) == std::string{"\xC3\xA8"} + emoji);
+	CHECK(trim_right_std<T>(" \xE2\x80\x83 ").empty() && trim_right_std<T>("").empty());
+}
+
+static void test_reverse(){
+	test_reverse_enc<UTF8>();
+	test_reverse_enc<UTF16LE>();
+	test_reverse_enc<UTF16BE>();
+	test_reverse_enc<UTF32LE>();
+	//not reversible, the string is scanned forward
+	CHECK(!EncMetric_info<GB18030>{}.reversible());
+	test_reverse_enc<GB18030>();
+
+	//the suffix must start at a character boundary, here the second byte of a GBK character is an ASCII letter
+	adv_string_view<GBK> gbk = sv<GBK>("\xB0\x41\x42", 3);
+	CHECK(gbk.length() == 2 && !gbk.endsWith(sv<GBK>("AB")) && gbk.endsWith(sv<GBK>("B")));
+	bool found;
+	CHECK(gbk.lastIndexOf(sv<GBK>("A"), found) == 0 && !found);
+	CHECK(gbk.lastIndexOf(sv<GBK>("B"), found) == 1 && found);
+
+	//trim_right with a predicate, on a runtime encoding
+	adv_string<UTF8> u8 = convert_to<UTF8>(sv("a.b..\xC3\xA8.."));
+	adv_string<WIDE<unicode>> w = u8.basic_encoding_conversion(DynEncoding<UTF16BE>::instance());
+	adv_string_view<WIDE<unicode>> wt = w.trim_right([](unicode c) {return c == '.';});
+	CHECK(wt.length() == 6 && wt.size() == 12);
+}
+
+/*
+    Characters of s read forward and backward with code_points, checked against the ones read by
+    the character pointers
+*/
+template<typename T>
+static void test_code_points_enc(const std::string &s){
+	adv_string<T> str = convert_to<T>(sv(s.data(), s.size()));
+	std::vector<unicode> ref;
+	for(const_tchar_pt<T> p = str.begin(); p != str.end(); p.next()){
+		unicode c;
+		p.decode(&c, 4);
+		ref.push_back(c);
+	}
+	code_point_range<T> cps = str.code_points();
+	std::vector<unicode> fw{cps.begin(), cps.end()};
+	CHECK(fw == ref && cps.empty() == ref.empty());
+	std::vector<unicode> bw;
+	for(code_point_iterator<T> it = cps.end(); it != cps.begin();)
+		bw.push_back(*--it);
+	std::reverse(bw.begin(), bw.end());
+	CHECK(bw == ref);
+	CHECK(std::vector<unicode>(std::make_reverse_iterator(cps.end()), std::make_reverse_iterator(cps.begin())) == std::vector<unicode>(ref.rbegin(), ref.rend()));
+	//changes of direction across the block boundaries, base follows the characters
+	if(ref.size() < 2)
+		return;
+	code_point_iterator<T> it = cps.begin();
+	for(size_t i = 0; i + 1 < ref.size(); i++){
+		code_point_iterator<T> nx = it;
+		++nx;
+		code_point_iterator<T> back = nx;
+		CHECK(*it == ref[i] && *nx == ref[i+1] && *--back == ref[i] && back == it && back.base() == str.begin() + str.size(0, i));
+		it = nx;
+	}
+	CHECK(it++ != cps.end() && it == cps.end() && it.at_end());
+}
+
+static void test_code_points(){
+	//ASCII runs, two, three and four byte characters, longer than a block
+	std::string mixed;
+	for(int i = 0; i < 5; i++)
+		mixed += "abc\xC3\xA8\xE2\x82\xAC\xF0\x9F\x98\x80xyz0123456789\xD0\x96\xF0\x90\x8D\x88";
+	for(const std::string &s : {std::string{}, std::string{"a"}, std::string{"\xF0\x9F\x98\x80"}, mixed, mixed.substr(3)}){
+		test_code_points_enc<UTF8>(s);
+		test_code_points_enc<UTF16LE>(s);
+		test_code_points_enc<UTF16BE>(s);
+		test_code_points_enc<UTF32LE>(s);
+	}
+	static_assert(std::is_same_v<code_point_iterator<UTF8>::iterator_concept, std::bidirectional_iterator_tag>);
+	static_assert(std::is_same_v<code_point_iterator<UTF16LE>::iterator_concept, std::bidirectional_iterator_tag>);
+	static_assert(std::is_same_v<code_point_iterator<GB18030>::iterator_concept, std::forward_iterator_tag>);
+
+	//runtime encodings, decrementing a non reversible one throws
+	adv_string<UTF8> u8 = convert_to<UTF8>(sv(mixed.data(), mixed.size()));
+	adv_string<WIDE<unicode>> w = u8.basic_encoding_conversion(DynEncoding<UTF16LE>::instance());
+	std::vector<unicode> wf{w.code_points().begin(), w.code_points().end()};
+	code_point_range<WIDE<unicode>> wcps = w.code_points();
+	std::vector<unicode> wb{std::make_reverse_iterator(wcps.end()), std::make_reverse_iterator(wcps.begin())};
+	std::reverse(wb.begin(), wb.end());
+	CHECK(wf.size() == u8.length() && wf == wb);
+	adv_string<WIDE<unicode>> wg = u8.basic_encoding_conversion(DynEncoding<GB18030>::instance());
+	CHECK(std::vector<unicode>(wg.code_points().begin(), wg.code_points().end()) == wf);
+	code_point_iterator<WIDE<unicode>> ge = wg.code_points().end();
+	bool thrown = false;
+	try{
+		--ge;
+	}
+	catch(const encoding_error &){
+		thrown = true;
+	}
+	CHECK(thrown);
+	//forward only
+	adv_string<GB18030> g = convert_to<GB18030>(sv(mixed.data(), mixed.size()));
+	CHECK(std::vector<unicode>(g.code_points().begin(), g.code_points().end()) == wf);
+}
+
+static std::string norm(const char *s, norm_form f){
+	adv_string_buf<UTF8> buf{};
+	normalize_append(sv(s), f, buf);
+	return to_std(buf.allocate<std::allocator<byte>>());
+}
+
+/*
+    Checks the four normalization forms of s
+*/
+static bool norm_all(const char *s, const char *nfc, const char *nfd, const char *nfkc, const char *nfkd){
+	return norm(s, norm_form::nfc) == nfc && norm(s, norm_form::nfd) == nfd && norm(s, norm_form::nfkc) == nfkc && norm(s, norm_form::nfkd) == nfkd;
+}
+
+static void test_normalization(){
+	//canonical reordering: dot below (ccc 220) before acute (ccc 230)
+	CHECK(norm("a\xCC\x81\xCC\xA3", norm_form::nfd) == "a\xCC\xA3\xCC\x81");
+	CHECK(norm("a\xCC\xA3\xCC\x81", norm_form::nfd) == "a\xCC\xA3\xCC\x81");
+	CHECK(norm("a\xCC\x81\xCC\xA3", norm_form::nfc) == "\xE1\xBA\xA1\xCC\x81");
+	CHECK(norm("a\xCC\x81", norm_form::nfc) == "\xC3\xA1");
+	//acute blocked by another acute
+	CHECK(norm("a\xCC\x81\xCC\x81", norm_form::nfc) == "\xC3\xA1\xCC\x81");
+	CHECK(combining_class(unicode{0x323}) == 220 && combining_class(unicode{0x301}) == 230 && combining_class(unicode{'a'}) == 0);
+
+	//Hangul: LVT and LV syllables, LV + T composition
+	CHECK(norm_all("\xED\x95\x9C", "\xED\x95\x9C", "\xE1\x84\x92\xE1\x85\xA1\xE1\x86\xAB", "\xED\x95\x9C", "\xE1\x84\x92\xE1\x85\xA1\xE1\x86\xAB"));
+	CHECK(norm("\xE1\x84\x92\xE1\x85\xA1\xE1\x86\xAB", norm_form::nfc) == "\xED\x95\x9C");
+	CHECK(norm("\xEA\xB0\x80", norm_form::nfd) == "\xE1\x84\x80\xE1\x85\xA1");
+	CHECK(norm("\xEA\xB0\x80\xE1\x86\xA8", norm_form::nfc) == "\xEA\xB0\x81");
+	unicode hc;
+	CHECK(compose(unicode{0xAC00}, unicode{0x11A8}, hc) && hc == 0xAC01 && !compose(unicode{0xAC01}, unicode{0x11A8}, hc));
+
+	//composition exclusions and singletons
+	CHECK(norm("\xE0\xA5\x98", norm_form::nfc) == "\xE0\xA4\x95\xE0\xA4\xBC");
+	CHECK(norm("\xE0\xA4\x95\xE0\xA4\xBC", norm_form::nfc) == "\xE0\xA4\x95\xE0\xA4\xBC");
+	CHECK(!compose(unicode{0x915}, unicode{0x93C}, hc));
+	CHECK(norm("\xE2\x84\xAB", norm_form::nfc) == "\xC3\x85");
+	CHECK(norm("\xE2\x84\xA6", norm_form::nfc) == "\xCE\xA9");
+
+	//compatibility mappings
+	CHECK(norm_all("\xEF\xAC\x81", "\xEF\xAC\x81", "\xEF\xAC\x81", "fi", "fi"));
+	CHECK(norm("x\xC2\xB2 \xEF\xBC\xA1\xE2\x85\xA8", norm_form::nfkc) == "x2 AIX");
+	CHECK(norm_all("\xE1\xBA\x9B\xCC\xA3", "\xE1\xBA\x9B\xCC\xA3", "\xC5\xBF\xCC\xA3\xCC\x87", "\xE1\xB9\xA9", "s\xCC\xA3\xCC\x87"));
+
+	//checks
+	CHECK(quick_check(sv("abc \xC3\xA1"), norm_form::nfc) == qc_result::yes);
+	CHECK(quick_check(sv("\xC3\xA1"), norm_form::nfd) == qc_result::no);
+	CHECK(quick_check(sv("a\xCC\x81"), norm_form::nfc) == qc_result::maybe);
+	CHECK(!is_normalized(sv("a\xCC\x81"), norm_form::nfc) && is_normalized(sv("a\xCC\x81"), norm_form::nfd));
+	CHECK(is_normalized(sv("\xCC\x81"), norm_form::nfc));
+
+	//normalize returns the argument if it's already normalized
+	adv_string<UTF16LE> u16 = convert_to<UTF16LE>(sv("e\xCC\x81t\xC3\xA9"));
+	adv_string_buf<UTF16LE> b16{};
+	adv_string_view<UTF16LE> n16 = normalize(u16, norm_form::nfc, b16);
+	CHECK(to_std(convert_to<UTF8>(n16)) == "\xC3\xA9t\xC3\xA9" && n16.data() != u16.data());
+	adv_string_view<UTF16LE> same = normalize(n16, norm_form::nfc, b16);
+	CHECK(same.data() == n16.data());
+}
+
+template<typename T>
+static size_t icase_index(const char *str, const char *sq, bool &found){
+	return indexOf_icase(convert_to<T>(sv(str)), convert_to<T>(sv(sq)), found);
+}
+
+template<typename T>
+static int icase_compare(const char *a, const char *b){
+	return compare_icase(convert_to<T>(sv(a)), convert_to<T>(sv(b)));
+}
+
+template<typename T>
+static void test_icase_enc(){
+	//long ASCII runs are compared a word at a time
+	CHECK(icase_compare<T>("Hello World, an ASCII sentence", "hELLO wORLD, AN ascii SENTENCE") == 0);
+	CHECK(icase_compare<T>("abcdefghijklmnopQ", "ABCDEFGHIJKLMNOPr") < 0);
+	CHECK(icase_compare<T>("ABCDEFGHIJKLMNOPr", "abcdefghijklmnopQ") > 0);
+	CHECK(icase_compare<T>("abcdefghijklmnop", "ABCDEFGHIJKLMNOPQ") < 0);
+	CHECK(icase_compare<T>("abcdefgh@", "ABCDEFGH`") != 0);
+	//non ASCII characters after the ASCII run
+	CHECK(icase_compare<T>("ABCDEFGHIJKLstra\xC3\x9F" "e", "abcdefghijklSTRASSE") == 0);
+	CHECK(icase_compare<T>("ABCDEFGH\xF0\x9F\x98\x80", "abcdefgh\xF0\x9F\x98\x80") == 0);
+
+	bool found = false;
+	CHECK(icase_index<T>("xxxxxxxxxxxxxxxxxxxxHeLLo", "hello", found) == 20 && found);
+	CHECK(icase_index<T>("\xF0\x9F\x98\x80xxxxxxxxxxxxHELLO", "hello", found) == 13 && found);
+	CHECK(icase_index<T>("hhhhhhhhhhhhhhhhhhhhhhhHelp", "help", found) == 23 && found);
+	CHECK(icase_index<T>("xxxxxxxxxxxxxxxxstrasse", "STRA\xC3\x9F" "E", found) == 16 && found);
+	icase_index<T>("xxxxxxxxxxxxxxxxxxxxHeLL", "hello", found);
+	CHECK(!found);
+}
+
+static void test_case_mapping(){
+	//final sigma: at the end of a word, also before case ignorable characters
+	CHECK(to_std(to_lower(sv("\xCE\x8C\xCE\xA3\xCE\x9F\xCE\xA3"))) == "\xCF\x8C\xCF\x83\xCE\xBF\xCF\x82");
+	CHECK(to_std(to_lower(sv("\xCE\x91\xCE\xA3. \xCE\xA3"))) == "\xCE\xB1\xCF\x82. \xCF\x83");
+	CHECK(to_std(to_lower(sv("\xCE\x91\xCE\xA3'\xCE\x91"))) == "\xCE\xB1\xCF\x83'\xCE\xB1");
+	//sharp s
+	CHECK(to_std(to_upper(sv("stra\xC3\x9F" "e"))) == "STRASSE");
+	CHECK(to_std(fold(sv("Stra\xC3\x9F" "e"))) == "strasse");
+	CHECK(equals_icase(sv("stra\xC3\x9F" "e"), sv("STRASSE")));
+	CHECK(to_std(to_lower(sv("\xE1\xBA\x9E"))) == "\xC3\x9F");
+
+	//UTF16 input, the result keeps the encoding
+	adv_string<UTF16LE> u16 = convert_to<UTF16LE>(sv("\xCE\x8C\xCE\xA3\xCE\x9F\xCE\xA3 stra\xC3\x9F" "e \xF0\x90\x90\x80"));
+	CHECK(to_std(convert_to<UTF8>(to_lower(u16))) == "\xCF\x8C\xCF\x83\xCE\xBF\xCF\x82 stra\xC3\x9F" "e \xF0\x90\x90\xA8");
+	CHECK(to_std(convert_to<UTF8>(to_upper(u16))) == "\xCE\x8C\xCE\xA3\xCE\x9F\xCE\xA3 STRASSE \xF0\x90\x90\x80");
+	CHECK(equals_icase(u16, sv("\xCF\x8C\xCF\x83\xCE\xBF\xCF\x82 STRASSE \xF0\x90\x90\xA8")));
+
+	test_icase_enc<UTF8>();
+	test_icase_enc<UTF16LE>();
+	test_icase_enc<UTF16BE>();
+	test_icase_enc<UTF32LE>();
+}
+
+/*
+    Segments of str in the encoding T, converted back to UTF8
+*/
+template<typename T, bool words>
+static std::vector<std::string> segments(const char *str){
+	adv_string<T> tstr = convert_to<T>(sv(str));
+	std::vector<std::string> ret;
+	size_t len = 0;
+	for(adv_string_view<T> s : segment_range<T, words>{adv_string_view<T>{tstr}.code_points()}){
+		ret.push_back(to_std(convert_to<UTF8>(s)));
+		len += s.length();
+	}
+	if(len != tstr.length())
+		ret.push_back("<wrong length>");
+	return ret;
+}
+
+template<typename T>
+static void test_segmentation_enc(){
+	using strs = std::vector<std::string>;
+	//combining marks, also more than one and after a non ASCII base
+	CHECK((segments<T, false>("e\xCC\x81\xCC\xA3x\xC3\xA5\xCC\x8A") == strs{"e\xCC\x81\xCC\xA3", "x", "\xC3\xA5\xCC\x8A"}));
+	CHECK((segments<T, false>("\xCC\x81" "a") == strs{"\xCC\x81", "a"}));
+	//emoji ZWJ sequences, with modifiers and variation selectors
+	const char *family = "\xF0\x9F\x91\xA8\xE2\x80\x8D\xF0\x9F\x91\xA9\xE2\x80\x8D\xF0\x9F\x91\xA7";
+	const char *rainbow = "\xF0\x9F\x8F\xB3\xEF\xB8\x8F\xE2\x80\x8D\xF0\x9F\x8C\x88";
+	const char *tone = "\xF0\x9F\x91\x8D\xF0\x9F\x8F\xBD";
+	CHECK((segments<T, false>((std::string{family} + "a" + rainbow + tone).c_str()) == strs{family, "a", rainbow, tone}));
+	//a ZWJ after a letter doesn't join the emoji
+	CHECK((segments<T, false>("a\xE2\x80\x8D\xF0\x9F\x91\xA9") == strs{"a\xE2\x80\x8D", "\xF0\x9F\x91\xA9"}));
+	//regional indicators are paired
+	const char *it = "\xF0\x9F\x87\xAE\xF0\x9F\x87\xB9";
+	const char *fr = "\xF0\x9F\x87\xAB\xF0\x9F\x87\xB7";
+	const char *r = "\xF0\x9F\x87\xB7";
+	CHECK((segments<T, false>((std::string{it} + fr + r).c_str()) == strs{it, fr, r}));
+	CHECK((segments<T, false>((std::string{"x"} + it + "y" + r).c_str()) == strs{"x", it, "y", r}));
+	//CR LF is a single cluster, CR CR and LF CR are not
+	CHECK((segments<T, false>("a\r\nb\r\r\n\n\r") == strs{"a", "\r\n", "b", "\r", "\r\n", "\n", "\r"}));
+	CHECK((segments<T, false>("\r\n\xCC\x81") == strs{"\r\n", "\xCC\x81"}));
+	//Hangul syllables from jamo
+	CHECK((segments<T, false>("\xE1\x84\x92\xE1\x85\xA1\xE1\x86\xAB\xED\x95\x9C") == strs{"\xE1\x84\x92\xE1\x85\xA1\xE1\x86\xAB", "\xED\x95\x9C"}));
+
+	//words
+	CHECK((segments<T, true>("can't stop, 3.14 e\xCC\x81t\xC3\xA9!") == strs{"can't", " ", "stop", ",", " ", "3.14", " ", "e\xCC\x81t\xC3\xA9", "!"}));
+	CHECK((segments<T, true>("a  b\r\nc") == strs{"a", "  ", "b", "\r\n", "c"}));
+	CHECK((segments<T, true>((std::string{it} + fr + " " + family).c_str()) == strs{it, fr, " ", family}));
+
+	adv_string<T> tstr = convert_to<T>(sv((std::string{"a\r\n"} + family + "e\xCC\x81" + it).c_str()));
+	CHECK(grapheme_length<T>(tstr) == 5);
+	CHECK(to_std(convert_to<UTF8>(grapheme_prefix<T>(tstr, 3))) == std::string{"a\r\n"} + family);
+	CHECK(grapheme_prefix<T>(tstr, 10).size() == tstr.size());
+	//the family would be cut
+	size_t pre = convert_to<T>(sv("a\r\n")).size();
+	CHECK(to_std(convert_to<UTF8>(grapheme_truncate<T>(tstr, pre + 2))) == "a\r\n");
+	CHECK(grapheme_truncate<T>(tstr, tstr.size() - 1).length() == tstr.length() - 2);
+}
+
+static void test_segmentation(){
+	test_segmentation_enc<UTF8>();
+	test_segmentation_enc<UTF16LE>();
+	test_segmentation_enc<UTF32BE>();
+
+	//ASCII runs in grapheme_length
+	CHECK(grapheme_length(sv("plain ASCII text\r\n\r\n")) == 18);
+	CHECK(grapheme_length(sv("ab\r\ncd\xCC\x81" "ef\r")) == 8);
+	CHECK(grapheme_length(sv("\r\n")) == 1 && grapheme_length(sv("")) == 0);
+	CHECK(grapheme_length(sv<Latin1>("a\r\n\xE8")) == 3);
+}
+
+/*
+    Swaps every unit of siz bytes with u bytes, the reference for swap_utf16 and swap_utf32
+*/
+static std::vector<byte> ref_swap(const byte *in, size_t siz, size_t u){
+	std::vector<byte> ret(in, in + siz);
+	for(size_t i = 0; i + u <= siz; i += u)
+		std::reverse(ret.begin() + i, ret.begin() + i + u);
+	return ret;
+}
+
+/*
+    Swaps the bytes of b at every offset in [0, 8) of a buffer and at every length, with the input
+    separated from the output or the same. valid is the length of the valid prefix of b
+*/
+static bool swap_all_lengths(const std::vector<byte> &b, size_t u, bool be, size_t valid){
+	std::vector<byte> inbuf(b.size() + 16), outbuf(b.size() + 16);
+	for(size_t off = 0; off < 8; off++){
+		for(size_t l = 0; l <= b.size(); l++){
+			std::copy(b.begin(), b.begin() + l, inbuf.begin() + off);
+			std::fill(outbuf.begin(), outbuf.end(), byte{0});
+			byte *in = inbuf.data() + off;
+			byte *out = outbuf.data() + 7 - off;
+			size_t ok = u == 2 ? swap_utf16(in, out, l, be) : swap_utf32(in, out, l, be);
+			//a partial unit is never converted, a character cut in the middle is invalid
+			size_t expect = std::min(l - l % u, valid);
+			if(u == 2 && expect < valid && expect >= 2){
+				std::uint8_t hb = std::to_integer<std::uint8_t>(b[expect - 2 + (be ? 0 : 1)]);
+				if((hb & 0xFC) == 0xD8)
+					expect -= 2;
+			}
+			if(ok != expect || ref_swap(in, ok, u) != std::vector<byte>(out, out + ok))
+				return false;
+			//in place
+			ok = u == 2 ? swap_utf16(in, in, l, be) : swap_utf32(in, in, l, be);
+			if(ok != expect || ref_swap(b.data(), ok, u) != std::vector<byte>(in, in + ok))
+				return false;
+		}
+	}
+	return true;
+}
+
+template<typename T>
+static std::vector<byte> bytes_of(const char *s){
+	adv_string<T> str = convert_to<T>(sv(s));
+	return std::vector<byte>(str.data(), str.data() + str.size());
+}
+
+static void test_byte_swap(){
+	const char *text = "abcd\xF0\x9F\x98\x80" "efgh\xC3\xA8\xE2\x82\xAC" "ijklmnop\xF0\x90\x8D\x88\xF0\x90\x8D\x89qrstuvwxyz";
+	std::vector<byte> le16 = bytes_of<UTF16LE>(text), be16 = bytes_of<UTF16BE>(text);
+	std::vector<byte> le32 = bytes_of<UTF32LE>(text), be32 = bytes_of<UTF32BE>(text);
+	CHECK(swap_all_lengths(le16, 2, false, le16.size()) && swap_all_lengths(be16, 2, true, be16.size()));
+	CHECK(swap_all_lengths(le32, 4, false, le32.size()) && swap_all_lengths(be32, 4, true, be32.size()));
+
+	//a lone high surrogate, a lone low surrogate, a surrogate and a value after U+10FFFF
+	std::vector<byte> bad = le16;
+	bad[14] = byte{0x00};
+	bad[15] = byte{0xD9};
+	CHECK(swap_all_lengths(bad, 2, false, 14));
+	bad = le16;
+	bad[4] = byte{0x00};
+	bad[5] = byte{0xDE};
+	CHECK(swap_all_lengths(bad, 2, false, 4));
+	bad = le32;
+	bad[21] = byte{0xDC};
+	CHECK(swap_all_lengths(bad, 4, false, 20));
+	bad = be32;
+	bad[41] = byte{0x11};
+	CHECK(swap_all_lengths(bad, 4, true, 40));
+
+	//strings
+	adv_string<UTF16LE> s16 = convert_to<UTF16LE>(sv(text));
+	adv_string<UTF16BE> b16 = swap_byte_order(adv_string_view<UTF16LE>{s16});
+	CHECK(b16 == convert_to<UTF16BE>(sv(text)) && b16.length() == s16.length());
+	adv_string<UTF32LE> l32 = swap_byte_order(adv_string_view<UTF32BE>{convert_to<UTF32BE>(sv(text))});
+	CHECK(l32 == convert_to<UTF32LE>(sv(text)));
+	//in place, the memory is reused
+	const byte *mem = s16.data();
+	adv_string<UTF16BE> moved = swap_byte_order(std::move(s16));
+	CHECK(moved.data() == mem && moved == convert_to<UTF16BE>(sv(text)) && s16.size() == 0);
+	adv_string_buf<UTF32BE> buf{};
+	buf.append_string_c(sv(text));
+	adv_string<UTF32LE> fbuf = swap_byte_order(buf);
+	CHECK(fbuf == convert_to<UTF32LE>(sv(text)));
+
+	//on error the string is restored, also the part before the invalid character
+	adv_string<UTF16LE> in16 = convert_to<UTF16LE>(sv(text));
+	std::vector<byte> raw16(in16.data(), in16.data() + in16.size());
+	byte *w16 = const_cast<byte *>(in16.data());
+	w16[25] = raw16[25] = byte{0xDC};
+	bool thrown = false;
+	try{
+		swap_byte_order(std::move(in16));
+	}
+	catch(const encoding_error &){
+		thrown = true;
+	}
+	CHECK(thrown && std::vector<byte>(in16.data(), in16.data() + in16.size()) == raw16);
+	adv_string<UTF32BE> in32 = convert_to<UTF32BE>(sv(text));
+	std::vector<byte> raw32(in32.data(), in32.data() + in32.size());
+	byte *w32 = const_cast<byte *>(in32.data());
+	w32[41] = raw32[41] = byte{0x11};
+	thrown = false;
+	try{
+		swap_byte_order(std::move(in32));
+	}
+	catch(const encoding_error &){
+		thrown = true;
+	}
+	CHECK(thrown && std::vector<byte>(in32.data(), in32.data() + in32.size()) == raw32);
+}
+
+static bool registration_fails(std::string_view name, const EncMetric<unicode> *enc){
+	try{
+		register_encoding(name, enc);
+		return false;
+	}
+	catch(const encoding_error &){
+		return true;
+	}
+}
+
+static const EncMetric<unicode> *bom_of(const char *s, size_t n, size_t &bomlen){
+	return detect_encoding("ISO-8859-1", adv_string_view<RAW<unicode>>{reinterpret_cast<const byte *>(s), n, meas::size}, bomlen);
+}
+
+static void test_registry(){
+	//aliases ignore the case of ASCII letters
+	const EncMetric<unicode> *u8 = find_encoding("UTF-8");
+	CHECK(u8 != nullptr && u8->index() == index_traits<UTF8>::index());
+	CHECK(find_encoding("utf-8") == u8 && find_encoding("Utf8") == u8 && find_encoding("CSUTF8") == u8);
+	CHECK(find_encoding("cp1252") == find_encoding("WINDOWS-1252") && find_encoding("cP1252")->index() == index_traits<Win_1252>::index());
+	CHECK(find_encoding("latin1")->index() == index_traits<Latin1>::index());
+	CHECK(find_encoding("utf-16")->index() == index_traits<UTF16BE>::index());
+
+	//unknown names
+	CHECK(find_encoding("") == nullptr);
+	CHECK(find_encoding("utf-9") == nullptr && find_encoding("UTF-8 ") == nullptr && find_encoding("UTF") == nullptr);
+	CHECK(find_encoding(std::string(max_encoding_name + 1, 'a')) == nullptr);
+
+	//registrations
+	register_encoding("x-test-utf16", DynEncoding<UTF16LE>::instance());
+	CHECK(find_encoding("X-Test-UTF16") == DynEncoding<UTF16LE>::instance());
+	CHECK(registration_fails("X-TEST-utf16", u8));
+	CHECK(registration_fails("utf-8", u8));
+	CHECK(registration_fails("", u8));
+	CHECK(registration_fails(std::string(max_encoding_name + 1, 'b'), u8));
+	CHECK(registration_fails("x-null", nullptr) && find_encoding("x-null") == nullptr);
+	std::string longest(max_encoding_name, 'c');
+	register_encoding(longest, u8);
+	CHECK(find_encoding(longest) == u8);
+
+	//BOM detection, UTF32LE before UTF16LE
+	size_t bomlen = 9;
+	CHECK(bom_of("\xFF\xFE\0\0a\0\0\0", 8, bomlen) == DynEncoding<UTF32LE>::instance() && bomlen == 4);
+	CHECK(bom_of("\0\0\xFE\xFF\0\0\0a", 8, bomlen) == DynEncoding<UTF32BE>::instance() && bomlen == 4);
+	CHECK(bom_of("\xFF\xFE" "a\0", 4, bomlen) == DynEncoding<UTF16LE>::instance() && bomlen == 2);
+	CHECK(bom_of("\xFE\xFF\0a", 4, bomlen) == DynEncoding<UTF16BE>::instance() && bomlen == 2);
+	CHECK(bom_of("\xEF\xBB\xBF" "a", 4, bomlen) == DynEncoding<UTF8>::instance() && bomlen == 3);
+	//without a BOM the name is used
+	CHECK(bom_of("\xFF\xFE\0", 3, bomlen) == DynEncoding<UTF16LE>::instance() && bomlen == 2);
+	CHECK(bom_of("ab", 2, bomlen)->index() == index_traits<Latin1>::index() && bomlen == 0);
+	bool thrown = false;
+	try{
+		detect_encoding("x-unknown", adv_string_view<RAW<unicode>>{reinterpret_cast<const byte *>("ab"), size_t{2}, meas::size}, bomlen);
+	}
+	catch(const encoding_error &){
+		thrown = true;
+	}
+	CHECK(thrown);
+}
+
+/*
+    Every byte defined by the table decodes to a character that encodes back to it, undefined
+    bytes and characters outside the codepage are rejected
+*/
+template<typename T>
+static bool codepage_round_trips(){
+	bool ok = true;
+	for(unsigned int i = 0; i < 0x100; i++){
+		byte in{static_cast<unsigned char>(i)};
+		bool defined = i < 0x80 || T::table[i - 0x80] != 0;
+		unicode c;
+		uint len;
+		if(T::validChar(&in, len) != defined || EncMetric_info<T>{}.decode_checked(&c, &in, 1, len) != defined){
+			ok = false;
+			continue;
+		}
+		if(!defined)
+			continue;
+		byte out;
+		ok = ok && c == (i < 0x80 ? i : T::table[i - 0x80]) && T::encode_checked(c, &out, 1, len) && len == 1 && out == in;
+	}
+	byte out;
+	uint len;
+	//private use characters aren't included in any of these codepages
+	return ok && !T::encode_checked(unicode{0xE000}, &out, 1, len) && !T::encode_checked(unicode{0x1F600}, &out, 1, len);
+}
+
+template<typename... T>
+static bool all_codepages_round_trip(){
+	return (codepage_round_trips<T>() && ...);
+}
+
+static void test_codepages(){
+	CHECK(codepage_round_trips<ISO_8859_2>());
+	CHECK(codepage_round_trips<ISO_8859_3>());
+	CHECK(all_codepages_round_trip<ISO_8859_4, ISO_8859_5, ISO_8859_6, ISO_8859_7, ISO_8859_8, ISO_8859_9, ISO_8859_10>());
+	CHECK(all_codepages_round_trip<ISO_8859_11, ISO_8859_13, ISO_8859_14, ISO_8859_15, ISO_8859_16>());
+	CHECK(all_codepages_round_trip<Win_874, Win_1250, Win_1251, Win_1252, Win_1253, Win_1254, Win_1255, Win_1256, Win_1257, Win_1258>());
+	CHECK(all_codepages_round_trip<KOI8_R, KOI8_U, IBM_437, IBM_850>());
+
+	//0x96 is the en dash, 0x81 isn't defined
+	CHECK(to_std(convert_to<UTF8>(sv<Win_1252>("a\x96\x80"))) == "a\xE2\x80\x93\xE2\x82\xAC");
+	CHECK(to_std(convert_to<UTF8>(convert_to<Win_1252>(sv("\xE2\x80\x93")))) == "\xE2\x80\x93");
+	CHECK(convert_to<Win_1252>(sv("\xE2\x80\x93")).data()[0] == byte{0x96});
+	CHECK(sv<Win_1252>("a\x96").verify_safe() && !sv<Win_1252>("a\x81").verify_safe());
+	size_t replaced;
+	CHECK(to_std(convert_to<UTF8>(sanitize(sv<Win_1252>("a\x81" "b"), replaced))) == "a?b" && replaced == 1);
+	CHECK(to_std(convert_to<UTF8>(sanitize(sv<ISO_8859_3>("\xA5"), replaced))) == "?" && replaced == 1);
+	//the registry finds the generated codepages
+	CHECK(find_encoding("windows-1252")->index() == index_traits<Win_1252>::index());
+	CHECK(find_encoding("koi8-r")->index() == index_traits<KOI8_R>::index());
+}
+
+/*
+    Every valid two byte character decodes to a character that reencodes (possibly with another
+    byte sequence) to the same character
+*/
+template<typename T>
+size_t cjk_round_trips(){
+	size_t nvalid = 0;
+	for(uint a = 0x81; a <= 0xfe; a++){
+		for(uint b = 0x40; b <= 0xfe; b++){
+			byte in[2]{byte{static_cast<unsigned char>(a)}, byte{static_cast<unsigned char>(b)}};
+			unicode c;
+			uint len;
+			if(!T::decode_checked(&c, in, 2, len) || len != 2)
+				continue;
+			nvalid++;
+			byte out[4];
+			uint olen;
+			unicode d;
+			uint dlen;
+			if(!T::encode_checked(c, out, 4, olen) || !T::decode_checked(&d, out, olen, dlen) || d != c || dlen != olen){
+				failures++;
+				std::cerr << "round trip failed for " << std::hex << a << b << std::dec << std::endl;
+				return nvalid;
+			}
+		}
+	}
+	return nvalid;
+}
+
+/*
+    Checks that the whole byte sequence s is accepted by every validation path
+*/
+template<typename T>
+bool cjk_accepted(const char *s, size_t n){
+	adv_string_view<T> v = sv<T>(s, n);
+	size_t replaced = 1;
+	adv_string<T> san = sanitize(v, replaced);
+	unicode c;
+	uint len;
+	return v.verify_safe() && replaced == 0 && san.size() == n && T::decode_checked(&c, v.data(), n, len) && len == n;
+}
+
+static void test_cjk(){
+	CHECK(cjk_round_trips<Shift_JIS>() > 6000);
+	CHECK(cjk_round_trips<EUC_JP>() > 6000);
+	CHECK(cjk_round_trips<EUC_KR>() > 8000);
+	CHECK(cjk_round_trips<Big5>() > 13000);
+	CHECK(cjk_round_trips<GBK>() > 20000);
+	CHECK(cjk_round_trips<GB18030>() > 20000);
+
+	//characters with more than one encoding
+	CHECK(cjk_accepted<Big5>("\xA2\xCC", 2));
+	CHECK(cjk_accepted<Big5>("\xA2\xCE", 2));
+	CHECK(cjk_accepted<Big5>("\xA1\xFE", 2));
+	CHECK(cjk_accepted<Big5>("\xA2\x40", 2));
+	CHECK(cjk_accepted<EUC_JP>("\x8F\xA2\xB7", 3));
+	CHECK(to_std(convert_to<UTF8>(sv<Big5>("\xA2\xCC"))) == to_std(convert_to<UTF8>(sv<Big5>("\xA4\x51"))));
+
+	adv_string_view<UTF8> text = sv("ab\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E" "c");
+	CHECK(to_std(convert_to<UTF8>(convert_to<Shift_JIS>(text))) == to_std(text));
+	CHECK(to_std(convert_to<UTF8>(convert_to<EUC_JP>(text))) == to_std(text));
+	CHECK(to_std(convert_to<UTF8>(convert_to<GB18030>(text))) == to_std(text));
+	CHECK(to_std(convert_to<UTF8>(convert_to<Big5>(text))) == to_std(text));
+	CHECK(convert_to<Shift_JIS>(text).size() == 9);
+
+	//GB18030: odd length ASCII, two and four byte characters
+	CHECK(sv<GB18030>("abc").verify_safe());
+	CHECK(to_std(convert_to<UTF8>(sv<GB18030>("abc"))) == "abc");
+	CHECK(to_std(convert_to<UTF8>(sv<GB18030>("\xB0\xA1" "a"))) == "\xE5\x95\x8A" "a");
+	CHECK(to_std(convert_to<UTF8>(sv<GB18030>("\x81\x30\x81\x30"))) == "\xC2\x80");
+	CHECK(to_std(convert_to<UTF8>(sv<GB18030>("\x90\x30\x81\x30"))) == "\xF0\x90\x80\x80");
+	CHECK(to_std(convert_to<UTF8>(convert_to<GB18030>(sv("\xF0\x9F\x98\x80")))) == "\xF0\x9F\x98\x80");
+	byte lead{0x81};
+	CHECK(GB18030::chLen(reinterpret_cast<const byte *>("\xE5\x30")) == 2);
+
+	//maximal invalid subsequences
+	unicode c;
+	uint len = 0;
+	CHECK(!GB18030::decode_checked(&c, &lead, 1, len) && len == 1);
+	CHECK(!GB18030::decode_checked(&c, reinterpret_cast<const byte *>("\x81 "), 2, len) && len == 1);
+	CHECK(!GB18030::decode_checked(&c, reinterpret_cast<const byte *>("\x81\x30\x81"), 3, len) && len == 3);
+	CHECK(!EUC_JP::decode_checked(&c, reinterpret_cast<const byte *>("\x8F\xA2"), 2, len) && len == 2);
+	CHECK(!Shift_JIS::decode_checked(&c, reinterpret_cast<const byte *>("\x80"), 1, len) && len == 1);
+
+	//truncated data: the byte after a trailing lead is never read
+	std::unique_ptr<byte[]> trunc{new byte[3]{byte{'a'}, byte{'b'}, byte{0x81}}};
+	adv_string_view<GB18030> tv{const_tchar_pt<GB18030>{trunc.get()}, 3, meas::size};
+	CHECK(tv.size() == 2 && tv.length() == 2);
+	const_tchar_pt<GB18030> tp{trunc.get() + 2};
+	size_t trem = 1;
+	CHECK(!tp.valid_next(trem));
+	CHECK(EncMetric_info<GB18030>{}.chLen(trunc.get() + 2, 1) > 1);
+	size_t replaced;
+	CHECK(to_std(convert_to<UTF8>(sanitize(trunc.get(), 3, replaced, EncMetric_info<GB18030>{}))) == "ab\xEF\xBF\xBD" && replaced == 1);
+	//U+FFFD isn't included in Big5
+	CHECK(to_std(convert_to<UTF8>(sanitize(sv<Big5>("a\xA2 b"), replaced))) == "a? b" && replaced == 1);
+}
+
+/*
+    Streams src through a converter, cutting the input at the given positions and writing at most
+    cap bytes per call
+*/
+static std::string c_stream(const char *from, const char *to, const std::string &src, const std::vector<size_t> &cuts, size_t cap, encmetric_status &last){
+	encmetric_converter *conv = encmetric_converter_new(encmetric_find(from), encmetric_find(to));
+	std::string ret;
+	std::vector<char> out(cap);
+	size_t beg = 0;
+	last = ENCMETRIC_OK;
+	for(size_t i = 0; i <= cuts.size() && last == ENCMETRIC_OK; i++){
+		size_t end = i < cuts.size() ? cuts[i] : src.size();
+		int flush = i == cuts.size();
+		while(true){
+			size_t rd, wr;
+			last = encmetric_converter_run(conv, src.data() + beg, end - beg, out.data(), cap, &rd, &wr, flush);
+			ret.append(out.data(), wr);
+			beg += rd;
+			if(last != ENCMETRIC_OUTPUT_FULL || (rd == 0 && wr == 0))
+				break;
+		}
+	}
+	encmetric_converter_free(conv);
+	return ret;
+}
+
+static void test_c_api(){
+	const encmetric_encoding *utf8 = encmetric_find("UTF-8");
+	const encmetric_encoding *utf16 = encmetric_find("UTF-16LE");
+	CHECK(utf8 != nullptr && utf16 != nullptr);
+	CHECK(encmetric_find("no such encoding") == nullptr);
+
+	std::string text = "a\xC3\xA8" "b\xE2\x82\xAC\xF0\x9F\x98\x80z";
+	size_t rd, wr, nchr;
+	CHECK(encmetric_count(utf8, text.data(), text.size(), &rd, &nchr) == ENCMETRIC_OK && rd == text.size() && nchr == 6);
+	CHECK(encmetric_validate(utf8, text.data(), 5, &rd) == ENCMETRIC_INCOMPLETE && rd == 4);
+	CHECK(encmetric_validate(utf8, "ab\xFF" "c", 4, &rd) == ENCMETRIC_INVALID && rd == 2);
+	CHECK(encmetric_validate(utf8, "a\xE2" "b", 3, &rd) == ENCMETRIC_INVALID && rd == 1);
+	CHECK(encmetric_validate(utf16, "a\0\x3D\xD8\x00", 5, &rd) == ENCMETRIC_INCOMPLETE && rd == 2);
+	CHECK(encmetric_validate(encmetric_find("GB18030"), "a\x81\x30\x81", 4, &rd) == ENCMETRIC_INCOMPLETE && rd == 1);
+	CHECK(encmetric_validate(encmetric_find("GB18030"), "a\x81 ", 3, &rd) == ENCMETRIC_INVALID && rd == 1);
+	CHECK(encmetric_validate(encmetric_find("Big5"), "\xA2\xCC\xA1\xFE", 4, &rd) == ENCMETRIC_OK && rd == 4);
+
+	adv_string<UTF16LE> expect16 = convert_to<UTF16LE>(sv(text.c_str()));
+	std::string expect(reinterpret_cast<const char *>(expect16.data()), expect16.size());
+	char out[64];
+	CHECK(encmetric_convert(utf8, text.data(), text.size(), utf16, out, sizeof(out), &rd, &wr) == ENCMETRIC_OK);
+	CHECK(rd == text.size() && std::string(out, wr) == expect);
+	//only whole characters are written
+	CHECK(encmetric_convert(utf8, text.data(), text.size(), utf16, out, 9, &rd, &wr) == ENCMETRIC_OUTPUT_FULL && rd == 7 && wr == 8);
+
+	encmetric_status st;
+	//every split of the input, characters split between calls are kept by the converter
+	for(size_t i = 0; i <= text.size(); i++){
+		for(size_t j = i; j <= text.size(); j++){
+			if(c_stream("UTF-8", "UTF-16LE", text, {i, j}, 64, st) != expect || st != ENCMETRIC_OK){
+				failures++;
+				std::cerr << "streaming conversion failed splitting at " << i << " and " << j << std::endl;
+			}
+		}
+	}
+	std::vector<size_t> bytes;
+	for(size_t i = 1; i < expect.size(); i++)
+		bytes.push_back(i);
+	CHECK(c_stream("UTF-16LE", "UTF-8", expect, bytes, 4, st) == text && st == ENCMETRIC_OK);
+	CHECK(c_stream("UTF-8", "UTF-8", text, {3, 5}, 4, st) == text && st == ENCMETRIC_OK);
+	CHECK(c_stream("UTF-8", "Shift_JIS", "\xE6\x97\xA5\xE6\x9C\xAC", {1, 4}, 64, st) == "\x93\xFA\x96\x7B" && st == ENCMETRIC_OK);
+
+	//truncated character at the end of the stream
+	CHECK(c_stream("UTF-8", "UTF-16LE", "ab\xE2\x82", {3}, 64, st) == std::string("a\0b\0", 4) && st == ENCMETRIC_INCOMPLETE);
+	//invalid sequence started in the previous call
+	CHECK(c_stream("UTF-8", "UTF-16LE", "a\xE2" "b", {2}, 64, st) == std::string("a\0", 2) && st == ENCMETRIC_INVALID);
+	CHECK(c_stream("UTF-8", "UTF-16LE", "a\xFF" "b", {}, 64, st) == std::string("a\0", 2) && st == ENCMETRIC_INVALID);
+	CHECK(c_stream("UTF-8", "Latin1", "a\xE2\x82\xAC", {2}, 64, st) == "a" && st == ENCMETRIC_UNMAPPABLE);
+}
+
+#define FMT_CHECK(expected, ...) do{ \
+		adv_string_buf<UTF8> fbuf{}; \
+		format_to(fbuf, __VA_ARGS__); \
+		CHECK(to_std(fbuf.allocate<std::allocator<byte>>()) == expected); \
+	}while(false)
+
+static void test_format(){
+	FMT_CHECK("x=    42 y=0xff s=*h\xC3\xA9llo* f=3.142 u=\xC3\xBC", ENCMETRIC_FORMAT("x={:>6} y={:#x} s={:*^7} f={:.3f} u={}"), 42, 255, "h\xC3\xA9llo", 3.14159, U'\u00FC');
+	//width, fill and alignment (widths are in characters)
+	FMT_CHECK("ab   |   ab| ab  |", ENCMETRIC_FORMAT("{:<5}|{:>5}|{:^5}|"), "ab", "ab", "ab");
+	FMT_CHECK("\xC3\xA9\xC3\xA9\xC3\xA9" "1|7__", ENCMETRIC_FORMAT("{:\xC3\xA9>4}|{:_<3}"), 1, 7);
+	FMT_CHECK("-0042|   -42|+5| 5", ENCMETRIC_FORMAT("{:05}|{:6}|{:+}|{: }"), -42, -42, 5, 5);
+	//integer types
+	FMT_CHECK("ff FF 0XFF 101 0b101 17 -0x10", ENCMETRIC_FORMAT("{:x} {:X} {:#X} {:b} {:#b} {:o} {:#x}"), 255, 255, 255, 5, 5, 15, -16);
+	//precision
+	FMT_CHECK("3.14 2.50e+00 0.1 1e+20 3.000000", ENCMETRIC_FORMAT("{:.2f} {:.2e} {} {} {:f}"), 3.14159, 2.5, 0.1, 1e20, 3.0);
+	FMT_CHECK("  3.1", ENCMETRIC_FORMAT("{:5.1f}"), 3.14159);
+	//strings, characters, booleans, indexes and braces
+	std::string str = "std";
+	adv_string<UTF16LE> w16 = convert_to<UTF16LE>(sv("\xE2\x82\xAC" "16"));
+	FMT_CHECK("std|view|\xE2\x82\xAC" "16|c|\xF0\x9F\x98\x80|true", ENCMETRIC_FORMAT("{}|{}|{}|{}|{}|{}"), str, std::string_view{"view"}, w16, 'c', unicode{0x1F600}, true);
+	FMT_CHECK("b a {b}", ENCMETRIC_FORMAT("{1} {0} {{{1}}}"), "a", "b");
+	FMT_CHECK("[   \xE2\x82\xAC" "16]", ENCMETRIC_FORMAT("[{:>6}]"), w16);
+
+	//output into a UTF16LE buffer
+	adv_string_buf<UTF16LE> b16{};
+	size_t n = format_to(b16, ENCMETRIC_FORMAT("x={:>6} y={:#x} s={:*^7} f={:.3f} u={}"), 42, 255, "h\xC3\xA9llo", 3.14159, U'\u00FC');
+	adv_string<UTF16LE> r16 = b16.allocate<std::allocator<byte>>();
+	CHECK(to_std(convert_to<UTF8>(r16)) == "x=    42 y=0xff s=*h\xC3\xA9llo* f=3.142 u=\xC3\xBC");
+	CHECK(n == r16.size() && r16.length() == 37);
+	//appends to the previous content
+	b16.clear();
+	format_to(b16, ENCMETRIC_FORMAT("+"));
+	format_to(b16, ENCMETRIC_FORMAT("{}"), w16);
+	format_to(b16, ENCMETRIC_FORMAT("-{:03}"), 7);
+	CHECK(to_std(convert_to<UTF8>(b16.allocate<std::allocator<byte>>())) == "+\xE2\x82\xAC" "16-007");
+}
+
+static void test_charconv(){
+	uint pos = 9;
+	CHECK(ascii_widened(EncMetric_info<UTF16LE>{}, pos) && pos == 0);
+	CHECK(ascii_widened(EncMetric_info<UTF16BE>{}, pos) && pos == 1);
+	CHECK(ascii_widened(EncMetric_info<UTF32BE>{}, pos) && pos == 3);
+	CHECK(!ascii_widened(EncMetric_info<UTF8>{}, pos));
+
+	//partial parses, the digits are followed by other characters
+	adv_string<UTF16LE> i16 = convert_to<UTF16LE>(sv("-123456789012\xF0\x9F\x98\x80"));
+	long long v = 0;
+	adv_from_chars_result<UTF16LE> r16 = from_chars(i16, v);
+	CHECK(r16.ec == std::errc{} && v == -123456789012 && r16.ptr.data() == i16.data() + 26);
+	adv_string<UTF16BE> h16 = convert_to<UTF16BE>(sv("fF7g"));
+	int h = 0;
+	CHECK(from_chars(h16, h, 16).ptr.data() == h16.data() + 6 && h == 0xff7);
+	adv_string<UTF32LE> f32 = convert_to<UTF32LE>(sv("2.5e3 rest"));
+	double d = 0;
+	adv_from_chars_result<UTF32LE> r32 = from_chars(f32, d);
+	CHECK(r32.ec == std::errc{} && d == 2500.0 && r32.ptr.data() == f32.data() + 20);
+	adv_string<UTF32BE> l32 = convert_to<UTF32BE>(sv("12345678901234567"));
+	CHECK(from_chars(l32, v).ptr.data() == l32.data() + l32.size() && v == 12345678901234567);
+
+	//errors: the value is left unchanged
+	int i = 7;
+	adv_string<UTF16LE> bad = convert_to<UTF16LE>(sv("x1"));
+	adv_from_chars_result<UTF16LE> rb = from_chars(bad, i);
+	CHECK(rb.ec == std::errc::invalid_argument && rb.ptr.data() == bad.data() && i == 7);
+	adv_string<UTF32LE> big = convert_to<UTF32LE>(sv("99999999999;"));
+	adv_from_chars_result<UTF32LE> ro = from_chars(big, i);
+	CHECK(ro.ec == std::errc::result_out_of_range && ro.ptr.data() == big.data() + 44 && i == 7);
+	CHECK(from_chars(bad.begin(), 0, i).ec == std::errc::invalid_argument && i == 7);
+
+	adv_string_buf<UTF16LE> b16{};
+	CHECK(to_chars(b16, -255, 16) == 6);
+	b16.append_ascii(" ", 1);
+	to_chars(b16, 0.125);
+	CHECK(to_std(convert_to<UTF8>(b16.allocate<std::allocator<byte>>())) == "-ff 0.125");
+	adv_string_buf<UTF32BE> b32{};
+	to_chars(b32, 1e21, std::chars_format::scientific, 2);
+	adv_string<UTF32BE> s32 = b32.allocate<std::allocator<byte>>();
+	CHECK(to_std(convert_to<UTF8>(s32)) == "1.00e+21");
+	CHECK(from_chars(s32, d).ec == std::errc{} && d == 1e21);
+}
+
+static std::string json_esc(const std::string &str, bool ascii_only = false){
+	adv_string_buf<UTF8> buf{};
+	return to_std(json_escape(sv(str.data(), str.size()), buf, ascii_only));
+}
+
+static std::string json_unesc(const std::string &str){
+	adv_string_buf<UTF8> buf{};
+	return to_std(json_unescape(sv(str.data(), str.size()), buf));
+}
+
+static bool json_rejected(const std::string &str){
+	try{
+		json_unesc(str);
+		return false;
+	}
+	catch(const incorrect_encoding &){
+		return true;
+	}
+}
+
+static void test_json(){
+	adv_string_view<UTF8> plain = sv("nothing to escape here, even \xC3\xA8");
+	adv_string_buf<UTF8> buf{};
+	CHECK(!json_needs_escape(plain));
+	CHECK(json_needs_escape(plain, true));
+	CHECK(json_escape(plain, buf).data() == plain.data());
+	CHECK(json_unescape(plain, buf).data() == plain.data());
+
+	CHECK(json_esc("a\"b\\c\nd\te\x01/") == "a\\\"b\\\\c\\nd\\te\\u0001/");
+	CHECK(json_esc("\b\f\r\x1F\x7F") == "\\b\\f\\r\\u001f\x7F");
+	CHECK(json_esc("\xC3\xA8\xF0\x9F\x98\x80", true) == "\\u00e8\\ud83d\\ude00");
+	//special characters in every position of the 8 byte blocks
+	std::string pad(19, 'x');
+	for(size_t i = 0; i < pad.size(); i++){
+		std::string in = pad.substr(0, i) + "\"" + pad.substr(i);
+		CHECK(json_esc(in) == pad.substr(0, i) + "\\\"" + pad.substr(i));
+		CHECK(json_unesc(json_esc(in)) == in);
+	}
+
+	CHECK(json_unesc("a\\\"b\\\\c\\/d\\n\\u00E8\\u00e8") == "a\"b\\c/d\n\xC3\xA8\xC3\xA8");
+	CHECK(json_unesc("\\ud83d\\ude00!") == "\xF0\x9F\x98\x80!");
+	CHECK(json_rejected("\\x"));
+	CHECK(json_rejected("abc\\u12"));
+	CHECK(json_rejected("abc\\"));
+	CHECK(json_rejected("\\ud83d"));
+	CHECK(json_rejected("\\ud83dx"));
+	CHECK(json_rejected("\\ude00\\ud83d"));
+	CHECK(json_rejected("\\u12G4"));
+
+	std::string all;
+	for(int c = 1; c < 0x80; c++)
+		all.push_back(static_cast<char>(c));
+	all += "\xC3\xA8\xE2\x82\xAC\xF0\x9F\x98\x80";
+	CHECK(json_unesc(json_esc(all)) == all);
+	CHECK(json_unesc(json_esc(all, true)) == all);
+
+	//conversion between encodings
+	adv_string<UTF16LE> in16 = convert_to<UTF16LE>(sv("say \"\xE2\x82\xAC\"\n"));
+	adv_string_buf<UTF8> out8{};
+	json_escape_append(in16, out8);
+	CHECK(to_std(out8.allocate<std::allocator<byte>>()) == "say \\\"\xE2\x82\xAC\\\"\\n");
+	adv_string<UTF16LE> esc16 = convert_to<UTF16LE>(sv("\\u20AC\\t\\ud83d\\ude00"));
+	adv_string_buf<UTF16LE> buf16{};
+	adv_string_view<UTF16LE> un16 = json_unescape(esc16, buf16);
+	CHECK(to_std(convert_to<UTF8>(un16)) == "\xE2\x82\xAC\t\xF0\x9F\x98\x80");
+	CHECK(json_needs_unescape(esc16) && json_needs_escape(un16));
+}
+
+static const byte *bytes_of(const std::string &s){
+	return reinterpret_cast<const byte *>(s.data());
+}
+
+/*
+    Runs a codec function with an output buffer of outsiz bytes, thrown is set if it throws
+*/
+template<typename F>
+static std::string codec_run(const std::string &in, size_t outsiz, F fun, bool &thrown){
+	std::string out(outsiz + 8, '\0');
+	thrown = false;
+	try{
+		out.resize(fun(bytes_of(in), reinterpret_cast<byte *>(&out[0]), in.size()));
+	}
+	catch(const encoding_error &){
+		thrown = true;
+		out.clear();
+	}
+	return out;
+}
+
+static void test_codecs(){
+	const char *plain[] = {"", "f", "fo", "foo", "foob", "fooba", "foobar"};
+	const char *b32[] = {"", "MY======", "MZXQ====", "MZXW6===", "MZXW6YQ=", "MZXW6YTB", "MZXW6YTBOI======"};
+	bool th;
+	for(int i = 0; i < 7; i++){
+		std::string p = plain[i];
+		std::string enc = codec_run(p, base32_encoded_size(p.size()), [](auto f, auto t, size_t n){return base32_encode(f, t, n);}, th);
+		CHECK(enc == b32[i] && base32_encoded_size(p.size()) == enc.size());
+		CHECK(codec_run(enc, p.size(), base32_decode, th) == p && base32_decoded_size(bytes_of(enc), enc.size()) == p.size());
+		//without padding
+		std::string nopad = enc.substr(0, enc.find('='));
+		CHECK(codec_run(p, enc.size(), [](auto f, auto t, size_t n){return base32_encode(f, t, n, false);}, th) == nopad);
+		CHECK(codec_run(nopad, p.size(), base32_decode, th) == p);
+		std::string hex = codec_run(p, 2 * p.size(), base16_encode, th);
+		CHECK(hex.size() == 2 * p.size() && codec_run(hex, p.size(), base16_decode, th) == p);
+	}
+	CHECK(codec_run("foobar", 12, base16_encode, th) == "666F6F626172");
+	CHECK(codec_run("666f6F626172", 6, base16_decode, th) == "foobar");
+	CHECK(codec_run("mzxw6ytboi======", 6, base32_decode, th) == "foobar");
+	codec_run("66G6", 2, base16_decode, th);
+	CHECK(th);
+	codec_run("666", 2, base16_decode, th);
+	CHECK(th);
+	codec_run("MZXW6YT1", 5, base32_decode, th);
+	CHECK(th);
+
+	//every byte value, long enough for the 8 byte loops
+	std::string all;
+	for(int c = 0; c < 256; c++)
+		all.push_back(static_cast<char>(c));
+	std::string hex = codec_run(all, 512, base16_encode, th);
+	CHECK(codec_run(hex, 256, base16_decode, th) == all);
+	std::string enc32 = codec_run(all, base32_encoded_size(256), [](auto f, auto t, size_t n){return base32_encode(f, t, n);}, th);
+	CHECK(codec_run(enc32, 256, base32_decode, th) == all);
+	std::string pct = codec_run(all, 3 * 256, [](auto f, auto t, size_t n){return percent_encode(f, t, n);}, th);
+	CHECK(pct.size() == percent_encoded_size(bytes_of(all), 256) && codec_run(pct, 256, percent_decode, th) == all);
+
+	std::string url = "a b&c/d?e:\xC3\xA9~";
+	auto pencode = [&](percent_set set){
+		return codec_run(url, 3 * url.size(), [set](auto f, auto t, size_t n){return percent_encode(f, t, n, set);}, th);
+	};
+	CHECK(pencode(percent_set::component) == "a%20b%26c%2Fd%3Fe%3A%C3%A9~");
+	CHECK(pencode(percent_set::path) == "a%20b&c/d%3Fe:%C3%A9~");
+	CHECK(pencode(percent_set::query) == "a%20b&c/d?e:%C3%A9~");
+	//caller supplied masks
+	auto mencode = [&](const std::string &str, const percent_mask &mask){
+		std::string ret = codec_run(str, 3 * str.size(), [&mask](auto f, auto t, size_t n){return percent_encode(f, t, n, mask);}, th);
+		CHECK(ret.size() == percent_encoded_size(bytes_of(str), str.size(), mask));
+		return ret;
+	};
+	percent_mask form = percent_mask{percent_set::component}.add("*&").remove(byte{'~'});
+	CHECK(mencode(url, form) == "a%20b&c%2Fd%3Fe%3A%C3%A9%7E" && percent_keep(byte{'*'}, form) && !percent_keep(byte{'~'}, form));
+	CHECK(mencode(url, percent_mask{percent_set::uri}) == pencode(percent_set::uri));
+	//the predefined masks are plain masks, letters and digits
+	constexpr percent_mask alnum{0x03FF000000000000ULL, 0x07FFFFFE07FFFFFEULL, 0, 0};
+	static_assert(alnum.keeps_alnum() && alnum.contains(byte{'z'}) && !alnum.contains(byte{'-'}));
+	CHECK(mencode(all, percent_mask{alnum}.add("-._~")) == pct);
+	//without some letters the words of letters are encoded a byte at a time
+	percent_mask no_e = percent_mask{alnum}.remove(byte{'e'});
+	CHECK(!no_e.keeps_alnum() && mencode("abcdefghABCDEFGH12345678", no_e) == "abcd%65fghABCDEFGH12345678");
+	CHECK(mencode("abcdefgh", percent_mask{}) == "%61%62%63%64%65%66%67%68");
+	std::string high = mencode("\x80\xFF\xC3\xA9 ", percent_mask{}.add(byte{0xFF}).add(byte{0xC3}));
+	CHECK(high == "%80\xFF\xC3%A9%20" && codec_run(mencode("x y", percent_mask{}), 3, percent_decode, th) == "x y");
+	CHECK(codec_run("a%20b%c3%A9", 5, percent_decode, th) == "a b\xC3\xA9" && percent_decoded_size(bytes_of(std::string{"a%20b"}), 5) == 3);
+	codec_run("a%2", 3, percent_decode, th);
+	CHECK(th);
+	codec_run("a%G0", 3, percent_decode, th);
+	CHECK(th);
+
+	//streaming codecs with the input split at every position
+	for(size_t i = 0; i <= enc32.size(); i += 3){
+		std::string out(256 + 16, '\0');
+		base32_decoder dec;
+		size_t n = dec.update(bytes_of(enc32), i, reinterpret_cast<byte *>(&out[0]));
+		n += dec.update(bytes_of(enc32) + i, enc32.size() - i, reinterpret_cast<byte *>(&out[n]));
+		n += dec.finish(reinterpret_cast<byte *>(&out[n]));
+		out.resize(n);
+		CHECK(out == all);
+
+		base32_encoder en;
+		std::string e(base32_encoded_size(256) + 16, '\0');
+		size_t m = en.update(bytes_of(all), i % 257, reinterpret_cast<byte *>(&e[0]));
+		m += en.update(bytes_of(all) + i % 257, 256 - i % 257, reinterpret_cast<byte *>(&e[m]));
+		m += en.finish(reinterpret_cast<byte *>(&e[m]));
+		e.resize(m);
+		CHECK(e == enc32);
+	}
+	for(size_t i = 0; i <= hex.size(); i += 7){
+		std::string out(256 + 2, '\0');
+		base16_decoder dec;
+		size_t n = dec.update(bytes_of(hex), i, reinterpret_cast<byte *>(&out[0]));
+		n += dec.update(bytes_of(hex) + i, hex.size() - i, reinterpret_cast<byte *>(&out[n]));
+		dec.finish();
+		out.resize(n);
+		CHECK(out == all);
+	}
+	for(size_t i = 0; i <= pct.size(); i += 5){
+		std::string out(256, '\0');
+		percent_decoder dec;
+		size_t n = dec.update(bytes_of(pct), i, reinterpret_cast<byte *>(&out[0]));
+		n += dec.update(bytes_of(pct) + i, pct.size() - i, reinterpret_cast<byte *>(&out[n]));
+		dec.finish();
+		out.resize(n);
+		CHECK(out == all);
+	}
+	base16_decoder odd;
+	byte tmp[4];
+	odd.update(bytes_of(std::string{"666"}), 3, tmp);
+	bool left = false;
+	try{
+		odd.finish();
+	}
+	catch(const encoding_error &){
+		left = true;
+	}
+	CHECK(left);
+
+	//codecs as encodings
+	adv_string_view<Base16> h16{"666F6F", size_t{6}, meas::size};
+	CHECK(h16.length() == 3 && h16.verify_safe());
+	CHECK(!adv_string_view<Base16>("66G6", size_t{4}, meas::size).verify_safe());
+	adv_string_view<PercentComponent> pc{"a%20b", size_t{5}, meas::size};
+	CHECK(pc.length() == 3 && pc.verify_safe());
+}
+
+static void test_shared_string(){
+	adv_string_view<UTF8> hello = sv("hello \xC3\xA8");
+	adv_shared_string<UTF8> a{hello};
+	CHECK(a == hello && a.length() == 7 && a.data() != hello.data());
+	CHECK(a.use_count() == 1 && a.unique());
+
+	adv_shared_string<UTF8> b{a};
+	CHECK(b.data() == a.data() && a.use_count() == 2 && !b.unique());
+	adv_shared_string<UTF8> sub = a.substring(6);
+	CHECK(sub == sv("\xC3\xA8") && sub.data() == a.data() + 6 && a.use_count() == 3);
+
+	//the moved-from string is left empty
+	adv_shared_string<UTF8> c{std::move(b)};
+	CHECK(c.data() == a.data() && a.use_count() == 3);
+	CHECK(b.size() == 0 && b.length() == 0 && b.data() == nullptr && b.use_count() == 0);
+	b.append(sv("x"));
+	CHECK(b == sv("x") && b.unique());
+	adv_shared_string<UTF8> d{sv("other")};
+	d = std::move(c);
+	CHECK(d.data() == a.data() && a.use_count() == 3);
+	CHECK(c.size() == 0 && c.length() == 0 && c.data() == nullptr && c.use_count() == 0);
+	d = d;
+	CHECK(d == hello && a.use_count() == 3);
+	c = a;
+	CHECK(c.data() == a.data() && a.use_count() == 4);
+
+	//copy on write
+	c.append(sv(" world"));
+	CHECK(c == sv("hello \xC3\xA8 world") && a == hello && c.unique() && a.use_count() == 3);
+	c.reserve(100);
+	CHECK(c.capacity() >= 100);
+	const byte *old = c.data();
+	c.append(sv("!"));
+	CHECK(c.data() == old && c.length() == 14);
+	byte *m = d.mutable_data();
+	CHECK(m != a.data() && d.unique() && a.use_count() == 2);
+	m[0] = byte{'j'};
+	CHECK(d == sv("jello \xC3\xA8") && a == hello);
+	sub.unshare();
+	CHECK(sub.unique() && a.unique() && sub == sv("\xC3\xA8"));
+	a.clear();
+	CHECK(a.size() == 0 && a.use_count() == 1);
+
+	adv_shared_string<UTF16LE> w{convert_to<UTF16LE>(sv("abc"))};
+	adv_shared_string<UTF16LE> w2{std::move(w)};
+	CHECK(w2.length() == 3 && w.length() == 0 && w.data() == nullptr);
+}
+
+static void test_static_string(){
+	adv_static_string<UTF8, 8> a;
+	CHECK(a.empty() && a.capacity() == 8 && a.length() == 0);
+	CHECK(a.append_string(sv("h\xC3\xA8llo")));
+	CHECK(a == sv("h\xC3\xA8llo") && a.size() == 6 && a.length() == 5);
+	//nothing is added if the result doesn't fit
+	CHECK(!a.append_string(sv("abc")));
+	CHECK(!a.append_chr(const_tchar_pt<UTF8>{"\xE2\x82\xAC"}));
+	CHECK(a.size() == 6 && a.length() == 5);
+	CHECK(a.append_chrs(const_tchar_pt<UTF8>{"\xC3\xA8z"}, 1));
+	CHECK(a == sv("h\xC3\xA8llo\xC3\xA8") && a.length() == 6);
+	unicode u[]{unicode{'a'}};
+	CHECK(!a.append_ctypes(u, 1) && a.size() == 8);
+
+	bool big = false;
+	try{
+		adv_static_string<UTF8, 8> b{sv("123456789")};
+	}
+	catch(const buffer_big &){
+		big = true;
+	}
+	CHECK(big);
+
+	//copies are plain byte copies
+	adv_static_string<UTF8, 8> c;
+	std::memcpy(static_cast<void *>(&c), &a, sizeof(a));
+	CHECK(c == a && c.view() == a.view() && c.data() != a.data());
+	adv_static_string<UTF8, 16> d{sv("h\xC3\xA8llo\xC3\xA8")};
+	CHECK(d == a && !(d != a) && d.compare(sv("h\xC3\xA8llo")) > 0);
+	d.clear();
+	CHECK(d.empty() && d != a);
+
+	//conversions
+	adv_static_string<UTF16LE, 16> w;
+	CHECK(w.append_string_c(sv("ab\xF0\x9F\x98\x80")));
+	CHECK(w.size() == 8 && w.length() == 3 && to_std(convert_to<UTF8>(w.view())) == "ab\xF0\x9F\x98\x80");
+	CHECK(!w.append_string_c(sv("abcde")));
+	CHECK(w.size() == 8 && w.length() == 3);
+	CHECK(w.append_string_c(sv("abcd")) && w.size() == 16);
+	adv_static_string<ISO_8859_1, 4> l;
+	conv_policy pol{unmappable_policy::replace};
+	CHECK(l.append_string_c(sv("a\xE2\x82\xAC"), pol) && l == sv<ISO_8859_1>("a?") && pol.unmapped == 1);
+}
+
+#ifndef _WIN32
+/*
+    Reads with an async_reader all the characters written in a pipe with the given chunks, every
+    chunk is written only after the previous read completed
+*/
+static std::string async_read_chunks(bool try_uring, const std::vector<std::string> &chunks, size_t nchr, size_t &nerr, size_t bufsiz = 2){
+	std::string ret;
+	nerr = 0;
+	int fds[2];
+	if(pipe(fds) != 0)
+		return ret;
+	io_loop loop{try_uring};
+	async_reader<UTF8> rd{loop, fds[0], bufsiz};
+	size_t next = 0;
+	std::function<void(std::exception_ptr, const adv_string_view<UTF8> &)> on_read;
+	on_read = [&](std::exception_ptr e, const adv_string_view<UTF8> &str){
+		if(e){
+			nerr++;
+			return;
+		}
+		if(str.size() == 0)
+			return;
+		ret += to_std(str);
+		if(next < chunks.size()){
+			if(write(fds[1], chunks[next].data(), chunks[next].size()) < 0)
+				return;
+			if(++next == chunks.size())
+				close(fds[1]);
+		}
+		rd.read_chars(nchr, on_read);
+	};
+	if(write(fds[1], chunks[0].data(), chunks[0].size()) >= 0){
+		next = 1;
+		if(chunks.size() == 1)
+			close(fds[1]);
+		rd.read_chars(nchr, on_read);
+		loop.run();
+	}
+	if(next < chunks.size())
+		close(fds[1]);
+	close(fds[0]);
+	return ret;
+}
+
+/*
+    Writes str in a pipe with an async_writer while an async_reader reads it on the same loop
+*/
+static std::string async_pipe(bool try_uring, const std::string &str, bool registered, bool nonblocking = false){
+	std::string ret;
+	int fds[2];
+	if(pipe(fds) != 0)
+		return ret;
+	if(nonblocking){
+		raw_fd_set_nonblocking(fds[0]);
+		raw_fd_set_nonblocking(fds[1]);
+	}
+	io_loop loop{try_uring};
+	std::vector<byte> mem(str.size());
+	std::memcpy(mem.data(), str.data(), str.size());
+	if(registered)
+		CHECK(loop.register_buffer(mem.data(), mem.size()) == loop.direct_io());
+	{
+		async_reader<UTF16LE> rd{loop, fds[0], 64};
+		async_writer<UTF16LE> wr{loop, fds[1]};
+		CHECK(rd.fixed_buffer() == loop.direct_io());
+		bool written = false;
+		wr.write_view(adv_string_view<UTF16LE>{mem.data(), mem.size(), meas::size}, [&](std::exception_ptr e){
+			written = !e;
+			close(fds[1]);
+		});
+		std::function<void(std::exception_ptr, const adv_string_view<UTF16LE> &)> on_read;
+		on_read = [&](std::exception_ptr e, const adv_string_view<UTF16LE> &s){
+			if(e || s.size() == 0)
+				return;
+			ret.append(reinterpret_cast<const char *>(s.data()), s.size());
+			rd.read_chars(1000, on_read);
+		};
+		rd.read_chars(1000, on_read);
+		loop.run();
+		CHECK(written);
+	}
+	if(registered)
+		loop.unregister_buffer(mem.data());
+	close(fds[0]);
+	return ret;
+}
+
+static void test_async(){
+	//longer than the pipe capacity, so writes are partial
+	adv_string<UTF16LE> big = convert_to<UTF16LE>(sv("x\xF0\x9F\x98\x80y"));
+	std::string bigs;
+	for(int i = 0; i < 40000; i++)
+		bigs.append(reinterpret_cast<const char *>(big.data()), big.size());
+	for(bool uring : {true, false}){
+		CHECK(async_pipe(uring, bigs, false) == bigs);
+		CHECK(async_pipe(uring, bigs, true) == bigs);
+		//descriptors already in non-blocking mode
+		CHECK(async_pipe(uring, bigs, false, true) == bigs);
+	}
+
+	for(bool uring : {true, false}){
+		size_t nerr;
+		//characters split between writes
+		CHECK(async_read_chunks(uring, {"a\xC3", "\xA8" "b\xE2\x82", "\xAC", "\xF0\x9F\x98\x80z"}, 0, nerr) == "a\xC3\xA8" "b\xE2\x82\xAC\xF0\x9F\x98\x80z");
+		CHECK(nerr == 0);
+		CHECK(async_read_chunks(uring, {"abc\xC3\xA8", "defgh"}, 2, nerr) == "abc\xC3\xA8" "defgh");
+		//the characters before an invalid one are not lost
+		CHECK(async_read_chunks(uring, {"ab\xFF" "c"}, 0, nerr, 64) == "ab");
+		CHECK(nerr == 1);
+		//truncated character at the end of the input
+		CHECK(async_read_chunks(uring, {"ab\xC3"}, 0, nerr, 64) == "ab");
+		CHECK(nerr == 1);
+	}
+}
+#endif
+
 int main(){
     adv_string_view<UTF8> i = "Hello"_asv;
 	adv_string_view<UTF16LE> ay{u"areèò"};
@@ -24,5 +1769,39 @@ int main(){
 		std::cout << (uint)(p[i]) << " ";
 	}
 	std::cout << std::endl;
-}
 
+	test_hash();
+	test_intern();
+	test_compare();
+	test_sort();
+	test_tokens();
+	test_records();
+	test_sanitize();
+	test_unmappable();
+	test_reverse();
+	test_code_points();
+	test_normalization();
+	test_case_mapping();
+	test_segmentation();
+	test_byte_swap();
+	test_registry();
+	test_codepages();
+	test_cjk();
+	test_c_api();
+	test_format();
+	test_charconv();
+	test_json();
+	test_codecs();
+	test_shared_string();
+	test_static_string();
+#ifndef _WIN32
+	test_async();
+#endif
+
+	if(failures != 0){
+		std::cerr << failures << " checks failed" << std::endl;
+		return 1;
+	}
+	std::cout << "All checks passed" << std::endl;
+	return 0;
+}
@@ -0,0 +1,65 @@
+#include <encmetric.hpp>
+#include <iostream>
+#include <algorithm>
+#include <ranges>
+#include <string>
+#include <vector>
+
+using namespace adv;
+
+static_assert(std::ranges::bidirectional_range<code_point_range<UTF8>>);
+static_assert(std::ranges::bidirectional_range<code_point_range<UTF16LE>>);
+static_assert(std::ranges::bidirectional_range<code_point_range<UTF32BE>>);
+static_assert(std::ranges::bidirectional_range<code_point_range<WIDE<unicode>>>);
+static_assert(std::ranges::borrowed_range<code_point_range<UTF8>>);
+static_assert(std::bidirectional_iterator<code_point_iterator<UTF8>>);
+static_assert(std::ranges::forward_range<code_point_range<ISO_8859_1>>);
+
+static int failures = 0;
+
+#define CHECK(...) check((__VA_ARGS__), #__VA_ARGS__, __LINE__)
+
+static void check(bool ok, const char *expr, int line){
+	if(!ok){
+		std::cerr << "ranges.cpp:" << line << ": check failed: " << expr << std::endl;
+		failures++;
+	}
+}
+
+template<typename T>
+static adv_string<T> convert_to(const char *s){
+	adv_string_buf<T> buf{};
+	buf.append_string_c(adv_string_view<UTF8>{s, std::char_traits<char>::length(s), meas::size});
+	return buf.template allocate<std::allocator<byte>>();
+}
+
+template<typename T>
+static void test_views(){
+	adv_string<T> str = convert_to<T>("ab\xC3\xA8\xE2\x82\xAC\xF0\x9F\x98\x80 abcdefghijklmnopqrstuvwxyz \xF0\x9F\x98\x81");
+	std::vector<unicode> fw;
+	std::ranges::copy(str.code_points(), std::back_inserter(fw));
+	CHECK(fw.size() == str.length() && fw[2] == 0xE8 && fw[4] == 0x1F600);
+	std::vector<unicode> bw;
+	std::ranges::copy(str.code_points() | std::views::reverse, std::back_inserter(bw));
+	std::ranges::reverse(bw);
+	CHECK(bw == fw);
+	//the last space, searched backward
+	auto rev = str.code_points() | std::views::reverse;
+	auto sp = std::ranges::find(rev, unicode{' '});
+	CHECK(sp != rev.end() && std::ranges::distance(rev.begin(), sp) == 1);
+	CHECK(std::ranges::count_if(str.code_points(), [](unicode c) {return c >= 0x80;}) == 4);
+	auto ascii = str.code_points() | std::views::filter([](unicode c) {return c < 0x80;});
+	CHECK(std::ranges::distance(ascii) == static_cast<std::ptrdiff_t>(str.length()) - 4);
+}
+
+int main(){
+	test_views<UTF8>();
+	test_views<UTF16LE>();
+	test_views<UTF32BE>();
+	if(failures != 0){
+		std::cerr << failures << " checks failed" << std::endl;
+		return 1;
+	}
+	std::cout << "All checks passed" << std::endl;
+	return 0;
+}
@@ -0,0 +1,143 @@
+#include <encmetric.hpp>
+#include <encmetric/stats.hpp>
+#include <encmetric/enc_io_core.hpp>
+#include <iostream>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <errno.h>
+#include <unistd.h>
+
+using namespace adv;
+
+static int failures = 0;
+
+#define CHECK(...) check((__VA_ARGS__), #__VA_ARGS__, __LINE__)
+
+static void check(bool ok, const char *expr, int line){
+	if(!ok){
+		std::cerr << "stats.cpp:" << line << ": check failed: " << expr << std::endl;
+		failures++;
+	}
+}
+
+static adv_string_view<UTF8> sv(const char *s){
+	return adv_string_view<UTF8>{reinterpret_cast<const byte *>(s), std::strlen(s), meas::size};
+}
+
+static encoding_stats find(const stats_snapshot &snap, std::type_index idx){
+	for(const encoding_stats &e : snap.encodings){
+		if(e.encoding == idx)
+			return e;
+	}
+	return encoding_stats{idx, 0, 0, 0, 0, 0};
+}
+
+static bool all_zero(const stats_snapshot &snap){
+	for(std::uint64_t e : snap.events){
+		if(e != 0)
+			return false;
+	}
+	for(const encoding_stats &e : snap.encodings){
+		if(e.decoded_bytes != 0 || e.decoded_chars != 0 || e.encoded_bytes != 0 || e.encoded_chars != 0 || e.invalid != 0)
+			return false;
+	}
+	return true;
+}
+
+static void convert(const char *s){
+	adv_string_buf<UTF16LE> buf{};
+	buf.append_string_c(sv(s));
+}
+
+static void test_conversions(){
+	reset_stats();
+	CHECK(all_zero(get_stats()));
+	convert("a\xC3\xA8\xE2\x82\xAC");
+	stats_snapshot snap = get_stats();
+	encoding_stats u8 = find(snap, index_traits<UTF8>::index());
+	encoding_stats u16 = find(snap, index_traits<UTF16LE>::index());
+	if constexpr(stats_enabled()){
+		CHECK(u8.decoded_bytes == 6 && u8.decoded_chars == 3 && u8.encoded_bytes == 0 && u8.invalid == 0);
+		CHECK(u16.encoded_bytes == 6 && u16.encoded_chars == 3 && u16.decoded_bytes == 0);
+		CHECK(snap.encodings.size() == 2 && snap.encodings[0].encoding == index_traits<UTF8>::index());
+	}
+	else
+		CHECK(all_zero(snap));
+
+	//invalid input and exceptions
+	reset_stats();
+	CHECK(all_zero(get_stats()));
+	CHECK(!sv("a\xC3(").verify_safe());
+	try{
+		convert("\xE2\x82");
+	}
+	catch(const encoding_error &){}
+	snap = get_stats();
+	if constexpr(stats_enabled())
+		CHECK(find(snap, index_traits<UTF8>::index()).invalid >= 1 && snap[stat_event::exceptions] >= 1);
+	else
+		CHECK(all_zero(snap));
+	reset_stats();
+	CHECK(all_zero(get_stats()));
+}
+
+static void test_io(){
+	int fds[2];
+	if(pipe(fds) != 0)
+		return;
+	reset_stats();
+	const byte out[5]{byte{'h'}, byte{'e'}, byte{'l'}, byte{'l'}, byte{'o'}};
+	byte in[16];
+	CHECK(raw_fd_writebytes(fds[1], out, 5) == 5);
+	CHECK(raw_fd_readbytes(fds[0], in, 16) == 5);
+	stats_snapshot snap = get_stats();
+	if constexpr(stats_enabled()){
+		CHECK(snap[stat_event::io_writes] == 1 && snap[stat_event::io_written_bytes] == 5);
+		CHECK(snap[stat_event::io_reads] == 1 && snap[stat_event::io_read_bytes] == 5);
+	}
+	else
+		CHECK(all_zero(snap));
+
+	//the first count of a thread registers its counters, errno of the failed read must survive
+	raw_fd_set_nonblocking(fds[0]);
+	bool would_block = false;
+	std::thread th{[&](){
+		would_block = raw_fd_readbytes(fds[0], in, 16) < 0 && raw_io_would_block();
+	}};
+	th.join();
+	CHECK(would_block);
+	//counters of terminated threads are kept
+	if constexpr(stats_enabled())
+		CHECK(get_stats()[stat_event::io_reads] == 2);
+	close(fds[0]);
+	close(fds[1]);
+}
+
+static void test_threads(){
+	reset_stats();
+	std::thread th[4];
+	for(std::thread &t : th)
+		t = std::thread{[](){
+			for(int i = 0; i < 100; i++)
+				convert("ab");
+		}};
+	for(std::thread &t : th)
+		t.join();
+	encoding_stats u8 = find(get_stats(), index_traits<UTF8>::index());
+	CHECK(u8.decoded_chars == (stats_enabled() ? 800 : 0));
+	reset_stats();
+	CHECK(all_zero(get_stats()));
+}
+
+int main(){
+	test_conversions();
+	test_io();
+	test_threads();
+	if(failures != 0){
+		std::cerr << failures << " checks failed" << std::endl;
+		return 1;
+	}
+	std::cout << "All checks passed" << std::endl;
+	return 0;
+}